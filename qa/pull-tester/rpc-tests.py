@@ -195,6 +195,7 @@ testScriptsExt = [
     'bip68-sequence.py',
     'getblocktemplate_longpoll.py',  # FIXME: "socket.error: [Errno 54] Connection reset by peer" on my Mac, same as  https://github.com/bitcoin/bitcoin/issues/6651
     'p2p-timeouts.py',
+    'p2p-socketevents.py',
     # vv Tests less than 60s vv
     'bip9-softforks.py',
     'rpcbind_test.py',
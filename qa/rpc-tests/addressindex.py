@@ -132,6 +132,27 @@ class AddressIndexTest(BitcoinTestFramework):
         assert_equal(len(txidsmany), 4)
         assert_equal(txidsmany[3], sent_txid)
 
+        # Check that paging returns the same txids, a transaction is not repeated across pages
+        print("Testing paging...")
+        paged = []
+        params = {"addresses": ["93bVhahvUKmQu8gu9g3QnPPa2cxFK98pMB"], "limit": 1}
+        while True:
+            page = self.nodes[1].getaddresstxids(params)
+            paged += page["txids"]
+            if "continuation" not in page:
+                break
+            params["continuation"] = page["continuation"]
+        assert_equal(paged, txidsmany)
+
+        pageddeltas = self.nodes[1].getaddressdeltas({"addresses": ["93bVhahvUKmQu8gu9g3QnPPa2cxFK98pMB"], "limit": 2})
+        assert_equal(len(pageddeltas["deltas"]), 2)
+        assert("continuation" in pageddeltas)
+        rest = self.nodes[1].getaddressdeltas({"addresses": ["93bVhahvUKmQu8gu9g3QnPPa2cxFK98pMB"], "limit": 100,
+                                               "continuation": pageddeltas["continuation"]})
+        assert("continuation" not in rest)
+        alldeltas = self.nodes[1].getaddressdeltas({"addresses": ["93bVhahvUKmQu8gu9g3QnPPa2cxFK98pMB"]})
+        assert_equal(pageddeltas["deltas"] + rest["deltas"], alldeltas)
+
         # Check that balances are correct
         print("Testing balances...")
         balance0 = self.nodes[1].getaddressbalance("93bVhahvUKmQu8gu9g3QnPPa2cxFK98pMB")
@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+# Copyright (c) 2017-2019 The QuantisNet Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+""" SocketEventsTest -- loopback soak test for the -socketevents modes
+
+- For every supported mode, restart the node with -socketevents=<mode>
+- Open --peers P2P connections over loopback and wait for all handshakes
+- Run --rounds rounds, each keeping --inflight pings outstanding per peer
+- Assert every pong arrives and no peer is dropped
+- Print the handshake time, mean/worst round latency and pongs per second
+  so the modes can be compared with hundreds of local peers
+"""
+
+from time import time, sleep
+
+from test_framework.mininode import *
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import *
+
+class PingNode(NodeConnCB):
+    def __init__(self):
+        NodeConnCB.__init__(self)
+        self.connection = None
+        self.connected = False
+        self.pongs = 0
+
+    def add_connection(self, conn):
+        self.connection = conn
+
+    def on_open(self, conn):
+        self.connected = True
+
+    def on_close(self, conn):
+        self.connected = False
+
+    def on_pong(self, conn, message):
+        self.pongs += 1
+
+class SocketEventsTest(BitcoinTestFramework):
+    def add_options(self, parser):
+        parser.add_option("--peers", dest="peers", default=300, type="int",
+                          help="Number of loopback peers per mode")
+        parser.add_option("--rounds", dest="rounds", default=20, type="int",
+                          help="Number of ping rounds per mode")
+        parser.add_option("--inflight", dest="inflight", default=10, type="int",
+                          help="Pings outstanding per peer in each round")
+
+    def __init__(self):
+        super().__init__()
+        self.setup_clean_chain = True
+        self.num_nodes = 1
+
+    def setup_network(self):
+        self.nodes = []
+
+    def node_args(self, mode):
+        return ["-debug=0", "-socketevents=%s" % mode, "-maxconnections=%d" % (self.options.peers + 20)]
+
+    def soak(self, mode):
+        self.nodes = [start_node(0, self.options.tmpdir, self.node_args(mode))]
+        assert_equal(self.nodes[0].getconnectioncount(), 0)
+
+        start = time()
+        peers = []
+        for i in range(self.options.peers):
+            peer = PingNode()
+            peer.add_connection(NodeConn('127.0.0.1', p2p_port(0), self.nodes[0], peer))
+            peers.append(peer)
+        NetworkThread().start()
+
+        assert wait_until(lambda: all(peer.verack_received for peer in peers), timeout=120)
+        handshake = time() - start
+        assert_equal(self.nodes[0].getconnectioncount(), self.options.peers)
+
+        latencies = []
+        nonce = 1
+        start = time()
+        for r in range(self.options.rounds):
+            round_start = time()
+            with mininode_lock:
+                expected = [peer.pongs + self.options.inflight for peer in peers]
+            for peer in peers:
+                for i in range(self.options.inflight):
+                    peer.connection.send_message(msg_ping(nonce=nonce))
+                    nonce += 1
+            assert wait_until(lambda: all(peer.pongs >= n for peer, n in zip(peers, expected)), timeout=60)
+            latencies.append(time() - round_start)
+        elapsed = time() - start
+
+        assert all(peer.connected for peer in peers)
+        assert_equal(self.nodes[0].getconnectioncount(), self.options.peers)
+
+        pongs = self.options.peers * self.options.rounds * self.options.inflight
+        print("%s: %d peers, handshake %.2fs, round latency mean %.1fms worst %.1fms, %.0f pongs/s" %
+              (mode, self.options.peers, handshake, 1000 * sum(latencies) / len(latencies),
+               1000 * max(latencies), pongs / elapsed))
+
+        for peer in peers:
+            peer.connection.disconnect_node()
+        assert wait_until(lambda: not any(peer.connected for peer in peers), timeout=30)
+        stop_node(self.nodes[0], 0)
+        self.nodes = []
+        # Let the network thread notice the empty socket map and exit
+        sleep(1)
+
+    def run_test(self):
+        for mode in ["select", "epoll"]:
+            if mode == "epoll" and not sys.platform.startswith("linux"):
+                continue
+            self.soak(mode)
+
+if __name__ == '__main__':
+    SocketEventsTest().main()
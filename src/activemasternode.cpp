@@ -185,7 +185,7 @@ void CActiveMasternode::ManageStateInitial(CConnman& connman)
     // Check socket connectivity
     LogPrintf("CActiveMasternode::ManageStateInitial -- Checking inbound connection to '%s'\n", service.ToString());
     SOCKET hSocket;
-    bool fConnected = ConnectSocket(service, hSocket, nConnectTimeout) && IsSelectableSocket(hSocket);
+    bool fConnected = ConnectSocket(service, hSocket, nConnectTimeout);
     CloseSocket(hSocket);
 
     if (!fConnected) {
@@ -5,6 +5,7 @@
 
 #include "bench.h"
 
+#include "crypto/x11.h"
 #include "key.h"
 #include "validation.h"
 #include "util.h"
@@ -13,6 +14,7 @@ int
 main(int argc, char** argv)
 {
     ECC_Start();
+    X11AutoDetect();
     SetupEnvironment();
     fPrintToDebugLog = false; // don't want to write to debug.log file
 
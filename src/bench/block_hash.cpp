@@ -0,0 +1,42 @@
+// Copyright (c) 2017-2019 The QuantisNet Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "primitives/block.h"
+
+// A block is hashed many times between being received and being connected
+// (CheckBlock, AcceptBlock, logging, compact block relay, ...). With the header
+// hash cached, BlockHashRepeated should cost about the same as BlockHashOnce.
+
+static void BlockHash(benchmark::State& state, int nCalls)
+{
+    CBlock block;
+    block.nVersion = 1;
+    block.nTime = 1556488204;
+    block.nBits = 0x1e0ffff0;
+    block.nHeight = 1;
+
+    uint64_t nNonce = 0;
+    while (state.KeepRunning()) {
+        // changing the header invalidates the cached hash, like the miner nonce loop does
+        block.nNonce = nNonce++;
+        for (int i = 0; i < nCalls; ++i) {
+            block.GetHash();
+        }
+    }
+}
+
+static void BlockHashOnce(benchmark::State& state)
+{
+    BlockHash(state, 1);
+}
+
+static void BlockHashRepeated(benchmark::State& state)
+{
+    BlockHash(state, 8);
+}
+
+BENCHMARK(BlockHashOnce);
+BENCHMARK(BlockHashRepeated);
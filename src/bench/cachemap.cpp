@@ -0,0 +1,124 @@
+// Copyright (c) 2017-2019 The QuantisNet Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "cachemap.h"
+#include "crypto/common.h"
+
+#include <list>
+#include <map>
+
+static const size_t BENCH_CACHE_ENTRIES = 1000000;
+static const size_t BENCH_CACHE_BATCH = 1000;
+
+// The list + std::map layout CacheMap had before its hash index, for comparison
+class LegacyCacheMap
+{
+private:
+    size_t nMaxSize;
+    std::list<CacheItem<uint256, int> > listItems;
+    std::map<uint256, std::list<CacheItem<uint256, int> >::iterator> mapIndex;
+
+public:
+    explicit LegacyCacheMap(size_t nMaxSizeIn) : nMaxSize(nMaxSizeIn) {}
+
+    bool Insert(const uint256& key, int value)
+    {
+        if (mapIndex.count(key)) return false;
+        if (listItems.size() == nMaxSize) {
+            mapIndex.erase(listItems.back().key);
+            listItems.pop_back();
+        }
+        listItems.push_front(CacheItem<uint256, int>(key, value));
+        mapIndex.emplace(key, listItems.begin());
+        return true;
+    }
+
+    bool HasKey(const uint256& key) const { return mapIndex.count(key) > 0; }
+
+    void Erase(const uint256& key)
+    {
+        auto it = mapIndex.find(key);
+        if (it == mapIndex.end()) return;
+        listItems.erase(it->second);
+        mapIndex.erase(it);
+    }
+};
+
+static uint256 BenchKey(uint64_t n)
+{
+    uint256 key;
+    WriteLE64(key.begin(), n * 0x9e3779b97f4a7c15ULL);
+    WriteLE64(key.begin() + 8, n);
+    return key;
+}
+
+// Insert into a full cache, each insert evicts the oldest entry
+template<typename Cache>
+static void CacheInsert(benchmark::State& state)
+{
+    Cache cache(BENCH_CACHE_ENTRIES);
+    uint64_t n = 0;
+    for (; n < BENCH_CACHE_ENTRIES; n++) {
+        cache.Insert(BenchKey(n), n);
+    }
+    while (state.KeepRunning()) {
+        for (size_t i = 0; i < BENCH_CACHE_BATCH; i++, n++) {
+            cache.Insert(BenchKey(n), n);
+        }
+    }
+}
+
+// Look up present and absent keys in turn
+template<typename Cache>
+static void CacheLookup(benchmark::State& state)
+{
+    Cache cache(BENCH_CACHE_ENTRIES);
+    for (uint64_t n = 0; n < BENCH_CACHE_ENTRIES; n++) {
+        cache.Insert(BenchKey(n), n);
+    }
+    uint64_t n = 0;
+    size_t nFound = 0;
+    while (state.KeepRunning()) {
+        for (size_t i = 0; i < BENCH_CACHE_BATCH; i++, n++) {
+            nFound += cache.HasKey(BenchKey((n * 7919) % (2 * BENCH_CACHE_ENTRIES)));
+        }
+    }
+    assert(nFound > 0);
+}
+
+// Erase entries and put them back
+template<typename Cache>
+static void CacheEvict(benchmark::State& state)
+{
+    Cache cache(BENCH_CACHE_ENTRIES + BENCH_CACHE_BATCH);
+    for (uint64_t n = 0; n < BENCH_CACHE_ENTRIES; n++) {
+        cache.Insert(BenchKey(n), n);
+    }
+    uint64_t n = 0;
+    while (state.KeepRunning()) {
+        for (size_t i = 0; i < BENCH_CACHE_BATCH; i++) {
+            cache.Erase(BenchKey((n + i * 7919) % BENCH_CACHE_ENTRIES));
+        }
+        for (size_t i = 0; i < BENCH_CACHE_BATCH; i++) {
+            uint64_t nKey = (n + i * 7919) % BENCH_CACHE_ENTRIES;
+            cache.Insert(BenchKey(nKey), nKey);
+        }
+        n++;
+    }
+}
+
+static void CacheMapInsert(benchmark::State& state) { CacheInsert<CacheMap<uint256, int> >(state); }
+static void CacheMapLookup(benchmark::State& state) { CacheLookup<CacheMap<uint256, int> >(state); }
+static void CacheMapEvict(benchmark::State& state) { CacheEvict<CacheMap<uint256, int> >(state); }
+static void LegacyCacheMapInsert(benchmark::State& state) { CacheInsert<LegacyCacheMap>(state); }
+static void LegacyCacheMapLookup(benchmark::State& state) { CacheLookup<LegacyCacheMap>(state); }
+static void LegacyCacheMapEvict(benchmark::State& state) { CacheEvict<LegacyCacheMap>(state); }
+
+BENCHMARK(CacheMapInsert);
+BENCHMARK(CacheMapLookup);
+BENCHMARK(CacheMapEvict);
+BENCHMARK(LegacyCacheMapInsert);
+BENCHMARK(LegacyCacheMapLookup);
+BENCHMARK(LegacyCacheMapEvict);
@@ -15,6 +15,12 @@
 #include "crypto/sha1.h"
 #include "crypto/sha256.h"
 #include "crypto/sha512.h"
+#include "crypto/x11.h"
+#include "crypto/sph_blake.h"
+#include "crypto/sph_bmw.h"
+#include "crypto/sph_cubehash.h"
+#include "crypto/sph_keccak.h"
+#include "crypto/sph_skein.h"
 
 /* Number of bytes to hash per iteration */
 static const uint64_t BUFFER_SIZE = 1000*1000;
@@ -187,6 +193,78 @@ static void HASH_X11_2048b_single(benchmark::State& state)
         hash = HashX11(in.begin(), in.end());
 }
 
+static void HASH_X11_0080b_4way(benchmark::State& state)
+{
+    std::vector<uint8_t> in(X11_LANES * 80, 0);
+    std::vector<uint8_t> out(X11_LANES * 32);
+    const unsigned char* pin[X11_LANES];
+    unsigned char* pout[X11_LANES];
+    for (size_t i = 0; i < X11_LANES; i++) {
+        pin[i] = &in[i * 80];
+        pout[i] = &out[i * 32];
+    }
+    while (state.KeepRunning())
+        X11Hash4Way(pin, 80, pout);
+}
+
+/* Single X11 stages over X11_LANES messages, the multi-lane version against one sph call per lane */
+class X11StageBuffers
+{
+public:
+    std::vector<uint8_t> in;
+    std::vector<uint8_t> out;
+    const unsigned char* pin[X11_LANES];
+    unsigned char* pout[X11_LANES];
+
+    X11StageBuffers() : in(X11_LANES * X11_STAGE_SIZE, 0), out(X11_LANES * X11_STAGE_SIZE)
+    {
+        for (size_t i = 0; i < X11_LANES; i++) {
+            pin[i] = &in[i * X11_STAGE_SIZE];
+            pout[i] = &out[i * X11_STAGE_SIZE];
+        }
+    }
+};
+
+#define BENCH_X11_STAGE_4WAY(Name) \
+static void HASH_X11_##Name##_4way(benchmark::State& state) \
+{ \
+    X11StageBuffers buf; \
+    while (state.KeepRunning()) \
+        X11##Name##_4Way(buf.pin, buf.pout); \
+}
+
+#define BENCH_X11_STAGE_SCALAR(Name, name) \
+static void HASH_X11_##Name##_scalar(benchmark::State& state) \
+{ \
+    X11StageBuffers buf; \
+    while (state.KeepRunning()) { \
+        for (size_t i = 0; i < X11_LANES; i++) { \
+            sph_##name##_context ctx; \
+            sph_##name##_init(&ctx); \
+            sph_##name(&ctx, buf.pin[i], X11_STAGE_SIZE); \
+            sph_##name##_close(&ctx, buf.pout[i]); \
+        } \
+    } \
+}
+
+static void HASH_X11_Blake512_4way(benchmark::State& state)
+{
+    X11StageBuffers buf;
+    while (state.KeepRunning())
+        X11Blake512_4Way(buf.pin, X11_STAGE_SIZE, buf.pout);
+}
+
+BENCH_X11_STAGE_4WAY(Bmw512)
+BENCH_X11_STAGE_4WAY(Skein512)
+BENCH_X11_STAGE_4WAY(Keccak512)
+BENCH_X11_STAGE_4WAY(CubeHash512)
+
+BENCH_X11_STAGE_SCALAR(Blake512, blake512)
+BENCH_X11_STAGE_SCALAR(Bmw512, bmw512)
+BENCH_X11_STAGE_SCALAR(Skein512, skein512)
+BENCH_X11_STAGE_SCALAR(Keccak512, keccak512)
+BENCH_X11_STAGE_SCALAR(CubeHash512, cubehash512)
+
 BENCHMARK(HASH_RIPEMD160);
 BENCHMARK(HASH_SHA1);
 BENCHMARK(HASH_SHA256);
@@ -210,3 +288,15 @@ BENCHMARK(HASH_X11_0128b_single);
 BENCHMARK(HASH_X11_0512b_single);
 BENCHMARK(HASH_X11_1024b_single);
 BENCHMARK(HASH_X11_2048b_single);
+BENCHMARK(HASH_X11_0080b_4way);
+
+BENCHMARK(HASH_X11_Blake512_4way);
+BENCHMARK(HASH_X11_Blake512_scalar);
+BENCHMARK(HASH_X11_Bmw512_4way);
+BENCHMARK(HASH_X11_Bmw512_scalar);
+BENCHMARK(HASH_X11_Skein512_4way);
+BENCHMARK(HASH_X11_Skein512_scalar);
+BENCHMARK(HASH_X11_Keccak512_4way);
+BENCHMARK(HASH_X11_Keccak512_scalar);
+BENCHMARK(HASH_X11_CubeHash512_4way);
+BENCHMARK(HASH_X11_CubeHash512_scalar);
@@ -0,0 +1,39 @@
+// Copyright (c) 2017-2019 The QuantisNet Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "crypto/egihash.h"
+
+#include <cstring>
+
+// Both benchmarks share the epoch 0 cache, only the first one pays for generating it.
+static void EgihashLight(benchmark::State& state, bool reference)
+{
+    egihash::cache_t const cache(0);
+    uint8_t input[egihash::h256_t::hash_size + sizeof(uint64_t)] = {0};
+    uint64_t nonce = 0;
+
+    while (state.KeepRunning()) {
+        std::memcpy(&input[egihash::h256_t::hash_size], &nonce, sizeof(nonce));
+        if (reference) {
+            egihash::light::hash_reference(cache, input, sizeof(input));
+        } else {
+            egihash::light::hash(cache, input, sizeof(input));
+        }
+        ++nonce;
+    }
+}
+
+static void EGIHASH_Light(benchmark::State& state)
+{
+    EgihashLight(state, false);
+}
+
+static void EGIHASH_LightReference(benchmark::State& state)
+{
+    EgihashLight(state, true);
+}
+
+BENCHMARK(EGIHASH_Light);
+BENCHMARK(EGIHASH_LightReference);
@@ -0,0 +1,78 @@
+// Copyright (c) 2017-2019 The QuantisNet Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "activemasternode.h"
+#include "checkqueue.h"
+#include "instantx.h"
+#include "key.h"
+#include "spork.h"
+#include "util.h"
+
+#include <boost/thread/thread.hpp>
+
+static const size_t BENCH_TXLOCKVOTES = 10000;
+static const size_t BENCH_MASTERNODES = 10;
+
+// Synthetic votes of BENCH_MASTERNODES masternodes on the inputs of lock requests, all correctly signed
+static std::vector<std::pair<CTxLockVote, CPubKey> > CreateVotes()
+{
+    std::vector<CKey> vKeys(BENCH_MASTERNODES);
+    for (auto& key : vKeys) {
+        key.MakeNewKey(true);
+    }
+
+    std::vector<std::pair<CTxLockVote, CPubKey> > vecVotes;
+    vecVotes.reserve(BENCH_TXLOCKVOTES);
+    for (size_t i = 0; i < BENCH_TXLOCKVOTES; ++i) {
+        size_t nMasternode = i % BENCH_MASTERNODES;
+        uint256 txHash, mnHash;
+        WriteLE64(txHash.begin(), i / BENCH_MASTERNODES);
+        WriteLE64(mnHash.begin(), nMasternode);
+
+        CTxLockVote vote(txHash, COutPoint(txHash, 0), COutPoint(mnHash, 0));
+        activeMasternode.keyMasternode = vKeys[nMasternode];
+        activeMasternode.pubKeyMasternode = vKeys[nMasternode].GetPubKey();
+        bool fSigned = vote.Sign();
+        assert(fSigned);
+        vecVotes.emplace_back(vote, activeMasternode.pubKeyMasternode);
+    }
+    return vecVotes;
+}
+
+static void TxLockVoteVerify(benchmark::State& state, int nThreads)
+{
+    std::vector<std::pair<CTxLockVote, CPubKey> > vecVotes = CreateVotes();
+    bool fNewSigs = sporkManager.IsSporkActive(SPORK_6_NEW_SIGS);
+
+    CCheckQueue<CTxLockVoteCheck> queue(16);
+    boost::thread_group tg;
+    for (int i = 0; i < nThreads - 1; ++i) {
+        tg.create_thread([&]{queue.Thread();});
+    }
+
+    std::vector<char> vValid;
+    while (state.KeepRunning()) {
+        CheckTxLockVoteSignatures(vecVotes, fNewSigs, vValid, nThreads > 1 ? &queue : NULL);
+    }
+    for (char fValid : vValid) {
+        assert(fValid);
+    }
+
+    tg.interrupt_all();
+    tg.join_all();
+}
+
+static void TxLockVoteVerify_1Thread(benchmark::State& state)
+{
+    TxLockVoteVerify(state, 1);
+}
+
+static void TxLockVoteVerify_AllCores(benchmark::State& state)
+{
+    TxLockVoteVerify(state, std::max(2, GetNumCores()));
+}
+
+BENCHMARK(TxLockVoteVerify_1Thread);
+BENCHMARK(TxLockVoteVerify_AllCores);
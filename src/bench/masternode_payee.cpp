@@ -0,0 +1,132 @@
+// Copyright (c) 2017-2019 The QuantisNet Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "chain.h"
+#include "chainparams.h"
+#include "coins.h"
+#include "masternode-payments.h"
+#include "masternode-sync.h"
+#include "masternodeman.h"
+#include "net.h"
+#include "validation.h"
+
+#include <vector>
+
+static const int BENCH_MASTERNODES = 5000;
+// More blocks than masternodes, so every collateral has the confirmations payment asks for
+static const int BENCH_CHAIN_HEIGHT = BENCH_MASTERNODES + 1000;
+
+// Synthetic active chain, coins view and masternode list of BENCH_MASTERNODES enabled
+// masternodes, each last paid at a different block. Restores the globals when destroyed.
+class MasternodeListSetup
+{
+private:
+    std::vector<uint256> vBlockHashes;
+    std::vector<CBlockIndex> vBlockIndex;
+    CCoinsView viewDummy;
+    CCoinsViewCache coins;
+    CCoinsViewCache* pcoinsTipPrev;
+
+public:
+    MasternodeListSetup() : vBlockHashes(BENCH_CHAIN_HEIGHT + 1), vBlockIndex(BENCH_CHAIN_HEIGHT + 1), coins(&viewDummy)
+    {
+        SelectParams(CBaseChainParams::MAIN);
+
+        for (int i = 0; i <= BENCH_CHAIN_HEIGHT; ++i) {
+            WriteLE64(vBlockHashes[i].begin(), 0x6d6e0000 + i);
+            vBlockIndex[i].phashBlock = &vBlockHashes[i];
+            vBlockIndex[i].nHeight = i;
+            vBlockIndex[i].pprev = i > 0 ? &vBlockIndex[i - 1] : nullptr;
+        }
+
+        LOCK(cs_main);
+        chainActive.SetTip(&vBlockIndex.back());
+        pcoinsTipPrev = pcoinsTip;
+        pcoinsTip = &coins;
+
+        CConnman connman(0x1337, 0x1337);
+        masternodeSync.Reset();
+        while (!masternodeSync.IsWinnersListSynced()) {
+            masternodeSync.SwitchToNextAsset(connman);
+        }
+
+        int nProtocolVersion = mnpayments.GetMinMasternodePaymentsProto();
+        for (int i = 0; i < BENCH_MASTERNODES; ++i) {
+            uint256 txHash;
+            WriteLE64(txHash.begin(), i);
+            COutPoint outpoint(txHash, 0);
+            coins.AddCoin(outpoint, Coin(CTxOut(1000 * COIN, CScript()), 1, false), false);
+
+            CMasternode mn(CService(), outpoint, CPubKey(), CPubKey(), nProtocolVersion);
+            mn.nActiveState = CMasternode::MASTERNODE_ENABLED;
+            mn.sigTime = 0;
+            mn.nBlockLastPaid = (i * 7919) % BENCH_MASTERNODES;
+            mnodeman.Add(mn);
+        }
+    }
+
+    ~MasternodeListSetup()
+    {
+        LOCK(cs_main);
+        mnodeman.Clear();
+        masternodeSync.Reset();
+        pcoinsTip = pcoinsTipPrev;
+        chainActive.SetTip(nullptr);
+    }
+};
+
+// The payee lookup done for every block template and every block checked by CMasternodePayments::ProcessBlock
+static void MasternodePayee(benchmark::State& state)
+{
+    MasternodeListSetup setup;
+    masternode_info_t mnInfo;
+    while (state.KeepRunning()) {
+        bool fFound = mnodeman.GetNextMasternodeInQueueForPayment(BENCH_CHAIN_HEIGHT, true, mnInfo);
+        assert(fFound);
+    }
+}
+
+// The same lookup counting every qualifying masternode, i.e. walking the whole list as the
+// selection did before it could stop after the oldest tenth
+static void MasternodePayee_CountAll(benchmark::State& state)
+{
+    MasternodeListSetup setup;
+    masternode_info_t mnInfo;
+    int nCount;
+    while (state.KeepRunning()) {
+        bool fFound = mnodeman.GetNextMasternodeInQueueForPayment(BENCH_CHAIN_HEIGHT, true, nCount, mnInfo);
+        assert(fFound && nCount == BENCH_MASTERNODES);
+    }
+}
+
+// Rank of a masternode at the same block over and over, served from the score cache
+static void MasternodeRank(benchmark::State& state)
+{
+    MasternodeListSetup setup;
+    COutPoint outpoint(uint256(), 0);
+    int nRank;
+    while (state.KeepRunning()) {
+        bool fFound = mnodeman.GetMasternodeRank(outpoint, nRank, BENCH_CHAIN_HEIGHT);
+        assert(fFound);
+    }
+}
+
+// Rank at a different block each time, so all scores are calculated and sorted on every call
+static void MasternodeRank_Uncached(benchmark::State& state)
+{
+    MasternodeListSetup setup;
+    COutPoint outpoint(uint256(), 0);
+    int nRank;
+    int nHeight = 0;
+    while (state.KeepRunning()) {
+        bool fFound = mnodeman.GetMasternodeRank(outpoint, nRank, nHeight++ % BENCH_CHAIN_HEIGHT);
+        assert(fFound);
+    }
+}
+
+BENCHMARK(MasternodePayee);
+BENCHMARK(MasternodePayee_CountAll);
+BENCHMARK(MasternodeRank);
+BENCHMARK(MasternodeRank_Uncached);
@@ -0,0 +1,74 @@
+// Copyright (c) 2017-2019 The QuantisNet Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <iostream>
+
+#include "bench.h"
+#include "net.h"
+#include "version.h"
+
+static const CMessageHeader::MessageStartChars BENCH_MESSAGE_START = {0x0b, 0x11, 0x09, 0x07};
+
+// Receive messages of nSize bytes the way CConnman::SocketRecvData does. With fDirect the
+// data of large messages is read into CNetMessage::GetDataBuffer(), otherwise all bytes go
+// through the stack buffer and get copied into the message. Prints the bytes copied per message.
+static void NetRecv(benchmark::State& state, const char* strName, unsigned int nSize, bool fDirect)
+{
+    CDataStream ssWire(SER_NETWORK, PROTOCOL_VERSION);
+    ssWire << CMessageHeader(BENCH_MESSAGE_START, "block", nSize);
+    ssWire.resize(ssWire.size() + nSize, 0x55);
+
+    char pchBuf[0x10000];
+    uint64_t nMessages = 0;
+    uint64_t nCopied = 0;
+    while (state.KeepRunning()) {
+        CNetMessage msg(BENCH_MESSAGE_START, SER_NETWORK, PROTOCOL_VERSION);
+        size_t nPos = 0;
+        while (!msg.complete()) {
+            unsigned int nBytes = MAX_DIRECT_RECV_SIZE;
+            char* pchDest = nullptr;
+            if (fDirect && msg.in_data && msg.hdr.nMessageSize - msg.nDataPos >= MIN_DIRECT_RECV_SIZE) {
+                pchDest = msg.GetDataBuffer(nBytes);
+            } else {
+                pchDest = pchBuf;
+                nBytes = sizeof(pchBuf);
+                nCopied += std::min((size_t)nBytes, ssWire.size() - nPos);
+            }
+            nBytes = std::min((size_t)nBytes, ssWire.size() - nPos);
+            // stands in for the copy out of the kernel socket buffer
+            memcpy(pchDest, &ssWire[nPos], nBytes);
+            nPos += nBytes;
+
+            const char* pch = pchDest;
+            while (nBytes > 0) {
+                int handled = msg.in_data ? msg.readData(pch, nBytes) : msg.readHeader(pch, nBytes);
+                assert(handled > 0);
+                pch += handled;
+                nBytes -= handled;
+            }
+        }
+        nMessages++;
+    }
+    std::cout << strName << "-bytes-copied-per-msg," << nMessages << "," << nCopied / nMessages << "\n";
+}
+
+// A burst of small masternode/governance messages
+static void NetRecvSmall(benchmark::State& state)
+{
+    NetRecv(state, "NetRecvSmall", 400, true);
+}
+
+static void NetRecvLargeCopy(benchmark::State& state)
+{
+    NetRecv(state, "NetRecvLargeCopy", 1000000, false);
+}
+
+static void NetRecvLargeDirect(benchmark::State& state)
+{
+    NetRecv(state, "NetRecvLargeDirect", 1000000, true);
+}
+
+BENCHMARK(NetRecvSmall);
+BENCHMARK(NetRecvLargeCopy);
+BENCHMARK(NetRecvLargeDirect);
@@ -0,0 +1,72 @@
+// Copyright (c) 2017-2019 The QuantisNet Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "pos_kernel.h"
+#include "util.h"
+
+#include <vector>
+
+static const size_t BENCH_STAKE_KERNELS = 50000;
+static const unsigned int BENCH_HASH_DRIFT = 30;
+static const unsigned int BENCH_TIME_BLOCK_FROM = 1550000000;
+static const unsigned int BENCH_TIME_TX = BENCH_TIME_BLOCK_FROM + 3600;
+
+// Synthetic candidates with a target no hash meets, so every search covers the whole window
+static std::vector<CStakeKernel> CreateKernels()
+{
+    std::vector<CStakeKernel> vKernels;
+    vKernels.reserve(BENCH_STAKE_KERNELS);
+    for (size_t i = 0; i < BENCH_STAKE_KERNELS; ++i) {
+        uint256 hash;
+        WriteLE64(hash.begin(), i);
+        vKernels.emplace_back(0x1234567887654321 + i, BENCH_TIME_BLOCK_FROM, COutPoint(hash, i % 4),
+                              arith_uint256(0), BENCH_TIME_BLOCK_FROM);
+    }
+    return vKernels;
+}
+
+// The per try hashing as done before the kernels were prepared once per search
+static void StakeKernelSearch_StakeHash(benchmark::State& state)
+{
+    std::vector<CStakeKernel> vKernels = CreateKernels();
+    while (state.KeepRunning()) {
+        for (size_t i = 0; i < vKernels.size(); ++i) {
+            CDataStream ss(SER_GETHASH, 0);
+            ss << vKernels[i].GetStakeModifier();
+            uint256 hash;
+            WriteLE64(hash.begin(), i);
+            for (unsigned int nTimeTx = BENCH_TIME_TX; nTimeTx < BENCH_TIME_TX + BENCH_HASH_DRIFT; ++nTimeTx) {
+                stakeHash(nTimeTx, ss, i % 4, hash, BENCH_TIME_BLOCK_FROM);
+            }
+        }
+    }
+}
+
+static void StakeKernelSearch(benchmark::State& state, int nThreads)
+{
+    std::vector<CStakeKernel> vKernels = CreateKernels();
+    size_t nIndex;
+    unsigned int nTimeTx;
+    uint256 hashProofOfStake;
+    while (state.KeepRunning()) {
+        bool fFound = FindStakeKernel(vKernels, 0, BENCH_TIME_TX, BENCH_TIME_TX + BENCH_HASH_DRIFT, nThreads,
+                                      nIndex, nTimeTx, hashProofOfStake);
+        assert(!fFound);
+    }
+}
+
+static void StakeKernelSearch_1Thread(benchmark::State& state)
+{
+    StakeKernelSearch(state, 1);
+}
+
+static void StakeKernelSearch_AllCores(benchmark::State& state)
+{
+    StakeKernelSearch(state, GetNumCores());
+}
+
+BENCHMARK(StakeKernelSearch_StakeHash);
+BENCHMARK(StakeKernelSearch_1Thread);
+BENCHMARK(StakeKernelSearch_AllCores);
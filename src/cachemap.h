@@ -9,8 +9,14 @@
 
 #include <map>
 #include <list>
+#include <memory>
+#include <limits>
+#include <type_traits>
+#include <vector>
 #include <cstddef>
 
+#include "hash.h"
+#include "random.h"
 #include "serialize.h"
 
 /**
@@ -40,6 +46,360 @@ struct CacheItem
     }
 };
 
+/**
+ * Pool the item list nodes of a cache are carved from.
+ *
+ * Nodes are allocated in blocks and recycled through a free list, so that
+ * inserting an item and evicting the oldest one doesn't go to the heap.
+ * Blocks are only released once the pool is empty or destroyed.
+ */
+class CacheNodePool
+{
+private:
+    static const size_t NODES_PER_BLOCK = 256;
+
+    size_t nNodeSize;
+    std::vector<std::unique_ptr<char[]> > vBlocks;
+    size_t nBlockUsed;
+    void* pFree;
+    size_t nLive;
+
+public:
+    CacheNodePool()
+        : nNodeSize(0),
+          vBlocks(),
+          nBlockUsed(NODES_PER_BLOCK),
+          pFree(nullptr),
+          nLive(0)
+    {}
+
+    CacheNodePool(const CacheNodePool&) = delete;
+    CacheNodePool& operator=(const CacheNodePool&) = delete;
+
+    void* Allocate(size_t nSize)
+    {
+        if (nNodeSize == 0) {
+            // all nodes of a list have the same size, the first allocation sets it
+            const size_t nAlign = alignof(std::max_align_t);
+            nNodeSize = (std::max(nSize, sizeof(void*)) + nAlign - 1) / nAlign * nAlign;
+        }
+        if (nSize > nNodeSize) {
+            return ::operator new(nSize);
+        }
+        ++nLive;
+        if (pFree) {
+            void* p = pFree;
+            pFree = *static_cast<void**>(p);
+            return p;
+        }
+        if (nBlockUsed == NODES_PER_BLOCK) {
+            vBlocks.emplace_back(new char[nNodeSize * NODES_PER_BLOCK]);
+            nBlockUsed = 0;
+        }
+        return vBlocks.back().get() + nNodeSize * nBlockUsed++;
+    }
+
+    void Deallocate(void* p, size_t nSize)
+    {
+        if (nSize > nNodeSize) {
+            ::operator delete(p);
+            return;
+        }
+        *static_cast<void**>(p) = pFree;
+        pFree = p;
+        if (--nLive == 0) {
+            // nothing uses the blocks anymore, e.g. after a Clear()
+            vBlocks.clear();
+            nBlockUsed = NODES_PER_BLOCK;
+            pFree = nullptr;
+        }
+    }
+};
+
+/**
+ * Allocator handing out single nodes from a CacheNodePool. Every container gets a pool of
+ * its own, so that containers protected by different locks don't share one.
+ */
+template<typename T>
+class CacheAllocator
+{
+public:
+    typedef T value_type;
+
+    typedef std::false_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    std::shared_ptr<CacheNodePool> pool;
+
+    CacheAllocator()
+        : pool(std::make_shared<CacheNodePool>())
+    {}
+
+    template<typename U>
+    CacheAllocator(const CacheAllocator<U>& other)
+        : pool(other.pool)
+    {}
+
+    CacheAllocator select_on_container_copy_construction() const
+    {
+        return CacheAllocator();
+    }
+
+    T* allocate(size_t n)
+    {
+        if (n != 1) {
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+        return static_cast<T*>(pool->Allocate(sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n)
+    {
+        if (n != 1) {
+            ::operator delete(p);
+            return;
+        }
+        pool->Deallocate(p, sizeof(T));
+    }
+
+    template<typename U>
+    bool operator==(const CacheAllocator<U>& other) const { return pool == other.pool; }
+
+    template<typename U>
+    bool operator!=(const CacheAllocator<U>& other) const { return pool != other.pool; }
+};
+
+/** Serialization target feeding a SipHash, to hash any serializable key */
+class CacheKeyHashWriter
+{
+private:
+    CSipHasher hasher;
+
+public:
+    CacheKeyHashWriter(uint64_t k0, uint64_t k1) : hasher(k0, k1) {}
+
+    int GetType() const { return SER_GETHASH; }
+    int GetVersion() const { return 0; }
+
+    void write(const char* pch, size_t nSize)
+    {
+        hasher.Write((const unsigned char*)pch, nSize);
+    }
+
+    template<typename T>
+    CacheKeyHashWriter& operator<<(const T& obj)
+    {
+        ::Serialize(*this, obj);
+        return (*this);
+    }
+
+    uint64_t Finalize() { return hasher.Finalize(); }
+};
+
+/**
+ * Salted hash of cache keys. The keys of the governance caches come from the network,
+ * the salt keeps peers from filling a probe sequence on purpose.
+ */
+template<typename K, typename Enable = void>
+struct CacheKeyHasher
+{
+    const uint64_t k0, k1;
+
+    CacheKeyHasher()
+        : k0(GetRand(std::numeric_limits<uint64_t>::max())),
+          k1(GetRand(std::numeric_limits<uint64_t>::max()))
+    {}
+
+    uint64_t operator()(const K& key) const
+    {
+        CacheKeyHashWriter writer(k0, k1);
+        writer << key;
+        return writer.Finalize();
+    }
+};
+
+template<>
+struct CacheKeyHasher<uint256>
+{
+    const uint64_t k0, k1;
+
+    CacheKeyHasher()
+        : k0(GetRand(std::numeric_limits<uint64_t>::max())),
+          k1(GetRand(std::numeric_limits<uint64_t>::max()))
+    {}
+
+    uint64_t operator()(const uint256& key) const
+    {
+        return SipHashUint256(k0, k1, key);
+    }
+};
+
+/** Integers and pointers are chosen locally, they only need their bits mixed */
+template<typename K>
+struct CacheKeyHasher<K, typename std::enable_if<std::is_integral<K>::value || std::is_pointer<K>::value>::type>
+{
+    uint64_t operator()(const K& key) const
+    {
+        // MurmurHash3 finalizer
+        uint64_t h = (uint64_t)key;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+};
+
+/**
+ * Hash table with open addressing, linear probing and backward shift deletion,
+ * indexing the items of CacheMap and CacheMultiMap by key.
+ */
+template<typename K, typename T>
+class CacheIndex
+{
+private:
+    struct Slot
+    {
+        /// Hash of the key with the top bit set, 0 for an empty slot
+        uint64_t nHash;
+        K key;
+        T value;
+
+        Slot() : nHash(0), key(), value() {}
+    };
+
+    static const size_t MIN_CAPACITY = 16;
+
+    std::vector<Slot> vSlots;
+    size_t nSize;
+    CacheKeyHasher<K> hasher;
+
+    uint64_t Hash(const K& key) const
+    {
+        return hasher(key) | (1ULL << 63);
+    }
+
+    size_t Mask() const
+    {
+        return vSlots.size() - 1;
+    }
+
+    size_t FindSlot(const K& key, uint64_t nHash) const
+    {
+        for (size_t i = nHash & Mask(); ; i = (i + 1) & Mask()) {
+            const Slot& slot = vSlots[i];
+            if (slot.nHash == 0 || (slot.nHash == nHash && slot.key == key)) {
+                return i;
+            }
+        }
+    }
+
+    void Rehash(size_t nCapacity)
+    {
+        std::vector<Slot> vOld;
+        vOld.swap(vSlots);
+        vSlots.resize(nCapacity);
+        for (Slot& slot : vOld) {
+            if (slot.nHash == 0) continue;
+            size_t i = slot.nHash & Mask();
+            while (vSlots[i].nHash != 0) {
+                i = (i + 1) & Mask();
+            }
+            vSlots[i] = std::move(slot);
+        }
+    }
+
+public:
+    CacheIndex()
+        : vSlots(),
+          nSize(0),
+          hasher()
+    {}
+
+    size_t Size() const
+    {
+        return nSize;
+    }
+
+    void Clear()
+    {
+        vSlots.clear();
+        nSize = 0;
+    }
+
+    void Reserve(size_t nItems)
+    {
+        size_t nCapacity = MIN_CAPACITY;
+        while (nCapacity * 3 < nItems * 4) {
+            nCapacity *= 2;
+        }
+        if (nCapacity > vSlots.size()) {
+            Rehash(nCapacity);
+        }
+    }
+
+    T* Find(const K& key)
+    {
+        if (nSize == 0) return nullptr;
+        Slot& slot = vSlots[FindSlot(key, Hash(key))];
+        return slot.nHash ? &slot.value : nullptr;
+    }
+
+    const T* Find(const K& key) const
+    {
+        if (nSize == 0) return nullptr;
+        const Slot& slot = vSlots[FindSlot(key, Hash(key))];
+        return slot.nHash ? &slot.value : nullptr;
+    }
+
+    /// Return the value of key, inserting a default one if key is not there yet
+    T& FindOrInsert(const K& key)
+    {
+        // keep the load factor at or below 3/4
+        if ((nSize + 1) * 4 > vSlots.size() * 3) {
+            Rehash(std::max(vSlots.size() * 2, MIN_CAPACITY));
+        }
+        uint64_t nHash = Hash(key);
+        Slot& slot = vSlots[FindSlot(key, nHash)];
+        if (slot.nHash == 0) {
+            slot.nHash = nHash;
+            slot.key = key;
+            ++nSize;
+        }
+        return slot.value;
+    }
+
+    bool Erase(const K& key)
+    {
+        if (nSize == 0) return false;
+        size_t i = FindSlot(key, Hash(key));
+        if (vSlots[i].nHash == 0) return false;
+
+        // move back the following items which would not be found past the hole anymore
+        for (size_t j = (i + 1) & Mask(); vSlots[j].nHash != 0; j = (j + 1) & Mask()) {
+            size_t k = vSlots[j].nHash & Mask();
+            bool fStays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+            if (fStays) continue;
+            vSlots[i] = std::move(vSlots[j]);
+            i = j;
+        }
+        vSlots[i] = Slot();
+        --nSize;
+        return true;
+    }
+
+    void GetKeys(std::vector<K>& vecKeys) const
+    {
+        for (const Slot& slot : vSlots) {
+            if (slot.nHash != 0) {
+                vecKeys.push_back(slot.key);
+            }
+        }
+    }
+};
+
 
 /**
  * Map like container that keeps the N most recently added items
@@ -52,17 +412,13 @@ public:
 
     typedef CacheItem<K,V> item_t;
 
-    typedef std::list<item_t> list_t;
+    typedef std::list<item_t, CacheAllocator<item_t> > list_t;
 
     typedef typename list_t::iterator list_it;
 
     typedef typename list_t::const_iterator list_cit;
 
-    typedef std::map<K, list_it> map_t;
-
-    typedef typename map_t::iterator map_it;
-
-    typedef typename map_t::const_iterator map_cit;
+    typedef CacheIndex<K, list_it> map_t;
 
 private:
     size_type nMaxSize;
@@ -88,7 +444,7 @@ public:
 
     void Clear()
     {
-        mapIndex.clear();
+        mapIndex.Clear();
         listItems.clear();
     }
 
@@ -107,41 +463,41 @@ public:
 
     bool Insert(const K& key, const V& value)
     {
-        if(mapIndex.find(key) != mapIndex.end()) {
+        if(mapIndex.Find(key)) {
             return false;
         }
         if(listItems.size() == nMaxSize) {
             PruneLast();
         }
         listItems.push_front(item_t(key, value));
-        mapIndex.emplace(key, listItems.begin());
+        mapIndex.FindOrInsert(key) = listItems.begin();
         return true;
     }
 
     bool HasKey(const K& key) const
     {
-        return (mapIndex.find(key) != mapIndex.end());
+        return mapIndex.Find(key) != nullptr;
     }
 
     bool Get(const K& key, V& value) const
     {
-        map_cit it = mapIndex.find(key);
-        if(it == mapIndex.end()) {
+        const list_it* plit = mapIndex.Find(key);
+        if(!plit) {
             return false;
         }
-        item_t& item = *(it->second);
+        item_t& item = **plit;
         value = item.value;
         return true;
     }
 
     void Erase(const K& key)
     {
-        map_it it = mapIndex.find(key);
-        if(it == mapIndex.end()) {
+        list_it* plit = mapIndex.Find(key);
+        if(!plit) {
             return;
         }
-        listItems.erase(it->second);
-        mapIndex.erase(it);
+        listItems.erase(*plit);
+        mapIndex.Erase(key);
     }
 
     const list_t& GetItemList() const {
@@ -175,15 +531,18 @@ private:
             return;
         }
         item_t& item = listItems.back();
-        mapIndex.erase(item.key);
+        mapIndex.Erase(item.key);
         listItems.pop_back();
     }
 
     void RebuildIndex()
     {
-        mapIndex.clear();
+        mapIndex.Clear();
+        mapIndex.Reserve(listItems.size());
         for(list_it it = listItems.begin(); it != listItems.end(); ++it) {
-            mapIndex.emplace(it->key, it);
+            if(!mapIndex.Find(it->key)) {
+                mapIndex.FindOrInsert(it->key) = it;
+            }
         }
     }
 };
@@ -27,7 +27,7 @@ public:
 
     typedef CacheItem<K,V> item_t;
 
-    typedef std::list<item_t> list_t;
+    typedef std::list<item_t, CacheAllocator<item_t> > list_t;
 
     typedef typename list_t::iterator list_it;
 
@@ -39,11 +39,7 @@ public:
 
     typedef typename it_map_t::const_iterator it_map_cit;
 
-    typedef std::map<K, it_map_t> map_t;
-
-    typedef typename map_t::iterator map_it;
-
-    typedef typename map_t::const_iterator map_cit;
+    typedef CacheIndex<K, it_map_t> map_t;
 
 private:
     size_type nMaxSize;
@@ -59,7 +55,7 @@ public:
           mapIndex()
     {}
 
-    CacheMultiMap(const CacheMap<K,V>& other)
+    CacheMultiMap(const CacheMultiMap<K,V>& other)
         : nMaxSize(other.nMaxSize),
           listItems(other.listItems),
           mapIndex()
@@ -69,7 +65,7 @@ public:
 
     void Clear()
     {
-        mapIndex.clear();
+        mapIndex.Clear();
         listItems.clear();
     }
 
@@ -88,13 +84,8 @@ public:
 
     bool Insert(const K& key, const V& value)
     {
-        map_it mit = mapIndex.find(key);
-        if(mit == mapIndex.end()) {
-            mit = mapIndex.emplace(key, it_map_t()).first;
-        }
-        it_map_t& mapIt = mit->second;
-
-        if(mapIt.count(value) > 0) {
+        const it_map_t* pmapIt = mapIndex.Find(key);
+        if(pmapIt && pmapIt->count(value) > 0) {
             // Don't insert duplicates
             return false;
         }
@@ -103,36 +94,34 @@ public:
             PruneLast();
         }
         listItems.push_front(item_t(key, value));
-        mapIt.emplace(value, listItems.begin());
+        mapIndex.FindOrInsert(key).emplace(value, listItems.begin());
         return true;
     }
 
     bool HasKey(const K& key) const
     {
-        return (mapIndex.find(key) != mapIndex.end());
+        return mapIndex.Find(key) != nullptr;
     }
 
     bool Get(const K& key, V& value) const
     {
-        map_cit it = mapIndex.find(key);
-        if(it == mapIndex.end()) {
+        const it_map_t* pmapIt = mapIndex.Find(key);
+        if(!pmapIt) {
             return false;
         }
-        const it_map_t& mapIt = it->second;
-        const item_t& item = *(mapIt.begin()->second);
+        const item_t& item = *(pmapIt->begin()->second);
         value = item.value;
         return true;
     }
 
     bool GetAll(const K& key, std::vector<V>& vecValues)
     {
-        map_cit mit = mapIndex.find(key);
-        if(mit == mapIndex.end()) {
+        const it_map_t* pmapIt = mapIndex.Find(key);
+        if(!pmapIt) {
             return false;
         }
-        const it_map_t& mapIt = mit->second;
 
-        for(it_map_cit it = mapIt.begin(); it != mapIt.end(); ++it) {
+        for(it_map_cit it = pmapIt->begin(); it != pmapIt->end(); ++it) {
             const item_t& item = *(it->second);
             vecValues.push_back(item.value);
         }
@@ -141,44 +130,40 @@ public:
 
     void GetKeys(std::vector<K>& vecKeys)
     {
-        for(map_cit it = mapIndex.begin(); it != mapIndex.end(); ++it) {
-            vecKeys.push_back(it->first);
-        }
+        mapIndex.GetKeys(vecKeys);
     }
 
     void Erase(const K& key)
     {
-        map_it mit = mapIndex.find(key);
-        if(mit == mapIndex.end()) {
+        it_map_t* pmapIt = mapIndex.Find(key);
+        if(!pmapIt) {
             return;
         }
-        it_map_t& mapIt = mit->second;
 
-        for(it_map_it it = mapIt.begin(); it != mapIt.end(); ++it) {
+        for(it_map_it it = pmapIt->begin(); it != pmapIt->end(); ++it) {
             listItems.erase(it->second);
         }
 
-        mapIndex.erase(mit);
+        mapIndex.Erase(key);
     }
 
     void Erase(const K& key, const V& value)
     {
-        map_it mit = mapIndex.find(key);
-        if(mit == mapIndex.end()) {
+        it_map_t* pmapIt = mapIndex.Find(key);
+        if(!pmapIt) {
             return;
         }
-        it_map_t& mapIt = mit->second;
 
-        it_map_it it = mapIt.find(value);
-        if(it == mapIt.end()) {
+        it_map_it it = pmapIt->find(value);
+        if(it == pmapIt->end()) {
             return;
         }
 
         listItems.erase(it->second);
-        mapIt.erase(it);
+        pmapIt->erase(it);
 
-        if(mapIt.empty()) {
-            mapIndex.erase(mit);
+        if(pmapIt->empty()) {
+            mapIndex.Erase(key);
         }
     }
 
@@ -186,7 +171,7 @@ public:
         return listItems;
     }
 
-    CacheMap<K,V>& operator=(const CacheMap<K,V>& other)
+    CacheMultiMap<K,V>& operator=(const CacheMultiMap<K,V>& other)
     {
         nMaxSize = other.nMaxSize;
         listItems = other.listItems;
@@ -217,15 +202,13 @@ private:
         --lit;
         item_t& item = *lit;
 
-        map_it mit = mapIndex.find(item.key);
-
-        if(mit != mapIndex.end()) {
-            it_map_t& mapIt = mit->second;
+        it_map_t* pmapIt = mapIndex.Find(item.key);
 
-            mapIt.erase(item.value);
+        if(pmapIt) {
+            pmapIt->erase(item.value);
 
-            if(mapIt.empty()) {
-                mapIndex.erase(item.key);
+            if(pmapIt->empty()) {
+                mapIndex.Erase(item.key);
             }
         }
 
@@ -234,15 +217,10 @@ private:
 
     void RebuildIndex()
     {
-        mapIndex.clear();
+        mapIndex.Clear();
         for(list_it lit = listItems.begin(); lit != listItems.end(); ++lit) {
             item_t& item = *lit;
-            map_it mit = mapIndex.find(item.key);
-            if(mit == mapIndex.end()) {
-                mit = mapIndex.emplace(item.key, it_map_t()).first;
-            }
-            it_map_t& mapIt = mit->second;
-            mapIt.emplace(item.value, lit);
+            mapIndex.FindOrInsert(item.key).emplace(item.value, lit);
         }
     }
 };
@@ -13,7 +13,9 @@ extern "C"
 #include <algorithm>
 #include <atomic>
 #include <cmath>
+#include <condition_variable>
 #include <cstring>
+#include <exception>
 #include <fstream>
 #include <iomanip>
 #include <limits>
@@ -21,8 +23,16 @@ extern "C"
 #include <mutex>
 #include <string>
 #include <sstream>
+#include <thread>
 #include <iostream> // used by test
 
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 //#define ENABLE_EGIHASH_DEBUG
 
 #ifdef ENABLE_EGIHASH_DEBUG
@@ -112,8 +122,9 @@ namespace
 	};
 #pragma pack(pop)
 
-	static_assert(dag_file_header_t::magic_size == 12, "Magic size invalid.");
-	static_assert(sizeof(dag_file_header_t) == 64, "Dag header size invalid.");
+	// the magic includes its terminating zero, which makes the header one byte longer than DAG_FILE_HEADER_SIZE
+	static_assert(dag_file_header_t::magic_size == 13, "Magic size invalid.");
+	static_assert(sizeof(dag_file_header_t) == (constants::DAG_FILE_HEADER_SIZE + 1), "Dag header size invalid.");
 
 	template <typename IntegralType >
 	typename ::std::enable_if<::std::is_integral<IntegralType>::value, ::std::string>::type
@@ -159,6 +170,181 @@ namespace
 		return ((v1 * FNV_PRIME) ^ v2) % FNV_MODULUS;
 	}
 
+	/** \brief node_arena_t owns the rows of a cache or DAG in one cache line aligned allocation.
+	*
+	*	A DAG consists of tens of millions of rows, so a single arena avoids per-row heap
+	*	allocations and keeps rows adjacent for the hardware prefetcher.
+	*/
+	class node_arena_t
+	{
+	public:
+		using size_type = data_view_t::size_type;
+		static constexpr size_type alignment = 64;
+		static constexpr size_type row_words = data_view_t::row_words;
+
+		node_arena_t() = default;
+		node_arena_t(node_arena_t const &) = delete;
+		node_arena_t & operator=(node_arena_t const &) = delete;
+		node_arena_t(node_arena_t &&) = default;
+		node_arena_t & operator=(node_arena_t &&) = default;
+		~node_arena_t() = default;
+
+		void allocate(size_type row_count)
+		{
+			// storage is intentionally left uninitialized, every row is written by generation or loading
+			owner.reset();
+			storage.reset(new uint8_t[(row_count * constants::HASH_BYTES) + alignment]);
+			uintptr_t const addr = reinterpret_cast<uintptr_t>(storage.get());
+			first = reinterpret_cast<node *>((addr + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1));
+			rows = row_count;
+		}
+
+		/** \brief Serve rows from memory kept alive by owner_, e.g. a read-only file mapping.
+		*
+		*	Such rows are never written, the non-const row() accessor is only used while generating or loading.
+		*	node is a packed type, so rows do not need to be aligned.
+		*/
+		void assign(node const * first_, size_type row_count, ::std::shared_ptr<void const> owner_)
+		{
+			storage.reset();
+			owner = ::std::move(owner_);
+			first = const_cast<node *>(first_);
+			rows = row_count;
+		}
+
+		bool is_borrowed() const noexcept
+		{
+			return static_cast<bool>(owner);
+		}
+
+		inline node * row(size_type i) noexcept
+		{
+			return first + (i * row_words);
+		}
+
+		inline node const * row(size_type i) const noexcept
+		{
+			return first + (i * row_words);
+		}
+
+		size_type size() const noexcept
+		{
+			return rows;
+		}
+
+		data_view_t view() const noexcept
+		{
+			return data_view_t(first, rows);
+		}
+
+	private:
+		::std::unique_ptr<uint8_t[]> storage;
+		::std::shared_ptr<void const> owner;
+		node * first = nullptr;
+		size_type rows = 0;
+	};
+
+#ifndef WIN32
+	/** \brief mapped_file_t owns a read-only private mapping of a whole file.
+	*
+	*	A mapping which could not be established is reported by valid() instead of an exception,
+	*	so that callers can fall back to reading the file.
+	*/
+	class mapped_file_t
+	{
+	public:
+		mapped_file_t(mapped_file_t const &) = delete;
+		mapped_file_t & operator=(mapped_file_t const &) = delete;
+
+		mapped_file_t(::std::string const & file_path, bool populate)
+		{
+			int const fd = ::open(file_path.c_str(), O_RDONLY);
+			if (fd < 0)
+			{
+				return;
+			}
+
+			struct stat st;
+			if ((::fstat(fd, &st) == 0) && (st.st_size > 0)
+				&& (static_cast<uint64_t>(st.st_size) <= ::std::numeric_limits<size_t>::max()))
+			{
+				int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+				if (populate)
+				{
+					flags |= MAP_POPULATE;
+				}
+#endif
+				void * const addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, flags, fd, 0);
+				if (addr != MAP_FAILED)
+				{
+					base = addr;
+					length = static_cast<size_t>(st.st_size);
+					// hashimoto touches pages at random, read-ahead only helps the warm-up
+					::madvise(base, length, populate ? MADV_WILLNEED : MADV_RANDOM);
+				}
+			}
+			::close(fd);
+		}
+
+		~mapped_file_t()
+		{
+			if (base != nullptr)
+			{
+				::munmap(base, length);
+			}
+		}
+
+		bool valid() const noexcept
+		{
+			return base != nullptr;
+		}
+
+		uint8_t const * data() const noexcept
+		{
+			return static_cast<uint8_t const *>(base);
+		}
+
+		size_t size() const noexcept
+		{
+			return length;
+		}
+
+	private:
+		void * base = nullptr;
+		size_t length = 0;
+	};
+#endif
+
+	/** \brief Keccak-512 of src_size bytes into a single row.
+	*
+	*	The sponge absorbs all input before squeezing, so dst may alias src.
+	*/
+	inline void sha3_512_row(node * dst, void const * src, size_t src_size)
+	{
+		if (::sha3_512(reinterpret_cast<uint8_t *>(dst), constants::HASH_BYTES, reinterpret_cast<uint8_t const *>(src), src_size) != 0)
+		{
+			throw hash_exception("Unable to compute hash");
+		}
+	}
+
+	/** \brief Read all rows of an arena in chunks of constants::CALLBACK_FREQUENCY rows.
+	*/
+	void read_rows(node_arena_t & arena, read_function_type & read, progress_callback_type & callback, progress_callback_phase phase, char const * cancel_message)
+	{
+		using size_type = node_arena_t::size_type;
+		size_type const row_count = arena.size();
+		for (size_type i = 0; i < row_count; i += constants::CALLBACK_FREQUENCY)
+		{
+			size_type const chunk = (::std::min)(static_cast<size_type>(constants::CALLBACK_FREQUENCY), row_count - i);
+			read(arena.row(i), chunk * constants::HASH_BYTES);
+			if (((i + chunk) % constants::CALLBACK_FREQUENCY) == 0 && !callback(i + chunk, row_count, phase))
+			{
+				throw hash_exception(cancel_message);
+			}
+		}
+	}
+
 	template <size_t HashSize, int (*HashFunction)(uint8_t *, size_t, uint8_t const * in, size_t)>
 	struct sha3_base
 	{
@@ -429,7 +615,7 @@ namespace egihash
 	struct cache_t::impl_t
 	{
 		using size_type = cache_t::size_type;
-		using data_type = ::std::vector<std::vector<node>>;
+		using data_type = node_arena_t;
 		using cache_cache_map = ::std::map<uint64_t /* epoch */, ::std::shared_ptr<impl_t>>;
 
 		impl_t(uint64_t const block_number, progress_callback_type callback)
@@ -454,11 +640,11 @@ namespace egihash
 		{
 			uint32_t n = size / constants::HASH_BYTES;
 
-			data.reserve(n);
-			data.push_back(sha3_512(&seedhash.b[0], seedhash.hash_size));
+			data.allocate(n);
+			sha3_512_row(data.row(0), &seedhash.b[0], seedhash.hash_size);
 			for (uint32_t i = 1; i < n; i++)
 			{
-				data.push_back(sha3_512(data.back()));
+				sha3_512_row(data.row(i), data.row(i - 1), constants::HASH_BYTES);
 				if (((i % constants::CALLBACK_FREQUENCY) == 0) && !callback(i, n, cache_seeding))
 				{
 					throw hash_exception("Cache creation cancelled.");
@@ -468,18 +654,19 @@ namespace egihash
 			EGIHASH_DEBUG("mkcache data length: " << data.size())
 
 			uint32_t progress_counter = 0;
+			node u[node_arena_t::row_words];
 			for (uint32_t i = 0; i < constants::CACHE_ROUNDS; i++)
 			{
 				for (uint32_t j = 0; j < n; j++)
 				{
-					auto v = data[j][0].hword % n;
-					auto u = data[(n - 1 + j)%n];
-					size_t count = 0;
-					for (auto & k : u)
+					auto const v = data.row(j)[0].hword % n;
+					::std::memcpy(u, data.row((n - 1 + j) % n), constants::HASH_BYTES);
+					node const * const w = data.row(v);
+					for (size_t k = 0; k < node_arena_t::row_words; k++)
 					{
-						k.hword = k.hword ^ data[v][count++].hword;
+						u[k].hword = u[k].hword ^ w[k].hword;
 					}
-					data[j] = sha3_512(u);
+					sha3_512_row(data.row(j), u, constants::HASH_BYTES);
 
 					if (((++progress_counter % constants::CALLBACK_FREQUENCY) == 0) && !callback(progress_counter, n * constants::CACHE_ROUNDS, cache_generation))
 					{
@@ -493,17 +680,8 @@ namespace egihash
 		{
 			size_type const cache_hash_count = size / constants::HASH_BYTES;
 
-			data.resize(cache_hash_count);
-			size_t count = 0;
-			for (auto & i : data)
-			{
-				i.resize(constants::HASH_BYTES / constants::WORD_BYTES);
-				read(&i[0], constants::HASH_BYTES);
-				if (((++count % constants::CALLBACK_FREQUENCY) == 0) && !callback(count, cache_hash_count, cache_loading))
-				{
-					throw hash_exception("Cache loading cancelled.");
-				}
-			}
+			data.allocate(cache_hash_count);
+			read_rows(data, read, callback, cache_loading, "Cache loading cancelled.");
 		}
 
 		static size_type get_cache_size(uint64_t block_number) noexcept
@@ -561,6 +739,7 @@ namespace egihash
 	void cache_t::unload() const
 	{
 		EGIHASH_DEBUG("unloading cache epoch " << epoch())
+		std::lock_guard<std::recursive_mutex> lock(get_cache_cache_mutex());
 		get_cache_cache().erase(epoch());
 	}
 
@@ -661,9 +840,9 @@ namespace egihash
 		return impl->size;
 	}
 
-	cache_t::data_type const & cache_t::data() const
+	cache_t::data_type cache_t::data() const
 	{
-		return impl->data;
+		return impl->data.view();
 	}
 
 	h256_t cache_t::seedhash() const
@@ -711,7 +890,7 @@ namespace egihash
 	struct dag_t::impl_t
 	{
 		using size_type = dag_t::size_type;
-		using data_type = ::std::vector<::std::vector<node>>;
+		using data_type = node_arena_t;
 		using dag_cache_map = ::std::map<uint64_t /* epoch */, ::std::shared_ptr<impl_t>>;
 		static constexpr uint64_t max_epoch = ::std::numeric_limits<uint64_t>::max();
 
@@ -732,16 +911,22 @@ namespace egihash
 		{
 			// load the DAG
 			size_type dag_hash_count = size / constants::HASH_BYTES;
-			data.resize(dag_hash_count);
-			size_t count = 0;
-			for (auto & i : data)
+			data.allocate(dag_hash_count);
+			read_rows(data, read, callback, dag_loading, "DAG loading cancelled.");
+		}
+
+		impl_t(read_function_type read, dag_file_header_t & header, node const * dag_rows, ::std::shared_ptr<void const> owner, progress_callback_type callback)
+		: epoch(header.epoch)
+		, size(header.dag_end - header.dag_begin)
+		, cache(header.epoch, header.cache_end - header.cache_begin, read, callback)
+		, data()
+		{
+			// serve the DAG straight from the mapping, pages are read in by the kernel on first access
+			size_type dag_hash_count = size / constants::HASH_BYTES;
+			data.assign(dag_rows, dag_hash_count, ::std::move(owner));
+			if (!callback(dag_hash_count, dag_hash_count, dag_loading))
 			{
-				i.resize(constants::HASH_BYTES / constants::WORD_BYTES);
-				read(&i[0], constants::HASH_BYTES);
-				if (((++count % constants::CALLBACK_FREQUENCY) == 0) && !callback(count, data.size(), dag_loading))
-				{
-					throw hash_exception("DAG loading cancelled.");
-				}
+				throw hash_exception("DAG loading cancelled.");
 			}
 		}
 
@@ -778,65 +963,174 @@ namespace egihash
 
 			size_t max_count = cache.data().size() + data.size();
 			size_t count = 0;
-			for (auto const & i : cache.data())
+
+			// write whole runs of rows, splitting them only where a progress callback is due
+			auto write_rows = [&](data_view_t const & rows)
 			{
-				for (auto const & j : i)
+				for (size_t i = 0; i < rows.size();)
 				{
-					write(&j, sizeof(j));
+					size_t const chunk = (::std::min)(constants::CALLBACK_FREQUENCY - (count % constants::CALLBACK_FREQUENCY), rows.size() - i);
+					write(rows[i], chunk * constants::HASH_BYTES);
+					i += chunk;
+					count += chunk;
+					if (((count % constants::CALLBACK_FREQUENCY) == 0) && !callback(count, max_count, dag_saving))
+					{
+						throw hash_exception("DAG save cancelled.");
+					}
 				}
-				if (((++count % constants::CALLBACK_FREQUENCY) == 0) && !callback(count, max_count, dag_saving))
+			};
+
+			write_rows(cache.data());
+			write_rows(data.view());
+		}
+
+		void generate(progress_callback_type callback)
+		{
+			uint32_t const n = size / constants::HASH_BYTES;
+			data.allocate(n);
+			generate_items(cache.data(), data.row(0), 0, n, dag_t::get_generation_threads(), callback);
+		}
+
+		static void generate_items(data_view_t const & cache, node * out, uint32_t const begin, uint32_t const end, unsigned threads, progress_callback_type & callback)
+		{
+			using namespace std;
+
+			uint32_t const count = end - begin;
+			uint32_t const chunk_size = constants::CALLBACK_FREQUENCY;
+			uint32_t const chunk_count = (count + chunk_size - 1) / chunk_size;
+			threads = (::std::max)(1u, (::std::min)(threads, chunk_count));
+
+			if (threads == 1)
+			{
+				for (uint32_t i = 0; i < count; i++)
 				{
-					throw hash_exception("DAG save cancelled.");
+					calc_dataset_item(cache, begin + i, out + (i * data_view_t::row_words));
+					if ((i % constants::CALLBACK_FREQUENCY) == 0 && !callback(i, count, dag_generation))
+					{
+						throw hash_exception("DAG creation cancelled.");
+					}
 				}
+				return;
 			}
 
-			for (auto const & i : data)
+			// workers grab chunks of CALLBACK_FREQUENCY items, only this thread calls the progress callback
+			atomic<uint32_t> next_chunk(0);
+			atomic<bool> cancelled(false);
+			mutex m;
+			condition_variable cv;
+			uint32_t done = 0;
+			unsigned finished = 0;
+			exception_ptr error;
+
+			auto worker = [&]()
 			{
-				for (auto const & j : i)
+				try
 				{
-					write(&j, sizeof(j));
+					for (uint32_t c = next_chunk++; (c < chunk_count) && !cancelled; c = next_chunk++)
+					{
+						uint32_t const first = c * chunk_size;
+						uint32_t const last = (::std::min)(first + chunk_size, count);
+						for (uint32_t i = first; i < last; i++)
+						{
+							calc_dataset_item(cache, begin + i, out + (i * data_view_t::row_words));
+						}
+
+						lock_guard<mutex> lock(m);
+						done += last - first;
+						cv.notify_one();
+					}
 				}
-				if (((++count % constants::CALLBACK_FREQUENCY) == 0) && !callback(count, max_count, dag_saving))
+				catch (...)
 				{
-					throw hash_exception("DAG save cancelled.");
+					lock_guard<mutex> lock(m);
+					if (!error)
+					{
+						error = current_exception();
+					}
+					cancelled = true;
 				}
+
+				lock_guard<mutex> lock(m);
+				++finished;
+				cv.notify_one();
+			};
+
+			vector<thread> workers;
+			workers.reserve(threads);
+
+			// make sure no worker outlives this frame, even if the callback throws
+			struct joiner_t
+			{
+				vector<thread> & workers;
+				atomic<bool> & cancelled;
+				~joiner_t()
+				{
+					cancelled = true;
+					for (auto & t : workers)
+					{
+						if (t.joinable()) t.join();
+					}
+				}
+			} joiner{workers, cancelled};
+
+			for (unsigned t = 0; t < threads; t++)
+			{
+				workers.emplace_back(worker);
 			}
-		}
 
-		void generate(progress_callback_type callback)
-		{
-			uint32_t const n = size / constants::HASH_BYTES;
-			data.reserve(n);
-			for (uint32_t i = 0; i < n; i++)
+			unique_lock<mutex> lock(m);
+			uint32_t reported = 0;
+			while (finished < threads)
 			{
-				data.push_back(calc_dataset_item(cache.data(), i));
-				if ((i % constants::CALLBACK_FREQUENCY) == 0 && !callback(i, n, dag_generation))
+				cv.wait(lock, [&]() { return (finished == threads) || (done != reported); });
+				if (done == reported)
+				{
+					continue;
+				}
+				reported = done;
+				if (!cancelled)
 				{
-					throw hash_exception("DAG creation cancelled.");
+					lock.unlock();
+					bool const keep_going = callback(reported, count, dag_generation);
+					lock.lock();
+					if (!keep_going)
+					{
+						cancelled = true;
+					}
 				}
 			}
+			bool const complete = (done == count);
+			lock.unlock();
+
+			if (error)
+			{
+				rethrow_exception(error);
+			}
+
+			if (cancelled || !complete)
+			{
+				throw hash_exception("DAG creation cancelled.");
+			}
 		}
 
-		static data_type::value_type calc_dataset_item(::std::vector<sha3_512_t::deserialized_hash_t> const & cache, uint32_t const i)
+		static void calc_dataset_item(data_view_t const & cache, uint32_t const i, node * out)
 		{
 			uint32_t const n = cache.size();
-			constexpr uint32_t r = constants::HASH_BYTES / constants::WORD_BYTES;
-			sha3_512_t::deserialized_hash_t mix(cache[i%n]);
+			constexpr uint32_t r = data_view_t::row_words;
+			node mix[r];
+			::std::memcpy(mix, cache[i % n], constants::HASH_BYTES);
 			mix[0].hword ^= i;
-			mix = sha3_512(mix);
+			sha3_512_row(mix, mix, constants::HASH_BYTES);
 			for (uint32_t j = 0; j < constants::DATASET_PARENTS; j++)
 			{
 				uint32_t const cache_index = fnv(i ^ j, mix[j % r].hword);
-				auto lBeg = cache[cache_index % n].begin();
-				auto lEnd = cache[cache_index % n].end();
-				for (auto k = mix.begin(), kEnd = mix.end();
-					((k != kEnd) && (lBeg != lEnd)); k++, lBeg++)
+				node const * const parent = cache[cache_index % n];
+				for (uint32_t k = 0; k < r; k++)
 				{
-					k->hword = fnv(k->hword, lBeg->hword);
+					mix[k].hword = fnv(mix[k].hword, parent[k].hword);
 				}
-
 			}
-			return sha3_512(mix);
+			sha3_512_row(out, mix, constants::HASH_BYTES);
 		}
 
 		cache_t get_cache() const
@@ -923,7 +1217,100 @@ namespace egihash
 		throw hash_exception("Could not get DAG");
 	}
 
-	::std::shared_ptr<dag_t::impl_t> get_dag(::std::string const & file_path, progress_callback_type callback)
+	::std::shared_ptr<dag_t::impl_t> find_loaded_dag(uint64_t const epoch_number)
+	{
+		using namespace std;
+		lock_guard<recursive_mutex> lock(get_dag_cache_mutex());
+		auto const dag_cache_iterator = get_dag_cache().find(epoch_number);
+		if (dag_cache_iterator != get_dag_cache().end())
+		{
+			return dag_cache_iterator->second;
+		}
+		return nullptr;
+	}
+
+	::std::shared_ptr<dag_t::impl_t> insert_loaded_dag(::std::shared_ptr<dag_t::impl_t> impl)
+	{
+		using namespace std;
+		lock_guard<recursive_mutex> lock(get_dag_cache_mutex());
+		auto insert_pair = get_dag_cache().insert(make_pair(impl->epoch, impl));
+
+		// if insert succeded, return the dag
+		if (insert_pair.second)
+		{
+			EGIHASH_DEBUG("inserted new DAG: " << impl->epoch
+				<< " size " << impl->size );
+			return insert_pair.first->second;
+		}
+
+		// if insert failed, it's probably already been inserted
+		auto const dag_cache_iterator = get_dag_cache().find(impl->epoch);
+		if (dag_cache_iterator != get_dag_cache().end())
+		{
+			return dag_cache_iterator->second;
+		}
+
+		// we couldn't insert it and it's not in the cache
+		throw hash_exception("Could not get DAG");
+	}
+
+	/** \brief Load a DAG by mapping its file, returns nullptr if the file could not be mapped.
+	*/
+	::std::shared_ptr<dag_t::impl_t> map_dag(::std::string const & file_path, bool warm, progress_callback_type callback)
+	{
+#ifndef WIN32
+		using namespace std;
+
+		auto file = make_shared<mapped_file_t>(file_path, warm);
+		if (!file->valid())
+		{
+			return nullptr;
+		}
+
+		// check minimum dag size
+		if (file->size() < constants::DAG_FILE_MINIMUM_SIZE)
+		{
+			throw hash_exception("DAG is corrupt");
+		}
+
+		size_t offset = 0;
+		auto read = [&file, &offset](void * dst, size_t count)
+		{
+			if (count > (file->size() - offset))
+			{
+				throw hash_exception("Read failure");
+			}
+			::std::memcpy(dst, file->data() + offset, count);
+			offset += count;
+		};
+
+		dag_file_header_t header(read);
+
+		// the cache directly follows the header and the DAG directly follows the cache
+		size_t const dag_offset = offset + (header.cache_end - header.cache_begin);
+		if ((dag_offset > file->size()) || ((header.dag_end - header.dag_begin) > (file->size() - dag_offset)))
+		{
+			throw hash_exception("DAG is corrupt");
+		}
+
+		// if we have the correct DAG already loaded, return it from the cache
+		auto loaded = find_loaded_dag(header.epoch);
+		if (loaded)
+		{
+			return loaded;
+		}
+
+		EGIHASH_DEBUG("mapping DAG from " << file_path)
+
+		node const * const dag_rows = reinterpret_cast<node const *>(file->data() + dag_offset);
+		shared_ptr<dag_t::impl_t> impl(new dag_t::impl_t(read, header, dag_rows, file, callback));
+		return insert_loaded_dag(impl);
+#else
+		return nullptr;
+#endif
+	}
+
+	::std::shared_ptr<dag_t::impl_t> stream_dag(::std::string const & file_path, progress_callback_type callback)
 	{
 		using namespace std;
 		using size_type = dag_t::size_type;
@@ -1002,13 +1389,10 @@ namespace egihash
 		}
 
 		// if we have the correct DAG already loaded, return it from the cache
+		auto loaded = find_loaded_dag(header.epoch);
+		if (loaded)
 		{
-			lock_guard<recursive_mutex> lock(get_dag_cache_mutex());
-			auto const dag_cache_iterator = get_dag_cache().find(header.epoch);
-			if (dag_cache_iterator != get_dag_cache().end())
-			{
-				return dag_cache_iterator->second;
-			}
+			return loaded;
 		}
 
 		EGIHASH_DEBUG("loading DAG from " << file_path)
@@ -1016,27 +1400,21 @@ namespace egihash
 		// otherwise create the dag and add it to the cache
 		// this is not locked as it can be a lengthy process and we don't want to block access to the dag cache
 		shared_ptr<dag_t::impl_t> impl(new dag_t::impl_t(read, header, callback));
+		return insert_loaded_dag(impl);
+	}
 
-		lock_guard<recursive_mutex> lock(get_dag_cache_mutex());
-		auto insert_pair = get_dag_cache().insert(make_pair(header.epoch, impl));
-
-		// if insert succeded, return the dag
-		if (insert_pair.second)
-		{
-			EGIHASH_DEBUG("inserted new DAG: " << impl->epoch
-				<< " size " << impl->size );
-			return insert_pair.first->second;
-		}
-
-		// if insert failed, it's probably already been inserted
-		auto const dag_cache_iterator = get_dag_cache().find(header.epoch);
-		if (dag_cache_iterator != get_dag_cache().end())
+	::std::shared_ptr<dag_t::impl_t> get_dag(::std::string const & file_path, dag_load_mode mode, progress_callback_type callback)
+	{
+		if (mode != dag_load_stream)
 		{
-			return dag_cache_iterator->second;
+			auto impl = map_dag(file_path, mode == dag_load_mapped_warm, callback);
+			if (impl)
+			{
+				return impl;
+			}
+			EGIHASH_DEBUG("could not map " << file_path << ", streaming it instead")
 		}
-
-		// we couldn't insert it and it's not in the cache
-		throw hash_exception("Could not get DAG");
+		return stream_dag(file_path, callback);
 	}
 
 	dag_t::dag_t(uint64_t block_number, progress_callback_type callback)
@@ -1045,7 +1423,13 @@ namespace egihash
 	}
 
 	dag_t::dag_t(::std::string const & file_path, progress_callback_type callback)
-	: impl(get_dag(file_path, callback))
+	: impl(get_dag(file_path, dag_load_mapped, callback))
+	{
+
+	}
+
+	dag_t::dag_t(::std::string const & file_path, dag_load_mode mode, progress_callback_type callback)
+	: impl(get_dag(file_path, mode, callback))
 	{
 
 	}
@@ -1060,9 +1444,14 @@ namespace egihash
 		return impl->size;
 	}
 
-	dag_t::data_type const & dag_t::data() const
+	dag_t::data_type dag_t::data() const
+	{
+		return impl->data.view();
+	}
+
+	bool dag_t::is_mapped() const
 	{
-		return impl->data;
+		return impl->data.is_borrowed();
 	}
 
 	void dag_t::save(::std::string const & file_path, progress_callback_type callback) const
@@ -1080,7 +1469,12 @@ namespace egihash
 		EGIHASH_DEBUG("unloading DAG epoch" << impl->epoch
 			<< " size " << impl->size );
 
-		auto const i = get_dag_cache().erase(epoch());
+		size_t i = 0;
+		{
+			// the next epoch may be generated on another thread while this one is unloaded
+			std::lock_guard<std::recursive_mutex> lock(get_dag_cache_mutex());
+			i = get_dag_cache().erase(epoch());
+		}
 		if (i == 0)
 		{
 			throw hash_exception("Can not unload DAG - not loaded.");
@@ -1117,6 +1511,37 @@ namespace egihash
 		return loaded_epochs;
 	}
 
+	// construct on first use ensures safe static initialization order
+	::std::atomic<unsigned> & get_generation_threads_setting()
+	{
+		static ::std::atomic<unsigned> threads(0);
+		return threads;
+	}
+
+	void dag_t::set_generation_threads(unsigned threads) noexcept
+	{
+		get_generation_threads_setting() = threads;
+	}
+
+	unsigned dag_t::get_generation_threads() noexcept
+	{
+		unsigned const threads = get_generation_threads_setting();
+		if (threads != 0)
+		{
+			return threads;
+		}
+		return (::std::max)(1u, ::std::thread::hardware_concurrency());
+	}
+
+	void dag_t::generate_items(cache_t const & cache, node * out, uint32_t begin, uint32_t end, unsigned threads, progress_callback_type callback)
+	{
+		if (end < begin)
+		{
+			throw hash_exception("Invalid DAG item range");
+		}
+		impl_t::generate_items(cache.data(), out, begin, end, (threads != 0) ? threads : get_generation_threads(), callback);
+	}
+
 // TODO: reference code, remove me
 #if 0
 	// TODO: unit tests / validation
@@ -1187,12 +1612,15 @@ namespace egihash
 	}
 #endif // 0
 
-	// TODO: unify light & full implementation
 	namespace hashimoto
 	{
 		using mediator_get_dag_size = std::function<dag_t::size_type ()>;
-		using mediator_get_dag_item = std::function<std::vector<node> const (uint32_t index)>;
+		using mediator_get_dag_item = std::function<node const * (uint32_t index)>;
 
+		/** \brief Reference hashimoto with std::function mediators and heap allocated buffers.
+		*
+		*	Kept to validate and benchmark the templated kernel below.
+		*/
 		result_t hash(void const * input_data, dag_t::size_type input_size, mediator_get_dag_size get_dag_size, mediator_get_dag_item get_dag_item)
 		{
 			static constexpr auto w = constants::MIX_BYTES / constants::WORD_BYTES;
@@ -1211,9 +1639,8 @@ namespace egihash
 				auto p = fnv(i ^ s[0].hword, mix[i % w].hword) % full_page_count;
 				for (uint32_t j = 0; j < MIXNODES; j++)
 				{
-					auto h = get_dag_item(p * MIXNODES + j);
-					auto k = h.begin(), kEnd = h.end();
-					for (auto m = mix.begin() + j * w / 2, mEnd = mix.begin() + ( j + 1 ) * w / 2; m != mEnd && k != kEnd; m++, k++)
+					node const * k = get_dag_item(p * MIXNODES + j);
+					for (auto m = mix.begin() + j * w / 2, mEnd = mix.begin() + ( j + 1 ) * w / 2; m != mEnd; m++, k++)
 					{
 						m->hword = fnv(m->hword, k->hword);
 					}
@@ -1234,21 +1661,115 @@ namespace egihash
 			::std::memcpy(&out.mixhash.b[0], &cmix[0], ::std::min(sizeof(out.mixhash.b), cmix.size() * sizeof(node)));
 			return out;
 		}
+
+		/** \brief Lookup policy serving DAG items from a loaded DAG.
+		*/
+		struct full_lookup_t
+		{
+			data_view_t const dag;
+
+			dag_t::size_type dag_size() const noexcept
+			{
+				return dag.size_bytes();
+			}
+
+			node const * operator()(uint32_t index, node *) const noexcept
+			{
+				return dag[index];
+			}
+		};
+
+		/** \brief Lookup policy computing DAG items from the cache on demand.
+		*/
+		struct light_lookup_t
+		{
+			data_view_t const cache;
+			dag_t::size_type const full_size;
+
+			dag_t::size_type dag_size() const noexcept
+			{
+				return full_size;
+			}
+
+			node const * operator()(uint32_t index, node * scratch) const
+			{
+				dag_t::impl_t::calc_dataset_item(cache, index, scratch);
+				return scratch;
+			}
+		};
+
+		/** \brief Hashimoto kernel, all working state lives in fixed size arrays on the stack.
+		*
+		*	LookupPolicy provides dag_size() and returns DAG item rows through operator()(index, scratch),
+		*	where scratch is a row the policy may compute the item into.
+		*/
+		template <typename LookupPolicy>
+		result_t hash(void const * input_data, dag_t::size_type input_size, LookupPolicy const & lookup)
+		{
+			static constexpr uint32_t row_words = data_view_t::row_words;
+			static constexpr uint32_t w = constants::MIX_BYTES / constants::WORD_BYTES;
+			static constexpr uint32_t MIXNODES = constants::MIX_BYTES / constants::HASH_BYTES;
+			static_assert(w == (MIXNODES * row_words), "mix must consist of whole DAG items");
+
+			// s is directly followed by cmix, so both can be hashed together at the end
+			node s[row_words + (w / 4)];
+			node * const cmix = s + row_words;
+			sha3_512_row(s, input_data, input_size);
+
+			node mix[w];
+			for (uint32_t i = 0; i < MIXNODES; i++)
+			{
+				::std::memcpy(mix + (i * row_words), s, constants::HASH_BYTES);
+			}
+
+			node scratch[row_words];
+			uint32_t const full_page_count = static_cast<uint32_t>(lookup.dag_size() / constants::MIX_BYTES);
+			for (uint32_t i = 0; i < constants::ACCESSES; i++)
+			{
+				uint32_t const p = fnv(i ^ s[0].hword, mix[i % w].hword) % full_page_count;
+				for (uint32_t j = 0; j < MIXNODES; j++)
+				{
+					node const * const item = lookup((p * MIXNODES) + j, scratch);
+					node * const m = mix + (j * row_words);
+					for (uint32_t k = 0; k < row_words; k++)
+					{
+						m[k].hword = fnv(m[k].hword, item[k].hword);
+					}
+				}
+			}
+
+			for (uint32_t i = 0; i < w; i += 4)
+			{
+				cmix[i / 4].hword = fnv(fnv(fnv(mix[i].hword, mix[i+1].hword), mix[i+2].hword), mix[i+3].hword);
+			}
+
+			result_t out;
+			if (::sha3_256(&out.value.b[0], out.value.hash_size, reinterpret_cast<uint8_t const *>(s), sizeof(s)) != 0)
+			{
+				throw hash_exception("Keccak-256 computation failed.");
+			}
+			::std::memcpy(&out.mixhash.b[0], cmix, sizeof(out.mixhash.b));
+			return out;
+		}
 	}
+
 	namespace full
 	{
-
-
 		result_t hash(dag_t const & dag, void const * input_data, dag_t::size_type input_size)
 		{
-			return hashimoto::hash(input_data, input_size
-					, [&]() -> dag_t::size_type { return dag.size(); }
-					, [&](uint32_t index) -> std::vector<node> const { return dag.data()[index]; });
+			return hashimoto::hash(input_data, input_size, hashimoto::full_lookup_t{dag.data()});
 		}
+
 		result_t hash(dag_t const & dag, h256_t const & header_hash, uint64_t const nonce)
 		{
-			std::function<result_t (dag_t const &, void const *, dag_t::size_type)> hash_func = static_cast<result_t (*)(dag_t const &, void const *, dag_t::size_type)>(&hash);
-			return hash_header_nonce(hash_func, dag, header_hash, nonce);
+			return hash_header_nonce(static_cast<result_t (*)(dag_t const &, void const *, dag_t::size_type)>(&hash), dag, header_hash, nonce);
+		}
+
+		result_t hash_reference(dag_t const & dag, void const * input_data, dag_t::size_type input_size)
+		{
+			return hashimoto::hash(input_data, input_size
+					, [&]() -> dag_t::size_type { return dag.size(); }
+					, [&](uint32_t index) -> node const * { return dag.data()[index]; });
 		}
 	}
 
@@ -1257,14 +1778,20 @@ namespace egihash
 		result_t hash(cache_t const & cache, void const * input_data, cache_t::size_type input_size)
 		{
 			return hashimoto::hash(input_data, input_size
-					, [&]() -> dag_t::size_type { return dag_t::get_full_size((cache.epoch() * constants::EPOCH_LENGTH)); }
-					, [&](uint32_t index) -> std::vector<node> const { return dag_t::impl_t::calc_dataset_item(cache.data(), index); });
+					, hashimoto::light_lookup_t{cache.data(), dag_t::get_full_size(cache.epoch() * constants::EPOCH_LENGTH)});
 		}
 
 		result_t hash(cache_t const & cache, h256_t const & header_hash, uint64_t const nonce)
 		{
-			std::function<result_t (cache_t const &, void const *, cache_t::size_type)> hash_func = static_cast<result_t (*)(cache_t const &, void const *, cache_t::size_type)>(&hash);
-			return hash_header_nonce(hash_func, cache, header_hash, nonce);
+			return hash_header_nonce(static_cast<result_t (*)(cache_t const &, void const *, cache_t::size_type)>(&hash), cache, header_hash, nonce);
+		}
+
+		result_t hash_reference(cache_t const & cache, void const * input_data, cache_t::size_type input_size)
+		{
+			::std::vector<node> item(data_view_t::row_words);
+			return hashimoto::hash(input_data, input_size
+					, [&]() -> dag_t::size_type { return dag_t::get_full_size((cache.epoch() * constants::EPOCH_LENGTH)); }
+					, [&](uint32_t index) -> node const * { dag_t::impl_t::calc_dataset_item(cache.data(), index, item.data()); return item.data(); });
 		}
 	}
 
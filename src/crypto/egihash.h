@@ -127,6 +127,80 @@ namespace egihash
 	static_assert(sizeof(node) == sizeof(uint32_t), "Invalid hash node size");
 
 
+	/** \brief data_view_t is a non-owning view of contiguous cache or DAG rows.
+	*
+	*	Every row is constants::HASH_BYTES long and rows are stored back to back, either in a single aligned arena or in a file mapping.
+	*	A view stays valid for as long as the cache_t or dag_t it was obtained from.
+	*/
+	struct data_view_t
+	{
+		/** \brief size_type represents row counts and byte sizes of a view.
+		*/
+		using size_type = ::std::size_t;
+
+		/** \brief The number of hash words in one row.
+		*/
+		static constexpr size_type row_words = constants::HASH_BYTES / constants::WORD_BYTES;
+
+		/** \brief Construct an empty view.
+		*/
+		constexpr data_view_t() noexcept
+		: first(nullptr)
+		, rows(0)
+		{
+		}
+
+		/** \brief Construct a view of rows_ rows starting at first_.
+		*/
+		constexpr data_view_t(node const * first_, size_type rows_) noexcept
+		: first(first_)
+		, rows(rows_)
+		{
+		}
+
+		/** \brief Get a row of the view.
+		*
+		*	\param row is the index of the row, no bounds checking is performed.
+		*	\returns pointer to the first of row_words hash words of the row.
+		*/
+		node const * operator[](size_type row) const noexcept
+		{
+			return first + (row * row_words);
+		}
+
+		/** \brief Get the number of rows in this view.
+		*/
+		size_type size() const noexcept
+		{
+			return rows;
+		}
+
+		/** \brief Get the size of this view in bytes.
+		*/
+		size_type size_bytes() const noexcept
+		{
+			return rows * constants::HASH_BYTES;
+		}
+
+		/** \brief Test if this view has no rows.
+		*/
+		bool empty() const noexcept
+		{
+			return rows == 0;
+		}
+
+		/** \brief Get a pointer to the first hash word of the view.
+		*/
+		node const * data() const noexcept
+		{
+			return first;
+		}
+
+	private:
+		node const * first;
+		size_type rows;
+	};
+
 	/** \brief hash_exception indicates an error or cancellation when performing a task within egihash.
 	*
 	*	All functions not marked noexcept may be assumed to throw hash_exception or C++ runtime exceptions.
@@ -372,6 +446,15 @@ namespace egihash
 	*/
 	using read_function_type = ::std::function<void(void * dst, ::std::size_t count)>;
 
+	/** \brief dag_load_mode values select how a DAG file is brought into memory.
+	*/
+	enum dag_load_mode
+	{
+		dag_load_stream,		/**< dag_load_stream reads the whole DAG file into memory */
+		dag_load_mapped,		/**< dag_load_mapped memory maps the DAG file, pages are read lazily on first access */
+		dag_load_mapped_warm	/**< dag_load_mapped_warm memory maps the DAG file and pre-faults all of its pages */
+	};
+
 	/** \brief cache_t is the cache used to compute a DAG for a given epoch.
 	*
 	* Each DAG owns a cache_t and the size of the cache grows linearly in time.
@@ -382,9 +465,9 @@ namespace egihash
 		*/
 		using size_type = uint64_t;
 
-		/** \brief data_type is the underlying data store which stores a cache.
+		/** \brief data_type is a view of the contiguous rows which store a cache.
 		*/
-		using data_type = ::std::vector<::std::vector<node>>;
+		using data_type = data_view_t;
 
 		/** \brief default copy constructor.
 		*/
@@ -431,9 +514,9 @@ namespace egihash
 
 		/** \brief Get the data the cache contains.
 		*
-		*	\returns data_type const & to the actual cache data.
+		*	\returns data_type view of the actual cache data.
 		*/
-		data_type const & data() const;
+		data_type data() const;
 
 		/** \brief Get the seedhash for this cache.
 		*
@@ -519,9 +602,9 @@ namespace egihash
 		*/
 		using size_type = ::std::size_t;
 
-		/** \brief data_type is the underlying data store which stores a cache.
+		/** \brief data_type is a view of the contiguous rows which store a DAG.
 		*/
-		using data_type = ::std::vector<::std::vector<node>>;
+		using data_type = data_view_t;
 
 		/** \brief default copy constructor.
 		*/
@@ -564,6 +647,16 @@ namespace egihash
 		*/
 		dag_t(::std::string const & file_path, progress_callback_type = [](size_type, size_type, int){ return true; });
 
+		/** \brief load a DAG from a file with the given load mode.
+		*
+		*	The mapped modes serve DAG lookups straight from a read-only mapping of the file.
+		*	If the file can not be mapped, the DAG is streamed into memory instead.
+		*	\param file_path is the path to the file the DAG should be loaded from.
+		*	\param mode selects streaming, lazy mapping or mapping with warm-up.
+		*	\param callback (optional) may be used to monitor the progress of DAG loading. Return false to cancel, true to continue.
+		*/
+		dag_t(::std::string const & file_path, dag_load_mode mode, progress_callback_type = [](size_type, size_type, int){ return true; });
+
 		/** \brief Get the epoch number for which this DAG is valid.
 		*
 		*	\returns uint64_t representing the epoch number (block_number / constants::EPOCH_LENGTH)
@@ -578,9 +671,15 @@ namespace egihash
 
 		/** \brief Get the data the DAG contains.
 		*
-		*	\returns data_type const & to the actual DAG data.
+		*	\returns data_type view of the actual DAG data.
+		*/
+		data_type data() const;
+
+		/** \brief Test if the DAG data is served from a memory mapped file.
+		*
+		*	\returns true if the DAG was loaded with a mapped dag_load_mode and mapping succeeded.
 		*/
-		data_type const & data() const;
+		bool is_mapped() const;
 
 		/** \brief Save the DAG to a file fur future loading.
 		*
@@ -622,6 +721,33 @@ namespace egihash
 		*/
 		static ::std::vector<uint64_t> get_loaded();
 
+		/** \brief Set the number of worker threads used for DAG generation.
+		*
+		*	\param threads is the number of workers, 0 selects the number of hardware threads.
+		*/
+		static void set_generation_threads(unsigned threads) noexcept;
+
+		/** \brief Get the number of worker threads used for DAG generation.
+		*
+		*	\return the configured number of workers, never less than 1.
+		*/
+		static unsigned get_generation_threads() noexcept;
+
+		/** \brief Compute the DAG items [begin, end) of the epoch of a cache.
+		*
+		*	DAG items are independent of each other, so the index range is split across a pool of worker threads.
+		*	Progress of all workers is aggregated and reported from the calling thread only.
+		*	The output is byte-identical regardless of the number of threads.
+		*	\param cache is the cache for the epoch of the DAG items.
+		*	\param out must point to (end - begin) * data_view_t::row_words writable nodes.
+		*	\param begin is the index of the first DAG item to compute.
+		*	\param end is the index one past the last DAG item to compute.
+		*	\param threads is the number of workers, 0 means get_generation_threads().
+		*	\param callback (optional) may be used to monitor the progress of DAG generation. Return false to cancel, true to continue.
+		*	\throws hash_exception if cancelled.
+		*/
+		static void generate_items(cache_t const & cache, node * out, uint32_t begin, uint32_t end, unsigned threads = 0, progress_callback_type callback = [](size_type, size_type, int){ return true; });
+
 		/** \brief dag_t private implementation.
 		*/
 		struct impl_t;
@@ -669,6 +795,19 @@ namespace egihash
 		*	\return result_t containing hashed data
 		*/
 		result_t hash(dag_t const & dag, h256_t const & header_hash, uint64_t const nonce);
+
+		/** \brief Reference implementation of the full Egihash function.
+		*
+		*	Produces the same result as hash(), but looks DAG items up through std::function and
+		*	works on heap allocated buffers. It is only meant for validation and benchmarks.
+		*
+		*	\param dag A const reference to the DAG for the current epoch
+		*	\param input_data A pointer to the start of the data to be hashed
+		*	\param input_size The number of bytes of input data to hash
+		*	\throws hash_exception on error
+		*	\return result_t containing hashed data
+		*/
+		result_t hash_reference(dag_t const & dag, void const * input_data, dag_t::size_type input_size);
 	}
 
 	namespace light
@@ -707,6 +846,19 @@ namespace egihash
 		*	\return result_t containing hashed data
 		*/
 		result_t hash(cache_t const & cache, h256_t const & header_hash, uint64_t const nonce);
+
+		/** \brief Reference implementation of the light Egihash function.
+		*
+		*	Produces the same result as hash(), but looks DAG items up through std::function and
+		*	works on heap allocated buffers. It is only meant for validation and benchmarks.
+		*
+		*	\param cache A const reference to the cache for the current epoch
+		*	\param input_data A pointer to the start of the data to be hashed
+		*	\param input_size The number of bytes of input data to hash
+		*	\throws hash_exception on error
+		*	\return result_t containing hashed data
+		*/
+		result_t hash_reference(cache_t const & cache, void const * input_data, cache_t::size_type input_size);
 	}
 }
 
@@ -0,0 +1,201 @@
+// Copyright (c) 2017-2019 The QuantisNet Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "crypto/x11.h"
+#include "crypto/common.h"
+
+#include "crypto/sph_blake.h"
+#include "crypto/sph_bmw.h"
+#include "crypto/sph_groestl.h"
+#include "crypto/sph_jh.h"
+#include "crypto/sph_keccak.h"
+#include "crypto/sph_skein.h"
+#include "crypto/sph_luffa.h"
+#include "crypto/sph_cubehash.h"
+#include "crypto/sph_shavite.h"
+#include "crypto/sph_simd.h"
+#include "crypto/sph_echo.h"
+
+#include <string.h>
+
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
+#if defined(ENABLE_SSE41) && !defined(BUILD_BITCOIN_INTERNAL)
+namespace x11_sse41
+{
+void CubeHash512_4way(const unsigned char* const in[4], unsigned char* const out[4]);
+}
+#endif
+
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+namespace x11_avx2
+{
+void Blake512_4way(const unsigned char* const in[4], size_t len, unsigned char* const out[4]);
+void Bmw512_4way(const unsigned char* const in[4], unsigned char* const out[4]);
+void Skein512_4way(const unsigned char* const in[4], unsigned char* const out[4]);
+void Keccak512_4way(const unsigned char* const in[4], unsigned char* const out[4]);
+}
+#endif
+#endif
+
+// Internal implementation code.
+namespace
+{
+/** Scalar versions of the stages with a multi-lane implementation, hashing one lane after the other. */
+namespace x11_scalar
+{
+void Blake512(const unsigned char* const in[X11_LANES], size_t len, unsigned char* const out[X11_LANES])
+{
+    static const unsigned char pblank[1] = {0};
+    for (size_t i = 0; i < X11_LANES; i++) {
+        sph_blake512_context ctx;
+        sph_blake512_init(&ctx);
+        sph_blake512(&ctx, len ? in[i] : pblank, len);
+        sph_blake512_close(&ctx, out[i]);
+    }
+}
+
+#define X11_SCALAR_STAGE(Name, name) \
+void Name(const unsigned char* const in[X11_LANES], unsigned char* const out[X11_LANES]) \
+{ \
+    for (size_t i = 0; i < X11_LANES; i++) { \
+        sph_##name##_context ctx; \
+        sph_##name##_init(&ctx); \
+        sph_##name(&ctx, in[i], X11_STAGE_SIZE); \
+        sph_##name##_close(&ctx, out[i]); \
+    } \
+}
+
+X11_SCALAR_STAGE(Bmw512, bmw512)
+X11_SCALAR_STAGE(Groestl512, groestl512)
+X11_SCALAR_STAGE(Skein512, skein512)
+X11_SCALAR_STAGE(Jh512, jh512)
+X11_SCALAR_STAGE(Keccak512, keccak512)
+X11_SCALAR_STAGE(Luffa512, luffa512)
+X11_SCALAR_STAGE(CubeHash512, cubehash512)
+X11_SCALAR_STAGE(Shavite512, shavite512)
+X11_SCALAR_STAGE(Simd512, simd512)
+X11_SCALAR_STAGE(Echo512, echo512)
+
+#undef X11_SCALAR_STAGE
+} // namespace x11_scalar
+
+typedef void (*TransformLenType)(const unsigned char* const in[X11_LANES], size_t len, unsigned char* const out[X11_LANES]);
+typedef void (*TransformType)(const unsigned char* const in[X11_LANES], unsigned char* const out[X11_LANES]);
+
+TransformLenType Blake512 = x11_scalar::Blake512;
+TransformType Bmw512 = x11_scalar::Bmw512;
+TransformType Skein512 = x11_scalar::Skein512;
+TransformType Keccak512 = x11_scalar::Keccak512;
+TransformType CubeHash512 = x11_scalar::CubeHash512;
+
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
+/** Check whether the OS has enabled AVX registers. */
+bool AVXEnabled()
+{
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return (a & 6) == 6;
+}
+
+void inline cpuid(uint32_t leaf, uint32_t subleaf, uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d)
+{
+  __asm__ ("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "0"(leaf), "2"(subleaf));
+}
+#endif
+} // namespace
+
+std::string X11AutoDetect()
+{
+    std::string ret = "standard";
+#if defined(USE_ASM) && (defined(__x86_64__) || defined(__amd64__) || defined(__i386__))
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(0, 0, eax, ebx, ecx, edx);
+    uint32_t const max_leaf = eax;
+    cpuid(1, 0, eax, ebx, ecx, edx);
+    bool const have_sse41 = (ecx >> 19) & 1;
+    bool const have_xsave = ((ecx >> 27) & 1) && ((ecx >> 28) & 1);
+    bool have_avx2 = false;
+    if (max_leaf >= 7 && have_xsave && AVXEnabled()) {
+        cpuid(7, 0, eax, ebx, ecx, edx);
+        have_avx2 = (ebx >> 5) & 1;
+    }
+    (void)have_sse41;
+    (void)have_avx2;
+
+#if defined(ENABLE_SSE41) && !defined(BUILD_BITCOIN_INTERNAL)
+    if (have_sse41) {
+        CubeHash512 = x11_sse41::CubeHash512_4way;
+        ret = "sse4.1(4way cubehash)";
+    }
+#endif
+
+#if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
+    if (have_avx2) {
+        Blake512 = x11_avx2::Blake512_4way;
+        Bmw512 = x11_avx2::Bmw512_4way;
+        Skein512 = x11_avx2::Skein512_4way;
+        Keccak512 = x11_avx2::Keccak512_4way;
+        ret += ",avx2(4way blake,bmw,skein,keccak)";
+    }
+#endif
+#endif
+    return ret;
+}
+
+void X11Blake512_4Way(const unsigned char* const in[X11_LANES], size_t len, unsigned char* const out[X11_LANES])
+{
+    Blake512(in, len, out);
+}
+
+void X11Bmw512_4Way(const unsigned char* const in[X11_LANES], unsigned char* const out[X11_LANES])
+{
+    Bmw512(in, out);
+}
+
+void X11Skein512_4Way(const unsigned char* const in[X11_LANES], unsigned char* const out[X11_LANES])
+{
+    Skein512(in, out);
+}
+
+void X11Keccak512_4Way(const unsigned char* const in[X11_LANES], unsigned char* const out[X11_LANES])
+{
+    Keccak512(in, out);
+}
+
+void X11CubeHash512_4Way(const unsigned char* const in[X11_LANES], unsigned char* const out[X11_LANES])
+{
+    CubeHash512(in, out);
+}
+
+void X11Hash4Way(const unsigned char* const in[X11_LANES], size_t len, unsigned char* const out[X11_LANES])
+{
+    // every stage reads one buffer and writes the other
+    unsigned char buf[2][X11_LANES][X11_STAGE_SIZE];
+    const unsigned char* a[X11_LANES];
+    unsigned char* b[X11_LANES];
+    const unsigned char* ra[X11_LANES];
+    unsigned char* wa[X11_LANES];
+    for (size_t i = 0; i < X11_LANES; i++) {
+        a[i] = buf[0][i];
+        wa[i] = buf[0][i];
+        b[i] = buf[1][i];
+        ra[i] = buf[1][i];
+    }
+
+    Blake512(in, len, wa);
+    Bmw512(a, b);
+    x11_scalar::Groestl512(ra, wa);
+    Skein512(a, b);
+    x11_scalar::Jh512(ra, wa);
+    Keccak512(a, b);
+    x11_scalar::Luffa512(ra, wa);
+    CubeHash512(a, b);
+    x11_scalar::Shavite512(ra, wa);
+    x11_scalar::Simd512(a, b);
+    x11_scalar::Echo512(ra, wa);
+
+    for (size_t i = 0; i < X11_LANES; i++) {
+        memcpy(out[i], buf[0][i], 32);
+    }
+}
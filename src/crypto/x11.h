@@ -0,0 +1,43 @@
+// Copyright (c) 2017-2019 The QuantisNet Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef QUANTISNET_CRYPTO_X11_H
+#define QUANTISNET_CRYPTO_X11_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+
+/** Number of messages hashed together by the multi-lane X11 functions. */
+static const size_t X11_LANES = 4;
+
+/** Size in bytes of the intermediate hash passed between X11 stages. */
+static const size_t X11_STAGE_SIZE = 64;
+
+/** Autodetect the multi-lane X11 stages supported by this CPU, returns a description of the choice. */
+std::string X11AutoDetect();
+
+/** Compute the X11 hash of X11_LANES messages of the same length.
+ *
+ * The result is identical to hashing each message with HashX11. The blake, bmw, skein, keccak
+ * and cubehash stages process all lanes at once when the CPU supports it, the other stages
+ * run once per lane.
+ *
+ * @param[in]  in  X11_LANES pointers to len bytes each
+ * @param[in]  len length of every message
+ * @param[out] out X11_LANES pointers to 32 bytes each
+ */
+void X11Hash4Way(const unsigned char* const in[X11_LANES], size_t len, unsigned char* const out[X11_LANES]);
+
+/** Single X11 stages over X11_LANES messages, exposed for benchmarks.
+ *  Blake takes messages of any length, the other stages take X11_STAGE_SIZE bytes as used within X11.
+ *  All of them write X11_STAGE_SIZE bytes per lane.
+ */
+void X11Blake512_4Way(const unsigned char* const in[X11_LANES], size_t len, unsigned char* const out[X11_LANES]);
+void X11Bmw512_4Way(const unsigned char* const in[X11_LANES], unsigned char* const out[X11_LANES]);
+void X11Skein512_4Way(const unsigned char* const in[X11_LANES], unsigned char* const out[X11_LANES]);
+void X11Keccak512_4Way(const unsigned char* const in[X11_LANES], unsigned char* const out[X11_LANES]);
+void X11CubeHash512_4Way(const unsigned char* const in[X11_LANES], unsigned char* const out[X11_LANES]);
+
+#endif // QUANTISNET_CRYPTO_X11_H
@@ -0,0 +1,379 @@
+// Copyright (c) 2017-2019 The QuantisNet Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+//
+// 4-way AVX2 implementations of the X11 stages working on 64-bit words.
+// Every __m256i holds the same state word of 4 independent messages.
+
+#ifdef ENABLE_AVX2
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+
+#include "crypto/common.h"
+
+namespace x11_avx2 {
+namespace {
+
+typedef __m256i V;
+
+inline V K(uint64_t x) { return _mm256_set1_epi64x(x); }
+inline V Add(V a, V b) { return _mm256_add_epi64(a, b); }
+inline V Sub(V a, V b) { return _mm256_sub_epi64(a, b); }
+inline V Xor(V a, V b) { return _mm256_xor_si256(a, b); }
+inline V AndNot(V a, V b) { return _mm256_andnot_si256(a, b); }
+inline V Shl(V x, int n) { return _mm256_slli_epi64(x, n); }
+inline V Shr(V x, int n) { return _mm256_srli_epi64(x, n); }
+inline V Rotl(V x, int n) { return _mm256_or_si256(Shl(x, n), Shr(x, 64 - n)); }
+inline V Rotr(V x, int n) { return Rotl(x, 64 - n); }
+
+inline V LoadLE(const unsigned char* const in[4], size_t pos)
+{
+    return _mm256_set_epi64x(ReadLE64(in[3] + pos), ReadLE64(in[2] + pos), ReadLE64(in[1] + pos), ReadLE64(in[0] + pos));
+}
+
+inline V LoadBE(const unsigned char* const in[4], size_t pos)
+{
+    return _mm256_set_epi64x(ReadBE64(in[3] + pos), ReadBE64(in[2] + pos), ReadBE64(in[1] + pos), ReadBE64(in[0] + pos));
+}
+
+inline void StoreLE(unsigned char* const out[4], size_t pos, V x)
+{
+    alignas(32) uint64_t w[4];
+    _mm256_store_si256((V*)w, x);
+    for (int i = 0; i < 4; i++) WriteLE64(out[i] + pos, w[i]);
+}
+
+inline void StoreBE(unsigned char* const out[4], size_t pos, V x)
+{
+    alignas(32) uint64_t w[4];
+    _mm256_store_si256((V*)w, x);
+    for (int i = 0; i < 4; i++) WriteBE64(out[i] + pos, w[i]);
+}
+
+/* ---------- BLAKE-512 ---------- */
+
+const uint64_t BLAKE_IV[8] = {
+    0x6A09E667F3BCC908ULL, 0xBB67AE8584CAA73BULL, 0x3C6EF372FE94F82BULL, 0xA54FF53A5F1D36F1ULL,
+    0x510E527FADE682D1ULL, 0x9B05688C2B3E6C1FULL, 0x1F83D9ABFB41BD6BULL, 0x5BE0CD19137E2179ULL
+};
+
+const uint64_t BLAKE_CB[16] = {
+    0x243F6A8885A308D3ULL, 0x13198A2E03707344ULL, 0xA4093822299F31D0ULL, 0x082EFA98EC4E6C89ULL,
+    0x452821E638D01377ULL, 0xBE5466CF34E90C6CULL, 0xC0AC29B7C97C50DDULL, 0x3F84D5B5B5470917ULL,
+    0x9216D5D98979FB1BULL, 0xD1310BA698DFB5ACULL, 0x2FFD72DBD01ADFB7ULL, 0xB8E1AFED6A267E96ULL,
+    0xBA7C9045F12C7F99ULL, 0x24A19947B3916CF7ULL, 0x0801F2E2858EFC16ULL, 0x636920D871574E69ULL
+};
+
+const uint8_t BLAKE_SIGMA[10][16] = {
+    {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+    { 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 },
+    { 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 },
+    {  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 },
+    {  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 },
+    {  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 },
+    { 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 },
+    { 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 },
+    {  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 },
+    { 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 }
+};
+
+inline void BlakeG(const V* m, const uint8_t* s, int i, V& a, V& b, V& c, V& d)
+{
+    a = Add(Add(a, b), Xor(m[s[2 * i]], K(BLAKE_CB[s[2 * i + 1]])));
+    d = Rotr(Xor(d, a), 32);
+    c = Add(c, d);
+    b = Rotr(Xor(b, c), 25);
+    a = Add(Add(a, b), Xor(m[s[2 * i + 1]], K(BLAKE_CB[s[2 * i]])));
+    d = Rotr(Xor(d, a), 16);
+    c = Add(c, d);
+    b = Rotr(Xor(b, c), 11);
+}
+
+void BlakeCompress(V h[8], const V m[16], uint64_t t0)
+{
+    V v[16];
+    for (int i = 0; i < 8; i++) v[i] = h[i];
+    for (int i = 0; i < 4; i++) v[8 + i] = K(BLAKE_CB[i]);
+    v[12] = K(t0 ^ BLAKE_CB[4]);
+    v[13] = K(t0 ^ BLAKE_CB[5]);
+    v[14] = K(BLAKE_CB[6]);
+    v[15] = K(BLAKE_CB[7]);
+    for (int r = 0; r < 16; r++) {
+        const uint8_t* s = BLAKE_SIGMA[r % 10];
+        BlakeG(m, s, 0, v[0], v[4], v[ 8], v[12]);
+        BlakeG(m, s, 1, v[1], v[5], v[ 9], v[13]);
+        BlakeG(m, s, 2, v[2], v[6], v[10], v[14]);
+        BlakeG(m, s, 3, v[3], v[7], v[11], v[15]);
+        BlakeG(m, s, 4, v[0], v[5], v[10], v[15]);
+        BlakeG(m, s, 5, v[1], v[6], v[11], v[12]);
+        BlakeG(m, s, 6, v[2], v[7], v[ 8], v[13]);
+        BlakeG(m, s, 7, v[3], v[4], v[ 9], v[14]);
+    }
+    for (int i = 0; i < 8; i++) h[i] = Xor(h[i], Xor(v[i], v[8 + i]));
+}
+
+/* ---------- BMW-512 ---------- */
+
+const uint64_t BMW_IV[16] = {
+    0x8081828384858687ULL, 0x88898A8B8C8D8E8FULL, 0x9091929394959697ULL, 0x98999A9B9C9D9E9FULL,
+    0xA0A1A2A3A4A5A6A7ULL, 0xA8A9AAABACADAEAFULL, 0xB0B1B2B3B4B5B6B7ULL, 0xB8B9BABBBCBDBEBFULL,
+    0xC0C1C2C3C4C5C6C7ULL, 0xC8C9CACBCCCDCECFULL, 0xD0D1D2D3D4D5D6D7ULL, 0xD8D9DADBDCDDDEDFULL,
+    0xE0E1E2E3E4E5E6E7ULL, 0xE8E9EAEBECEDEEEFULL, 0xF0F1F2F3F4F5F6F7ULL, 0xF8F9FAFBFCFDFEFFULL
+};
+
+// Indices and signs (bit i set = subtract term i + 1) of the five terms of each W word
+const uint8_t BMW_W[16][6] = {
+    {  5,  7, 10, 13, 14, 0x1 }, {  6,  8, 11, 14, 15, 0x9 }, {  0,  7,  9, 12, 15, 0x4 }, {  0,  1,  8, 10, 13, 0x5 },
+    {  1,  2,  9, 11, 14, 0xc }, {  3,  2, 10, 12, 15, 0x5 }, {  4,  0,  3, 11, 13, 0x7 }, {  1,  4,  5, 12, 14, 0xf },
+    {  2,  5,  6, 13, 15, 0xb }, {  0,  3,  6,  7, 14, 0x5 }, {  8,  1,  4,  7, 15, 0x7 }, {  8,  0,  2,  5,  9, 0x7 },
+    {  1,  3,  6,  9, 10, 0x6 }, {  2,  4,  7, 10, 11, 0x0 }, {  3,  5,  8, 11, 12, 0xd }, { 12,  4,  6,  9, 13, 0x7 }
+};
+
+inline V BmwS(int i, V x)
+{
+    switch (i) {
+        case 0: return Xor(Xor(Shr(x, 1), Shl(x, 3)), Xor(Rotl(x, 4), Rotl(x, 37)));
+        case 1: return Xor(Xor(Shr(x, 1), Shl(x, 2)), Xor(Rotl(x, 13), Rotl(x, 43)));
+        case 2: return Xor(Xor(Shr(x, 2), Shl(x, 1)), Xor(Rotl(x, 19), Rotl(x, 53)));
+        case 3: return Xor(Xor(Shr(x, 2), Shl(x, 2)), Xor(Rotl(x, 28), Rotl(x, 59)));
+        case 4: return Xor(Shr(x, 1), x);
+        default: return Xor(Shr(x, 2), x);
+    }
+}
+
+void BmwCompress(const V m[16], const V h[16], V dh[16])
+{
+    static const int rb[7] = { 5, 11, 27, 32, 37, 43, 53 };
+    V q[32];
+
+    for (int i = 0; i < 16; i++) {
+        const uint8_t* w = BMW_W[i];
+        V acc = Xor(m[w[0]], h[w[0]]);
+        for (int j = 1; j < 5; j++) {
+            V t = Xor(m[w[j]], h[w[j]]);
+            acc = (w[5] >> (j - 1)) & 1 ? Sub(acc, t) : Add(acc, t);
+        }
+        q[i] = Add(BmwS(i % 5, acc), h[(i + 1) & 15]);
+    }
+
+    for (int i = 16; i < 32; i++) {
+        int j = i - 16;
+        V elt = Xor(Add(Sub(Add(Rotl(m[j & 15], (j & 15) + 1), Rotl(m[(j + 3) & 15], ((j + 3) & 15) + 1)),
+                            Rotl(m[(j + 10) & 15], ((j + 10) & 15) + 1)),
+                        K((uint64_t)i * 0x0555555555555555ULL)),
+                    h[(j + 7) & 15]);
+        V acc = elt;
+        if (i < 18) {
+            for (int k = 0; k < 16; k++) acc = Add(acc, BmwS((k + 1) & 3, q[j + k]));
+        } else {
+            for (int k = 0; k < 14; k += 2) acc = Add(acc, Add(q[j + k], Rotl(q[j + k + 1], rb[k / 2])));
+            acc = Add(acc, Add(BmwS(4, q[j + 14]), BmwS(5, q[j + 15])));
+        }
+        q[i] = acc;
+    }
+
+    V xl = q[16];
+    for (int i = 17; i < 24; i++) xl = Xor(xl, q[i]);
+    V xh = xl;
+    for (int i = 24; i < 32; i++) xh = Xor(xh, q[i]);
+
+    dh[0] = Add(Xor(Xor(Shl(xh, 5), Shr(q[16], 5)), m[0]), Xor(Xor(xl, q[24]), q[0]));
+    dh[1] = Add(Xor(Xor(Shr(xh, 7), Shl(q[17], 8)), m[1]), Xor(Xor(xl, q[25]), q[1]));
+    dh[2] = Add(Xor(Xor(Shr(xh, 5), Shl(q[18], 5)), m[2]), Xor(Xor(xl, q[26]), q[2]));
+    dh[3] = Add(Xor(Xor(Shr(xh, 1), Shl(q[19], 5)), m[3]), Xor(Xor(xl, q[27]), q[3]));
+    dh[4] = Add(Xor(Xor(Shr(xh, 3), q[20]), m[4]), Xor(Xor(xl, q[28]), q[4]));
+    dh[5] = Add(Xor(Xor(Shl(xh, 6), Shr(q[21], 6)), m[5]), Xor(Xor(xl, q[29]), q[5]));
+    dh[6] = Add(Xor(Xor(Shr(xh, 4), Shl(q[22], 6)), m[6]), Xor(Xor(xl, q[30]), q[6]));
+    dh[7] = Add(Xor(Xor(Shr(xh, 11), Shl(q[23], 2)), m[7]), Xor(Xor(xl, q[31]), q[7]));
+    dh[8] = Add(Add(Rotl(dh[4], 9), Xor(Xor(xh, q[24]), m[8])), Xor(Xor(Shl(xl, 8), q[23]), q[8]));
+    dh[9] = Add(Add(Rotl(dh[5], 10), Xor(Xor(xh, q[25]), m[9])), Xor(Xor(Shr(xl, 6), q[16]), q[9]));
+    dh[10] = Add(Add(Rotl(dh[6], 11), Xor(Xor(xh, q[26]), m[10])), Xor(Xor(Shl(xl, 6), q[17]), q[10]));
+    dh[11] = Add(Add(Rotl(dh[7], 12), Xor(Xor(xh, q[27]), m[11])), Xor(Xor(Shl(xl, 4), q[18]), q[11]));
+    dh[12] = Add(Add(Rotl(dh[0], 13), Xor(Xor(xh, q[28]), m[12])), Xor(Xor(Shr(xl, 3), q[19]), q[12]));
+    dh[13] = Add(Add(Rotl(dh[1], 14), Xor(Xor(xh, q[29]), m[13])), Xor(Xor(Shr(xl, 4), q[20]), q[13]));
+    dh[14] = Add(Add(Rotl(dh[2], 15), Xor(Xor(xh, q[30]), m[14])), Xor(Xor(Shr(xl, 7), q[21]), q[14]));
+    dh[15] = Add(Add(Rotl(dh[3], 16), Xor(Xor(xh, q[31]), m[15])), Xor(Xor(Shr(xl, 2), q[22]), q[15]));
+}
+
+/* ---------- Skein-512 ---------- */
+
+const uint64_t SKEIN_IV[8] = {
+    0x4903ADFF749C51CEULL, 0x0D95DE399746DF03ULL, 0x8FD1934127C79BCEULL, 0x9A255629FF352CB1ULL,
+    0x5DB62599DF6CA7B0ULL, 0xEABE394CA9D5C3F4ULL, 0x991112C71A75B523ULL, 0xAE18A40B660FCC33ULL
+};
+
+#define SKEIN_MIX(a, b, rc) do { p[a] = Add(p[a], p[b]); p[b] = Xor(Rotl(p[b], rc), p[a]); } while (0)
+
+#define SKEIN_ROUNDS(r0, r1, r2, r3, r4, r5, r6, r7, r8, r9, r10, r11, r12, r13, r14, r15) do { \
+        SKEIN_MIX(0, 1, r0);  SKEIN_MIX(2, 3, r1);  SKEIN_MIX(4, 5, r2);  SKEIN_MIX(6, 7, r3);  \
+        SKEIN_MIX(2, 1, r4);  SKEIN_MIX(4, 7, r5);  SKEIN_MIX(6, 5, r6);  SKEIN_MIX(0, 3, r7);  \
+        SKEIN_MIX(4, 1, r8);  SKEIN_MIX(6, 3, r9);  SKEIN_MIX(0, 5, r10); SKEIN_MIX(2, 7, r11); \
+        SKEIN_MIX(6, 1, r12); SKEIN_MIX(0, 7, r13); SKEIN_MIX(2, 5, r14); SKEIN_MIX(4, 3, r15); \
+    } while (0)
+
+/** One UBI block: h = Threefish_h(m) ^ m with tweak (t0, t1) */
+void SkeinUbi(V h[8], const V m[8], uint64_t t0, uint64_t t1)
+{
+    V k[9];
+    V p[8];
+    V h8 = K(0x1BD11BDAA9FC1A22ULL);
+    for (int i = 0; i < 8; i++) {
+        k[i] = h[i];
+        h8 = Xor(h8, h[i]);
+        p[i] = m[i];
+    }
+    k[8] = h8;
+    const uint64_t t[3] = { t0, t1, t0 ^ t1 };
+
+    for (int s = 0; s <= 18; s++) {
+        for (int i = 0; i < 8; i++) p[i] = Add(p[i], k[(s + i) % 9]);
+        p[5] = Add(p[5], K(t[s % 3]));
+        p[6] = Add(p[6], K(t[(s + 1) % 3]));
+        p[7] = Add(p[7], K((uint64_t)s));
+        if (s == 18) break;
+        if (s & 1) {
+            SKEIN_ROUNDS(39, 30, 34, 24, 13, 50, 10, 17, 25, 29, 39, 43, 8, 35, 56, 22);
+        } else {
+            SKEIN_ROUNDS(46, 36, 19, 37, 33, 27, 14, 42, 17, 49, 36, 39, 44, 9, 54, 56);
+        }
+    }
+    for (int i = 0; i < 8; i++) h[i] = Xor(m[i], p[i]);
+}
+
+#undef SKEIN_ROUNDS
+#undef SKEIN_MIX
+
+/* ---------- Keccak-512 ---------- */
+
+const uint64_t KECCAK_RC[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808AULL, 0x8000000080008000ULL,
+    0x000000000000808BULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+    0x000000000000008AULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000AULL,
+    0x000000008000808BULL, 0x800000000000008BULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+    0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800AULL, 0x800000008000000AULL,
+    0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+
+#define KECCAK_RHOPI(src, x, rc, dst) b[dst] = Rotl(Xor(a[src], d[x]), rc)
+#define KECCAK_CHI(y) do { \
+        a[y + 0] = Xor(b[y + 0], AndNot(b[y + 1], b[y + 2])); \
+        a[y + 1] = Xor(b[y + 1], AndNot(b[y + 2], b[y + 3])); \
+        a[y + 2] = Xor(b[y + 2], AndNot(b[y + 3], b[y + 4])); \
+        a[y + 3] = Xor(b[y + 3], AndNot(b[y + 4], b[y + 0])); \
+        a[y + 4] = Xor(b[y + 4], AndNot(b[y + 0], b[y + 1])); \
+    } while (0)
+
+void KeccakF(V a[25])
+{
+    V b[25], c[5], d[5];
+    for (int round = 0; round < 24; round++) {
+        for (int x = 0; x < 5; x++) c[x] = Xor(Xor(Xor(a[x], a[x + 5]), Xor(a[x + 10], a[x + 15])), a[x + 20]);
+        d[0] = Xor(c[4], Rotl(c[1], 1));
+        d[1] = Xor(c[0], Rotl(c[2], 1));
+        d[2] = Xor(c[1], Rotl(c[3], 1));
+        d[3] = Xor(c[2], Rotl(c[4], 1));
+        d[4] = Xor(c[3], Rotl(c[0], 1));
+
+        b[0] = Xor(a[0], d[0]);
+        KECCAK_RHOPI( 1, 1,  1, 10); KECCAK_RHOPI( 2, 2, 62, 20); KECCAK_RHOPI( 3, 3, 28,  5); KECCAK_RHOPI( 4, 4, 27, 15);
+        KECCAK_RHOPI( 5, 0, 36, 16); KECCAK_RHOPI( 6, 1, 44,  1); KECCAK_RHOPI( 7, 2,  6, 11); KECCAK_RHOPI( 8, 3, 55, 21);
+        KECCAK_RHOPI( 9, 4, 20,  6); KECCAK_RHOPI(10, 0,  3,  7); KECCAK_RHOPI(11, 1, 10, 17); KECCAK_RHOPI(12, 2, 43,  2);
+        KECCAK_RHOPI(13, 3, 25, 12); KECCAK_RHOPI(14, 4, 39, 22); KECCAK_RHOPI(15, 0, 41, 23); KECCAK_RHOPI(16, 1, 45,  8);
+        KECCAK_RHOPI(17, 2, 15, 18); KECCAK_RHOPI(18, 3, 21,  3); KECCAK_RHOPI(19, 4,  8, 13); KECCAK_RHOPI(20, 0, 18, 14);
+        KECCAK_RHOPI(21, 1,  2, 24); KECCAK_RHOPI(22, 2, 61,  9); KECCAK_RHOPI(23, 3, 56, 19); KECCAK_RHOPI(24, 4, 14,  4);
+
+        KECCAK_CHI(0);
+        KECCAK_CHI(5);
+        KECCAK_CHI(10);
+        KECCAK_CHI(15);
+        KECCAK_CHI(20);
+        a[0] = Xor(a[0], K(KECCAK_RC[round]));
+    }
+}
+
+#undef KECCAK_CHI
+#undef KECCAK_RHOPI
+
+} // namespace
+
+void Blake512_4way(const unsigned char* const in[4], size_t len, unsigned char* const out[4])
+{
+    V h[8];
+    for (int i = 0; i < 8; i++) h[i] = K(BLAKE_IV[i]);
+
+    // the last block takes 0x80, the 0x01 marker and the 128-bit bit length, which may not fit
+    size_t const blocks = len / 128 + ((len % 128) <= 111 ? 1 : 2);
+    for (size_t b = 0; b < blocks; b++) {
+        size_t const pos = b * 128;
+        V m[16];
+        if (pos + 128 <= len) {
+            for (int i = 0; i < 16; i++) m[i] = LoadBE(in, pos + 8 * i);
+        } else {
+            unsigned char block[4][128];
+            const unsigned char* pblock[4] = { block[0], block[1], block[2], block[3] };
+            for (int l = 0; l < 4; l++) {
+                memset(block[l], 0, 128);
+                if (pos < len) memcpy(block[l], in[l] + pos, len - pos);
+                if (pos <= len) block[l][len - pos] = 0x80;
+                if (b == blocks - 1) {
+                    block[l][111] |= 0x01;
+                    WriteBE64(block[l] + 120, (uint64_t)len << 3);
+                }
+            }
+            for (int i = 0; i < 16; i++) m[i] = LoadBE(pblock, 8 * i);
+        }
+        // the counter holds the message bits up to this block, 0 for a block of padding only
+        uint64_t const t0 = pos < len ? (uint64_t)(len < pos + 128 ? len : pos + 128) << 3 : 0;
+        BlakeCompress(h, m, t0);
+    }
+
+    for (int i = 0; i < 8; i++) StoreBE(out, 8 * i, h[i]);
+}
+
+void Bmw512_4way(const unsigned char* const in[4], unsigned char* const out[4])
+{
+    V m[16], h[16], dh[16];
+    for (int i = 0; i < 8; i++) m[i] = LoadLE(in, 8 * i);
+    m[8] = K(0x80);
+    for (int i = 9; i < 15; i++) m[i] = K(0);
+    m[15] = K(512);
+    for (int i = 0; i < 16; i++) h[i] = K(BMW_IV[i]);
+    BmwCompress(m, h, dh);
+
+    // final compression of the chaining value under the constant 0xaaaaaaaaaaaaaaa0 + i
+    for (int i = 0; i < 16; i++) h[i] = K(0xaaaaaaaaaaaaaaa0ULL + i);
+    BmwCompress(dh, h, m);
+    for (int i = 0; i < 8; i++) StoreLE(out, 8 * i, m[8 + i]);
+}
+
+void Skein512_4way(const unsigned char* const in[4], unsigned char* const out[4])
+{
+    V h[8], m[8];
+    for (int i = 0; i < 8; i++) {
+        h[i] = K(SKEIN_IV[i]);
+        m[i] = LoadLE(in, 8 * i);
+    }
+    // message block: first and final, 64 bytes; then the output block: first and final, 8 bytes
+    SkeinUbi(h, m, 64, (uint64_t)480 << 55);
+    for (int i = 0; i < 8; i++) m[i] = K(0);
+    SkeinUbi(h, m, 8, (uint64_t)510 << 55);
+    for (int i = 0; i < 8; i++) StoreLE(out, 8 * i, h[i]);
+}
+
+void Keccak512_4way(const unsigned char* const in[4], unsigned char* const out[4])
+{
+    V a[25];
+    for (int i = 0; i < 8; i++) a[i] = LoadLE(in, 8 * i);
+    // 64 bytes fit into the 72 byte rate, followed by the 0x01 ... 0x80 padding
+    a[8] = K(0x8000000000000001ULL);
+    for (int i = 9; i < 25; i++) a[i] = K(0);
+    KeccakF(a);
+    for (int i = 0; i < 8; i++) StoreLE(out, 8 * i, a[i]);
+}
+
+} // namespace x11_avx2
+
+#endif
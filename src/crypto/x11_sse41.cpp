@@ -0,0 +1,99 @@
+// Copyright (c) 2017-2019 The QuantisNet Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+//
+// 4-way SSE4.1 implementation of the CubeHash X11 stage working on 32-bit words.
+// Every __m128i holds the same state word of 4 independent messages.
+
+#ifdef ENABLE_SSE41
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+
+#include "crypto/common.h"
+
+namespace x11_sse41 {
+namespace {
+
+typedef __m128i V;
+
+inline V Add(V a, V b) { return _mm_add_epi32(a, b); }
+inline V Xor(V a, V b) { return _mm_xor_si128(a, b); }
+template <int n> inline V Rotl(V x) { return _mm_or_si128(_mm_slli_epi32(x, n), _mm_srli_epi32(x, 32 - n)); }
+
+inline V LoadLE(const unsigned char* const in[4], size_t pos)
+{
+    return _mm_set_epi32(ReadLE32(in[3] + pos), ReadLE32(in[2] + pos), ReadLE32(in[1] + pos), ReadLE32(in[0] + pos));
+}
+
+inline void StoreLE(unsigned char* const out[4], size_t pos, V x)
+{
+    WriteLE32(out[0] + pos, _mm_extract_epi32(x, 0));
+    WriteLE32(out[1] + pos, _mm_extract_epi32(x, 1));
+    WriteLE32(out[2] + pos, _mm_extract_epi32(x, 2));
+    WriteLE32(out[3] + pos, _mm_extract_epi32(x, 3));
+}
+
+const uint32_t CUBEHASH_IV[32] = {
+    0x2AEA2A61, 0x50F494D4, 0x2D538B8B, 0x4167D83E, 0x3FEE2313, 0xC701CF8C, 0xCC39968E, 0x50AC5695,
+    0x4D42C787, 0xA647A8B3, 0x97CF0BEF, 0x825B4537, 0xEEF864D2, 0xF22090C4, 0xD0E5CD33, 0xA23911AE,
+    0xFCD398D9, 0x148FE485, 0x1B017BEF, 0xB6444532, 0x6A536159, 0x2FF5781C, 0x91FA7934, 0x0DBADEA9,
+    0xD65C8A2B, 0xA5A70E75, 0xB1C62456, 0xBC796576, 0x1921C8F7, 0xE7989AF1, 0x7795D246, 0xD43E3B44
+};
+
+#define CUBEHASH_FOR16(S) S(0) S(1) S(2) S(3) S(4) S(5) S(6) S(7) S(8) S(9) S(10) S(11) S(12) S(13) S(14) S(15)
+#define CUBEHASH_ADD_ROTL7(i) x[16 + (i ^ B)] = Add(x[16 + (i ^ B)], x[i ^ A]); x[i ^ A] = Rotl<7>(x[i ^ A]);
+#define CUBEHASH_XOR1(i) x[i ^ A ^ 8] = Xor(x[i ^ A ^ 8], x[16 + (i ^ B)]);
+#define CUBEHASH_ADD_ROTL11(i) x[16 + (i ^ B ^ 2)] = Add(x[16 + (i ^ B ^ 2)], x[i ^ A ^ 8]); x[i ^ A ^ 8] = Rotl<11>(x[i ^ A ^ 8]);
+#define CUBEHASH_XOR2(i) x[i ^ A ^ 12] = Xor(x[i ^ A ^ 12], x[16 + (i ^ B ^ 2)]);
+
+/** One round, with the swaps of the previous rounds folded into the index masks A (x[0..15]) and B (x[16..31]). */
+template <int A, int B>
+inline void Round(V x[32])
+{
+    CUBEHASH_FOR16(CUBEHASH_ADD_ROTL7)
+    CUBEHASH_FOR16(CUBEHASH_XOR1)
+    CUBEHASH_FOR16(CUBEHASH_ADD_ROTL11)
+    CUBEHASH_FOR16(CUBEHASH_XOR2)
+}
+
+#undef CUBEHASH_XOR2
+#undef CUBEHASH_ADD_ROTL11
+#undef CUBEHASH_XOR1
+#undef CUBEHASH_ADD_ROTL7
+#undef CUBEHASH_FOR16
+
+/** Two rounds leave every word at its original position. */
+void Rounds(V x[32], int n)
+{
+    for (int r = 0; r < n; r += 2) {
+        Round<0, 0>(x);
+        Round<12, 3>(x);
+    }
+}
+
+} // namespace
+
+void CubeHash512_4way(const unsigned char* const in[4], unsigned char* const out[4])
+{
+    V x[32];
+    for (int i = 0; i < 32; i++) x[i] = _mm_set1_epi32(CUBEHASH_IV[i]);
+
+    // two 32-byte message blocks followed by a block of padding only
+    for (int b = 0; b < 2; b++) {
+        for (int i = 0; i < 8; i++) x[i] = Xor(x[i], LoadLE(in, 32 * b + 4 * i));
+        Rounds(x, 16);
+    }
+    x[0] = Xor(x[0], _mm_set1_epi32(0x80));
+    Rounds(x, 16);
+
+    x[31] = Xor(x[31], _mm_set1_epi32(1));
+    Rounds(x, 160);
+    for (int i = 0; i < 16; i++) StoreLE(out, 4 * i, x[i]);
+}
+
+} // namespace x11_sse41
+
+#endif
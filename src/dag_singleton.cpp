@@ -5,37 +5,230 @@
 
 #include "dag_singleton.h"
 
+#include "chain.h"
+#include "utiltime.h"
+
 #include "boost_workaround.hpp"
+#include <boost/bind.hpp>
 #include <boost/thread/locks.hpp>
 #include <boost/thread/mutex.hpp>
 //#include <mutex>
 
-std::unique_ptr<egihash::dag_t> const & ActiveDAG(std::unique_ptr<egihash::dag_t> next_dag)
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+CDAGManager dagManager;
+
+std::shared_ptr<egihash::dag_t> ActiveDAG(std::shared_ptr<egihash::dag_t> next_dag)
 {
     using namespace std;
 
     static boost::mutex m;
-    boost::lock_guard<boost::mutex> lock(m);
-    static unique_ptr<egihash::dag_t> active; // only keep one DAG in memory at once
+    static shared_ptr<egihash::dag_t> active; // only keep one DAG in memory at once
+
+    // only the swap happens under the lock, unloading the previous DAG can take a while
+    shared_ptr<egihash::dag_t> previous;
+    shared_ptr<egihash::dag_t> result;
+    {
+        boost::lock_guard<boost::mutex> lock(m);
+        if (next_dag)
+        {
+            previous = active;
+            active = next_dag;
+        }
+        result = active;
+    }
 
-    // if we have a next_dag swap it
     if (next_dag)
     {
-        auto const previous_epoch = active ? active->epoch() : 0;
+        auto const previous_epoch = previous ? previous->epoch() : 0;
         auto const new_epoch = next_dag->epoch();
-        active.swap(next_dag);
         if (new_epoch != previous_epoch) LogPrint("nrghash", "DAG swapped to new epoch (%d->%d)\n", previous_epoch, new_epoch);
         else LogPrint("nrghash", "DAG activated for epoch %d\n", new_epoch);
+
+        // unload the previous dag, it is freed once the last caller holding it lets go
+        if (previous && new_epoch != previous_epoch)
+        {
+            try {
+                previous->unload();
+                LogPrint("nrghash", "DAG for epoch %d unloaded\n", previous_epoch);
+            } catch (const egihash::hash_exception& e) {
+                LogPrint("nrghash", "DAG for epoch %d not unloaded: %s\n", previous_epoch, e.what());
+            }
+            previous.reset();
+        }
     }
 
-    // unload the previous dag
-    if (next_dag)
+    return result;
+}
+
+// Give the memory of a DAG that never became active back, reset() alone would leave it in the egihash cache
+static void UnloadDAG(std::shared_ptr<egihash::dag_t>& dag)
+{
+    if (!dag) return;
+    auto const epoch = dag->epoch();
+    try {
+        dag->unload();
+        LogPrint("nrghash", "DAG for epoch %d unloaded\n", epoch);
+    } catch (const egihash::hash_exception& e) {
+        LogPrint("nrghash", "DAG for epoch %d not unloaded: %s\n", epoch, e.what());
+    }
+    dag.reset();
+}
+
+CDAGManager::CDAGManager() :
+    fInterrupt(false),
+    nProgress(0),
+    nProgressMax(0),
+    nDistance(0),
+    state(PREFETCH_IDLE),
+    nEpoch(0),
+    nStartTime(0),
+    nDuration(0)
+{
+}
+
+CDAGManager::~CDAGManager()
+{
+    fInterrupt = true;
+    if (prefetchThread.joinable()) prefetchThread.join();
+}
+
+void CDAGManager::SetDistance(int nDistanceIn)
+{
+    LOCK(cs);
+    nDistance = std::max(0, std::min(nDistanceIn, (int)egihash::constants::EPOCH_LENGTH - 1));
+}
+
+void CDAGManager::UpdatedBlockTip(const CBlockIndex *pindex)
+{
+    if (!pindex) return;
+
+    uint64_t const nTipEpoch = pindex->nHeight / egihash::constants::EPOCH_LENGTH;
+    std::shared_ptr<egihash::dag_t> dagToActivate;
+    std::shared_ptr<egihash::dag_t> dagStale;
+
     {
-        auto const previous_epoch = next_dag->epoch();
-        next_dag->unload();
-        next_dag.reset();
-        LogPrint("nrghash", "DAG for epoch %d unloaded\n", previous_epoch);
+        LOCK(cs);
+        if (state == PREFETCH_READY) {
+            if (nEpoch == nTipEpoch) {
+                dagToActivate.swap(nextDAG);
+                state = PREFETCH_IDLE;
+            } else if (nEpoch < nTipEpoch) {
+                // the chain moved past this epoch before it was needed
+                LogPrint("nrghash", "CDAGManager::UpdatedBlockTip -- dropping stale prefetched DAG for epoch %d\n", nEpoch);
+                dagStale.swap(nextDAG);
+                state = PREFETCH_IDLE;
+            }
+        }
+
+        uint64_t const nNextEpoch = nTipEpoch + 1;
+        int const nBlocksLeft = nNextEpoch * egihash::constants::EPOCH_LENGTH - pindex->nHeight;
+        bool const fStart = nDistance > 0 && nBlocksLeft <= nDistance &&
+                            state != PREFETCH_RUNNING && !(state != PREFETCH_IDLE && nEpoch == nNextEpoch);
+        if (fStart) {
+            // a previous run has already returned, make sure the thread is reaped before reuse
+            if (prefetchThread.joinable()) prefetchThread.join();
+
+            state = PREFETCH_RUNNING;
+            nEpoch = nNextEpoch;
+            nStartTime = GetTime();
+            nDuration = 0;
+            strError.clear();
+            nProgress = 0;
+            nProgressMax = 0;
+            fInterrupt = false;
+            LogPrintf("CDAGManager::UpdatedBlockTip -- %d blocks before epoch %d, building its DAG in the background\n", nBlocksLeft, nNextEpoch);
+            prefetchThread = boost::thread(boost::bind(&CDAGManager::ThreadPrefetch, this, nNextEpoch));
+        }
     }
 
-    return active;
+    // activation may unload the previous DAG which takes a while, do it without holding cs
+    if (dagToActivate) ActiveDAG(dagToActivate);
+    UnloadDAG(dagStale);
+}
+
+void CDAGManager::ThreadPrefetch(uint64_t nEpochIn)
+{
+    RenameThread("quantisnet-dag");
+
+    // DAG generation is plain CPU work, keep it out of the way of validation and networking.
+    // Worker threads spawned by egihash inherit this priority. Only Linux applies the nice
+    // value of setpriority() to the calling thread, elsewhere it would slow the whole process.
+#if defined(WIN32)
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#elif defined(__linux__)
+    setpriority(PRIO_PROCESS, 0, 19);
+#endif
+
+    auto progress = [this](::std::size_t step, ::std::size_t max, int phase) {
+        nProgress = step;
+        nProgressMax = max;
+        return !fInterrupt;
+    };
+
+    std::shared_ptr<egihash::dag_t> dag;
+    std::string strErrorOut;
+    int64_t nStart = GetTimeMillis();
+    try {
+        dag = std::make_shared<egihash::dag_t>(nEpochIn * egihash::constants::EPOCH_LENGTH, progress);
+    } catch (const std::exception& e) {
+        strErrorOut = e.what();
+    }
+    int64_t nElapsed = GetTimeMillis() - nStart;
+
+    LOCK(cs);
+    nDuration = nElapsed;
+    if (dag) {
+        nextDAG = dag;
+        state = PREFETCH_READY;
+        LogPrintf("CDAGManager::ThreadPrefetch -- DAG for epoch %d ready in %dms\n", nEpochIn, nElapsed);
+    } else {
+        state = PREFETCH_FAILED;
+        strError = strErrorOut;
+        LogPrintf("CDAGManager::ThreadPrefetch -- DAG for epoch %d not built: %s\n", nEpochIn, strErrorOut);
+    }
+}
+
+void CDAGManager::Stop()
+{
+    fInterrupt = true;
+    if (prefetchThread.joinable()) prefetchThread.join();
+
+    std::shared_ptr<egihash::dag_t> dagStale;
+    {
+        LOCK(cs);
+        // no new prefetch may start once we are shutting down
+        nDistance = 0;
+        dagStale.swap(nextDAG);
+        state = PREFETCH_IDLE;
+    }
+    UnloadDAG(dagStale);
+}
+
+CDAGManager::Status CDAGManager::GetStatus() const
+{
+    LOCK(cs);
+    Status status;
+    status.state = state;
+    status.nEpoch = nEpoch;
+    status.nProgress = nProgress;
+    status.nProgressMax = nProgressMax;
+    status.nStartTime = nStartTime;
+    status.nDuration = (state == PREFETCH_RUNNING) ? (GetTimeMillis() - nStartTime * 1000) : nDuration;
+    status.nDistance = nDistance;
+    status.strError = strError;
+    return status;
+}
+
+std::string CDAGManager::StateToString(PrefetchState state)
+{
+    switch (state) {
+        case PREFETCH_IDLE:     return "idle";
+        case PREFETCH_RUNNING:  return "running";
+        case PREFETCH_READY:    return "ready";
+        case PREFETCH_FAILED:   return "failed";
+    }
+    return "unknown";
 }
@@ -7,19 +7,97 @@
 #define QUANTISNET_DAG_SINGLETON_H
 
 #include "crypto/egihash.h"
+#include "sync.h"
 #include "util.h"
 
+#include <atomic>
 #include <memory>
 
+#include <boost/thread/thread.hpp>
+
+class CBlockIndex;
+class CDAGManager;
+
+/** Default number of blocks before an epoch boundary at which the next DAG starts being built (0 = never) */
+static const int DEFAULT_DAG_PREFETCH_DISTANCE = 720;
+
+extern CDAGManager dagManager;
+
 /** \brief Get the currently loaded DAG.
 *
 *	Note that this function is both a getter and a setter function.
 *	If no parameters are specified, or operator bool(next_dag) == false, return the currently active DAG
 *	If a valid next_dag is specified, swap the active DAG with next_dag and return the new active DAG (unloads the previous DAG)
 *
+*	The swap itself is the only work done under the lock, so callers keep a valid reference to whichever
+*	DAG they were handed even if a new one is activated concurrently.
+*
 *	\param next_dag (optional) swap the active DAG with next_dag
-*	\returns A unique_ptr to the currently active DAG, or a null unique_ptr if no DAG is active.
+*	\returns A shared_ptr to the currently active DAG, or a null shared_ptr if no DAG is active.
 */
-std::unique_ptr<egihash::dag_t> const & ActiveDAG(std::unique_ptr<egihash::dag_t> next_dag = std::unique_ptr<egihash::dag_t>());
+std::shared_ptr<egihash::dag_t> ActiveDAG(std::shared_ptr<egihash::dag_t> next_dag = std::shared_ptr<egihash::dag_t>());
+
+//
+// CDAGManager : Builds the DAG for the next epoch in the background and activates it at the boundary
+//
+
+class CDAGManager
+{
+public:
+    enum PrefetchState {
+        PREFETCH_IDLE,
+        PREFETCH_RUNNING,
+        PREFETCH_READY,
+        PREFETCH_FAILED
+    };
+
+    /** Snapshot of the prefetch state for RPC */
+    struct Status {
+        PrefetchState state;
+        uint64_t nEpoch;
+        uint32_t nProgress;
+        uint32_t nProgressMax;
+        int64_t nStartTime;
+        int64_t nDuration;
+        int nDistance;
+        std::string strError;
+    };
+
+private:
+    mutable CCriticalSection cs;
+
+    boost::thread prefetchThread;
+    std::atomic<bool> fInterrupt;
+    std::atomic<uint32_t> nProgress;
+    std::atomic<uint32_t> nProgressMax;
+
+    // Blocks before the boundary at which prefetching starts, 0 disables it
+    int nDistance;
+    PrefetchState state;
+    // Epoch being (or last) prefetched
+    uint64_t nEpoch;
+    int64_t nStartTime;
+    int64_t nDuration;
+    std::string strError;
+    // DAG for nEpoch once state == PREFETCH_READY
+    std::shared_ptr<egihash::dag_t> nextDAG;
+
+    void ThreadPrefetch(uint64_t nEpochIn);
+
+public:
+    CDAGManager();
+    ~CDAGManager();
+
+    void SetDistance(int nDistanceIn);
+
+    /** Activate a prefetched DAG once the tip enters its epoch and start prefetching when the boundary is near */
+    void UpdatedBlockTip(const CBlockIndex *pindex);
+
+    /** Cancel a running prefetch and wait for the background thread to exit */
+    void Stop();
+
+    Status GetStatus() const;
+    static std::string StateToString(PrefetchState state);
+};
 
 #endif
@@ -4,6 +4,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "chainparams.h"
+#include "dag_singleton.h"
 #include "dsnotificationinterface.h"
 #include "instantx.h"
 #include "governance.h"
@@ -44,6 +45,8 @@ void CDSNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, con
     if (fInitialDownload)
         return;
 
+    dagManager.UpdatedBlockTip(pindexNew);
+
     if (fLiteMode)
         return;
 
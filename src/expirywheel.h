@@ -0,0 +1,81 @@
+// Copyright (c) 2017-2019 The QuantisNet Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef EXPIRYWHEEL_H_
+#define EXPIRYWHEEL_H_
+
+#include <map>
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+#include "memusage.h"
+
+/**
+ * Schedule of keys to check for expiry, grouped in buckets of nBucketSize ticks (seconds or blocks).
+ *
+ * Cleanup pops the buckets that are due instead of walking a whole container. The owner still checks
+ * the real expiry condition of every popped key: a key can be scheduled more than once, or get a new
+ * lifetime after it was scheduled, so it should be dropped if gone and scheduled again if still alive.
+ */
+template<typename K>
+class CExpiryWheel
+{
+private:
+    int64_t nBucketSize;
+
+    /// First tick of the bucket - keys to check from then on
+    std::map<int64_t, std::vector<K> > mapBuckets;
+
+    size_t nSize;
+
+public:
+    explicit CExpiryWheel(int64_t nBucketSizeIn = 1)
+        : nBucketSize(nBucketSizeIn),
+          mapBuckets(),
+          nSize(0)
+    {}
+
+    /// Check key once nNow reaches nDue (rounded up to the end of its bucket)
+    void Schedule(const K& key, int64_t nDue)
+    {
+        int64_t nBucket = nDue - ((nDue % nBucketSize) + nBucketSize) % nBucketSize;
+        mapBuckets[nBucket + nBucketSize - 1].push_back(key);
+        ++nSize;
+    }
+
+    /// Move the keys of all buckets due at nNow to vKeysRet
+    void PopDue(int64_t nNow, std::vector<K>& vKeysRet)
+    {
+        auto it = mapBuckets.begin();
+        while (it != mapBuckets.end() && it->first <= nNow) {
+            nSize -= it->second.size();
+            vKeysRet.insert(vKeysRet.end(), it->second.begin(), it->second.end());
+            mapBuckets.erase(it++);
+        }
+    }
+
+    void Clear()
+    {
+        mapBuckets.clear();
+        nSize = 0;
+    }
+
+    /// Number of scheduled checks, including duplicates
+    size_t GetSize() const
+    {
+        return nSize;
+    }
+
+    size_t DynamicMemoryUsage() const
+    {
+        size_t nUsage = memusage::DynamicUsage(mapBuckets);
+        for (const auto& bucket : mapBuckets) {
+            nUsage += memusage::DynamicUsage(bucket.second);
+        }
+        return nUsage;
+    }
+};
+
+#endif /* EXPIRYWHEEL_H_ */
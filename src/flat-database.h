@@ -15,11 +15,213 @@
 
 #include <boost/filesystem.hpp>
 
-/** 
+/**
 *   Generic Dumping and Loading
 *   ---------------------------
+*
+*   Files are append-only logs of records. A dump cuts the serialized object into content-defined
+*   chunks, appends the chunks the log does not have yet and then a checkpoint record listing all
+*   chunks of the object in order. Unchanged parts of the object cost no writes, even when data
+*   was inserted before them. A load only reads the last checkpoint and the chunks it refers to,
+*   one at a time. Once most of the log is made of chunks no checkpoint refers to anymore, it is
+*   compacted into a new file.
+*
+*   Record: type (uint8_t), payload size (uint32_t), hash of the payload (uint256), payload.
+*   Logs are kept under their own file name (".log" instead of ".dat"), so that previous versions
+*   don't find a file they can't read. Files in the old single image format are still read, the
+*   next dump replaces them by a log.
 */
 
+static const uint8_t FLATDB_RECORD_CHUNK = 1;
+static const uint8_t FLATDB_RECORD_CHECKPOINT = 2;
+static const size_t FLATDB_RECORD_HEADER_SIZE = 1 + 4 + 32;
+
+/** Chunk boundaries are placed where the rolling hash has these bits clear, ~64kB apart on average.
+ *  High bits, as they depend on the last 64 bytes while low bits only depend on the last few. */
+static const uint64_t FLATDB_CHUNK_MASK = 0xffffULL << 48;
+static const size_t FLATDB_MIN_CHUNK_SIZE = 16 * 1024;
+static const size_t FLATDB_MAX_CHUNK_SIZE = 256 * 1024;
+
+/** Compact once the log is this many times larger than the data of its last checkpoint */
+static const int FLATDB_COMPACT_RATIO = 2;
+static const uint64_t FLATDB_MIN_COMPACT_SIZE = 1024 * 1024;
+
+/** Suffix of the magic message of files in the log format */
+static const std::string FLATDB_LOG_MAGIC_SUFFIX = "Log";
+
+/** Random constants of the gear rolling hash, fixed so that chunks stay the same across restarts */
+inline const uint64_t* FlatDBGearTable()
+{
+    static uint64_t table[256];
+    static bool fInit = [] {
+        uint64_t x = 0x9e3779b97f4a7c15ULL;
+        for (int i = 0; i < 256; i++) {
+            // splitmix64
+            uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            table[i] = z ^ (z >> 31);
+        }
+        return true;
+    }();
+    (void)fInit;
+    return table;
+}
+
+/** Location of a record payload in the log */
+struct CFlatDBRecordPos
+{
+    long nPos;
+    uint32_t nSize;
+};
+
+inline void WriteFlatDBRecord(CAutoFile& fileout, uint8_t nType, const std::vector<unsigned char>& vchPayload, const uint256& hash)
+{
+    uint32_t nSize = vchPayload.size();
+    fileout << nType << nSize << hash;
+    fileout.write((const char*)vchPayload.data(), vchPayload.size());
+}
+
+inline void ReadFlatDBRecord(CAutoFile& filein, const CFlatDBRecordPos& pos, const uint256& hashExpected, std::vector<unsigned char>& vchPayload)
+{
+    if (fseek(filein.Get(), pos.nPos, SEEK_SET))
+        throw std::ios_base::failure("ReadFlatDBRecord: seek failed");
+    vchPayload.resize(pos.nSize);
+    filein.read((char*)vchPayload.data(), vchPayload.size());
+    if (Hash(vchPayload.begin(), vchPayload.end()) != hashExpected)
+        throw std::ios_base::failure("ReadFlatDBRecord: checksum mismatch, data corrupted");
+}
+
+/** Serialization target cutting the data into chunks and appending the ones not in the log yet */
+class CFlatDBChunkWriter
+{
+private:
+    CAutoFile& fileout;
+    std::map<uint256, CFlatDBRecordPos>& mapChunks;
+    std::vector<unsigned char> vchChunk;
+    uint64_t nRollingHash;
+
+    void EndChunk()
+    {
+        if (vchChunk.empty()) return;
+        uint256 hash = Hash(vchChunk.begin(), vchChunk.end());
+        if (!mapChunks.count(hash)) {
+            long nPos = ftell(fileout.Get());
+            WriteFlatDBRecord(fileout, FLATDB_RECORD_CHUNK, vchChunk, hash);
+            mapChunks[hash] = CFlatDBRecordPos{nPos + (long)FLATDB_RECORD_HEADER_SIZE, (uint32_t)vchChunk.size()};
+            nNewBytes += vchChunk.size();
+        }
+        vChunks.push_back(hash);
+        nTotalBytes += vchChunk.size();
+        vchChunk.clear();
+        nRollingHash = 0;
+    }
+
+public:
+    std::vector<uint256> vChunks; ///< all chunks of the data, in order
+    uint64_t nTotalBytes;
+    uint64_t nNewBytes;
+
+    CFlatDBChunkWriter(CAutoFile& fileoutIn, std::map<uint256, CFlatDBRecordPos>& mapChunksIn) :
+        fileout(fileoutIn), mapChunks(mapChunksIn), nRollingHash(0), nTotalBytes(0), nNewBytes(0)
+    {
+        vchChunk.reserve(FLATDB_MAX_CHUNK_SIZE);
+    }
+
+    int GetType() const { return fileout.GetType(); }
+    int GetVersion() const { return fileout.GetVersion(); }
+    size_t size() const { return nTotalBytes + vchChunk.size(); }
+
+    void write(const char* pch, size_t nSize)
+    {
+        const uint64_t* gear = FlatDBGearTable();
+        for (size_t i = 0; i < nSize; i++) {
+            unsigned char ch = pch[i];
+            vchChunk.push_back(ch);
+            nRollingHash = (nRollingHash << 1) + gear[ch];
+            if (vchChunk.size() >= FLATDB_MAX_CHUNK_SIZE ||
+                (vchChunk.size() >= FLATDB_MIN_CHUNK_SIZE && (nRollingHash & FLATDB_CHUNK_MASK) == 0)) {
+                EndChunk();
+            }
+        }
+    }
+
+    /** End the last chunk and append the checkpoint record */
+    void Finish()
+    {
+        EndChunk();
+        CDataStream ssCheckpoint(SER_DISK, CLIENT_VERSION);
+        ssCheckpoint << vChunks << nTotalBytes;
+        std::vector<unsigned char> vch(ssCheckpoint.begin(), ssCheckpoint.end());
+        WriteFlatDBRecord(fileout, FLATDB_RECORD_CHECKPOINT, vch, Hash(vch.begin(), vch.end()));
+    }
+
+    template<typename T>
+    CFlatDBChunkWriter& operator<<(const T& obj)
+    {
+        ::Serialize(*this, obj);
+        return (*this);
+    }
+};
+
+/** Deserialization source reading the chunks of a checkpoint one after the other */
+class CFlatDBChunkReader
+{
+private:
+    CAutoFile& filein;
+    const std::map<uint256, CFlatDBRecordPos>& mapChunks;
+    const std::vector<uint256>& vChunks;
+    size_t nNextChunk;
+    std::vector<unsigned char> vchChunk;
+    size_t nChunkPos;
+    uint64_t nRemaining;
+
+public:
+    CFlatDBChunkReader(CAutoFile& fileinIn, const std::map<uint256, CFlatDBRecordPos>& mapChunksIn, const std::vector<uint256>& vChunksIn) :
+        filein(fileinIn), mapChunks(mapChunksIn), vChunks(vChunksIn), nNextChunk(0), nChunkPos(0), nRemaining(0)
+    {
+        for (const auto& hash : vChunks) {
+            auto it = mapChunks.find(hash);
+            if (it != mapChunks.end())
+                nRemaining += it->second.nSize;
+        }
+    }
+
+    int GetType() const { return filein.GetType(); }
+    int GetVersion() const { return filein.GetVersion(); }
+    /// Bytes left to read, like CDataStream::size()
+    size_t size() const { return nRemaining; }
+
+    void read(char* pch, size_t nSize)
+    {
+        while (nSize > 0) {
+            if (nChunkPos == vchChunk.size()) {
+                if (nNextChunk == vChunks.size())
+                    throw std::ios_base::failure("CFlatDBChunkReader::read: end of data");
+                const uint256& hash = vChunks[nNextChunk++];
+                auto it = mapChunks.find(hash);
+                if (it == mapChunks.end())
+                    throw std::ios_base::failure("CFlatDBChunkReader::read: missing chunk");
+                ReadFlatDBRecord(filein, it->second, hash, vchChunk);
+                nChunkPos = 0;
+            }
+            size_t nNow = std::min(nSize, vchChunk.size() - nChunkPos);
+            memcpy(pch, vchChunk.data() + nChunkPos, nNow);
+            nChunkPos += nNow;
+            nRemaining -= nNow;
+            pch += nNow;
+            nSize -= nNow;
+        }
+    }
+
+    template<typename T>
+    CFlatDBChunkReader& operator>>(T& obj)
+    {
+        ::Unserialize(*this, obj);
+        return (*this);
+    }
+};
+
 template<typename T>
 class CFlatDB
 {
@@ -32,54 +234,161 @@ private:
         IncorrectHash,
         IncorrectMagicMessage,
         IncorrectMagicNumber,
-        IncorrectFormat
+        IncorrectFormat,
+        LegacyFormat
     };
 
     boost::filesystem::path pathDB;
     std::string strFilename;
+    /// File in the single image format of previous versions
+    boost::filesystem::path pathLegacy;
     std::string strMagicMessage;
 
-    bool Write(const T& objToSave)
+    /// Records found in the log by Scan()
+    std::map<uint256, CFlatDBRecordPos> mapChunks;
+    std::vector<std::pair<uint256, CFlatDBRecordPos> > vCheckpoints;
+    /// End of the last complete record, anything after it is a torn write
+    long nValidSize;
+
+    ReadResult ReadHeader(CAutoFile& filein)
     {
-        // LOCK(objToSave.cs);
+        std::string strMagicMessageTmp;
+        unsigned char pchMsgTmp[4];
+        try {
+            // de-serialize file header (file specific magic message) and ..
+            filein >> strMagicMessageTmp;
 
-        int64_t nStart = GetTimeMillis();
+            // ... verify the message matches predefined one
+            if (strMagicMessageTmp == strMagicMessage)
+                return LegacyFormat;
+            if (strMagicMessageTmp != strMagicMessage + FLATDB_LOG_MAGIC_SUFFIX)
+            {
+                error("%s: Invalid magic message", __func__);
+                return IncorrectMagicMessage;
+            }
 
-        // serialize, checksum data up to that point, then append checksum
-        CDataStream ssObj(SER_DISK, CLIENT_VERSION);
-        ssObj << strMagicMessage; // specific magic message for this type of object
-        ssObj << FLATDATA(Params().MessageStart()); // network specific magic number
-        ssObj << objToSave;
-        uint256 hash = Hash(ssObj.begin(), ssObj.end());
-        ssObj << hash;
+            // de-serialize file header (network specific magic number) and ..
+            filein >> FLATDATA(pchMsgTmp);
 
-        // open output file, and associate with CAutoFile
-        FILE *file = fopen(pathDB.string().c_str(), "wb");
-        CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
-        if (fileout.IsNull())
-            return error("%s: Failed to open file %s", __func__, pathDB.string());
+            // ... verify the network matches ours
+            if (memcmp(pchMsgTmp, Params().MessageStart(), sizeof(pchMsgTmp)))
+            {
+                error("%s: Invalid network magic number", __func__);
+                return IncorrectMagicNumber;
+            }
+        }
+        catch (std::exception &e) {
+            error("%s: Deserialize or I/O error - %s", __func__, e.what());
+            return IncorrectMagicMessage;
+        }
+        return Ok;
+    }
 
-        // Write and commit header, data
+    void WriteHeader(CAutoFile& fileout)
+    {
+        fileout << strMagicMessage + FLATDB_LOG_MAGIC_SUFFIX; // specific magic message for this type of object
+        fileout << FLATDATA(Params().MessageStart()); // network specific magic number
+    }
+
+    /** Check the header and index the records of the log whose payload matches their hash */
+    ReadResult Scan()
+    {
+        mapChunks.clear();
+        vCheckpoints.clear();
+        nValidSize = 0;
+
+        FILE *file = fopen(pathDB.string().c_str(), "rb");
+        CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
+        if (filein.IsNull())
+            return FileError;
+
+        ReadResult result = ReadHeader(filein);
+        if (result != Ok)
+            return result;
+
+        long nFileSize = boost::filesystem::file_size(pathDB);
+        nValidSize = ftell(filein.Get());
+        std::vector<unsigned char> vchPayload;
         try {
-            fileout << ssObj;
+            while (nValidSize + (long)FLATDB_RECORD_HEADER_SIZE <= nFileSize) {
+                uint8_t nType;
+                uint32_t nSize;
+                uint256 hash;
+                filein >> nType >> nSize >> hash;
+                CFlatDBRecordPos pos{nValidSize + (long)FLATDB_RECORD_HEADER_SIZE, nSize};
+                if (pos.nPos + (long)nSize > nFileSize)
+                    break;
+                if (nType != FLATDB_RECORD_CHUNK && nType != FLATDB_RECORD_CHECKPOINT)
+                    break;
+                vchPayload.resize(nSize);
+                filein.read((char*)vchPayload.data(), vchPayload.size());
+                nValidSize = pos.nPos + nSize;
+                // a corrupted chunk is written again by the next dump that needs it
+                if (Hash(vchPayload.begin(), vchPayload.end()) != hash) {
+                    LogPrintf("%s: Ignoring a record not matching its hash in %s\n", __func__, strFilename);
+                    continue;
+                }
+                if (nType == FLATDB_RECORD_CHUNK)
+                    mapChunks[hash] = pos;
+                else
+                    vCheckpoints.emplace_back(hash, pos);
+            }
         }
         catch (std::exception &e) {
-            return error("%s: Serialize or I/O error - %s", __func__, e.what());
+            // incomplete record at the end, ignore it
         }
-        fileout.fclose();
+        if (nValidSize != nFileSize)
+            LogPrintf("%s: Ignoring %d bytes of incomplete records at the end of %s\n", __func__, nFileSize - nValidSize, strFilename);
 
-        LogPrintf("Written info to %s  %dms\n", strFilename, GetTimeMillis() - nStart);
-        LogPrintf("     %s\n", objToSave.ToString());
+        return Ok;
+    }
 
-        return true;
+    /** Read the list of chunks of the last checkpoint whose chunks are all present */
+    ReadResult ReadCheckpoint(CAutoFile& filein, std::vector<uint256>& vChunksRet, std::vector<unsigned char>* pvchCheckpointRet = nullptr)
+    {
+        for (auto it = vCheckpoints.rbegin(); it != vCheckpoints.rend(); ++it) {
+            std::vector<unsigned char> vchCheckpoint;
+            uint64_t nTotalBytes;
+            try {
+                ReadFlatDBRecord(filein, it->second, it->first, vchCheckpoint);
+                CDataStream ssCheckpoint(vchCheckpoint, SER_DISK, CLIENT_VERSION);
+                ssCheckpoint >> vChunksRet >> nTotalBytes;
+            }
+            catch (std::exception &e) {
+                error("%s: Skipping invalid checkpoint - %s", __func__, e.what());
+                continue;
+            }
+            bool fComplete = true;
+            for (const auto& hash : vChunksRet) {
+                fComplete &= mapChunks.count(hash) > 0;
+            }
+            if (fComplete) {
+                if (pvchCheckpointRet)
+                    pvchCheckpointRet->swap(vchCheckpoint);
+                return Ok;
+            }
+            error("%s: Skipping checkpoint with missing chunks", __func__);
+        }
+        return vCheckpoints.empty() ? IncorrectFormat : IncorrectHash;
     }
 
-    ReadResult Read(T& objToLoad, bool fDryRun = false)
+    ReadResult Read(T& objToLoad)
     {
         //LOCK(objToLoad.cs);
 
         int64_t nStart = GetTimeMillis();
-        // open input file, and associate with CAutoFile
+
+        // only previous versions write it, so it is newer than the log
+        if (boost::filesystem::exists(pathLegacy))
+            return ReadLegacy(objToLoad);
+
+        ReadResult result = Scan();
+        if (result != Ok) {
+            if (result == FileError)
+                error("%s: Failed to open file %s", __func__, pathDB.string());
+            return result;
+        }
+
         FILE *file = fopen(pathDB.string().c_str(), "rb");
         CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
         if (filein.IsNull())
@@ -88,8 +397,46 @@ private:
             return FileError;
         }
 
+        std::vector<uint256> vChunks;
+        result = ReadCheckpoint(filein, vChunks);
+        if (result != Ok)
+            return result;
+
+        try {
+            // de-serialize data into T object, one chunk at a time
+            CFlatDBChunkReader reader(filein, mapChunks, vChunks);
+            reader >> objToLoad;
+        }
+        catch (std::exception &e) {
+            objToLoad.Clear();
+            error("%s: Deserialize or I/O error - %s", __func__, e.what());
+            return IncorrectFormat;
+        }
+
+        LogPrintf("Loaded info from %s  %dms\n", strFilename, GetTimeMillis() - nStart);
+        LogPrintf("     %s\n", objToLoad.ToString());
+        LogPrintf("%s: Cleaning....\n", __func__);
+        objToLoad.CheckAndRemove();
+        LogPrintf("     %s\n", objToLoad.ToString());
+
+        return Ok;
+    }
+
+    /** Read a file written as one image by previous versions */
+    ReadResult ReadLegacy(T& objToLoad)
+    {
+        int64_t nStart = GetTimeMillis();
+        // open input file, and associate with CAutoFile
+        FILE *file = fopen(pathLegacy.string().c_str(), "rb");
+        CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
+        if (filein.IsNull())
+        {
+            error("%s: Failed to open file %s", __func__, pathLegacy.string());
+            return FileError;
+        }
+
         // use file size to size memory buffer
-        int fileSize = boost::filesystem::file_size(pathDB);
+        int fileSize = boost::filesystem::file_size(pathLegacy);
         int dataSize = fileSize - sizeof(uint256);
         // Don't try to resize to a negative number if file is small
         if (dataSize < 0)
@@ -127,13 +474,12 @@ private:
             ssObj >> strMagicMessageTmp;
 
             // ... verify the message matches predefined one
-            if (strMagicMessage != strMagicMessageTmp)
+            if (strMagicMessageTmp != strMagicMessage)
             {
                 error("%s: Invalid magic message", __func__);
                 return IncorrectMagicMessage;
             }
 
-
             // de-serialize file header (network specific magic number) and ..
             ssObj >> FLATDATA(pchMsgTmp);
 
@@ -153,23 +499,132 @@ private:
             return IncorrectFormat;
         }
 
-        LogPrintf("Loaded info from %s  %dms\n", strFilename, GetTimeMillis() - nStart);
+        LogPrintf("Loaded info from %s  %dms\n", pathLegacy.filename().string(), GetTimeMillis() - nStart);
+        LogPrintf("     %s\n", objToLoad.ToString());
+        LogPrintf("%s: Cleaning....\n", __func__);
+        objToLoad.CheckAndRemove();
         LogPrintf("     %s\n", objToLoad.ToString());
-        if(!fDryRun) {
-            LogPrintf("%s: Cleaning....\n", __func__);
-            objToLoad.CheckAndRemove();
-            LogPrintf("     %s\n", objToLoad.ToString());
-        }
 
         return Ok;
     }
 
+    /** Check the header of the file written by previous versions, LegacyFormat if it is ours */
+    ReadResult ReadLegacyHeader()
+    {
+        FILE *file = fopen(pathLegacy.string().c_str(), "rb");
+        CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
+        if (filein.IsNull())
+            return FileError;
+        ReadResult result = ReadHeader(filein);
+        return result == Ok ? IncorrectFormat : result;
+    }
+
+    /** Append the new chunks and a checkpoint of objToSave to the log scanned last, or start a new log */
+    bool Write(const T& objToSave, bool fNewLog)
+    {
+        // LOCK(objToSave.cs);
+
+        int64_t nStart = GetTimeMillis();
+
+        if (fNewLog) {
+            mapChunks.clear();
+            vCheckpoints.clear();
+        }
+
+        FILE *file = fopen(pathDB.string().c_str(), fNewLog ? "wb" : "r+b");
+        CAutoFile fileout(file, SER_DISK, CLIENT_VERSION);
+        if (fileout.IsNull())
+            return error("%s: Failed to open file %s", __func__, pathDB.string());
+
+        uint64_t nTotalBytes, nNewBytes;
+        try {
+            if (fNewLog) {
+                WriteHeader(fileout);
+            } else {
+                // drop a torn write of an earlier dump before appending
+                if (nValidSize != (long)boost::filesystem::file_size(pathDB) && !TruncateFile(fileout.Get(), nValidSize))
+                    return error("%s: Failed to truncate %s", __func__, pathDB.string());
+                if (fseek(fileout.Get(), nValidSize, SEEK_SET))
+                    return error("%s: Failed to seek in %s", __func__, pathDB.string());
+            }
+
+            CFlatDBChunkWriter writer(fileout, mapChunks);
+            writer << objToSave;
+            writer.Finish();
+            nTotalBytes = writer.nTotalBytes;
+            nNewBytes = writer.nNewBytes;
+        }
+        catch (std::exception &e) {
+            return error("%s: Serialize or I/O error - %s", __func__, e.what());
+        }
+        FileCommit(fileout.Get());
+        long nFileSize = ftell(fileout.Get());
+        fileout.fclose();
+
+        LogPrintf("Written info to %s  %dms, %d of %d bytes appended\n", strFilename, GetTimeMillis() - nStart, nNewBytes, nTotalBytes);
+        LogPrintf("     %s\n", objToSave.ToString());
+
+        if ((uint64_t)nFileSize > FLATDB_MIN_COMPACT_SIZE && (uint64_t)nFileSize > FLATDB_COMPACT_RATIO * nTotalBytes) {
+            return Compact();
+        }
+
+        return true;
+    }
+
+    /** Rewrite the log with only the chunks and the record of its last checkpoint */
+    bool Compact()
+    {
+        int64_t nStart = GetTimeMillis();
+
+        if (Scan() != Ok)
+            return error("%s: Failed to scan %s", __func__, pathDB.string());
+
+        boost::filesystem::path pathTmp = pathDB;
+        pathTmp += ".new";
+        {
+            FILE *file = fopen(pathDB.string().c_str(), "rb");
+            CAutoFile filein(file, SER_DISK, CLIENT_VERSION);
+            FILE *fileNew = fopen(pathTmp.string().c_str(), "wb");
+            CAutoFile fileout(fileNew, SER_DISK, CLIENT_VERSION);
+            if (filein.IsNull() || fileout.IsNull())
+                return error("%s: Failed to open %s", __func__, pathTmp.string());
+
+            std::vector<uint256> vChunks;
+            std::vector<unsigned char> vchCheckpoint;
+            if (ReadCheckpoint(filein, vChunks, &vchCheckpoint) != Ok)
+                return error("%s: No valid checkpoint in %s", __func__, pathDB.string());
+
+            try {
+                WriteHeader(fileout);
+                std::set<uint256> setWritten;
+                std::vector<unsigned char> vchPayload;
+                for (const auto& hash : vChunks) {
+                    if (!setWritten.insert(hash).second) continue;
+                    ReadFlatDBRecord(filein, mapChunks[hash], hash, vchPayload);
+                    WriteFlatDBRecord(fileout, FLATDB_RECORD_CHUNK, vchPayload, hash);
+                }
+                WriteFlatDBRecord(fileout, FLATDB_RECORD_CHECKPOINT, vchCheckpoint, Hash(vchCheckpoint.begin(), vchCheckpoint.end()));
+            }
+            catch (std::exception &e) {
+                return error("%s: Serialize or I/O error - %s", __func__, e.what());
+            }
+            FileCommit(fileout.Get());
+        }
+        if (!RenameOver(pathTmp, pathDB))
+            return error("%s: Failed to rename %s", __func__, pathTmp.string());
+
+        LogPrintf("Compacted %s  %dms, %d bytes\n", strFilename, GetTimeMillis() - nStart, boost::filesystem::file_size(pathDB));
+        return true;
+    }
 
 public:
-    CFlatDB(std::string strFilenameIn, std::string strMagicMessageIn)
+    /** strFilenameIn is the file name used by previous versions, the log replaces its extension by ".log" */
+    CFlatDB(std::string strFilenameIn, std::string strMagicMessageIn) : nValidSize(0)
     {
-        pathDB = GetDataDir() / strFilenameIn;
-        strFilename = strFilenameIn;
+        pathLegacy = GetDataDir() / strFilenameIn;
+        pathDB = pathLegacy;
+        pathDB.replace_extension(".log");
+        strFilename = pathDB.filename().string();
         strMagicMessage = strMagicMessageIn;
     }
 
@@ -200,26 +655,27 @@ public:
         int64_t nStart = GetTimeMillis();
 
         LogPrintf("Verifying %s format...\n", strFilename);
-        T tmpObjToLoad;
-        ReadResult readResult = Read(tmpObjToLoad, true);
+        bool fConvert = boost::filesystem::exists(pathLegacy);
+        ReadResult readResult = fConvert ? ReadLegacyHeader() : Scan();
 
         // there was an error and it was not an error on file opening => do not proceed
         if (readResult == FileError)
             LogPrintf("Missing file %s, will try to recreate\n", strFilename);
+        else if (fConvert && readResult == LegacyFormat)
+            LogPrintf("Converting %s to %s\n", pathLegacy.filename().string(), strFilename);
         else if (readResult != Ok)
         {
             LogPrintf("Error reading %s: ", strFilename);
-            if(readResult == IncorrectFormat)
-                LogPrintf("%s: Magic is ok but data has invalid format, will try to recreate\n", __func__);
-            else
-            {
-                LogPrintf("%s: File format is unknown or invalid, please fix it manually\n", __func__);
-                return false;
-            }
+            LogPrintf("%s: File format is unknown or invalid, please fix it manually\n", __func__);
+            return false;
         }
 
         LogPrintf("Writing info to %s...\n", strFilename);
-        Write(objToSave);
+        // previous versions start over without the file, rather than from an outdated one
+        if (Write(objToSave, readResult != Ok) && fConvert) {
+            boost::system::error_code ec;
+            boost::filesystem::remove(pathLegacy, ec);
+        }
         LogPrintf("%s dump finished  %dms\n", strFilename, GetTimeMillis() - nStart);
 
         return true;
@@ -102,7 +102,8 @@ CGovernanceObject::CGovernanceObject(const CGovernanceObject& other):
 bool CGovernanceObject::ProcessVote(CNode* pfrom,
                                     const CGovernanceVote& vote,
                                     CGovernanceException& exception,
-                                    CConnman& connman)
+                                    CConnman& connman,
+                                    bool fSignatureChecked)
 {
     LOCK(cs);
 
@@ -179,7 +180,7 @@ bool CGovernanceObject::ProcessVote(CNode* pfrom,
     }
 
     // Finally check that the vote is actually valid (done last because of cost of signature verification)
-    if(!vote.IsValid(true)) {
+    if(!vote.IsValid(!fSignatureChecked)) {
         std::ostringstream ostr;
         ostr << "CGovernanceObject::ProcessVote -- Invalid vote"
                 << ", MN outpoint = " << vote.GetMasternodeOutpoint().ToStringShort()
@@ -690,6 +691,52 @@ bool CGovernanceObject::GetCurrentMNVotes(const COutPoint& mnCollateralOutpoint,
     return  true;
 }
 
+CGovernanceObject::vote_m_t CGovernanceObject::GetCurrentMNVotes() const
+{
+    LOCK(cs);
+    return mapCurrentMNVotes;
+}
+
+std::shared_ptr<const std::vector<CGovernanceVote> > CGovernanceObject::GetVotesSnapshot() const
+{
+    LOCK(cs);
+    return fileVotes.GetVotesSnapshot();
+}
+
+governance_object_summary_t CGovernanceObject::GetSummary() const
+{
+    governance_object_summary_t summary;
+    summary.nHash = GetHash();
+    summary.nCollateralHash = nCollateralHash;
+    summary.nObjectType = nObjectType;
+    summary.nCreationTime = nTime;
+    summary.masternodeOutpoint = masternodeOutpoint;
+    summary.strDataHex = GetDataAsHexString();
+    summary.strDataString = GetDataAsPlainString();
+    summary.fLocalValidity = IsValidLocally(summary.strLocalValidityError, false);
+
+    LOCK(cs);
+
+    summary.nFundingYesCount = 0;
+    summary.nFundingNoCount = 0;
+    summary.nFundingAbstainCount = 0;
+    for (const auto& votepair : mapCurrentMNVotes) {
+        vote_instance_m_cit it = votepair.second.mapInstances.find(VOTE_SIGNAL_FUNDING);
+        if(it == votepair.second.mapInstances.end()) continue;
+        switch(it->second.eOutcome) {
+            case VOTE_OUTCOME_YES:      ++summary.nFundingYesCount; break;
+            case VOTE_OUTCOME_NO:       ++summary.nFundingNoCount; break;
+            case VOTE_OUTCOME_ABSTAIN:  ++summary.nFundingAbstainCount; break;
+            default: break;
+        }
+    }
+    summary.fCachedValid = fCachedValid;
+    summary.fCachedFunding = fCachedFunding;
+    summary.fCachedDelete = fCachedDelete;
+    summary.fCachedEndorsed = fCachedEndorsed;
+    return summary;
+}
+
 void CGovernanceObject::Relay(CConnman& connman)
 {
     // Do not relay until fully synced
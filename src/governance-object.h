@@ -104,6 +104,29 @@ struct vote_rec_t {
      }
 };
 
+/**
+ * What gobject list reports about a governance object. A copy, so the caller
+ * can format it without holding any governance lock
+ */
+struct governance_object_summary_t {
+    uint256 nHash;
+    uint256 nCollateralHash;
+    int nObjectType;
+    int64_t nCreationTime;
+    COutPoint masternodeOutpoint;
+    std::string strDataHex;
+    std::string strDataString;
+    int nFundingYesCount;
+    int nFundingNoCount;
+    int nFundingAbstainCount;
+    bool fLocalValidity;
+    std::string strLocalValidityError;
+    bool fCachedValid;
+    bool fCachedFunding;
+    bool fCachedDelete;
+    bool fCachedEndorsed;
+};
+
 /**
 * Governance Object
 *
@@ -294,6 +317,15 @@ public:
 
     bool GetCurrentMNVotes(const COutPoint& mnCollateralOutpoint, vote_rec_t& voteRecord) const;
 
+    /// Copy of the current votes of all masternodes
+    vote_m_t GetCurrentMNVotes() const;
+
+    /// All votes as an immutable snapshot, see CGovernanceObjectVoteFile::GetVotesSnapshot
+    std::shared_ptr<const std::vector<CGovernanceVote> > GetVotesSnapshot() const;
+
+    /// Data, funding vote counts and flags as reported by gobject list
+    governance_object_summary_t GetSummary() const;
+
     // FUNCTIONS FOR DEALING WITH DATA STRING
 
     std::string GetDataAsHexString() const;
@@ -371,7 +403,8 @@ private:
     bool ProcessVote(CNode* pfrom,
                      const CGovernanceVote& vote,
                      CGovernanceException& exception,
-                     CConnman& connman);
+                     CConnman& connman,
+                     bool fSignatureChecked = false);
 
     /// Called when MN's which have voted on this object have been removed
     void ClearMasternodeVotes();
@@ -9,13 +9,15 @@
 CGovernanceObjectVoteFile::CGovernanceObjectVoteFile()
     : nMemoryVotes(0),
       listVotes(),
-      mapVoteIndex()
+      mapVoteIndex(),
+      pvecVotesSnapshot()
 {}
 
 CGovernanceObjectVoteFile::CGovernanceObjectVoteFile(const CGovernanceObjectVoteFile& other)
     : nMemoryVotes(other.nMemoryVotes),
       listVotes(other.listVotes),
-      mapVoteIndex()
+      mapVoteIndex(),
+      pvecVotesSnapshot(other.pvecVotesSnapshot)
 {
     RebuildIndex();
 }
@@ -29,6 +31,7 @@ void CGovernanceObjectVoteFile::AddVote(const CGovernanceVote& vote)
     listVotes.push_front(vote);
     mapVoteIndex.emplace(nHash, listVotes.begin());
     ++nMemoryVotes;
+    pvecVotesSnapshot.reset();
 }
 
 bool CGovernanceObjectVoteFile::HasVote(const uint256& nHash) const
@@ -55,8 +58,17 @@ std::vector<CGovernanceVote> CGovernanceObjectVoteFile::GetVotes() const
     return vecResult;
 }
 
+std::shared_ptr<const std::vector<CGovernanceVote> > CGovernanceObjectVoteFile::GetVotesSnapshot() const
+{
+    if(!pvecVotesSnapshot) {
+        pvecVotesSnapshot = std::make_shared<const std::vector<CGovernanceVote> >(listVotes.begin(), listVotes.end());
+    }
+    return pvecVotesSnapshot;
+}
+
 void CGovernanceObjectVoteFile::RemoveVotesFromMasternode(const COutPoint& outpointMasternode)
 {
+    pvecVotesSnapshot.reset();
     vote_l_it it = listVotes.begin();
     while(it != listVotes.end()) {
         if(it->GetMasternodeOutpoint() == outpointMasternode) {
@@ -74,6 +86,7 @@ void CGovernanceObjectVoteFile::RebuildIndex()
 {
     mapVoteIndex.clear();
     nMemoryVotes = 0;
+    pvecVotesSnapshot.reset();
     vote_l_it it = listVotes.begin();
     while(it != listVotes.end()) {
         CGovernanceVote& vote = *it;
@@ -88,3 +101,126 @@ void CGovernanceObjectVoteFile::RebuildIndex()
         }
     }
 }
+
+CGovernanceVoteIndex::CGovernanceVoteIndex(int nMaxSize)
+{
+    for(Shard& shard : vShards) {
+        shard.cmapVoteToObject.SetMaxSize(nMaxSize / SHARDS);
+        shard.cmapInvalidVotes.SetMaxSize(nMaxSize / SHARDS);
+    }
+}
+
+bool CGovernanceVoteIndex::HasVote(const uint256& nHashVote) const
+{
+    const Shard& shard = GetShard(nHashVote);
+    LOCK(shard.cs);
+    return shard.cmapVoteToObject.HasKey(nHashVote);
+}
+
+bool CGovernanceVoteIndex::GetVoteParent(const uint256& nHashVote, uint256& nHashParentRet) const
+{
+    const Shard& shard = GetShard(nHashVote);
+    LOCK(shard.cs);
+    return shard.cmapVoteToObject.Get(nHashVote, nHashParentRet);
+}
+
+bool CGovernanceVoteIndex::AddVote(const uint256& nHashVote, const uint256& nHashParent)
+{
+    Shard& shard = GetShard(nHashVote);
+    LOCK(shard.cs);
+    return shard.cmapVoteToObject.Insert(nHashVote, nHashParent);
+}
+
+void CGovernanceVoteIndex::RemoveObjectVotes(const uint256& nHashParent)
+{
+    for(Shard& shard : vShards) {
+        LOCK(shard.cs);
+        const vote_to_object_cm_t::list_t& listItems = shard.cmapVoteToObject.GetItemList();
+        vote_to_object_cm_t::list_cit lit = listItems.begin();
+        while(lit != listItems.end()) {
+            if(lit->value == nHashParent) {
+                uint256 nKey = lit->key;
+                ++lit;
+                shard.cmapVoteToObject.Erase(nKey);
+            }
+            else {
+                ++lit;
+            }
+        }
+    }
+}
+
+bool CGovernanceVoteIndex::IsInvalidVote(const uint256& nHashVote) const
+{
+    const Shard& shard = GetShard(nHashVote);
+    LOCK(shard.cs);
+    return shard.cmapInvalidVotes.HasKey(nHashVote);
+}
+
+void CGovernanceVoteIndex::AddInvalidVote(const CGovernanceVote& vote)
+{
+    uint256 nHashVote = vote.GetHash();
+    Shard& shard = GetShard(nHashVote);
+    LOCK(shard.cs);
+    shard.cmapInvalidVotes.Insert(nHashVote, vote);
+}
+
+void CGovernanceVoteIndex::ClearVotes()
+{
+    for(Shard& shard : vShards) {
+        LOCK(shard.cs);
+        shard.cmapVoteToObject.Clear();
+    }
+}
+
+void CGovernanceVoteIndex::Clear()
+{
+    for(Shard& shard : vShards) {
+        LOCK(shard.cs);
+        shard.cmapVoteToObject.Clear();
+        shard.cmapInvalidVotes.Clear();
+    }
+}
+
+int CGovernanceVoteIndex::GetVoteCount() const
+{
+    int nCount = 0;
+    for(const Shard& shard : vShards) {
+        LOCK(shard.cs);
+        nCount += shard.cmapVoteToObject.GetSize();
+    }
+    return nCount;
+}
+
+uint64_t CGovernanceVoteIndex::GetContentions() const
+{
+    uint64_t nContentions = 0;
+    for(const Shard& shard : vShards) {
+        nContentions += shard.cs.GetContentions();
+    }
+    return nContentions;
+}
+
+void CGovernanceVoteIndex::GetInvalidVotes(vote_cm_t& cmapInvalidVotesRet) const
+{
+    cmapInvalidVotesRet.Clear();
+    cmapInvalidVotesRet.SetMaxSize(vShards[0].cmapInvalidVotes.GetMaxSize() * SHARDS);
+    for(const Shard& shard : vShards) {
+        LOCK(shard.cs);
+        // oldest first, so that the most recent votes stay in front
+        const vote_cm_t::list_t& listItems = shard.cmapInvalidVotes.GetItemList();
+        for(vote_cm_t::list_t::const_reverse_iterator lit = listItems.rbegin(); lit != listItems.rend(); ++lit) {
+            cmapInvalidVotesRet.Insert(lit->key, lit->value);
+        }
+    }
+}
+
+void CGovernanceVoteIndex::SetInvalidVotes(const vote_cm_t& cmapInvalidVotes)
+{
+    const vote_cm_t::list_t& listItems = cmapInvalidVotes.GetItemList();
+    for(vote_cm_t::list_t::const_reverse_iterator lit = listItems.rbegin(); lit != listItems.rend(); ++lit) {
+        Shard& shard = GetShard(lit->key);
+        LOCK(shard.cs);
+        shard.cmapInvalidVotes.Insert(lit->key, lit->value);
+    }
+}
@@ -9,10 +9,13 @@
 
 #include <list>
 #include <map>
+#include <memory>
 
+#include "cachemap.h"
 #include "governance-vote.h"
 #include "serialize.h"
 #include "streams.h"
+#include "sync.h"
 #include "uint256.h"
 
 /**
@@ -47,6 +50,9 @@ private:
 
     vote_m_t mapVoteIndex;
 
+    /// Votes as last handed out by GetVotesSnapshot(), reset whenever they change
+    mutable std::shared_ptr<const std::vector<CGovernanceVote> > pvecVotesSnapshot;
+
 public:
     CGovernanceObjectVoteFile();
 
@@ -73,6 +79,12 @@ public:
 
     std::vector<CGovernanceVote> GetVotes() const;
 
+    /**
+     * Return the votes as an immutable snapshot which stays valid after the lock
+     * of the owning object is released. It is only rebuilt after the votes changed.
+     */
+    std::shared_ptr<const std::vector<CGovernanceVote> > GetVotesSnapshot() const;
+
     void RemoveVotesFromMasternode(const COutPoint& outpointMasternode);
 
     ADD_SERIALIZE_METHODS;
@@ -91,4 +103,82 @@ private:
 
 };
 
+/**
+ * Index of the votes known to the governance manager: the parent object of every
+ * valid vote, and the votes found invalid.
+ *
+ * The index is split in shards by vote hash, each behind its own lock, so that
+ * checking and recording votes from the network neither waits on the governance
+ * manager lock nor on lookups of unrelated votes. The votes themselves are stored
+ * per governance object, see CGovernanceObjectVoteFile.
+ */
+class CGovernanceVoteIndex
+{
+public: // Types
+    typedef CacheMap<uint256, uint256> vote_to_object_cm_t;
+
+    typedef CacheMap<uint256, CGovernanceVote> vote_cm_t;
+
+    static const int SHARDS = 16;
+
+private:
+    struct Shard
+    {
+        mutable CCriticalSection cs;
+        vote_to_object_cm_t cmapVoteToObject;
+        vote_cm_t cmapInvalidVotes;
+    };
+
+    Shard vShards[SHARDS];
+
+    Shard& GetShard(const uint256& nHashVote)
+    {
+        return vShards[nHashVote.GetCheapHash() % SHARDS];
+    }
+
+    const Shard& GetShard(const uint256& nHashVote) const
+    {
+        return vShards[nHashVote.GetCheapHash() % SHARDS];
+    }
+
+public:
+    explicit CGovernanceVoteIndex(int nMaxSize);
+
+    bool HasVote(const uint256& nHashVote) const;
+
+    bool GetVoteParent(const uint256& nHashVote, uint256& nHashParentRet) const;
+
+    /**
+     * Record a valid vote, returns false if it was known already
+     */
+    bool AddVote(const uint256& nHashVote, const uint256& nHashParent);
+
+    void RemoveObjectVotes(const uint256& nHashParent);
+
+    bool IsInvalidVote(const uint256& nHashVote) const;
+
+    void AddInvalidVote(const CGovernanceVote& vote);
+
+    /**
+     * Forget the valid votes only, e.g. to rebuild them from the governance objects
+     */
+    void ClearVotes();
+
+    void Clear();
+
+    int GetVoteCount() const;
+
+    /**
+     * Number of times a thread had to wait for the lock of a shard
+     */
+    uint64_t GetContentions() const;
+
+    /**
+     * Merge all invalid votes in a single cache, in the format stored on disk
+     */
+    void GetInvalidVotes(vote_cm_t& cmapInvalidVotesRet) const;
+
+    void SetInvalidVotes(const vote_cm_t& cmapInvalidVotes);
+};
+
 #endif
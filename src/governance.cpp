@@ -33,8 +33,7 @@ CGovernanceManager::CGovernanceManager()
       mapObjects(),
       mapErasedGovernanceObjects(),
       mapMasternodeOrphanObjects(),
-      cmapVoteToObject(MAX_CACHE_SIZE),
-      cmapInvalidVotes(MAX_CACHE_SIZE),
+      voteIndex(MAX_CACHE_SIZE),
       cmmapOrphanVotes(MAX_CACHE_SIZE),
       mapLastMasternodeObject(),
       setRequestedObjects(),
@@ -64,24 +63,27 @@ bool CGovernanceManager::SerializeObjectForHash(const uint256& nHash, CDataStrea
 
 bool CGovernanceManager::HaveVoteForHash(const uint256& nHash) const
 {
-    LOCK(cs);
+    uint256 nHashParent;
+    if(!voteIndex.GetVoteParent(nHash, nHashParent)) return false;
 
-    CGovernanceObject* pGovobj = NULL;
-    return cmapVoteToObject.Get(nHash, pGovobj) && pGovobj->GetVoteFile().HasVote(nHash);
+    LOCK(cs);
+    object_m_cit it = mapObjects.find(nHashParent);
+    return it != mapObjects.end() && it->second.GetVoteFile().HasVote(nHash);
 }
 
 int CGovernanceManager::GetVoteCount() const
 {
-    LOCK(cs);
-    return (int)cmapVoteToObject.GetSize();
+    return voteIndex.GetVoteCount();
 }
 
 bool CGovernanceManager::SerializeVoteForHash(const uint256& nHash, CDataStream& ss) const
 {
-    LOCK(cs);
+    uint256 nHashParent;
+    if(!voteIndex.GetVoteParent(nHash, nHashParent)) return false;
 
-    CGovernanceObject* pGovobj = NULL;
-    return cmapVoteToObject.Get(nHash,pGovobj) && pGovobj->GetVoteFile().SerializeVoteToStream(nHash, ss);
+    LOCK(cs);
+    object_m_cit it = mapObjects.find(nHashParent);
+    return it != mapObjects.end() && it->second.GetVoteFile().SerializeVoteToStream(nHash, ss);
 }
 
 void CGovernanceManager::ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman)
@@ -425,18 +427,7 @@ void CGovernanceManager::UpdateCachesAndClean()
             mnodeman.RemoveGovernanceObject(pObj->GetHash());
 
             // Remove vote references
-            const object_ref_cm_t::list_t& listItems = cmapVoteToObject.GetItemList();
-            object_ref_cm_t::list_cit lit = listItems.begin();
-            while(lit != listItems.end()) {
-                if(lit->value == pObj) {
-                    uint256 nKey = lit->key;
-                    ++lit;
-                    cmapVoteToObject.Erase(nKey);
-                }
-                else {
-                    ++lit;
-                }
-            }
+            voteIndex.RemoveObjectVotes(nHash);
 
             int64_t nTimeExpired{0};
 
@@ -490,26 +481,32 @@ CGovernanceObject* CGovernanceManager::FindGovernanceObject(const uint256& nHash
 
 std::vector<CGovernanceVote> CGovernanceManager::GetMatchingVotes(const uint256& nParentHash) const
 {
-    LOCK(cs);
-    std::vector<CGovernanceVote> vecResult;
-
-    object_m_cit it = mapObjects.find(nParentHash);
-    if(it == mapObjects.end()) {
-        return vecResult;
+    std::shared_ptr<const std::vector<CGovernanceVote> > pvecVotes;
+    {
+        LOCK(cs);
+        object_m_cit it = mapObjects.find(nParentHash);
+        if(it == mapObjects.end()) {
+            return std::vector<CGovernanceVote>();
+        }
+        pvecVotes = it->second.GetVotesSnapshot();
     }
 
-    return it->second.GetVoteFile().GetVotes();
+    // copy outside of the locks, the snapshot does not change anymore
+    return *pvecVotes;
 }
 
 std::vector<CGovernanceVote> CGovernanceManager::GetCurrentVotes(const uint256& nParentHash, const COutPoint& mnCollateralOutpointFilter) const
 {
-    LOCK(cs);
     std::vector<CGovernanceVote> vecResult;
 
     // Find the governance object or short-circuit.
-    object_m_cit it = mapObjects.find(nParentHash);
-    if(it == mapObjects.end()) return vecResult;
-    const CGovernanceObject& govobj = it->second;
+    CGovernanceObject::vote_m_t mapCurrentMNVotes;
+    {
+        LOCK(cs);
+        object_m_cit it = mapObjects.find(nParentHash);
+        if(it == mapObjects.end()) return vecResult;
+        mapCurrentMNVotes = it->second.GetCurrentMNVotes();
+    }
 
     CMasternode mn;
     std::map<COutPoint, CMasternode> mapMasternodes;
@@ -523,10 +520,11 @@ std::vector<CGovernanceVote> CGovernanceManager::GetCurrentVotes(const uint256&
     for (const auto& mnpair : mapMasternodes)
     {
         // get a vote_rec_t from the govobj
-        vote_rec_t voteRecord;
-        if (!govobj.GetCurrentMNVotes(mnpair.first, voteRecord)) continue;
+        CGovernanceObject::vote_m_cit it2 = mapCurrentMNVotes.find(mnpair.first);
+        if (it2 == mapCurrentMNVotes.end()) continue;
+        const vote_rec_t& voteRecord = it2->second;
 
-        for (vote_instance_m_it it3 = voteRecord.mapInstances.begin(); it3 != voteRecord.mapInstances.end(); ++it3) {
+        for (vote_instance_m_cit it3 = voteRecord.mapInstances.begin(); it3 != voteRecord.mapInstances.end(); ++it3) {
             int signal = (it3->first);
             int outcome = ((it3->second).eOutcome);
             int64_t nCreationTime = ((it3->second).nCreationTime);
@@ -541,33 +539,22 @@ std::vector<CGovernanceVote> CGovernanceManager::GetCurrentVotes(const uint256&
     return vecResult;
 }
 
-std::vector<const CGovernanceObject*> CGovernanceManager::GetAllNewerThan(int64_t nMoreThanTime) const
+std::vector<governance_object_summary_t> CGovernanceManager::GetSummariesNewerThan(int64_t nMoreThanTime) const
 {
     LOCK(cs);
 
-    std::vector<const CGovernanceObject*> vGovObjs;
+    std::vector<governance_object_summary_t> vSummaries;
 
-    object_m_cit it = mapObjects.begin();
-    while(it != mapObjects.end())
+    for (const auto& objpair : mapObjects)
     {
         // IF THIS OBJECT IS OLDER THAN TIME, CONTINUE
 
-        if((*it).second.GetCreationTime() < nMoreThanTime) {
-            ++it;
-            continue;
-        }
-
-        // ADD GOVERNANCE OBJECT TO LIST
-
-        const CGovernanceObject* pGovObj = &((*it).second);
-        vGovObjs.push_back(pGovObj);
-
-        // NEXT
+        if(objpair.second.GetCreationTime() < nMoreThanTime) continue;
 
-        ++it;
+        vSummaries.push_back(objpair.second.GetSummary());
     }
 
-    return vGovObjs;
+    return vSummaries;
 }
 
 //
@@ -617,7 +604,7 @@ bool CGovernanceManager::ConfirmInventoryRequest(const CInv& inv)
     break;
     case MSG_GOVERNANCE_OBJECT_VOTE:
     {
-        if(cmapVoteToObject.HasKey(inv.hash)) {
+        if(voteIndex.HasVote(inv.hash)) {
             LogPrint("gobject", "CGovernanceManager::ConfirmInventoryRequest already have governance vote, returning false\n");
             return false;
         }
@@ -848,27 +835,45 @@ bool CGovernanceManager::MasternodeRateCheck(const CGovernanceObject& govobj, bo
 
 bool CGovernanceManager::ProcessVote(CNode* pfrom, const CGovernanceVote& vote, CGovernanceException& exception, CConnman& connman)
 {
-    ENTER_CRITICAL_SECTION(cs);
     uint256 nHashVote = vote.GetHash();
     uint256 nHashGovobj = vote.GetParentHash();
 
-    if(cmapVoteToObject.HasKey(nHashVote)) {
+    if(voteIndex.HasVote(nHashVote)) {
         LogPrint("gobject", "CGovernanceObject::ProcessVote -- skipping known valid vote %s for object %s\n", nHashVote.ToString(), nHashGovobj.ToString());
-        LEAVE_CRITICAL_SECTION(cs);
         return false;
     }
 
-    if(cmapInvalidVotes.HasKey(nHashVote)) {
+    if(voteIndex.IsInvalidVote(nHashVote)) {
         std::ostringstream ostr;
         ostr << "CGovernanceManager::ProcessVote -- Old invalid vote "
                 << ", MN outpoint = " << vote.GetMasternodeOutpoint().ToStringShort()
                 << ", governance object hash = " << nHashGovobj.ToString();
         LogPrintf("%s\n", ostr.str());
         exception = CGovernanceException(ostr.str(), GOVERNANCE_EXCEPTION_PERMANENT_ERROR, 20);
-        LEAVE_CRITICAL_SECTION(cs);
         return false;
     }
 
+    // Verify the signature before taking cs, it doesn't depend on the object and is
+    // by far the most expensive part. Votes of unknown masternodes are left to
+    // CGovernanceObject::ProcessVote which keeps them as orphans.
+    bool fSignatureChecked = false;
+    if(mnodeman.Has(vote.GetMasternodeOutpoint())) {
+        if(!vote.IsValid(true)) {
+            std::ostringstream ostr;
+            ostr << "CGovernanceManager::ProcessVote -- Invalid vote"
+                    << ", MN outpoint = " << vote.GetMasternodeOutpoint().ToStringShort()
+                    << ", governance object hash = " << nHashGovobj.ToString()
+                    << ", vote hash = " << nHashVote.ToString();
+            LogPrintf("%s\n", ostr.str());
+            exception = CGovernanceException(ostr.str(), GOVERNANCE_EXCEPTION_PERMANENT_ERROR, 20);
+            AddInvalidVote(vote);
+            return false;
+        }
+        fSignatureChecked = true;
+    }
+
+    ENTER_CRITICAL_SECTION(cs);
+
     object_m_it it = mapObjects.find(nHashGovobj);
     if(it == mapObjects.end()) {
         std::ostringstream ostr;
@@ -895,7 +900,8 @@ bool CGovernanceManager::ProcessVote(CNode* pfrom, const CGovernanceVote& vote,
         return false;
     }
 
-    bool fOk = govobj.ProcessVote(pfrom, vote, exception, connman) && cmapVoteToObject.Insert(nHashVote, &govobj);
+    // the same vote could have been processed by another thread in the meantime
+    bool fOk = govobj.ProcessVote(pfrom, vote, exception, connman, fSignatureChecked) && voteIndex.AddVote(nHashVote, nHashGovobj);
     LEAVE_CRITICAL_SECTION(cs);
     return fOk;
 }
@@ -1189,12 +1195,12 @@ void CGovernanceManager::RebuildIndexes()
 {
     LOCK(cs);
 
-    cmapVoteToObject.Clear();
+    voteIndex.ClearVotes();
     for(object_m_it it = mapObjects.begin(); it != mapObjects.end(); ++it) {
         CGovernanceObject& govobj = it->second;
         std::vector<CGovernanceVote> vecVotes = govobj.GetVoteFile().GetVotes();
         for(size_t i = 0; i < vecVotes.size(); ++i) {
-            cmapVoteToObject.Insert(vecVotes[i].GetHash(), &govobj);
+            voteIndex.AddVote(vecVotes[i].GetHash(), it->first);
         }
     }
 }
@@ -1258,7 +1264,7 @@ std::string CGovernanceManager::ToString() const
     return strprintf("Governance Objects: %d (Proposals: %d, Triggers: %d, Other: %d; Erased: %d), Votes: %d",
                     (int)mapObjects.size(),
                     nProposalCount, nTriggerCount, nOtherCount, (int)mapErasedGovernanceObjects.size(),
-                    (int)cmapVoteToObject.GetSize());
+                    voteIndex.GetVoteCount());
 }
 
 UniValue CGovernanceManager::ToJson() const
@@ -1289,7 +1295,9 @@ UniValue CGovernanceManager::ToJson() const
     jsonObj.push_back(Pair("triggers", nTriggerCount));
     jsonObj.push_back(Pair("other", nOtherCount));
     jsonObj.push_back(Pair("erased", (int)mapErasedGovernanceObjects.size()));
-    jsonObj.push_back(Pair("votes", (int)cmapVoteToObject.GetSize()));
+    jsonObj.push_back(Pair("votes", voteIndex.GetVoteCount()));
+    jsonObj.push_back(Pair("lock_contentions", (uint64_t)cs.GetContentions()));
+    jsonObj.push_back(Pair("vote_index_lock_contentions", (uint64_t)voteIndex.GetContentions()));
     return jsonObj;
 }
 
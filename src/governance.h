@@ -180,8 +180,6 @@ public: // Types
 
     typedef object_m_t::const_iterator object_m_cit;
 
-    typedef CacheMap<uint256, CGovernanceObject*> object_ref_cm_t;
-
     typedef std::map<uint256, CGovernanceVote> vote_m_t;
 
     typedef vote_m_t::iterator vote_m_it;
@@ -247,9 +245,7 @@ private:
     object_m_t mapPostponedObjects;
     hash_s_t setAdditionalRelayObjects;
 
-    object_ref_cm_t cmapVoteToObject;
-
-    vote_cm_t cmapInvalidVotes;
+    CGovernanceVoteIndex voteIndex;
 
     vote_cmm_t cmmapOrphanVotes;
 
@@ -281,7 +277,7 @@ private:
     };
 
 public:
-    // critical section to protect the inner data structures
+    // critical section to protect the inner data structures, except voteIndex
     mutable CCriticalSection cs;
 
     CGovernanceManager();
@@ -307,7 +303,7 @@ public:
     // These commands are only used in RPC
     std::vector<CGovernanceVote> GetMatchingVotes(const uint256& nParentHash) const;
     std::vector<CGovernanceVote> GetCurrentVotes(const uint256& nParentHash, const COutPoint& mnCollateralOutpointFilter) const;
-    std::vector<const CGovernanceObject*> GetAllNewerThan(int64_t nMoreThanTime) const;
+    std::vector<governance_object_summary_t> GetSummariesNewerThan(int64_t nMoreThanTime) const;
 
     void AddGovernanceObject(CGovernanceObject& govobj, CConnman& connman, CNode* pfrom = NULL);
 
@@ -322,8 +318,7 @@ public:
         LogPrint("gobject", "Governance object manager was cleared\n");
         mapObjects.clear();
         mapErasedGovernanceObjects.clear();
-        cmapVoteToObject.Clear();
-        cmapInvalidVotes.Clear();
+        voteIndex.Clear();
         cmmapOrphanVotes.Clear();
         mapLastMasternodeObject.clear();
     }
@@ -346,7 +341,14 @@ public:
         }
 
         READWRITE(mapErasedGovernanceObjects);
+        vote_cm_t cmapInvalidVotes;
+        if(!ser_action.ForRead()) {
+            voteIndex.GetInvalidVotes(cmapInvalidVotes);
+        }
         READWRITE(cmapInvalidVotes);
+        if(ser_action.ForRead()) {
+            voteIndex.SetInvalidVotes(cmapInvalidVotes);
+        }
         READWRITE(cmmapOrphanVotes);
         READWRITE(mapObjects);
         READWRITE(mapLastMasternodeObject);
@@ -357,8 +359,8 @@ public:
     }
 
     void UpdatedBlockTip(const CBlockIndex *pindex, CConnman& connman);
-    int64_t GetLastDiffTime() const { return nTimeLastDiff; }
-    void UpdateLastDiffTime(int64_t nTimeIn) { nTimeLastDiff = nTimeIn; }
+    int64_t GetLastDiffTime() const { LOCK(cs); return nTimeLastDiff; }
+    void UpdateLastDiffTime(int64_t nTimeIn) { LOCK(cs); nTimeLastDiff = nTimeIn; }
 
     int GetCachedBlockHeight() const { return nCachedBlockHeight; }
 
@@ -418,7 +420,7 @@ private:
 
     void AddInvalidVote(const CGovernanceVote& vote)
     {
-        cmapInvalidVotes.Insert(vote.GetHash(), vote);
+        voteIndex.AddInvalidVote(vote);
     }
 
     void AddOrphanVote(const CGovernanceVote& vote)
@@ -197,9 +197,11 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
             strReply = JSONRPCReply(result, NullUniValue, jreq.id);
 
         // array of requests
-        } else if (valRequest.isArray())
-            strReply = JSONRPCExecBatch(valRequest.get_array());
-        else
+        } else if (valRequest.isArray()) {
+            // a batch never takes all workers
+            int64_t nBatchThreads = std::min(GetArg("-rpcbatchthreads", DEFAULT_RPC_BATCH_THREADS), GetArg("-rpcthreads", DEFAULT_HTTP_THREADS) - 1);
+            strReply = JSONRPCExecBatch(valRequest.get_array(), EnqueueHTTPWork, nBatchThreads);
+        } else
             throw JSONRPCError(RPC_PARSE_ERROR, "Top-level object parse error");
 
         req->WriteHeader("Content-Type", "application/json");
@@ -59,6 +59,22 @@ private:
     HTTPRequestHandler func;
 };
 
+/** Work item running an arbitrary function */
+class HTTPFunctionWorkItem : public HTTPClosure
+{
+public:
+    HTTPFunctionWorkItem(const std::function<void()>& _func): func(_func)
+    {
+    }
+    void operator()() override
+    {
+        func();
+    }
+
+private:
+    std::function<void()> func;
+};
+
 /** Simple work queue for distributing work over multiple threads.
  * Work items are simply callable objects.
  */
@@ -115,6 +131,17 @@ public:
         cond.notify_one();
         return true;
     }
+    /** Enqueue a work item if the queue is less than half full, keeping room for requests */
+    bool EnqueueSpare(WorkItem* item)
+    {
+        std::unique_lock<std::mutex> lock(cs);
+        if (queue.size() * 2 >= maxDepth) {
+            return false;
+        }
+        queue.emplace_back(std::unique_ptr<WorkItem>(item));
+        cond.notify_one();
+        return true;
+    }
     /** Thread function */
     void Run()
     {
@@ -515,6 +542,17 @@ void StopHTTPServer()
     LogPrint("http", "Stopped HTTP server\n");
 }
 
+bool EnqueueHTTPWork(const std::function<void()>& func)
+{
+    if (!workQueue)
+        return false;
+    std::unique_ptr<HTTPFunctionWorkItem> item(new HTTPFunctionWorkItem(func));
+    if (!workQueue->EnqueueSpare(item.get()))
+        return false;
+    item.release(); /* if true, queue took ownership */
+    return true;
+}
+
 struct event_base* EventBase()
 {
     return eventBase;
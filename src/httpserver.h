@@ -43,6 +43,11 @@ void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPR
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
 
+/** Run func on one of the HTTP worker threads.
+ * Returns false if the work queue is half full or not running, the rest is kept for requests.
+ */
+bool EnqueueHTTPWork(const std::function<void()>& func);
+
 /** Return evhttp event base. This can be used by submodules to
  * queue timers or custom events.
  */
@@ -0,0 +1,139 @@
+// Copyright (c) 2017-2019 The QuantisNet Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "indexwriter.h"
+
+#include "util.h"
+#include "validation.h"
+
+#include <chrono>
+#include <functional>
+
+CIndexWriter indexWriter;
+
+CIndexWriter::CIndexWriter() :
+    fRunning(false),
+    fWriting(false),
+    fFlushRequested(false),
+    fInterrupt(false),
+    fFailed(false)
+{
+}
+
+CIndexWriter::~CIndexWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        fInterrupt = true;
+    }
+    condQueued.notify_all();
+    if (threadWriter.joinable())
+        threadWriter.join();
+}
+
+bool CIndexWriter::WriteQueue(std::unique_lock<std::mutex>& lock)
+{
+    // keep the order of the updates, the previous batch must be on disk first
+    condWritten.wait(lock, [this] { return !fWriting; });
+    if (fFailed)
+        return false;
+    if (vQueue.empty())
+        return true;
+
+    std::vector<CIndexUpdate> vUpdates;
+    vUpdates.swap(vQueue);
+    fWriting = true;
+    lock.unlock();
+
+    int64_t nStart = GetTimeMicros();
+    bool fWritten = pblocktree->WriteIndexUpdates(vUpdates);
+    if (fWritten) {
+        LogPrint("bench", "- Index writer: %u blocks in %.2fms\n", vUpdates.size(), (GetTimeMicros() - nStart) * 0.001);
+    } else {
+        error("%s: failed to write the index updates of %u blocks", __func__, vUpdates.size());
+    }
+
+    lock.lock();
+    fWriting = false;
+    fFailed = fFailed || !fWritten;
+    condWritten.notify_all();
+    return fWritten;
+}
+
+void CIndexWriter::ThreadIndexWriter()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        condQueued.wait_for(lock, std::chrono::milliseconds(INDEX_WRITER_INTERVAL), [this] {
+            return fInterrupt || fFlushRequested || vQueue.size() >= INDEX_WRITER_BATCH_BLOCKS;
+        });
+        fFlushRequested = false;
+        WriteQueue(lock);
+        if (fInterrupt)
+            return;
+    }
+}
+
+void CIndexWriter::Start()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    assert(!fRunning);
+    fRunning = true;
+    fInterrupt = false;
+    threadWriter = std::thread(&TraceThread<std::function<void()> >, "idxwriter", std::function<void()>(std::bind(&CIndexWriter::ThreadIndexWriter, this)));
+}
+
+void CIndexWriter::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        fInterrupt = true;
+    }
+    condQueued.notify_all();
+    if (threadWriter.joinable())
+        threadWriter.join();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    fRunning = false;
+    fInterrupt = false;
+    // anything queued while the thread was finishing
+    if (pblocktree != NULL)
+        WriteQueue(lock);
+}
+
+bool CIndexWriter::Queue(CIndexUpdate&& update)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (fRunning) {
+        // don't let validation run arbitrarily far ahead of the disk
+        condWritten.wait(lock, [this] { return fFailed || vQueue.size() < INDEX_WRITER_MAX_QUEUED_BLOCKS; });
+        if (fFailed)
+            return false;
+        vQueue.push_back(std::move(update));
+        if (vQueue.size() >= INDEX_WRITER_BATCH_BLOCKS)
+            condQueued.notify_one();
+        return true;
+    }
+
+    if (fFailed)
+        return false;
+    vQueue.push_back(std::move(update));
+    if (vQueue.size() >= INDEX_WRITER_BATCH_BLOCKS)
+        return WriteQueue(lock);
+    return true;
+}
+
+bool CIndexWriter::Flush()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!fRunning)
+        return WriteQueue(lock);
+
+    if (!vQueue.empty()) {
+        fFlushRequested = true;
+        condQueued.notify_one();
+    }
+    condWritten.wait(lock, [this] { return fFailed || (vQueue.empty() && !fWriting); });
+    return !fFailed;
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2017-2019 The QuantisNet Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef INDEXWRITER_H
+#define INDEXWRITER_H
+
+#include "txdb.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** Write queued updates once this many blocks are waiting */
+static const size_t INDEX_WRITER_BATCH_BLOCKS = 100;
+/** Block the validation thread while this many blocks are waiting */
+static const size_t INDEX_WRITER_MAX_QUEUED_BLOCKS = 1000;
+/** Write queued updates at least this often (in milliseconds) */
+static const int INDEX_WRITER_INTERVAL = 1000;
+
+/**
+ * Writes the address, spent and timestamp index updates of connected and disconnected
+ * blocks to the block tree database on its own thread.
+ *
+ * Updates are applied strictly in the order they were queued, so a reorg undoes index
+ * entries before the new branch writes them again. All waiting updates go to disk in a
+ * single batch together with the index best block marker and the block index entries of
+ * the connected blocks, so after a crash the indexes match the marker, the marker names a
+ * block with undo data and CatchUpIndexes() can bring them back in line with the chain.
+ * Without a running thread (e.g. during startup or in tests) updates are written by the
+ * caller whenever a batch is full or Flush() is called.
+ */
+class CIndexWriter
+{
+private:
+    std::mutex mutex;
+    std::condition_variable condQueued;
+    std::condition_variable condWritten;
+    std::vector<CIndexUpdate> vQueue;
+    bool fRunning;
+    bool fWriting;
+    bool fFlushRequested;
+    bool fInterrupt;
+    bool fFailed;
+    std::thread threadWriter;
+
+    void ThreadIndexWriter();
+    bool WriteQueue(std::unique_lock<std::mutex>& lock);
+
+public:
+    CIndexWriter();
+    ~CIndexWriter();
+
+    void Start();
+    /** Stop the writer thread after writing everything queued */
+    void Stop();
+
+    /** Queue an update, false if an earlier write failed */
+    bool Queue(CIndexUpdate&& update);
+    /** Wait until everything queued so far is on disk, false if a write failed */
+    bool Flush();
+};
+
+extern CIndexWriter indexWriter;
+
+#endif // INDEXWRITER_H
@@ -5,6 +5,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "activemasternode.h"
+#include "checkqueue.h"
 #include "instantx.h"
 #include "key.h"
 #include "validation.h"
@@ -41,6 +42,8 @@ int nCompleteTXLocks;
 
 CInstantSend instantsend;
 
+static CCheckQueue<CTxLockVoteCheck> txlockvotecheckqueue(16);
+
 // Transaction Locks
 //
 // step 1) Some node announces intention to lock transaction inputs via "txlockrequest" message (ix)
@@ -83,9 +86,22 @@ void CInstantSend::ProcessMessage(CNode* pfrom, const std::string& strCommand, C
             LOCK(cs_instantsend);
             auto ret = mapTxLockVotes.emplace(nVoteHash, vote);
             if (!ret.second) return;
+            ScheduleVoteTimeout(vote, false);
         }
 
-        ProcessNewTxLockVote(pfrom, vote, connman);
+        // everything but the signature is cheap to check here, where the peer can still be asked for a missing masternode
+        masternode_info_t infoMn;
+        if(!vote.IsValid(pfrom, connman, false) || !mnodeman.GetMasternodeInfo(vote.GetMasternodeOutpoint(), infoMn)) {
+            // could be because of missing MN
+            LogPrint("instantsend", "CInstantSend::%s -- Vote is invalid, txid=%s\n", __func__, vote.GetTxHash().ToString());
+            return;
+        }
+
+        {
+            boost::unique_lock<boost::mutex> lock(cs_pendingvotes);
+            vecTxLockVotesPending.emplace_back(vote, infoMn.pubKeyMasternode);
+        }
+        condPendingVotes.notify_one();
 
         return;
     }
@@ -137,7 +153,7 @@ bool CInstantSend::ProcessTxLockRequest(const CTxLockRequest& txLockRequest, CCo
     // If this just happened - process orphan votes, lock inputs, resolve conflicting locks,
     // update transaction status forcing external script/zmq notifications.
     ProcessOrphanTxLockVotes();
-    std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.find(txHash);
+    auto itLockCandidate = mapTxLockCandidates.find(txHash);
     TryToFinalizeLockCandidate(itLockCandidate->second);
 
     return true;
@@ -151,7 +167,7 @@ bool CInstantSend::CreateTxLockCandidate(const CTxLockRequest& txLockRequest)
 
     uint256 txHash = txLockRequest.GetHash();
 
-    std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.find(txHash);
+    auto itLockCandidate = mapTxLockCandidates.find(txHash);
     if(itLockCandidate == mapTxLockCandidates.end()) {
         LogPrintf("CInstantSend::CreateTxLockCandidate -- new, txid=%s\n", txHash.ToString());
 
@@ -260,7 +276,7 @@ void CInstantSend::Vote(CTxLockCandidate& txLockCandidate, CConnman& connman)
         bool fAlreadyVoted = false;
         if(itVoted != mapVotedOutpoints.end()) {
             for (const auto& hash : itVoted->second) {
-                std::map<uint256, CTxLockCandidate>::iterator it2 = mapTxLockCandidates.find(hash);
+                auto it2 = mapTxLockCandidates.find(hash);
                 if(it2->second.HasMasternodeVoted(itOutpointLock->first, activeMasternode.outpoint)) {
                     // we already voted for this outpoint to be included either in the same tx or in a competing one,
                     // skip it anyway
@@ -290,7 +306,9 @@ void CInstantSend::Vote(CTxLockCandidate& txLockCandidate, CConnman& connman)
 
         // vote constructed sucessfully, let's store and relay it
         uint256 nVoteHash = vote.GetHash();
-        mapTxLockVotes.insert(std::make_pair(nVoteHash, vote));
+        if(mapTxLockVotes.insert(std::make_pair(nVoteHash, vote)).second) {
+            ScheduleVoteTimeout(vote, false);
+        }
         if(itOutpointLock->second.AddVote(vote)) {
             LogPrintf("CInstantSend::Vote -- Vote created successfully, relaying: txHash=%s, outpoint=%s, vote=%s\n",
                     txHash.ToString(), itOutpointLock->first.ToStringShort(), nVoteHash.ToString());
@@ -315,19 +333,42 @@ void CInstantSend::Vote(CTxLockCandidate& txLockCandidate, CConnman& connman)
     }
 }
 
-bool CInstantSend::ProcessNewTxLockVote(CNode* pfrom, const CTxLockVote& vote, CConnman& connman)
+void CInstantSend::WaitForPendingTxLockVotes()
 {
-    uint256 txHash = vote.GetTxHash();
-    uint256 nVoteHash = vote.GetHash();
+    boost::unique_lock<boost::mutex> lock(cs_pendingvotes);
+    while (vecTxLockVotesPending.empty()) {
+        condPendingVotes.wait(lock);
+    }
+}
 
-    if(!vote.IsValid(pfrom, connman)) {
-        // could be because of missing MN
-        LogPrint("instantsend", "CInstantSend::%s -- Vote is invalid, txid=%s\n", __func__, txHash.ToString());
-        return false;
+size_t CInstantSend::ProcessPendingTxLockVotes(CConnman& connman)
+{
+    std::vector<std::pair<CTxLockVote, CPubKey> > vecVotes;
+    {
+        boost::unique_lock<boost::mutex> lock(cs_pendingvotes);
+        if (vecTxLockVotesPending.size() <= MAX_TXLOCKVOTE_BATCH) {
+            vecVotes.swap(vecTxLockVotesPending);
+        } else {
+            auto itEnd = vecTxLockVotesPending.begin() + MAX_TXLOCKVOTE_BATCH;
+            vecVotes.assign(vecTxLockVotesPending.begin(), itEnd);
+            vecTxLockVotesPending.erase(vecTxLockVotesPending.begin(), itEnd);
+        }
     }
+    if (vecVotes.empty()) return 0;
+
+    // signatures are verified without holding any lock, only the valid votes are applied below
+    std::vector<char> vValid;
+    CheckTxLockVoteSignatures(vecVotes, sporkManager.IsSporkActive(SPORK_6_NEW_SIGS), vValid,
+                              nScriptCheckThreads ? &txlockvotecheckqueue : NULL);
 
-    // relay valid vote asap
-    vote.Relay(connman);
+    // relay valid votes asap
+    for (size_t i = 0; i < vecVotes.size(); ++i) {
+        if (vValid[i]) {
+            vecVotes[i].first.Relay(connman);
+        } else {
+            LogPrintf("CInstantSend::%s -- Signature invalid, txid=%s\n", __func__, vecVotes[i].first.GetTxHash().ToString());
+        }
+    }
 
     LOCK(cs_main);
 #ifdef ENABLE_WALLET
@@ -335,10 +376,32 @@ bool CInstantSend::ProcessNewTxLockVote(CNode* pfrom, const CTxLockVote& vote, C
 #endif
     LOCK2(mempool.cs, cs_instantsend);
 
+    for (size_t i = 0; i < vecVotes.size(); ++i) {
+        if (vValid[i]) {
+            ProcessNewTxLockVote(vecVotes[i].first);
+        }
+    }
+
+    return vecVotes.size();
+}
+
+bool CInstantSend::ProcessNewTxLockVote(const CTxLockVote& vote)
+{
+    // cs_main, cs_wallet and cs_instantsend should be already locked
+    AssertLockHeld(cs_main);
+#ifdef ENABLE_WALLET
+    if (pwalletMain)
+        AssertLockHeld(pwalletMain->cs_wallet);
+#endif
+    AssertLockHeld(cs_instantsend);
+
+    uint256 txHash = vote.GetTxHash();
+    uint256 nVoteHash = vote.GetHash();
+
     // Masternodes will sometimes propagate votes before the transaction is known to the client,
     // will actually process only after the lock request itself has arrived
 
-    std::map<uint256, CTxLockCandidate>::iterator it = mapTxLockCandidates.find(txHash);
+    auto it = mapTxLockCandidates.find(txHash);
     if(it == mapTxLockCandidates.end() || !it->second.txLockRequest) {
         // no or empty tx lock candidate
         if(it == mapTxLockCandidates.end()) {
@@ -346,6 +409,9 @@ bool CInstantSend::ProcessNewTxLockVote(CNode* pfrom, const CTxLockVote& vote, C
             CreateEmptyTxLockCandidate(txHash);
         }
         bool fInserted = mapTxLockVotesOrphan.emplace(nVoteHash, vote).second;
+        if(fInserted) {
+            ScheduleVoteTimeout(vote, true);
+        }
         LogPrint("instantsend", "CInstantSend::%s -- Orphan vote: txid=%s  masternode=%s %s\n",
                 __func__, txHash.ToString(), vote.GetMasternodeOutpoint().ToStringShort(), fInserted ? "new" : "seen");
 
@@ -355,7 +421,7 @@ bool CInstantSend::ProcessNewTxLockVote(CNode* pfrom, const CTxLockVote& vote, C
         int nMasternodeOrphanExpireTime = GetTime() + 60*10; // keep time data for 10 minutes
         auto itMnOV = mapMasternodeOrphanVotes.find(vote.GetMasternodeOutpoint());
         if(itMnOV == mapMasternodeOrphanVotes.end()) {
-            mapMasternodeOrphanVotes.emplace(vote.GetMasternodeOutpoint(), nMasternodeOrphanExpireTime);
+            SetMasternodeOrphanVoteTime(vote.GetMasternodeOutpoint(), nMasternodeOrphanExpireTime);
         } else {
             if(itMnOV->second > GetTime() && itMnOV->second > GetAverageMasternodeOrphanVoteTime()) {
                 LogPrint("instantsend", "CInstantSend::%s -- masternode is spamming orphan Transaction Lock Votes: txid=%s  masternode=%s\n",
@@ -364,7 +430,7 @@ bool CInstantSend::ProcessNewTxLockVote(CNode* pfrom, const CTxLockVote& vote, C
                 return false;
             }
             // not spamming, refresh
-            itMnOV->second = nMasternodeOrphanExpireTime;
+            SetMasternodeOrphanVoteTime(vote.GetMasternodeOutpoint(), nMasternodeOrphanExpireTime);
         }
 
         return true;
@@ -410,7 +476,7 @@ bool CInstantSend::ProcessOrphanTxLockVote(const CTxLockVote& vote)
     uint256 txHash = vote.GetTxHash();
 
     // We shouldn't process orphan votes without a valid tx lock candidate
-    std::map<uint256, CTxLockCandidate>::iterator it = mapTxLockCandidates.find(txHash);
+    auto it = mapTxLockCandidates.find(txHash);
     if(it == mapTxLockCandidates.end() || !it->second.txLockRequest)
         return false; // this shouldn never happen
 
@@ -451,7 +517,7 @@ void CInstantSend::UpdateVotedOutpoints(const CTxLockVote& vote, CTxLockCandidat
                 // same outpoint was already voted to be locked by another tx lock request,
                 // let's see if it was the same masternode who voted on this outpoint
                 // for another tx lock request
-                std::map<uint256, CTxLockCandidate>::iterator it2 = mapTxLockCandidates.find(hash);
+                auto it2 = mapTxLockCandidates.find(hash);
                 if(it2 !=mapTxLockCandidates.end() && it2->second.HasMasternodeVoted(vote.GetOutpoint(), vote.GetMasternodeOutpoint())) {
                     // yes, it was the same masternode
                     LogPrintf("CInstantSend::%s -- masternode sent conflicting votes! %s\n", __func__, vote.GetMasternodeOutpoint().ToStringShort());
@@ -480,7 +546,7 @@ void CInstantSend::ProcessOrphanTxLockVotes()
     AssertLockHeld(cs_main);
     AssertLockHeld(cs_instantsend);
 
-    std::map<uint256, CTxLockVote>::iterator it = mapTxLockVotesOrphan.begin();
+    auto it = mapTxLockVotesOrphan.begin();
     while(it != mapTxLockVotesOrphan.end()) {
         if(ProcessOrphanTxLockVote(it->second)) {
             mapTxLockVotesOrphan.erase(it++);
@@ -585,8 +651,8 @@ bool CInstantSend::ResolveConflicts(const CTxLockCandidate& txLockCandidate)
         if(GetLockedOutPointTxHash(txin.prevout, hashConflicting) && txHash != hashConflicting) {
             // completed lock which conflicts with another completed one?
             // this means that majority of MNs in the quorum for this specific tx input are malicious!
-            std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.find(txHash);
-            std::map<uint256, CTxLockCandidate>::iterator itLockCandidateConflicting = mapTxLockCandidates.find(hashConflicting);
+            auto itLockCandidate = mapTxLockCandidates.find(txHash);
+            auto itLockCandidateConflicting = mapTxLockCandidates.find(hashConflicting);
             if(itLockCandidate == mapTxLockCandidates.end() || itLockCandidateConflicting == mapTxLockCandidates.end()) {
                 // safety check, should never really happen
                 LogPrintf("CInstantSend::ResolveConflicts -- ERROR: Found conflicting completed Transaction Lock, but one of txLockCandidate-s is missing, txid=%s, conflicting txid=%s\n",
@@ -599,6 +665,8 @@ bool CInstantSend::ResolveConflicts(const CTxLockCandidate& txLockCandidate)
             CTxLockRequest txLockRequestConflicting = itLockCandidateConflicting->second.txLockRequest;
             itLockCandidate->second.SetConfirmedHeight(0); // expired
             itLockCandidateConflicting->second.SetConfirmedHeight(0); // expired
+            ScheduleCandidateExpiry(txHash, 0);
+            ScheduleCandidateExpiry(hashConflicting, 0);
             CheckAndRemove(); // clean up
             // AlreadyHave should still return "true" for both of them
             mapLockRequestRejected.insert(std::make_pair(txHash, txLockRequest));
@@ -650,15 +718,41 @@ int64_t CInstantSend::GetAverageMasternodeOrphanVoteTime()
     // NOTE: should never actually call this function when mapMasternodeOrphanVotes is empty
     if(mapMasternodeOrphanVotes.empty()) return 0;
 
-    std::map<COutPoint, int64_t>::iterator it = mapMasternodeOrphanVotes.begin();
-    int64_t total = 0;
+    return nMasternodeOrphanVoteTimeTotal / (int64_t)mapMasternodeOrphanVotes.size();
+}
+
+void CInstantSend::SetMasternodeOrphanVoteTime(const COutPoint& outpointMasternode, int64_t nTime)
+{
+    AssertLockHeld(cs_instantsend);
 
-    while(it != mapMasternodeOrphanVotes.end()) {
-        total+= it->second;
-        ++it;
-    }
+    int64_t& nTimeStored = mapMasternodeOrphanVotes[outpointMasternode];
+    nMasternodeOrphanVoteTimeTotal += nTime - nTimeStored;
+    nTimeStored = nTime;
+    wheelMasternodeOrphanVotes.Schedule(outpointMasternode, nTime + 1);
+}
 
-    return total / mapMasternodeOrphanVotes.size();
+void CInstantSend::ScheduleCandidateExpiry(const uint256& txHash, int nConfirmedHeight)
+{
+    AssertLockHeld(cs_instantsend);
+    if(nConfirmedHeight == -1) return; // can't expire until confirmed again
+
+    wheelExpiredCandidates.Schedule(txHash, nConfirmedHeight + Params().GetConsensus().nInstantSendKeepLock + 1);
+}
+
+void CInstantSend::ScheduleVoteExpiry(const CTxLockVote& vote, int nConfirmedHeight)
+{
+    AssertLockHeld(cs_instantsend);
+    if(nConfirmedHeight == -1) return; // can't expire until confirmed again
+
+    wheelExpiredVotes.Schedule(vote.GetHash(), nConfirmedHeight + Params().GetConsensus().nInstantSendKeepLock + 1);
+}
+
+void CInstantSend::ScheduleVoteTimeout(const CTxLockVote& vote, bool fOrphan)
+{
+    AssertLockHeld(cs_instantsend);
+
+    int nTimeout = fOrphan ? INSTANTSEND_LOCK_TIMEOUT_SECONDS : INSTANTSEND_FAILED_TIMEOUT_SECONDS;
+    wheelTimedOutVotes.Schedule(vote.GetHash(), vote.GetTimeCreated() + nTimeout + 1);
 }
 
 void CInstantSend::CheckAndRemove()
@@ -667,10 +761,13 @@ void CInstantSend::CheckAndRemove()
 
     LOCK(cs_instantsend);
 
-    std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.begin();
+    std::vector<uint256> vHashes;
 
     // remove expired candidates
-    while(itLockCandidate != mapTxLockCandidates.end()) {
+    wheelExpiredCandidates.PopDue(nCachedBlockHeight, vHashes);
+    for (const auto& hash : vHashes) {
+        auto itLockCandidate = mapTxLockCandidates.find(hash);
+        if(itLockCandidate == mapTxLockCandidates.end()) continue;
         CTxLockCandidate &txLockCandidate = itLockCandidate->second;
         uint256 txHash = txLockCandidate.GetHash();
         if(txLockCandidate.IsExpired(nCachedBlockHeight)) {
@@ -683,63 +780,86 @@ void CInstantSend::CheckAndRemove()
             }
             mapLockRequestAccepted.erase(txHash);
             mapLockRequestRejected.erase(txHash);
-            mapTxLockCandidates.erase(itLockCandidate++);
-        } else {
-            ++itLockCandidate;
+            mapTxLockCandidates.erase(itLockCandidate);
         }
     }
 
     // remove expired votes
-    std::map<uint256, CTxLockVote>::iterator itVote = mapTxLockVotes.begin();
-    while(itVote != mapTxLockVotes.end()) {
-        if(itVote->second.IsExpired(nCachedBlockHeight)) {
+    vHashes.clear();
+    wheelExpiredVotes.PopDue(nCachedBlockHeight, vHashes);
+    for (const auto& hash : vHashes) {
+        auto itVote = mapTxLockVotes.find(hash);
+        if(itVote != mapTxLockVotes.end() && itVote->second.IsExpired(nCachedBlockHeight)) {
             LogPrint("instantsend", "CInstantSend::CheckAndRemove -- Removing expired vote: txid=%s  masternode=%s\n",
                     itVote->second.GetTxHash().ToString(), itVote->second.GetMasternodeOutpoint().ToStringShort());
-            mapTxLockVotes.erase(itVote++);
-        } else {
-            ++itVote;
+            mapTxLockVotes.erase(itVote);
         }
     }
 
-    // remove timed out orphan votes
-    std::map<uint256, CTxLockVote>::iterator itOrphanVote = mapTxLockVotesOrphan.begin();
-    while(itOrphanVote != mapTxLockVotesOrphan.end()) {
-        if(itOrphanVote->second.IsTimedOut()) {
+    // remove timed out orphan votes, invalid votes and votes for failed lock attempts
+    vHashes.clear();
+    wheelTimedOutVotes.PopDue(GetTime(), vHashes);
+    for (const auto& hash : vHashes) {
+        auto itOrphanVote = mapTxLockVotesOrphan.find(hash);
+        if(itOrphanVote != mapTxLockVotesOrphan.end() && itOrphanVote->second.IsTimedOut()) {
             LogPrint("instantsend", "CInstantSend::CheckAndRemove -- Removing timed out orphan vote: txid=%s  masternode=%s\n",
                     itOrphanVote->second.GetTxHash().ToString(), itOrphanVote->second.GetMasternodeOutpoint().ToStringShort());
-            mapTxLockVotes.erase(itOrphanVote->first);
-            mapTxLockVotesOrphan.erase(itOrphanVote++);
-        } else {
-            ++itOrphanVote;
+            mapTxLockVotes.erase(hash);
+            mapTxLockVotesOrphan.erase(itOrphanVote);
+            continue;
         }
-    }
-
-    // remove invalid votes and votes for failed lock attempts
-    itVote = mapTxLockVotes.begin();
-    while(itVote != mapTxLockVotes.end()) {
+        auto itVote = mapTxLockVotes.find(hash);
+        if(itVote == mapTxLockVotes.end()) continue;
         if(itVote->second.IsFailed()) {
             LogPrint("instantsend", "CInstantSend::CheckAndRemove -- Removing vote for failed lock attempt: txid=%s  masternode=%s\n",
                     itVote->second.GetTxHash().ToString(), itVote->second.GetMasternodeOutpoint().ToStringShort());
-            mapTxLockVotes.erase(itVote++);
+            mapTxLockVotes.erase(itVote);
         } else {
-            ++itVote;
+            // not failed yet or locked, which can still change, look again later
+            int64_t nFailedTime = itVote->second.GetTimeCreated() + INSTANTSEND_FAILED_TIMEOUT_SECONDS + 1;
+            wheelTimedOutVotes.Schedule(hash, std::max(nFailedTime, GetTime() + INSTANTSEND_FAILED_TIMEOUT_SECONDS));
         }
     }
 
     // remove timed out masternode orphan votes (DOS protection)
-    std::map<COutPoint, int64_t>::iterator itMasternodeOrphan = mapMasternodeOrphanVotes.begin();
-    while(itMasternodeOrphan != mapMasternodeOrphanVotes.end()) {
-        if(itMasternodeOrphan->second < GetTime()) {
+    std::vector<COutPoint> vOutpoints;
+    wheelMasternodeOrphanVotes.PopDue(GetTime(), vOutpoints);
+    for (const auto& outpoint : vOutpoints) {
+        auto itMasternodeOrphan = mapMasternodeOrphanVotes.find(outpoint);
+        // refreshed entries were scheduled again
+        if(itMasternodeOrphan != mapMasternodeOrphanVotes.end() && itMasternodeOrphan->second < GetTime()) {
             LogPrint("instantsend", "CInstantSend::CheckAndRemove -- Removing timed out orphan masternode vote: masternode=%s\n",
                     itMasternodeOrphan->first.ToStringShort());
-            mapMasternodeOrphanVotes.erase(itMasternodeOrphan++);
-        } else {
-            ++itMasternodeOrphan;
+            nMasternodeOrphanVoteTimeTotal -= itMasternodeOrphan->second;
+            mapMasternodeOrphanVotes.erase(itMasternodeOrphan);
         }
     }
     LogPrintf("CInstantSend::CheckAndRemove -- %s\n", ToString());
 }
 
+void CInstantSend::GetMemoryStats(size_t& nCandidates, size_t& nVotes, size_t& nOrphanVotes, size_t& nScheduled, size_t& nUsage)
+{
+    LOCK(cs_instantsend);
+
+    nCandidates = mapTxLockCandidates.size();
+    nVotes = mapTxLockVotes.size();
+    nOrphanVotes = mapTxLockVotesOrphan.size();
+    nScheduled = wheelExpiredCandidates.GetSize() + wheelExpiredVotes.GetSize() +
+                 wheelTimedOutVotes.GetSize() + wheelMasternodeOrphanVotes.GetSize();
+    nUsage = memusage::DynamicUsage(mapLockRequestAccepted) +
+             memusage::DynamicUsage(mapLockRequestRejected) +
+             memusage::DynamicUsage(mapTxLockVotes) +
+             memusage::DynamicUsage(mapTxLockVotesOrphan) +
+             memusage::DynamicUsage(mapTxLockCandidates) +
+             memusage::DynamicUsage(mapVotedOutpoints) +
+             memusage::DynamicUsage(mapLockedOutpoints) +
+             memusage::DynamicUsage(mapMasternodeOrphanVotes) +
+             wheelExpiredCandidates.DynamicMemoryUsage() +
+             wheelExpiredVotes.DynamicMemoryUsage() +
+             wheelTimedOutVotes.DynamicMemoryUsage() +
+             wheelMasternodeOrphanVotes.DynamicMemoryUsage();
+}
+
 bool CInstantSend::AlreadyHave(const uint256& hash)
 {
     LOCK(cs_instantsend);
@@ -770,7 +890,7 @@ bool CInstantSend::GetTxLockRequest(const uint256& txHash, CTxLockRequest& txLoc
 {
     LOCK(cs_instantsend);
 
-    std::map<uint256, CTxLockCandidate>::iterator it = mapTxLockCandidates.find(txHash);
+    auto it = mapTxLockCandidates.find(txHash);
     if(it == mapTxLockCandidates.end() || !it->second.txLockRequest) return false;
     txLockRequestRet = it->second.txLockRequest;
 
@@ -781,7 +901,7 @@ bool CInstantSend::GetTxLockVote(const uint256& hash, CTxLockVote& txLockVoteRet
 {
     LOCK(cs_instantsend);
 
-    std::map<uint256, CTxLockVote>::iterator it = mapTxLockVotes.find(hash);
+    auto it = mapTxLockVotes.find(hash);
     if(it == mapTxLockVotes.end()) return false;
     txLockVoteRet = it->second;
 
@@ -796,7 +916,7 @@ bool CInstantSend::IsInstantSendReadyToLock(const uint256& txHash)
     LOCK(cs_instantsend);
     // There must be a successfully verified lock request
     // and all outputs must be locked (i.e. have enough signatures)
-    std::map<uint256, CTxLockCandidate>::iterator it = mapTxLockCandidates.find(txHash);
+    auto it = mapTxLockCandidates.find(txHash);
     return it != mapTxLockCandidates.end() && it->second.IsAllOutPointsReady();
 }
 
@@ -808,7 +928,7 @@ bool CInstantSend::IsLockedInstantSendTransaction(const uint256& txHash)
     LOCK(cs_instantsend);
 
     // there must be a lock candidate
-    std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.find(txHash);
+    auto itLockCandidate = mapTxLockCandidates.find(txHash);
     if(itLockCandidate == mapTxLockCandidates.end()) return false;
 
     // which should have outpoints
@@ -833,7 +953,7 @@ int CInstantSend::GetTransactionLockSignatures(const uint256& txHash)
 
     LOCK(cs_instantsend);
 
-    std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.find(txHash);
+    auto itLockCandidate = mapTxLockCandidates.find(txHash);
     if(itLockCandidate != mapTxLockCandidates.end()) {
         return itLockCandidate->second.CountVotes();
     }
@@ -852,7 +972,7 @@ bool CInstantSend::IsTxLockCandidateTimedOut(const uint256& txHash)
 
     LOCK(cs_instantsend);
 
-    std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.find(txHash);
+    auto itLockCandidate = mapTxLockCandidates.find(txHash);
     if (itLockCandidate != mapTxLockCandidates.end()) {
         return !itLockCandidate->second.IsAllOutPointsReady() &&
                 itLockCandidate->second.IsTimedOut();
@@ -865,7 +985,7 @@ void CInstantSend::Relay(const uint256& txHash, CConnman& connman)
 {
     LOCK(cs_instantsend);
 
-    std::map<uint256, CTxLockCandidate>::const_iterator itLockCandidate = mapTxLockCandidates.find(txHash);
+    auto itLockCandidate = mapTxLockCandidates.find(txHash);
     if (itLockCandidate != mapTxLockCandidates.end()) {
         itLockCandidate->second.Relay(connman);
     }
@@ -893,25 +1013,26 @@ void CInstantSend::SyncTransaction(const CTransaction& tx, const CBlockIndex *pi
     LogPrint("instantsend", "CInstantSend::SyncTransaction -- txid=%s nHeightNew=%d\n", txHash.ToString(), nHeightNew);
 
     // Check lock candidates
-    std::map<uint256, CTxLockCandidate>::iterator itLockCandidate = mapTxLockCandidates.find(txHash);
+    auto itLockCandidate = mapTxLockCandidates.find(txHash);
     if(itLockCandidate != mapTxLockCandidates.end()) {
         LogPrint("instantsend", "CInstantSend::SyncTransaction -- txid=%s nHeightNew=%d lock candidate updated\n",
                 txHash.ToString(), nHeightNew);
         itLockCandidate->second.SetConfirmedHeight(nHeightNew);
+        ScheduleCandidateExpiry(txHash, nHeightNew);
         // Loop through outpoint locks
         std::map<COutPoint, COutPointLock>::iterator itOutpointLock = itLockCandidate->second.mapOutPointLocks.begin();
         while(itOutpointLock != itLockCandidate->second.mapOutPointLocks.end()) {
             // Check corresponding lock votes
             std::vector<CTxLockVote> vVotes = itOutpointLock->second.GetVotes();
             std::vector<CTxLockVote>::iterator itVote = vVotes.begin();
-            std::map<uint256, CTxLockVote>::iterator it;
             while(itVote != vVotes.end()) {
                 uint256 nVoteHash = itVote->GetHash();
                 LogPrint("instantsend", "CInstantSend::SyncTransaction -- txid=%s nHeightNew=%d vote %s updated\n",
                         txHash.ToString(), nHeightNew, nVoteHash.ToString());
-                it = mapTxLockVotes.find(nVoteHash);
+                auto it = mapTxLockVotes.find(nVoteHash);
                 if(it != mapTxLockVotes.end()) {
                     it->second.SetConfirmedHeight(nHeightNew);
+                    ScheduleVoteExpiry(it->second, nHeightNew);
                 }
                 ++itVote;
             }
@@ -920,12 +1041,14 @@ void CInstantSend::SyncTransaction(const CTransaction& tx, const CBlockIndex *pi
     }
 
     // check orphan votes
-    std::map<uint256, CTxLockVote>::iterator itOrphanVote = mapTxLockVotesOrphan.begin();
+    auto itOrphanVote = mapTxLockVotesOrphan.begin();
     while(itOrphanVote != mapTxLockVotesOrphan.end()) {
         if(itOrphanVote->second.GetTxHash() == txHash) {
             LogPrint("instantsend", "CInstantSend::SyncTransaction -- txid=%s nHeightNew=%d vote %s updated\n",
                     txHash.ToString(), nHeightNew, itOrphanVote->first.ToString());
-            mapTxLockVotes[itOrphanVote->first].SetConfirmedHeight(nHeightNew);
+            CTxLockVote& vote = mapTxLockVotes[itOrphanVote->first];
+            vote.SetConfirmedHeight(nHeightNew);
+            ScheduleVoteExpiry(vote, nHeightNew);
         }
         ++itOrphanVote;
     }
@@ -1011,7 +1134,7 @@ int CTxLockRequest::GetMaxSignatures() const
 // CTxLockVote
 //
 
-bool CTxLockVote::IsValid(CNode* pnode, CConnman& connman) const
+bool CTxLockVote::IsValid(CNode* pnode, CConnman& connman, bool fCheckSignature) const
 {
     if(!mnodeman.Has(outpointMasternode)) {
         LogPrint("instantsend", "CTxLockVote::IsValid -- Unknown masternode %s\n", outpointMasternode.ToStringShort());
@@ -1043,7 +1166,7 @@ bool CTxLockVote::IsValid(CNode* pnode, CConnman& connman) const
         return false;
     }
 
-    if(!CheckSignature()) {
+    if(fCheckSignature && !CheckSignature()) {
         LogPrintf("CTxLockVote::IsValid -- Signature invalid\n");
         return false;
     }
@@ -1063,8 +1186,6 @@ uint256 CTxLockVote::GetSignatureHash() const
 
 bool CTxLockVote::CheckSignature() const
 {
-    std::string strError;
-
     masternode_info_t infoMn;
 
     if(!mnodeman.GetMasternodeInfo(outpointMasternode, infoMn)) {
@@ -1072,13 +1193,20 @@ bool CTxLockVote::CheckSignature() const
         return false;
     }
 
-    if (sporkManager.IsSporkActive(SPORK_6_NEW_SIGS)) {
+    return CheckSignature(infoMn.pubKeyMasternode, sporkManager.IsSporkActive(SPORK_6_NEW_SIGS));
+}
+
+bool CTxLockVote::CheckSignature(const CPubKey& pubKeyMasternode, bool fNewSigs) const
+{
+    std::string strError;
+
+    if (fNewSigs) {
         uint256 hash = GetSignatureHash();
 
-        if (!CHashSigner::VerifyHash(hash, infoMn.pubKeyMasternode, vchMasternodeSignature, strError)) {
+        if (!CHashSigner::VerifyHash(hash, pubKeyMasternode, vchMasternodeSignature, strError)) {
             // could be a signature in old format
             std::string strMessage = txHash.ToString() + outpoint.ToStringShort();
-            if(!CMessageSigner::VerifyMessage(infoMn.pubKeyMasternode, vchMasternodeSignature, strMessage, strError)) {
+            if(!CMessageSigner::VerifyMessage(pubKeyMasternode, vchMasternodeSignature, strMessage, strError)) {
                 // nope, not in old format either
                 LogPrintf("CTxLockVote::CheckSignature -- VerifyMessage() failed, error: %s\n", strError);
                 return false;
@@ -1086,7 +1214,7 @@ bool CTxLockVote::CheckSignature() const
         }
     } else {
         std::string strMessage = txHash.ToString() + outpoint.ToStringShort();
-        if(!CMessageSigner::VerifyMessage(infoMn.pubKeyMasternode, vchMasternodeSignature, strMessage, strError)) {
+        if(!CMessageSigner::VerifyMessage(pubKeyMasternode, vchMasternodeSignature, strMessage, strError)) {
             LogPrintf("CTxLockVote::CheckSignature -- VerifyMessage() failed, error: %s\n", strError);
             return false;
         }
@@ -1150,6 +1278,54 @@ bool CTxLockVote::IsFailed() const
     return (GetTime() - nTimeCreated > INSTANTSEND_FAILED_TIMEOUT_SECONDS) && !instantsend.IsLockedInstantSendTransaction(GetTxHash());
 }
 
+bool CTxLockVoteCheck::operator()()
+{
+    *pfValid = pvote->CheckSignature(pubKeyMasternode, fNewSigs);
+    // never fail the queue, every vote gets its own result
+    return true;
+}
+
+void CheckTxLockVoteSignatures(const std::vector<std::pair<CTxLockVote, CPubKey> >& vecVotes, bool fNewSigs,
+                               std::vector<char>& vValidRet, CCheckQueue<CTxLockVoteCheck>* pqueue)
+{
+    vValidRet.assign(vecVotes.size(), false);
+
+    std::vector<CTxLockVoteCheck> vChecks;
+    vChecks.reserve(vecVotes.size());
+    for (size_t i = 0; i < vecVotes.size(); ++i) {
+        vChecks.emplace_back(vecVotes[i].first, vecVotes[i].second, fNewSigs, vValidRet[i]);
+    }
+
+    if (pqueue == NULL) {
+        for (auto& check : vChecks) {
+            check();
+        }
+        return;
+    }
+
+    CCheckQueueControl<CTxLockVoteCheck> control(pqueue);
+    control.Add(vChecks);
+    control.Wait();
+}
+
+void ThreadTxLockVoteCheck()
+{
+    RenameThread("quantisnet-isvcheck");
+    txlockvotecheckqueue.Thread();
+}
+
+void ThreadInstantSendVotes(CConnman& connman)
+{
+    if(fLiteMode) return; // disable all QuantisNet specific functionality
+
+    RenameThread("quantisnet-isvotes");
+
+    while (true) {
+        instantsend.WaitForPendingTxLockVotes();
+        instantsend.ProcessPendingTxLockVotes(connman);
+    }
+}
+
 //
 // COutPointLock
 //
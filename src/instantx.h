@@ -7,10 +7,20 @@
 #define INSTANTX_H
 
 #include "chain.h"
+#include "expirywheel.h"
 #include "net.h"
 #include "primitives/transaction.h"
+#include "pubkey.h"
+#include "sync.h"
+#include "txmempool.h"
+
+#include <unordered_map>
+
+template <typename T>
+class CCheckQueue;
 
 class CTxLockVote;
+class CTxLockVoteCheck;
 class COutPointLock;
 class CTxLockRequest;
 class CTxLockCandidate;
@@ -44,6 +54,10 @@ static const int INSTANTSEND_LOCK_TIMEOUT_SECONDS   = 15;
 /// For how long we are going to keep invalid votes and votes for failed lock attempts,
 /// must be greater than INSTANTSEND_LOCK_TIMEOUT_SECONDS
 static const int INSTANTSEND_FAILED_TIMEOUT_SECONDS = 60;
+/// Granularity of the time based expiry of votes
+static const int64_t INSTANTSEND_EXPIRY_BUCKET_SECONDS = 10;
+/// Maximum number of lock votes verified and applied together
+static const size_t MAX_TXLOCKVOTE_BATCH            = 1024;
 
 extern bool fEnableInstantSend;
 extern int nInstantSendDepth;
@@ -58,26 +72,46 @@ private:
     // Keep track of current block height
     int nCachedBlockHeight;
 
+    template<typename V>
+    using TxHashMap = std::unordered_map<uint256, V, SaltedTxidHasher>;
+
     // maps for AlreadyHave
-    std::map<uint256, CTxLockRequest> mapLockRequestAccepted; ///< Tx hash - Tx
-    std::map<uint256, CTxLockRequest> mapLockRequestRejected; ///< Tx hash - Tx
-    std::map<uint256, CTxLockVote> mapTxLockVotes; ///< Vote hash - Vote
-    std::map<uint256, CTxLockVote> mapTxLockVotesOrphan; ///< Vote hash - Vote
+    TxHashMap<CTxLockRequest> mapLockRequestAccepted; ///< Tx hash - Tx
+    TxHashMap<CTxLockRequest> mapLockRequestRejected; ///< Tx hash - Tx
+    TxHashMap<CTxLockVote> mapTxLockVotes; ///< Vote hash - Vote
+    TxHashMap<CTxLockVote> mapTxLockVotesOrphan; ///< Vote hash - Vote
 
-    std::map<uint256, CTxLockCandidate> mapTxLockCandidates; ///< Tx hash - Lock candidate
+    TxHashMap<CTxLockCandidate> mapTxLockCandidates; ///< Tx hash - Lock candidate
 
     std::map<COutPoint, std::set<uint256> > mapVotedOutpoints; ///< UTXO - Tx hash set
     std::map<COutPoint, uint256> mapLockedOutpoints; ///< UTXO - Tx hash
 
     /// Track masternodes who voted with no txlockrequest (for DOS protection)
     std::map<COutPoint, int64_t> mapMasternodeOrphanVotes; ///< MN outpoint - Time
+    int64_t nMasternodeOrphanVoteTimeTotal;
+
+    /// Expiry schedules, so that CheckAndRemove only looks at the entries due
+    CExpiryWheel<uint256> wheelExpiredCandidates; ///< By height, tx hash of mapTxLockCandidates
+    CExpiryWheel<uint256> wheelExpiredVotes; ///< By height, vote hash of mapTxLockVotes
+    CExpiryWheel<uint256> wheelTimedOutVotes; ///< By time, vote hash of mapTxLockVotes(Orphan)
+    CExpiryWheel<COutPoint> wheelMasternodeOrphanVotes; ///< By time, MN outpoint of mapMasternodeOrphanVotes
+
+    /// Votes of top masternodes waiting for their signature to be verified
+    std::vector<std::pair<CTxLockVote, CPubKey> > vecTxLockVotesPending; ///< Vote - Masternode key
+    boost::mutex cs_pendingvotes;
+    CConditionVariable condPendingVotes;
+
+    void ScheduleCandidateExpiry(const uint256& txHash, int nConfirmedHeight);
+    void ScheduleVoteExpiry(const CTxLockVote& vote, int nConfirmedHeight);
+    void ScheduleVoteTimeout(const CTxLockVote& vote, bool fOrphan);
+    void SetMasternodeOrphanVoteTime(const COutPoint& outpointMasternode, int64_t nTime);
 
     bool CreateTxLockCandidate(const CTxLockRequest& txLockRequest);
     void CreateEmptyTxLockCandidate(const uint256& txHash);
     void Vote(CTxLockCandidate& txLockCandidate, CConnman& connman);
 
-    /// Process consensus vote message
-    bool ProcessNewTxLockVote(CNode* pfrom, const CTxLockVote& vote, CConnman& connman);
+    /// Process consensus vote message with a verified signature
+    bool ProcessNewTxLockVote(const CTxLockVote& vote);
 
     void UpdateVotedOutpoints(const CTxLockVote& vote, CTxLockCandidate& txLockCandidate);
     bool ProcessOrphanTxLockVote(const CTxLockVote& vote);
@@ -95,11 +129,25 @@ private:
 public:
     CCriticalSection cs_instantsend;
 
+    CInstantSend() :
+        nCachedBlockHeight(0),
+        nMasternodeOrphanVoteTimeTotal(0),
+        wheelExpiredCandidates(1),
+        wheelExpiredVotes(1),
+        wheelTimedOutVotes(INSTANTSEND_EXPIRY_BUCKET_SECONDS),
+        wheelMasternodeOrphanVotes(INSTANTSEND_EXPIRY_BUCKET_SECONDS)
+        {}
+
     void ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman);
 
     bool ProcessTxLockRequest(const CTxLockRequest& txLockRequest, CConnman& connman);
     void Vote(const uint256& txHash, CConnman& connman);
 
+    /// Wait until votes are queued for verification
+    void WaitForPendingTxLockVotes();
+    /// Verify a batch of queued votes in parallel and apply the valid ones, returns the number of votes taken
+    size_t ProcessPendingTxLockVotes(CConnman& connman);
+
     bool AlreadyHave(const uint256& hash);
 
     void AcceptLockRequest(const CTxLockRequest& txLockRequest);
@@ -120,6 +168,8 @@ public:
 
     /// Remove expired entries from maps
     void CheckAndRemove();
+    /// Sizes of the maps and expiry schedules, and their estimated memory usage in bytes
+    void GetMemoryStats(size_t& nCandidates, size_t& nVotes, size_t& nOrphanVotes, size_t& nScheduled, size_t& nUsage);
     /// Verify if transaction lock timed out
     bool IsTxLockCandidateTimedOut(const uint256& txHash);
 
@@ -240,18 +290,57 @@ public:
     COutPoint GetOutpoint() const { return outpoint; }
     COutPoint GetMasternodeOutpoint() const { return outpointMasternode; }
 
-    bool IsValid(CNode* pnode, CConnman& connman) const;
+    bool IsValid(CNode* pnode, CConnman& connman, bool fCheckSignature = true) const;
     void SetConfirmedHeight(int nConfirmedHeightIn) { nConfirmedHeight = nConfirmedHeightIn; }
+    int64_t GetTimeCreated() const { return nTimeCreated; }
     bool IsExpired(int nHeight) const;
     bool IsTimedOut() const;
     bool IsFailed() const;
 
     bool Sign();
     bool CheckSignature() const;
+    bool CheckSignature(const CPubKey& pubKeyMasternode, bool fNewSigs) const;
 
     void Relay(CConnman& connman) const;
 };
 
+/**
+ * Closure verifying the signature of a lock vote with the key of its masternode, for CCheckQueue.
+ * The outcome is stored per vote so that one invalid vote does not reject the whole batch.
+ */
+class CTxLockVoteCheck
+{
+private:
+    const CTxLockVote* pvote;
+    CPubKey pubKeyMasternode;
+    bool fNewSigs;
+    char* pfValid;
+
+public:
+    CTxLockVoteCheck() : pvote(NULL), pubKeyMasternode(), fNewSigs(false), pfValid(NULL) {}
+    CTxLockVoteCheck(const CTxLockVote& voteIn, const CPubKey& pubKeyMasternodeIn, bool fNewSigsIn, char& fValidRet) :
+        pvote(&voteIn), pubKeyMasternode(pubKeyMasternodeIn), fNewSigs(fNewSigsIn), pfValid(&fValidRet) {}
+
+    bool operator()();
+
+    void swap(CTxLockVoteCheck& check)
+    {
+        std::swap(pvote, check.pvote);
+        std::swap(pubKeyMasternode, check.pubKeyMasternode);
+        std::swap(fNewSigs, check.fNewSigs);
+        std::swap(pfValid, check.pfValid);
+    }
+};
+
+/** Verify vote signatures with the paired masternode keys, on pqueue when not NULL. vValidRet gets one flag per vote. */
+void CheckTxLockVoteSignatures(const std::vector<std::pair<CTxLockVote, CPubKey> >& vecVotes, bool fNewSigs,
+                               std::vector<char>& vValidRet, CCheckQueue<CTxLockVoteCheck>* pqueue);
+
+/** Worker verifying lock vote signatures, run -par - 1 of them */
+void ThreadTxLockVoteCheck();
+/** Verify and apply the lock votes received from peers */
+void ThreadInstantSendVotes(CConnman& connman);
+
 /**
  * An InstantSend OutpointLock.
  */
@@ -69,6 +69,10 @@ CMasternodeMan::CMasternodeMan():
     listScheduledMnbRequestConnections(),
     fMasternodesAdded(false),
     fMasternodesRemoved(false),
+    setLastPaidIndex(),
+    mapScoreCache(MAX_SCORE_CACHE_SIZE),
+    nScoreCacheHits(0),
+    nScoreCacheMisses(0),
     vecDirtyGovernanceObjectHashes(),
     nLastSentinelPingTime(0),
     mapSeenMasternodeBroadcast(),
@@ -84,7 +88,9 @@ bool CMasternodeMan::Add(CMasternode &mn)
 
     LogPrint("masternode", "CMasternodeMan::Add -- Adding new Masternode: addr=%s, %i now\n", mn.addr.ToString(), size() + 1);
     mapMasternodes[mn.outpoint] = mn;
+    setLastPaidIndex.emplace(mn.GetLastPaidBlock(), mn.outpoint);
     fMasternodesAdded = true;
+    InvalidateScoreCache();
     return true;
 }
 
@@ -205,8 +211,10 @@ void CMasternodeMan::CheckAndRemove(CConnman& connman)
 
                 // and finally remove it from the list
                 it->second.FlagGovernanceItemsAsDirty();
+                setLastPaidIndex.erase(std::make_pair(it->second.GetLastPaidBlock(), it->first));
                 mapMasternodes.erase(it++);
                 fMasternodesRemoved = true;
+                InvalidateScoreCache();
             } else {
                 bool fAsk = (nAskForMnbRecovery > 0) &&
                             masternodeSync.IsSynced() &&
@@ -362,6 +370,8 @@ void CMasternodeMan::Clear()
 {
     LOCK(cs);
     mapMasternodes.clear();
+    setLastPaidIndex.clear();
+    InvalidateScoreCache();
     mAskedUsForMasternodeList.clear();
     mWeAskedForMasternodeList.clear();
     mWeAskedForMasternodeListEntry.clear();
@@ -514,6 +524,17 @@ bool CMasternodeMan::GetNextMasternodeInQueueForPayment(bool fFilterSigTime, int
 }
 
 bool CMasternodeMan::GetNextMasternodeInQueueForPayment(int nBlockHeight, bool fFilterSigTime, int& nCountRet, masternode_info_t& mnInfoRet)
+{
+    return FindNextMasternodeInQueueForPayment(nBlockHeight, fFilterSigTime, true, nCountRet, mnInfoRet);
+}
+
+bool CMasternodeMan::GetNextMasternodeInQueueForPayment(int nBlockHeight, bool fFilterSigTime, masternode_info_t& mnInfoRet)
+{
+    int nCount;
+    return FindNextMasternodeInQueueForPayment(nBlockHeight, fFilterSigTime, false, nCount, mnInfoRet);
+}
+
+bool CMasternodeMan::FindNextMasternodeInQueueForPayment(int nBlockHeight, bool fFilterSigTime, bool fCountAll, int& nCountRet, masternode_info_t& mnInfoRet)
 {
     mnInfoRet = masternode_info_t();
     nCountRet = 0;
@@ -526,69 +547,77 @@ bool CMasternodeMan::GetNextMasternodeInQueueForPayment(int nBlockHeight, bool f
     // Need LOCK2 here to ensure consistent locking order because the GetBlockHash call below locks cs_main
     LOCK2(cs_main,cs);
 
-    std::vector<std::pair<int, const CMasternode*> > vecMasternodeLastPaid;
-
-    /*
-        Make a vector with all of the last paid times
-    */
-
     int nMnCount = CountMasternodes();
 
-    for (const auto& mnpair : mapMasternodes) {
-        if(!mnpair.second.IsValidForPayment()) continue;
-
-        //check protocol version
-        if(mnpair.second.nProtocolVersion < mnpayments.GetMinMasternodePaymentsProto()) continue;
-
-        //it's in the list (up to 8 entries ahead of current block to allow propagation) -- so let's skip it
-        if(mnpayments.IsScheduled(mnpair.second, nBlockHeight)) continue;
-
-        //it's too new, wait for a cycle
-        if(fFilterSigTime && mnpair.second.sigTime + (nMnCount*2.6*60) > GetAdjustedTime()) continue;
-
-        //make sure it has at least as many confirmations as there are masternodes
-        if(GetUTXOConfirmations(mnpair.first) < nMnCount) continue;
-
-        vecMasternodeLastPaid.push_back(std::make_pair(mnpair.second.GetLastPaidBlock(), &mnpair.second));
-    }
-
-    nCountRet = (int)vecMasternodeLastPaid.size();
-
-    //when the network is in the process of upgrading, don't penalize nodes that recently restarted
-    if(fFilterSigTime && nCountRet < nMnCount/3)
-        return GetNextMasternodeInQueueForPayment(nBlockHeight, false, nCountRet, mnInfoRet);
-
-    // Sort them low to high
-    sort(vecMasternodeLastPaid.begin(), vecMasternodeLastPaid.end(), CompareLastPaidBlock());
-
     uint256 blockHash;
     if(!GetBlockHash(blockHash, nBlockHeight - 101)) {
         LogPrintf("CMasternode::GetNextMasternodeInQueueForPayment -- ERROR: GetBlockHash() failed at nBlockHeight %d\n", nBlockHeight - 101);
         return false;
     }
+
     // Look at 1/10 of the oldest nodes (by last payment), calculate their scores and pay the best one
     //  -- This doesn't look at who is being paid in the +8-10 blocks, allowing for double payments very rarely
     //  -- 1/100 payments should be a double payment on mainnet - (1/(3000/10))*2
     //  -- (chance per block * chances before IsScheduled will fire)
-    int nTenthNetwork = nMnCount/10;
+    int nTenthNetwork = std::max(nMnCount/10, 1);
+    // when the network is in the process of upgrading, don't penalize nodes that recently restarted
+    int nMinCountFiltered = fFilterSigTime ? nMnCount/3 : 0;
     int nCountTenth = 0;
     arith_uint256 nHighest = 0;
     const CMasternode *pBestMasternode = NULL;
-    for (const auto& s : vecMasternodeLastPaid) {
-        arith_uint256 nScore = s.second->CalculateScore(blockHash);
-        if(nScore > nHighest){
-            nHighest = nScore;
-            pBestMasternode = s.second;
+
+    // setLastPaidIndex is sorted low to high, so the walk can stop as soon as the oldest tenth
+    // is scored, unless the caller wants the number of all masternodes qualifying for payment
+    for (const auto& lastPaid : setLastPaidIndex) {
+        if(!fCountAll && nCountTenth >= nTenthNetwork && nCountRet >= nMinCountFiltered) break;
+
+        const auto it = mapMasternodes.find(lastPaid.second);
+        if(it == mapMasternodes.end()) continue;
+        const CMasternode& mn = it->second;
+
+        if(!mn.IsValidForPayment()) continue;
+
+        //check protocol version
+        if(mn.nProtocolVersion < mnpayments.GetMinMasternodePaymentsProto()) continue;
+
+        //it's in the list (up to 8 entries ahead of current block to allow propagation) -- so let's skip it
+        if(mnpayments.IsScheduled(mn, nBlockHeight)) continue;
+
+        //it's too new, wait for a cycle
+        if(fFilterSigTime && mn.sigTime + (nMnCount*2.6*60) > GetAdjustedTime()) continue;
+
+        //make sure it has at least as many confirmations as there are masternodes
+        if(GetUTXOConfirmations(it->first) < nMnCount) continue;
+
+        nCountRet++;
+        if(nCountTenth < nTenthNetwork) {
+            arith_uint256 nScore = mn.CalculateScore(blockHash);
+            if(nScore > nHighest){
+                nHighest = nScore;
+                pBestMasternode = &mn;
+            }
+            nCountTenth++;
         }
-        nCountTenth++;
-        if(nCountTenth >= nTenthNetwork) break;
     }
+
+    if(nCountRet < nMinCountFiltered)
+        return FindNextMasternodeInQueueForPayment(nBlockHeight, false, fCountAll, nCountRet, mnInfoRet);
+
     if (pBestMasternode) {
         mnInfoRet = pBestMasternode->GetInfo();
     }
     return mnInfoRet.fInfoValid;
 }
 
+void CMasternodeMan::RebuildLastPaidIndex()
+{
+    AssertLockHeld(cs);
+    setLastPaidIndex.clear();
+    for (const auto& mnpair : mapMasternodes) {
+        setLastPaidIndex.emplace(mnpair.second.GetLastPaidBlock(), mnpair.first);
+    }
+}
+
 masternode_info_t CMasternodeMan::FindRandomNotInVec(const std::vector<COutPoint> &vecToExclude, int nProtocolVersion)
 {
     LOCK(cs);
@@ -632,6 +661,45 @@ masternode_info_t CMasternodeMan::FindRandomNotInVec(const std::vector<COutPoint
     return masternode_info_t();
 }
 
+CMasternodeMan::score_cache_entry_t CMasternodeMan::GetScoreCacheEntry(const uint256& nBlockHash)
+{
+    AssertLockHeld(cs);
+
+    score_cache_entry_t pScores;
+    if (mapScoreCache.Get(nBlockHash, pScores)) {
+        nScoreCacheHits++;
+        return pScores;
+    }
+    nScoreCacheMisses++;
+
+    // Protocol versions can change with masternode updates, so scores are cached for all
+    // masternodes and filtered by the callers
+    std::shared_ptr<score_pair_vec_t> pNewScores = std::make_shared<score_pair_vec_t>();
+    pNewScores->reserve(mapMasternodes.size());
+    for (const auto& mnpair : mapMasternodes) {
+        pNewScores->push_back(std::make_pair(mnpair.second.CalculateScore(nBlockHash), &mnpair.second));
+    }
+    sort(pNewScores->rbegin(), pNewScores->rend(), CompareScoreMN());
+
+    pScores = pNewScores;
+    mapScoreCache.Insert(nBlockHash, pScores);
+    return pScores;
+}
+
+void CMasternodeMan::InvalidateScoreCache()
+{
+    AssertLockHeld(cs);
+    mapScoreCache.Clear();
+}
+
+void CMasternodeMan::GetScoreCacheStats(int& nEntriesRet, uint64_t& nHitsRet, uint64_t& nMissesRet)
+{
+    LOCK(cs);
+    nEntriesRet = mapScoreCache.GetSize();
+    nHitsRet = nScoreCacheHits;
+    nMissesRet = nScoreCacheMisses;
+}
+
 bool CMasternodeMan::GetMasternodeScores(const uint256& nBlockHash, CMasternodeMan::score_pair_vec_t& vecMasternodeScoresRet, int nMinProtocol)
 {
     vecMasternodeScoresRet.clear();
@@ -644,14 +712,14 @@ bool CMasternodeMan::GetMasternodeScores(const uint256& nBlockHash, CMasternodeM
     if (mapMasternodes.empty())
         return false;
 
-    // calculate scores
-    for (const auto& mnpair : mapMasternodes) {
-        if (mnpair.second.nProtocolVersion >= nMinProtocol) {
-            vecMasternodeScoresRet.push_back(std::make_pair(mnpair.second.CalculateScore(nBlockHash), &mnpair.second));
+    score_cache_entry_t pScores = GetScoreCacheEntry(nBlockHash);
+    vecMasternodeScoresRet.reserve(pScores->size());
+    for (const auto& scorePair : *pScores) {
+        if (scorePair.second->nProtocolVersion >= nMinProtocol) {
+            vecMasternodeScoresRet.push_back(scorePair);
         }
     }
 
-    sort(vecMasternodeScoresRet.rbegin(), vecMasternodeScoresRet.rend(), CompareScoreMN());
     return !vecMasternodeScoresRet.empty();
 }
 
@@ -671,12 +739,13 @@ bool CMasternodeMan::GetMasternodeRank(const COutPoint& outpoint, int& nRankRet,
 
     LOCK(cs);
 
-    score_pair_vec_t vecMasternodeScores;
-    if (!GetMasternodeScores(nBlockHash, vecMasternodeScores, nMinProtocol))
+    if (mapMasternodes.empty())
         return false;
 
+    // walk the cached order directly instead of copying the filtered list
     int nRank = 0;
-    for (const auto& scorePair : vecMasternodeScores) {
+    for (const auto& scorePair : *GetScoreCacheEntry(nBlockHash)) {
+        if (scorePair.second->nProtocolVersion < nMinProtocol) continue;
         nRank++;
         if(scorePair.second->outpoint == outpoint) {
             nRankRet = nRank;
@@ -1613,7 +1682,12 @@ void CMasternodeMan::UpdateLastPaid(const CBlockIndex* pindex)
                             nCachedBlockHeight, nLastRunBlockHeight, nMaxBlocksToScanBack);
 
     for (auto& mnpair : mapMasternodes) {
+        int nBlockLastPaidPrev = mnpair.second.GetLastPaidBlock();
         mnpair.second.UpdateLastPaid(pindex, nMaxBlocksToScanBack);
+        if (mnpair.second.GetLastPaidBlock() != nBlockLastPaidPrev) {
+            setLastPaidIndex.erase(std::make_pair(nBlockLastPaidPrev, mnpair.first));
+            setLastPaidIndex.emplace(mnpair.second.GetLastPaidBlock(), mnpair.first);
+        }
     }
 
     nLastRunBlockHeight = nCachedBlockHeight;
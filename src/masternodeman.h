@@ -7,9 +7,13 @@
 #ifndef MASTERNODEMAN_H
 #define MASTERNODEMAN_H
 
+#include "cachemap.h"
 #include "masternode.h"
 #include "sync.h"
 
+#include <memory>
+#include <set>
+
 class CMasternodeMan;
 class CConnman;
 
@@ -41,6 +45,9 @@ private:
     static const int MNB_RECOVERY_WAIT_SECONDS      = 60;
     static const int MNB_RECOVERY_RETRY_SECONDS     = 3 * 60 * 60;
 
+    static const int MAX_SCORE_CACHE_SIZE           = 16;
+
+    typedef std::shared_ptr<const score_pair_vec_t> score_cache_entry_t;
 
     // critical section to protect the inner data structures
     mutable CCriticalSection cs;
@@ -74,6 +81,15 @@ private:
     /// Set when masternodes are removed, cleared when CGovernanceManager is notified
     bool fMasternodesRemoved;
 
+    /// (last paid block, outpoint) of every masternode, the order payments are queued in
+    std::set<std::pair<int, COutPoint> > setLastPaidIndex;
+
+    /// Masternodes of every protocol version sorted by score for recently used block hashes,
+    /// cleared whenever masternodes are added or removed as the entries point into mapMasternodes
+    CacheMap<uint256, score_cache_entry_t> mapScoreCache;
+    uint64_t nScoreCacheHits;
+    uint64_t nScoreCacheMisses;
+
     std::vector<uint256> vecDirtyGovernanceObjectHashes;
 
     int64_t nLastSentinelPingTime;
@@ -83,6 +99,12 @@ private:
     CMasternode* Find(const COutPoint& outpoint);
 
     bool GetMasternodeScores(const uint256& nBlockHash, score_pair_vec_t& vecMasternodeScoresRet, int nMinProtocol = 0);
+    /// Sorted scores of all masternodes for nBlockHash, from the cache when possible
+    score_cache_entry_t GetScoreCacheEntry(const uint256& nBlockHash);
+    void InvalidateScoreCache();
+
+    bool FindNextMasternodeInQueueForPayment(int nBlockHeight, bool fFilterSigTime, bool fCountAll, int& nCountRet, masternode_info_t& mnInfoRet);
+    void RebuildLastPaidIndex();
 
     void SyncSingle(CNode* pnode, const COutPoint& outpoint, CConnman& connman);
     void SyncAll(CNode* pnode, CConnman& connman);
@@ -125,6 +147,10 @@ public:
 
         READWRITE(mapSeenMasternodeBroadcast);
         READWRITE(mapSeenMasternodePing);
+        if(ser_action.ForRead()) {
+            RebuildLastPaidIndex();
+            InvalidateScoreCache();
+        }
         if(ser_action.ForRead() && (strVersion != SERIALIZATION_VERSION_STRING)) {
             Clear();
         }
@@ -178,6 +204,8 @@ public:
     bool GetNextMasternodeInQueueForPayment(int nBlockHeight, bool fFilterSigTime, int& nCountRet, masternode_info_t& mnInfoRet);
     /// Same as above but use current block height
     bool GetNextMasternodeInQueueForPayment(bool fFilterSigTime, int& nCountRet, masternode_info_t& mnInfoRet);
+    /// Same as above but without counting all qualifying masternodes, which allows to stop after the oldest tenth
+    bool GetNextMasternodeInQueueForPayment(int nBlockHeight, bool fFilterSigTime, masternode_info_t& mnInfoRet);
 
     /// Find a random entry
     masternode_info_t FindRandomNotInVec(const std::vector<COutPoint> &vecToExclude, int nProtocolVersion = -1);
@@ -187,6 +215,9 @@ public:
     bool GetMasternodeRanks(rank_pair_vec_t& vecMasternodeRanksRet, int nBlockHeight = -1, int nMinProtocol = 0);
     bool GetMasternodeRank(const COutPoint &outpoint, int& nRankRet, int nBlockHeight = -1, int nMinProtocol = 0);
 
+    /// Number of cached block hashes and cache hits / misses of the masternode score cache
+    void GetScoreCacheStats(int& nEntriesRet, uint64_t& nHitsRet, uint64_t& nMissesRet);
+
     void ProcessMasternodeConnections(CConnman& connman);
     std::pair<CService, std::set<uint256> > PopScheduledMnbRequestConnection();
     void ProcessPendingMnbRequests(CConnman& connman);
@@ -52,6 +52,9 @@
 uint64_t nLastBlockTx = 0;
 uint64_t nLastBlockSize = 0;
 int64_t nLastCoinStakeSearchTime = 0;
+int64_t nLastBlockTemplateTime = 0;
+uint64_t nBlockTemplatesReused = 0;
+uint64_t nBlockTemplatesExtended = 0;
 
 class ScoreCompare
 {
@@ -87,7 +90,8 @@ int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParam
 }
 
 BlockAssembler::BlockAssembler(const CChainParams& _chainparams)
-    : chainparams(_chainparams)
+    : chainparams(_chainparams),
+      nCachedTransactionsUpdated(0)
 {
     // Largest block you're willing to create:
     nBlockMaxSize = GetArg("-blockmaxsize", DEFAULT_BLOCK_MAX_SIZE);
@@ -185,8 +189,7 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(
                         ? nMedianTimePast
                         : pblock->GetBlockTime();
 
-        addPriorityTxs();
-        addPackageTxs(nPackagesSelected, nDescendantsUpdated);
+        addTransactions(nPackagesSelected, nDescendantsUpdated);
 
         nLastBlockTx = nBlockTx;
         nLastBlockSize = nBlockSize;
@@ -274,6 +277,56 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(
     return std::move(pblocktemplate);
 }
 
+void BlockAssembler::addTransactions(int &nPackagesSelected, int &nDescendantsUpdated)
+{
+    int64_t nTimeStart = GetTimeMicros();
+    size_t nFirstTx = pblock->vtx.size();
+    unsigned int nTransactionsUpdated = mempool.GetTransactionsUpdated();
+
+    // The PoS miner asks for a new template every few seconds only to retry the
+    // kernel, so keep the selection while the tip stays the same and only
+    // look at the packages it does not include yet when the mempool changed.
+    if (hashCachedPrevBlock == pblock->hashPrevBlock && addCachedTxs()) {
+        if (nTransactionsUpdated == nCachedTransactionsUpdated) {
+            ++nBlockTemplatesReused;
+        } else {
+            addPackageTxs(nPackagesSelected, nDescendantsUpdated);
+            ++nBlockTemplatesExtended;
+        }
+    } else {
+        addPriorityTxs();
+        addPackageTxs(nPackagesSelected, nDescendantsUpdated);
+    }
+
+    hashCachedPrevBlock = pblock->hashPrevBlock;
+    nCachedTransactionsUpdated = nTransactionsUpdated;
+    vCachedTxHashes.clear();
+    vCachedTxHashes.reserve(pblock->vtx.size() - nFirstTx);
+    for (size_t i = nFirstTx; i < pblock->vtx.size(); ++i) {
+        vCachedTxHashes.push_back(pblock->vtx[i]->GetHash());
+    }
+
+    nLastBlockTemplateTime = GetTimeMicros() - nTimeStart;
+}
+
+bool BlockAssembler::addCachedTxs()
+{
+    std::vector<CTxMemPool::txiter> vIters;
+    vIters.reserve(vCachedTxHashes.size());
+    for (const auto& hash : vCachedTxHashes) {
+        CTxMemPool::txiter it = mempool.mapTx.find(hash);
+        if (it == mempool.mapTx.end()) {
+            return false;
+        }
+        vIters.push_back(it);
+    }
+
+    for (const auto& it : vIters) {
+        AddToBlock(it);
+    }
+    return true;
+}
+
 bool BlockAssembler::isStillDependent(CTxMemPool::txiter iter)
 {
     BOOST_FOREACH(CTxMemPool::txiter parent, mempool.GetMemPoolParents(iter))
@@ -161,6 +161,11 @@ private:
     int lastFewTxs;
     bool blockFinished;
 
+    // Transactions selected for the previous template, reused while the tip does not change
+    uint256 hashCachedPrevBlock;
+    unsigned int nCachedTransactionsUpdated;
+    std::vector<uint256> vCachedTxHashes;
+
 public:
     BlockAssembler(const CChainParams& chainparams);
     /** Construct a new block template with coinbase to scriptPubKeyIn */
@@ -172,6 +177,10 @@ private:
     void resetBlock();
     /** Add a tx to the block */
     void AddToBlock(CTxMemPool::txiter iter);
+    /** Select the transactions of the block, reusing the previous selection if possible */
+    void addTransactions(int &nPackagesSelected, int &nDescendantsUpdated);
+    /** Add the transactions of the previous selection, fails without changes if any left the mempool */
+    bool addCachedTxs();
 
     // Methods for how to add transactions to a block.
     /** Add transactions based on tx "priority" */
@@ -208,6 +217,13 @@ private:
     int UpdatePackagesForAdded(const CTxMemPool::setEntries& alreadyAdded, indexed_modified_transaction_set &mapModifiedTx);
 };
 
+/** Time in microseconds the last block template took to select its transactions */
+extern int64_t nLastBlockTemplateTime;
+/** Number of templates which reused the previous selection as is */
+extern uint64_t nBlockTemplatesReused;
+/** Number of templates which extended the previous selection with new mempool transactions */
+extern uint64_t nBlockTemplatesExtended;
+
 /** Modify the extranonce in a block */
 void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce);
 int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev);
@@ -38,6 +38,10 @@
 #include <fcntl.h>
 #endif
 
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+
 #ifdef USE_UPNP
 #include <miniupnpc/miniupnpc.h>
 #include <miniupnpc/miniwget.h>
@@ -72,8 +76,6 @@
 #endif
 #endif
 
-const static std::string NET_MESSAGE_COMMAND_OTHER = "*other*";
-
 constexpr const CConnman::CFullyConnectedOnly CConnman::FullyConnectedOnly;
 constexpr const CConnman::CAllNodes CConnman::AllNodes;
 
@@ -404,7 +406,7 @@ CNode* CConnman::ConnectNode(CAddress addrConnect, const char *pszDest, bool fCo
     if (pszDest ? ConnectSocketByName(addrConnect, hSocket, pszDest, Params().GetDefaultPort(), nConnectTimeout, &proxyConnectionFailed) :
                   ConnectSocket(addrConnect, hSocket, nConnectTimeout, &proxyConnectionFailed))
     {
-        if (!IsSelectableSocket(hSocket)) {
+        if (socketEventsMode == SOCKETEVENTS_SELECT && !IsSelectableSocket(hSocket)) {
             LogPrintf("Cannot create connection: non-selectable socket created (fd >= FD_SETSIZE ?)\n");
             CloseSocket(hSocket);
             return NULL;
@@ -474,6 +476,13 @@ void CNode::CloseSocketDisconnect()
     if (hSocket != INVALID_SOCKET)
     {
         LogPrint("net", "disconnecting peer=%d\n", id);
+#ifdef HAVE_SYS_EPOLL_H
+        // Deregister explicitly, the registration outlives close() while a child process holds a copy of the socket
+        if (nEpollFd != -1) {
+            epoll_ctl(nEpollFd, EPOLL_CTL_DEL, hSocket, nullptr);
+            nEpollFd = -1;
+        }
+#endif
         CloseSocket(hSocket);
     }
 }
@@ -700,6 +709,10 @@ void CNode::copyStats(CNodeStats &stats)
         X(mapRecvBytesPerMsgCmd);
         X(nRecvBytes);
     }
+    {
+        LOCK(cs_mapTimingPerMsgCmd);
+        X(mapTimingPerMsgCmd);
+    }
     X(fWhitelisted);
 
     // It is common for nodes with good ping times to suddenly become lagged,
@@ -736,7 +749,7 @@ bool CNode::ReceiveMsgBytes(const char *pch, unsigned int nBytes, bool& complete
         // get current incomplete message, or create a new one
         if (vRecvMsg.empty() ||
             vRecvMsg.back().complete())
-            vRecvMsg.push_back(CNetMessage(Params().MessageStart(), SER_NETWORK, INIT_PROTO_VERSION));
+            vRecvMsg.emplace_back(Params().MessageStart(), SER_NETWORK, INIT_PROTO_VERSION);
 
         CNetMessage& msg = vRecvMsg.back();
 
@@ -776,6 +789,34 @@ bool CNode::ReceiveMsgBytes(const char *pch, unsigned int nBytes, bool& complete
     return true;
 }
 
+char* CNode::GetRecvDataBuffer(unsigned int& nBytes)
+{
+    LOCK(cs_vRecv);
+    if (vRecvMsg.empty())
+        return nullptr;
+    CNetMessage& msg = vRecvMsg.back();
+    // Small messages are cheaper to receive several at once through the stack buffer
+    if (!msg.in_data || msg.hdr.nMessageSize > MAX_PROTOCOL_MESSAGE_LENGTH ||
+        msg.hdr.nMessageSize - msg.nDataPos < MIN_DIRECT_RECV_SIZE)
+        return nullptr;
+    return msg.GetDataBuffer(nBytes);
+}
+
+void CNode::RecordMsgTiming(const std::string& strCommand, int64_t nWaitTime, int64_t nProcessTime)
+{
+    LOCK(cs_mapTimingPerMsgCmd);
+    //to prevent a memory DOS, only allow valid commands
+    mapMsgCmdTiming::iterator i = mapTimingPerMsgCmd.find(strCommand);
+    if (i == mapTimingPerMsgCmd.end())
+        i = mapTimingPerMsgCmd.find(NET_MESSAGE_COMMAND_OTHER);
+    assert(i != mapTimingPerMsgCmd.end());
+    CMsgCmdTiming& timing = i->second;
+    timing.nCount++;
+    timing.nWaitTime += nWaitTime;
+    timing.nMaxWaitTime = std::max(timing.nMaxWaitTime, nWaitTime);
+    timing.nProcessTime += nProcessTime;
+}
+
 void CNode::SetSendVersion(int nVersionIn)
 {
     // Send version may only be changed in the version message, and
@@ -831,6 +872,15 @@ int CNetMessage::readHeader(const char *pch, unsigned int nBytes)
     // switch state to reading message data
     in_data = true;
 
+    // Only large messages get a buffer of their full size up front. Small ones grow as their
+    // data arrives, the flood limit counts message sizes and not reserved capacity. Oversized
+    // messages get the peer disconnected, don't reserve room for them either.
+    if (hdr.nMessageSize >= MIN_DIRECT_RECV_SIZE && hdr.nMessageSize <= MAX_PROTOCOL_MESSAGE_LENGTH) {
+        CSerializeData vch;
+        GetNetRecvBufferPool().Take(hdr.nMessageSize, vch);
+        vRecv.swap(vch);
+    }
+
     return nCopy;
 }
 
@@ -845,12 +895,95 @@ int CNetMessage::readData(const char *pch, unsigned int nBytes)
     }
 
     hasher.Write((const unsigned char*)pch, nCopy);
-    memcpy(&vRecv[nDataPos], pch, nCopy);
+    // the data is already in place if it was received through GetDataBuffer()
+    if (pch != &vRecv[nDataPos])
+        memcpy(&vRecv[nDataPos], pch, nCopy);
     nDataPos += nCopy;
 
     return nCopy;
 }
 
+char* CNetMessage::GetDataBuffer(unsigned int& nBytes)
+{
+    assert(in_data && !complete());
+    nBytes = std::min(hdr.nMessageSize - nDataPos, nBytes);
+    if (vRecv.size() < nDataPos + nBytes)
+        vRecv.resize(nDataPos + nBytes);
+    return &vRecv[nDataPos];
+}
+
+CNetMessage::~CNetMessage()
+{
+    CSerializeData vch;
+    vRecv.swap(vch);
+    GetNetRecvBufferPool().Return(vch);
+}
+
+CNetRecvBufferPool::CNetRecvBufferPool(size_t nMaxCachedBytesIn) :
+    vFreeBuffers(MAX_BUFFER_CLASS + 1),
+    nMaxCachedBytes(nMaxCachedBytesIn),
+    nCachedBytes(0)
+{
+}
+
+void CNetRecvBufferPool::Take(size_t nSize, CSerializeData& vchRet)
+{
+    int nClass = MIN_BUFFER_CLASS;
+    while (nClass <= MAX_BUFFER_CLASS && ((size_t)1 << nClass) < nSize)
+        nClass++;
+
+    CSerializeData vch;
+    if (nClass > MAX_BUFFER_CLASS) {
+        vch.reserve(nSize);
+    } else {
+        {
+            LOCK(cs);
+            if (!vFreeBuffers[nClass].empty()) {
+                vch.swap(vFreeBuffers[nClass].back());
+                vFreeBuffers[nClass].pop_back();
+                nCachedBytes -= vch.capacity();
+            }
+        }
+        if (vch.capacity() == 0)
+            vch.reserve((size_t)1 << nClass);
+    }
+    vchRet.swap(vch);
+}
+
+void CNetRecvBufferPool::Return(CSerializeData& vch)
+{
+    CSerializeData vchFree;
+    vchFree.swap(vch);
+
+    // file the buffer under the largest class it can serve
+    int nClass = MAX_BUFFER_CLASS;
+    while (nClass >= MIN_BUFFER_CLASS && ((size_t)1 << nClass) > vchFree.capacity())
+        nClass--;
+    if (nClass < MIN_BUFFER_CLASS || vchFree.capacity() > ((size_t)1 << MAX_BUFFER_CLASS))
+        return;
+
+    vchFree.clear();
+    LOCK(cs);
+    if (nCachedBytes + vchFree.capacity() > nMaxCachedBytes)
+        return;
+    nCachedBytes += vchFree.capacity();
+    vFreeBuffers[nClass].emplace_back();
+    vFreeBuffers[nClass].back().swap(vchFree);
+}
+
+size_t CNetRecvBufferPool::GetCachedBytes()
+{
+    LOCK(cs);
+    return nCachedBytes;
+}
+
+CNetRecvBufferPool& GetNetRecvBufferPool()
+{
+    // Never destroyed, messages may still be freed by other static destructors at exit
+    static CNetRecvBufferPool* pool = new CNetRecvBufferPool();
+    return *pool;
+}
+
 const uint256& CNetMessage::GetMessageHash() const
 {
     assert(complete());
@@ -1099,7 +1232,7 @@ void CConnman::AcceptConnection(const ListenSocket& hListenSocket) {
         return;
     }
 
-    if (!IsSelectableSocket(hSocket))
+    if (socketEventsMode == SOCKETEVENTS_SELECT && !IsSelectableSocket(hSocket))
     {
         LogPrintf("connection from %s dropped: non-selectable socket\n", addr.ToString());
         CloseSocket(hSocket);
@@ -1149,12 +1282,37 @@ void CConnman::AcceptConnection(const ListenSocket& hListenSocket) {
 
     LogPrint("net", "connection from %s accepted\n", addr.ToString());
 
+    RegisterSocketEvents(pnode);
     {
         LOCK(cs_vNodes);
         vNodes.push_back(pnode);
     }
 }
 
+void CConnman::RegisterSocketEvents(CNode* pnode)
+{
+#ifdef HAVE_SYS_EPOLL_H
+    if (epollfd == -1)
+        return;
+
+    LOCK(pnode->cs_hSocket);
+    if (pnode->hSocket == INVALID_SOCKET)
+        return;
+
+    // Registered once for the lifetime of the socket. Being edge-triggered, EPOLLOUT only fires after
+    // a send hit a full socket buffer, which is exactly when queued data is waiting to go out.
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.ptr = pnode;
+    if (epoll_ctl(epollfd, EPOLL_CTL_ADD, pnode->hSocket, &event) == SOCKET_ERROR) {
+        LogPrintf("socket epoll_ctl error %s\n", NetworkErrorString(WSAGetLastError()));
+        pnode->fDisconnect = true;
+        return;
+    }
+    pnode->nEpollFd = epollfd;
+#endif
+}
+
 void CConnman::ThreadSocketHandler()
 {
     unsigned int nPrevNodeCount = 0;
@@ -1209,6 +1367,7 @@ void CConnman::ThreadSocketHandler()
                     }
                     if (fDelete) {
                         vNodesDisconnected.remove(pnode);
+                        setNodesRecvPending.erase(pnode);
                         DeleteNode(pnode);
                     }
                 }
@@ -1225,226 +1384,348 @@ void CConnman::ThreadSocketHandler()
                 clientInterface->NotifyNumConnectionsChanged(nPrevNodeCount);
         }
 
-        //
-        // Find which sockets have data to receive
-        //
-        struct timeval timeout;
-        timeout.tv_sec  = 0;
-        timeout.tv_usec = 50000; // frequency to poll pnode->vSend
-
-        fd_set fdsetRecv;
-        fd_set fdsetSend;
-        fd_set fdsetError;
-        FD_ZERO(&fdsetRecv);
-        FD_ZERO(&fdsetSend);
-        FD_ZERO(&fdsetError);
-        SOCKET hSocketMax = 0;
-        bool have_fds = false;
+        if (socketEventsMode == SOCKETEVENTS_EPOLL)
+            SocketHandlerEpoll();
+        else
+            SocketHandlerSelect();
+    }
+}
 
-        BOOST_FOREACH(const ListenSocket& hListenSocket, vhListenSocket) {
-            FD_SET(hListenSocket.socket, &fdsetRecv);
-            hSocketMax = std::max(hSocketMax, hListenSocket.socket);
-            have_fds = true;
-        }
+void CConnman::SocketHandlerSelect()
+{
+    //
+    // Find which sockets have data to receive
+    //
+    struct timeval timeout;
+    timeout.tv_sec  = 0;
+    timeout.tv_usec = SOCKET_EVENTS_TIMEOUT * 1000; // frequency to poll pnode->vSend
 
+    fd_set fdsetRecv;
+    fd_set fdsetSend;
+    fd_set fdsetError;
+    FD_ZERO(&fdsetRecv);
+    FD_ZERO(&fdsetSend);
+    FD_ZERO(&fdsetError);
+    SOCKET hSocketMax = 0;
+    bool have_fds = false;
+
+    BOOST_FOREACH(const ListenSocket& hListenSocket, vhListenSocket) {
+        FD_SET(hListenSocket.socket, &fdsetRecv);
+        hSocketMax = std::max(hSocketMax, hListenSocket.socket);
+        have_fds = true;
+    }
+
+    {
+        LOCK(cs_vNodes);
+        BOOST_FOREACH(CNode* pnode, vNodes)
         {
-            LOCK(cs_vNodes);
-            BOOST_FOREACH(CNode* pnode, vNodes)
+            // Implement the following logic:
+            // * If there is data to send, select() for sending data. As this only
+            //   happens when optimistic write failed, we choose to first drain the
+            //   write buffer in this case before receiving more. This avoids
+            //   needlessly queueing received data, if the remote peer is not themselves
+            //   receiving data. This means properly utilizing TCP flow control signalling.
+            // * Otherwise, if there is space left in the receive buffer, select() for
+            //   receiving data.
+            // * Hand off all complete messages to the processor, to be handled without
+            //   blocking here.
+
+            bool select_recv = !pnode->fPauseRecv;
+            bool select_send;
             {
-                // Implement the following logic:
-                // * If there is data to send, select() for sending data. As this only
-                //   happens when optimistic write failed, we choose to first drain the
-                //   write buffer in this case before receiving more. This avoids
-                //   needlessly queueing received data, if the remote peer is not themselves
-                //   receiving data. This means properly utilizing TCP flow control signalling.
-                // * Otherwise, if there is space left in the receive buffer, select() for
-                //   receiving data.
-                // * Hand off all complete messages to the processor, to be handled without
-                //   blocking here.
-
-                bool select_recv = !pnode->fPauseRecv;
-                bool select_send;
-                {
-                    LOCK(pnode->cs_vSend);
-                    select_send = !pnode->vSendMsg.empty();
-                }
+                LOCK(pnode->cs_vSend);
+                select_send = !pnode->vSendMsg.empty();
+            }
 
-                LOCK(pnode->cs_hSocket);
-                if (pnode->hSocket == INVALID_SOCKET)
-                    continue;
+            LOCK(pnode->cs_hSocket);
+            if (pnode->hSocket == INVALID_SOCKET)
+                continue;
 
-                FD_SET(pnode->hSocket, &fdsetError);
-                hSocketMax = std::max(hSocketMax, pnode->hSocket);
-                have_fds = true;
+            FD_SET(pnode->hSocket, &fdsetError);
+            hSocketMax = std::max(hSocketMax, pnode->hSocket);
+            have_fds = true;
 
-                if (select_send) {
-                    FD_SET(pnode->hSocket, &fdsetSend);
-                    continue;
-                }
-                if (select_recv) {
-                    FD_SET(pnode->hSocket, &fdsetRecv);
-                }
+            if (select_send) {
+                FD_SET(pnode->hSocket, &fdsetSend);
+                continue;
             }
+            if (select_recv) {
+                FD_SET(pnode->hSocket, &fdsetRecv);
+            }
+        }
+    }
+
+    int nSelect = select(have_fds ? hSocketMax + 1 : 0,
+                         &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
+    if (interruptNet)
+        return;
+
+    if (nSelect == SOCKET_ERROR)
+    {
+        if (have_fds)
+        {
+            int nErr = WSAGetLastError();
+            LogPrintf("socket select error %s\n", NetworkErrorString(nErr));
+            for (unsigned int i = 0; i <= hSocketMax; i++)
+                FD_SET(i, &fdsetRecv);
+        }
+        FD_ZERO(&fdsetSend);
+        FD_ZERO(&fdsetError);
+        if (!interruptNet.sleep_for(std::chrono::milliseconds(timeout.tv_usec/1000)))
+            return;
+    }
+
+    //
+    // Accept new connections
+    //
+    BOOST_FOREACH(const ListenSocket& hListenSocket, vhListenSocket)
+    {
+        if (hListenSocket.socket != INVALID_SOCKET && FD_ISSET(hListenSocket.socket, &fdsetRecv))
+        {
+            AcceptConnection(hListenSocket);
         }
+    }
 
-        int nSelect = select(have_fds ? hSocketMax + 1 : 0,
-                             &fdsetRecv, &fdsetSend, &fdsetError, &timeout);
+    //
+    // Service each socket
+    //
+    std::vector<CNode*> vNodesCopy = CopyNodeVector();
+    BOOST_FOREACH(CNode* pnode, vNodesCopy)
+    {
         if (interruptNet)
             return;
 
-        if (nSelect == SOCKET_ERROR)
+        //
+        // Receive
+        //
+        bool recvSet = false;
+        bool sendSet = false;
+        bool errorSet = false;
         {
-            if (have_fds)
-            {
-                int nErr = WSAGetLastError();
-                LogPrintf("socket select error %s\n", NetworkErrorString(nErr));
-                for (unsigned int i = 0; i <= hSocketMax; i++)
-                    FD_SET(i, &fdsetRecv);
-            }
-            FD_ZERO(&fdsetSend);
-            FD_ZERO(&fdsetError);
-            if (!interruptNet.sleep_for(std::chrono::milliseconds(timeout.tv_usec/1000)))
-                return;
+            LOCK(pnode->cs_hSocket);
+            if (pnode->hSocket == INVALID_SOCKET)
+                continue;
+            recvSet = FD_ISSET(pnode->hSocket, &fdsetRecv);
+            sendSet = FD_ISSET(pnode->hSocket, &fdsetSend);
+            errorSet = FD_ISSET(pnode->hSocket, &fdsetError);
+        }
+        if (recvSet || errorSet)
+        {
+            SocketRecvData(pnode);
         }
 
         //
-        // Accept new connections
+        // Send
         //
+        if (sendSet)
+        {
+            LOCK(pnode->cs_vSend);
+            size_t nBytes = SocketSendData(pnode);
+            if (nBytes) {
+                RecordBytesSent(nBytes);
+            }
+        }
+
+        InactivityCheck(pnode);
+    }
+    ReleaseNodeVector(vNodesCopy);
+}
+
+#ifdef HAVE_SYS_EPOLL_H
+void CConnman::SocketHandlerEpoll()
+{
+    // Nodes still holding unread data won't be reported again, don't wait for events while they can be read
+    bool fRecvPending = false;
+    for (CNode* pnode : setNodesRecvPending) {
+        if (!pnode->fPauseRecv) {
+            fRecvPending = true;
+            break;
+        }
+    }
+
+    struct epoll_event events[MAX_SOCKET_EVENTS];
+    int nEvents = epoll_wait(epollfd, events, MAX_SOCKET_EVENTS, fRecvPending ? 0 : SOCKET_EVENTS_TIMEOUT);
+    if (interruptNet)
+        return;
+
+    if (nEvents == SOCKET_ERROR)
+    {
+        int nErr = WSAGetLastError();
+        nEvents = 0;
+        if (nErr != WSAEINTR) {
+            LogPrintf("socket epoll_wait error %s\n", NetworkErrorString(nErr));
+            if (!interruptNet.sleep_for(std::chrono::milliseconds(SOCKET_EVENTS_TIMEOUT)))
+                return;
+        }
+    }
+
+    // Nodes are only deleted by this thread, so every pointer handed out by epoll stays valid for this round
+    bool fAccept = false;
+    std::set<CNode*> setSendNodes;
+    for (int i = 0; i < nEvents; i++) {
+        CNode* pnode = static_cast<CNode*>(events[i].data.ptr);
+        if (pnode == nullptr) {
+            fAccept = true;
+            continue;
+        }
+        if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+            setNodesRecvPending.insert(pnode);
+        if (events[i].events & EPOLLOUT)
+            setSendNodes.insert(pnode);
+    }
+
+    //
+    // Accept new connections
+    //
+    if (fAccept) {
         BOOST_FOREACH(const ListenSocket& hListenSocket, vhListenSocket)
         {
-            if (hListenSocket.socket != INVALID_SOCKET && FD_ISSET(hListenSocket.socket, &fdsetRecv))
-            {
+            if (hListenSocket.socket != INVALID_SOCKET)
                 AcceptConnection(hListenSocket);
-            }
         }
+    }
 
-        //
-        // Service each socket
-        //
+    //
+    // Receive
+    //
+    auto it = setNodesRecvPending.begin();
+    while (it != setNodesRecvPending.end()) {
+        if (interruptNet)
+            return;
+        CNode* pnode = *it;
+        if (pnode->fPauseRecv || SocketRecvData(pnode)) {
+            ++it;
+        } else {
+            it = setNodesRecvPending.erase(it);
+        }
+    }
+
+    //
+    // Send
+    //
+    for (CNode* pnode : setSendNodes) {
+        LOCK(pnode->cs_vSend);
+        size_t nBytes = SocketSendData(pnode);
+        if (nBytes) {
+            RecordBytesSent(nBytes);
+        }
+    }
+
+    // Timeouts are counted in seconds, no need to walk all nodes more often
+    int64_t nTime = GetSystemTimeInSeconds();
+    if (nTime != nLastInactivityCheck) {
+        nLastInactivityCheck = nTime;
         std::vector<CNode*> vNodesCopy = CopyNodeVector();
         BOOST_FOREACH(CNode* pnode, vNodesCopy)
         {
-            if (interruptNet)
-                return;
+            InactivityCheck(pnode);
+        }
+        ReleaseNodeVector(vNodesCopy);
+    }
+}
+#else
+void CConnman::SocketHandlerEpoll()
+{
+    assert(false);
+}
+#endif
 
-            //
-            // Receive
-            //
-            bool recvSet = false;
-            bool sendSet = false;
-            bool errorSet = false;
-            {
-                LOCK(pnode->cs_hSocket);
-                if (pnode->hSocket == INVALID_SOCKET)
-                    continue;
-                recvSet = FD_ISSET(pnode->hSocket, &fdsetRecv);
-                sendSet = FD_ISSET(pnode->hSocket, &fdsetSend);
-                errorSet = FD_ISSET(pnode->hSocket, &fdsetError);
-            }
-            if (recvSet || errorSet)
-            {
-                {
-                    {
-                        // typical socket buffer is 8K-64K
-                        char pchBuf[0x10000];
-                        int nBytes = 0;
-                        {
-                            LOCK(pnode->cs_hSocket);
-                            if (pnode->hSocket == INVALID_SOCKET)
-                                continue;
-                            nBytes = recv(pnode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
-                        }
-                        if (nBytes > 0)
-                        {
-                            bool notify = false;
-                            if (!pnode->ReceiveMsgBytes(pchBuf, nBytes, notify))
-                                pnode->CloseSocketDisconnect();
-                            RecordBytesRecv(nBytes);
-                            if (notify) {
-                                size_t nSizeAdded = 0;
-                                auto it(pnode->vRecvMsg.begin());
-                                for (; it != pnode->vRecvMsg.end(); ++it) {
-                                    if (!it->complete())
-                                        break;
-                                    nSizeAdded += it->vRecv.size() + CMessageHeader::HEADER_SIZE;
-                                }
-                                {
-                                    LOCK(pnode->cs_vProcessMsg);
-                                    pnode->vProcessMsg.splice(pnode->vProcessMsg.end(), pnode->vRecvMsg, pnode->vRecvMsg.begin(), it);
-                                    pnode->nProcessQueueSize += nSizeAdded;
-                                    pnode->fPauseRecv = pnode->nProcessQueueSize > nReceiveFloodSize;
-                                }
-                                WakeMessageHandler();
-                            }
-                        }
-                        else if (nBytes == 0)
-                        {
-                            // socket closed gracefully
-                            if (!pnode->fDisconnect)
-                                LogPrint("net", "socket closed\n");
-                            pnode->CloseSocketDisconnect();
-                        }
-                        else if (nBytes < 0)
-                        {
-                            // error
-                            int nErr = WSAGetLastError();
-                            if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR && nErr != WSAEINPROGRESS)
-                            {
-                                if (!pnode->fDisconnect)
-                                    LogPrintf("socket recv error %s\n", NetworkErrorString(nErr));
-                                pnode->CloseSocketDisconnect();
-                            }
-                        }
-                    }
-                }
+bool CConnman::SocketRecvData(CNode* pnode)
+{
+    // typical socket buffer is 8K-64K
+    char pchBuf[0x10000];
+    // the bulk of large messages is read straight into the message buffer
+    unsigned int nBufSize = MAX_DIRECT_RECV_SIZE;
+    char* pchDest = pnode->GetRecvDataBuffer(nBufSize);
+    if (pchDest == nullptr) {
+        pchDest = pchBuf;
+        nBufSize = sizeof(pchBuf);
+    }
+    int nBytes = 0;
+    {
+        LOCK(pnode->cs_hSocket);
+        if (pnode->hSocket == INVALID_SOCKET)
+            return false;
+        nBytes = recv(pnode->hSocket, pchDest, nBufSize, MSG_DONTWAIT);
+    }
+    if (nBytes > 0)
+    {
+        bool notify = false;
+        if (!pnode->ReceiveMsgBytes(pchDest, nBytes, notify))
+            pnode->CloseSocketDisconnect();
+        RecordBytesRecv(nBytes);
+        if (notify) {
+            size_t nSizeAdded = 0;
+            auto it(pnode->vRecvMsg.begin());
+            for (; it != pnode->vRecvMsg.end(); ++it) {
+                if (!it->complete())
+                    break;
+                nSizeAdded += it->vRecv.size() + CMessageHeader::HEADER_SIZE;
             }
-
-            //
-            // Send
-            //
-            if (sendSet)
             {
-                LOCK(pnode->cs_vSend);
-                size_t nBytes = SocketSendData(pnode);
-                if (nBytes) {
-                    RecordBytesSent(nBytes);
-                }
+                LOCK(pnode->cs_vProcessMsg);
+                pnode->vProcessMsg.splice(pnode->vProcessMsg.end(), pnode->vRecvMsg, pnode->vRecvMsg.begin(), it);
+                pnode->nProcessQueueSize += nSizeAdded;
+                pnode->fPauseRecv = pnode->nProcessQueueSize > nReceiveFloodSize;
             }
+            WakeMessageHandler(pnode->GetId());
+        }
+        // A full buffer means there may be more to read
+        return (unsigned int)nBytes == nBufSize;
+    }
+    else if (nBytes == 0)
+    {
+        // socket closed gracefully
+        if (!pnode->fDisconnect)
+            LogPrint("net", "socket closed\n");
+        pnode->CloseSocketDisconnect();
+    }
+    else if (nBytes < 0)
+    {
+        // error
+        int nErr = WSAGetLastError();
+        if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR && nErr != WSAEINPROGRESS)
+        {
+            if (!pnode->fDisconnect)
+                LogPrintf("socket recv error %s\n", NetworkErrorString(nErr));
+            pnode->CloseSocketDisconnect();
+        }
+        else if (nErr == WSAEINTR)
+            return true;
+    }
+    return false;
+}
 
-            //
-            // Inactivity checking
-            //
-            int64_t nTime = GetSystemTimeInSeconds();
-            if (nTime - pnode->nTimeConnected > 60)
-            {
-                if (pnode->nLastRecv == 0 || pnode->nLastSend == 0)
-                {
-                    LogPrint("net", "socket no message in first 60 seconds, %d %d from %d\n", pnode->nLastRecv != 0, pnode->nLastSend != 0, pnode->id);
-                    pnode->fDisconnect = true;
-                }
-                else if (nTime - pnode->nLastSend > TIMEOUT_INTERVAL)
-                {
-                    LogPrintf("socket sending timeout: %is\n", nTime - pnode->nLastSend);
-                    pnode->fDisconnect = true;
-                }
-                else if (nTime - pnode->nLastRecv > (pnode->nVersion > BIP0031_VERSION ? TIMEOUT_INTERVAL : 90*60))
-                {
-                    LogPrintf("socket receive timeout: %is\n", nTime - pnode->nLastRecv);
-                    pnode->fDisconnect = true;
-                }
-                else if (pnode->nPingNonceSent && pnode->nPingUsecStart + TIMEOUT_INTERVAL * 1000000 < GetTimeMicros())
-                {
-                    LogPrintf("ping timeout: %fs\n", 0.000001 * (GetTimeMicros() - pnode->nPingUsecStart));
-                    pnode->fDisconnect = true;
-                }
-                else if (!pnode->fSuccessfullyConnected)
-                {
-                    LogPrintf("version handshake timeout from %d\n", pnode->id);
-                    pnode->fDisconnect = true;
-                }
-            }
+void CConnman::InactivityCheck(CNode* pnode)
+{
+    int64_t nTime = GetSystemTimeInSeconds();
+    if (nTime - pnode->nTimeConnected > 60)
+    {
+        if (pnode->nLastRecv == 0 || pnode->nLastSend == 0)
+        {
+            LogPrint("net", "socket no message in first 60 seconds, %d %d from %d\n", pnode->nLastRecv != 0, pnode->nLastSend != 0, pnode->id);
+            pnode->fDisconnect = true;
+        }
+        else if (nTime - pnode->nLastSend > TIMEOUT_INTERVAL)
+        {
+            LogPrintf("socket sending timeout: %is\n", nTime - pnode->nLastSend);
+            pnode->fDisconnect = true;
+        }
+        else if (nTime - pnode->nLastRecv > (pnode->nVersion > BIP0031_VERSION ? TIMEOUT_INTERVAL : 90*60))
+        {
+            LogPrintf("socket receive timeout: %is\n", nTime - pnode->nLastRecv);
+            pnode->fDisconnect = true;
+        }
+        else if (pnode->nPingNonceSent && pnode->nPingUsecStart + TIMEOUT_INTERVAL * 1000000 < GetTimeMicros())
+        {
+            LogPrintf("ping timeout: %fs\n", 0.000001 * (GetTimeMicros() - pnode->nPingUsecStart));
+            pnode->fDisconnect = true;
+        }
+        else if (!pnode->fSuccessfullyConnected)
+        {
+            LogPrintf("version handshake timeout from %d\n", pnode->id);
+            pnode->fDisconnect = true;
         }
-        ReleaseNodeVector(vNodesCopy);
     }
 }
 
@@ -1452,9 +1733,21 @@ void CConnman::WakeMessageHandler()
 {
     {
         std::lock_guard<std::mutex> lock(mutexMsgProc);
-        fMsgProcWake = true;
+        std::fill(vMsgProcWake.begin(), vMsgProcWake.end(), true);
     }
-    condMsgProc.notify_one();
+    condMsgProc.notify_all();
+}
+
+void CConnman::WakeMessageHandler(NodeId id)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutexMsgProc);
+        if (vMsgProcWake.empty())
+            return;
+        vMsgProcWake[id % vMsgProcWake.size()] = true;
+    }
+    // All handlers share the condition variable, the others go back to sleep
+    condMsgProc.notify_all();
 }
 
 
@@ -2190,6 +2483,7 @@ bool CConnman::OpenNetworkConnection(const CAddress& addrConnect, bool fCountFai
         pnode->fMasternode = true;
 
     GetNodeSignals().InitializeNode(pnode, *this);
+    RegisterSocketEvents(pnode);
     {
         LOCK(cs_vNodes);
         vNodes.push_back(pnode);
@@ -2202,7 +2496,7 @@ bool CConnman::OpenMasternodeConnection(const CAddress &addrConnect) {
     return OpenNetworkConnection(addrConnect, false, NULL, NULL, false, false, false, true);
 }
 
-void CConnman::ThreadMessageHandler()
+void CConnman::ThreadMessageHandler(int nThread)
 {
     while (!flagInterruptMsgProc)
     {
@@ -2212,6 +2506,10 @@ void CConnman::ThreadMessageHandler()
 
         BOOST_FOREACH(CNode* pnode, vNodesCopy)
         {
+            // Every peer belongs to one handler, so its messages are processed and answered in order
+            if (pnode->GetId() % nMessageHandlerThreads != nThread)
+                continue;
+
             if (pnode->fDisconnect)
                 continue;
 
@@ -2234,9 +2532,9 @@ void CConnman::ThreadMessageHandler()
 
         std::unique_lock<std::mutex> lock(mutexMsgProc);
         if (!fMoreWork) {
-            condMsgProc.wait_until(lock, std::chrono::steady_clock::now() + std::chrono::milliseconds(100), [this] { return fMsgProcWake; });
+            condMsgProc.wait_until(lock, std::chrono::steady_clock::now() + std::chrono::milliseconds(100), [this, nThread] { return vMsgProcWake[nThread]; });
         }
-        fMsgProcWake = false;
+        vMsgProcWake[nThread] = false;
     }
 }
 
@@ -2346,6 +2644,36 @@ bool CConnman::BindListenPort(const CService &addrBind, std::string& strError, b
     return true;
 }
 
+bool ParseSocketEventsMode(const std::string& strMode, SocketEventsMode& modeRet)
+{
+    if (strMode == "select") {
+        modeRet = SOCKETEVENTS_SELECT;
+        return true;
+    }
+#ifdef HAVE_SYS_EPOLL_H
+    if (strMode == "epoll") {
+        modeRet = SOCKETEVENTS_EPOLL;
+        return true;
+    }
+#endif
+    return false;
+}
+
+std::string GetSupportedSocketEventsModes()
+{
+#ifdef HAVE_SYS_EPOLL_H
+    return "select, epoll";
+#else
+    return "select";
+#endif
+}
+
+std::string GetDefaultSocketEventsMode()
+{
+    // epoll has to be asked for until it has seen more use on the network
+    return "select";
+}
+
 void Discover(boost::thread_group& threadGroup)
 {
     if (!fDiscover)
@@ -2437,6 +2765,10 @@ CConnman::CConnman(uint64_t nSeed0In, uint64_t nSeed1In) :
     nBestHeight = 0;
     clientInterface = NULL;
     flagInterruptMsgProc = false;
+    nMessageHandlerThreads = 1;
+    socketEventsMode = SOCKETEVENTS_SELECT;
+    epollfd = -1;
+    nLastInactivityCheck = 0;
 }
 
 NodeId CConnman::GetNewNodeId()
@@ -2518,6 +2850,31 @@ bool CConnman::Start(CScheduler& scheduler, std::string& strNodeError, Options c
         semMasternodeOutbound = new CSemaphore(MAX_OUTBOUND_MASTERNODE_CONNECTIONS);
     }
 
+    socketEventsMode = connOptions.socketEventsMode;
+#ifdef HAVE_SYS_EPOLL_H
+    if (socketEventsMode == SOCKETEVENTS_EPOLL) {
+        epollfd = epoll_create1(EPOLL_CLOEXEC);
+        bool fRegistered = epollfd != -1;
+        // Listen sockets stay level-triggered and are told apart from nodes by a null pointer
+        BOOST_FOREACH(const ListenSocket& hListenSocket, vhListenSocket) {
+            if (!fRegistered)
+                break;
+            struct epoll_event event;
+            event.events = EPOLLIN;
+            event.data.ptr = nullptr;
+            fRegistered = epoll_ctl(epollfd, EPOLL_CTL_ADD, hListenSocket.socket, &event) != SOCKET_ERROR;
+        }
+        if (!fRegistered) {
+            LogPrintf("epoll setup failed with error %s, falling back to select()\n", NetworkErrorString(WSAGetLastError()));
+            if (epollfd != -1)
+                close(epollfd);
+            epollfd = -1;
+            socketEventsMode = SOCKETEVENTS_SELECT;
+        }
+    }
+#endif
+    LogPrintf("Using %s for socket events\n", socketEventsMode == SOCKETEVENTS_EPOLL ? "epoll" : "select");
+
     //
     // Start threads
     //
@@ -2525,9 +2882,10 @@ bool CConnman::Start(CScheduler& scheduler, std::string& strNodeError, Options c
     interruptNet.reset();
     flagInterruptMsgProc = false;
 
+    nMessageHandlerThreads = std::max(1, std::min(connOptions.nMessageHandlerThreads, MAX_MSG_HANDLER_THREADS));
     {
         std::unique_lock<std::mutex> lock(mutexMsgProc);
-        fMsgProcWake = false;
+        vMsgProcWake.assign(nMessageHandlerThreads, false);
     }
 
     // Send and receive from sockets, accept connections
@@ -2549,7 +2907,12 @@ bool CConnman::Start(CScheduler& scheduler, std::string& strNodeError, Options c
     threadOpenMasternodeConnections = std::thread(&TraceThread<std::function<void()> >, "mncon", std::function<void()>(std::bind(&CConnman::ThreadOpenMasternodeConnections, this)));
 
     // Process messages
-    threadMessageHandler = std::thread(&TraceThread<std::function<void()> >, "msghand", std::function<void()>(std::bind(&CConnman::ThreadMessageHandler, this)));
+    for (int i = 0; i < nMessageHandlerThreads; i++) {
+        vThreadMessageHandler.push_back(std::thread([this, i] {
+            std::string strName = strprintf("msghand.%d", i);
+            TraceThread(strName.c_str(), std::function<void()>(std::bind(&CConnman::ThreadMessageHandler, this, i)));
+        }));
+    }
 
     // Dump network addresses
     scheduler.scheduleEvery(boost::bind(&CConnman::DumpData, this), DUMP_ADDRESSES_INTERVAL);
@@ -2621,8 +2984,11 @@ void CConnman::Stop()
 
     if (threadStakeMint.joinable())
         threadStakeMint.join();
-    if (threadMessageHandler.joinable())
-        threadMessageHandler.join();
+    for (std::thread& threadMessageHandler : vThreadMessageHandler) {
+        if (threadMessageHandler.joinable())
+            threadMessageHandler.join();
+    }
+    vThreadMessageHandler.clear();
     if (threadOpenMasternodeConnections.joinable())
         threadOpenMasternodeConnections.join();
     if (threadOpenConnections.joinable())
@@ -2653,6 +3019,13 @@ void CConnman::Stop()
         if (hListenSocket.socket != INVALID_SOCKET)
             if (!CloseSocket(hListenSocket.socket))
                 LogPrintf("CloseSocket(hListenSocket) failed with error %s\n", NetworkErrorString(WSAGetLastError()));
+#ifdef HAVE_SYS_EPOLL_H
+    if (epollfd != -1) {
+        close(epollfd);
+        epollfd = -1;
+    }
+#endif
+    setNodesRecvPending.clear();
 
     // clean up some globals (to help leak detection)
     BOOST_FOREACH(CNode *pnode, vNodes) {
@@ -2962,6 +3335,7 @@ CNode::CNode(NodeId idIn, ServiceFlags nLocalServicesIn, int nMyStartingHeightIn
     nServices = NODE_NONE;
     nServicesExpected = NODE_NONE;
     hSocket = hSocketIn;
+    nEpollFd = -1;
     nRecvVersion = INIT_PROTO_VERSION;
     nLastSend = 0;
     nLastRecv = 0;
@@ -3007,9 +3381,12 @@ CNode::CNode(NodeId idIn, ServiceFlags nLocalServicesIn, int nMyStartingHeightIn
     fPauseSend = false;
     nProcessQueueSize = 0;
 
-    BOOST_FOREACH(const std::string &msg, getAllNetMessageTypes())
+    BOOST_FOREACH(const std::string &msg, getAllNetMessageTypes()) {
         mapRecvBytesPerMsgCmd[msg] = 0;
+        mapTimingPerMsgCmd[msg] = CMsgCmdTiming();
+    }
     mapRecvBytesPerMsgCmd[NET_MESSAGE_COMMAND_OTHER] = 0;
+    mapTimingPerMsgCmd[NET_MESSAGE_COMMAND_OTHER] = CMsgCmdTiming();
 
     if (fLogIPs)
         LogPrint("net", "Added connection to %s peer=%d\n", addrName, id);
@@ -24,6 +24,7 @@
 #include "validation.h"
 #include <atomic>
 #include <deque>
+#include <set>
 #include <stdint.h>
 #include <thread>
 #include <memory>
@@ -59,6 +60,12 @@ static const unsigned int MAX_INV_SZ = 50000;
 static const unsigned int MAX_ADDR_TO_SEND = 1000;
 /** Maximum length of incoming protocol messages (no message over 3 MiB is currently acceptable). */
 static const unsigned int MAX_PROTOCOL_MESSAGE_LENGTH = 3 * 1024 * 1024;
+/** Messages with at least this much data left are received without the intermediate copy */
+static const unsigned int MIN_DIRECT_RECV_SIZE = 16 * 1024;
+/** Maximum amount of message data received directly by one recv() call */
+static const unsigned int MAX_DIRECT_RECV_SIZE = 256 * 1024;
+/** Maximum total size of finished receive buffers kept for reuse by later messages */
+static const size_t MAX_RECV_BUFFER_POOL_SIZE = 16 * 1024 * 1024;
 /** Maximum length of strSubVer in `version` message */
 static const unsigned int MAX_SUBVERSION_LENGTH = 256;
 /** Maximum number of automatic outgoing nodes */
@@ -75,6 +82,23 @@ static const bool DEFAULT_UPNP = USE_UPNP;
 #else
 static const bool DEFAULT_UPNP = false;
 #endif
+/** Time the socket handler waits for socket events before looking at its nodes again (in milliseconds) */
+static const int SOCKET_EVENTS_TIMEOUT = 50;
+/** The maximum number of socket events handled per epoll_wait() */
+static const int MAX_SOCKET_EVENTS = 1024;
+
+/** -msghandlerthreads default */
+static const int DEFAULT_MSG_HANDLER_THREADS = 2;
+/** Maximum number of message handler threads */
+static const int MAX_MSG_HANDLER_THREADS = 16;
+
+/** Ways for the socket handler to wait for socket events */
+enum SocketEventsMode
+{
+    SOCKETEVENTS_SELECT,  // rebuild the fd_sets on every round, limited to FD_SETSIZE sockets
+    SOCKETEVENTS_EPOLL,   // register every socket once, edge-triggered (Linux only)
+};
+
 /** The maximum number of entries in mapAskFor */
 static const size_t MAPASKFOR_MAX_SZ = MAX_INV_SZ;
 /** The maximum number of entries in setAskFor (larger due to getdata latency)*/
@@ -153,6 +177,8 @@ public:
         unsigned int nReceiveFloodSize = 0;
         uint64_t nMaxOutboundTimeframe = 0;
         uint64_t nMaxOutboundLimit = 0;
+        SocketEventsMode socketEventsMode = SOCKETEVENTS_SELECT;
+        int nMessageHandlerThreads = 1;
     };
     CConnman(uint64_t seed0, uint64_t seed1);
     ~CConnman();
@@ -400,6 +426,7 @@ public:
     unsigned int GetReceiveFloodSize() const;
 
     void WakeMessageHandler();
+    void WakeMessageHandler(NodeId id);
 private:
     struct ListenSocket {
         SOCKET socket;
@@ -411,9 +438,14 @@ private:
     void ThreadOpenAddedConnections();
     void ProcessOneShot();
     void ThreadOpenConnections();
-    void ThreadMessageHandler();
+    void ThreadMessageHandler(int nThread);
     void AcceptConnection(const ListenSocket& hListenSocket);
     void ThreadSocketHandler();
+    void SocketHandlerSelect();
+    void SocketHandlerEpoll();
+    void RegisterSocketEvents(CNode* pnode);
+    bool SocketRecvData(CNode* pnode);
+    void InactivityCheck(CNode* pnode);
     void ThreadDNSAddressSeed();
     void ThreadOpenMasternodeConnections();
     void ThreadStakeMinter();
@@ -487,6 +519,14 @@ private:
     std::vector<CNode*> vNodes;
     std::list<CNode*> vNodesDisconnected;
     mutable CCriticalSection cs_vNodes;
+
+    SocketEventsMode socketEventsMode;
+    /** epoll instance every socket is registered with, -1 when waiting with select() */
+    int epollfd;
+    /** Nodes that may have more data to read. Edge-triggered epoll won't report them again
+     *  until new data arrives, so the socket handler keeps reading them on its own (socket handler only). */
+    std::set<CNode*> setNodesRecvPending;
+    int64_t nLastInactivityCheck;
     std::atomic<NodeId> nLastNodeId;
 
     /** Services this instance offers */
@@ -508,8 +548,11 @@ private:
     /** SipHasher seeds for deterministic randomness */
     const uint64_t nSeed0, nSeed1;
 
-    /** flag for waking the message processor. */
-    bool fMsgProcWake;
+    /** Peers are sharded across the message handler threads by node id, keeping every peer's messages in order */
+    int nMessageHandlerThreads;
+
+    /** flags for waking the message processors, one per thread. */
+    std::vector<bool> vMsgProcWake;
 
     std::condition_variable condMsgProc;
     std::mutex mutexMsgProc;
@@ -522,7 +565,7 @@ private:
     std::thread threadOpenAddedConnections;
     std::thread threadOpenConnections;
     std::thread threadOpenMasternodeConnections;
-    std::thread threadMessageHandler;
+    std::vector<std::thread> vThreadMessageHandler;
     std::thread threadStakeMint;
     std::atomic_size_t asyncTaskCount{0};
 };
@@ -531,6 +574,11 @@ void Discover(boost::thread_group& threadGroup);
 void MapPort(bool fUseUPnP);
 unsigned short GetListenPort();
 bool BindListenPort(const CService &bindAddr, std::string& strError, bool fWhitelisted = false);
+bool ParseSocketEventsMode(const std::string& strMode, SocketEventsMode& modeRet);
+/** Comma separated names of the socket events modes this build supports */
+std::string GetSupportedSocketEventsModes();
+/** Name of the default -socketevents mode, epoll where it is available */
+std::string GetDefaultSocketEventsMode();
 
 struct CombinerAll
 {
@@ -609,6 +657,18 @@ struct LocalServiceInfo {
 extern CCriticalSection cs_mapLocalHost;
 extern std::map<CNetAddr, LocalServiceInfo> mapLocalHost;
 typedef std::map<std::string, uint64_t> mapMsgCmdSize; //command, total bytes
+/** Command under which statistics of unknown commands are kept */
+const static std::string NET_MESSAGE_COMMAND_OTHER = "*other*";
+
+/** Processing of one message command, times in microseconds */
+struct CMsgCmdTiming
+{
+    uint64_t nCount = 0;
+    int64_t nWaitTime = 0; // from receipt until processing started
+    int64_t nMaxWaitTime = 0;
+    int64_t nProcessTime = 0;
+};
+typedef std::map<std::string, CMsgCmdTiming> mapMsgCmdTiming;
 
 class CNodeStats
 {
@@ -630,6 +690,7 @@ public:
     mapMsgCmdSize mapSendBytesPerMsgCmd;
     uint64_t nRecvBytes;
     mapMsgCmdSize mapRecvBytesPerMsgCmd;
+    mapMsgCmdTiming mapTimingPerMsgCmd;
     bool fWhitelisted;
     double dPingTime;
     double dPingWait;
@@ -641,6 +702,38 @@ public:
 
 
 
+/**
+ * Receive buffers of processed messages, kept for reuse by the next messages.
+ *
+ * Buffers are grouped in power-of-two size classes and always have at least the capacity
+ * of their class, so a message buffer taken for the size announced in the header never has
+ * to be reallocated (and copied) while the message data arrives.
+ */
+class CNetRecvBufferPool
+{
+public:
+    static const int MIN_BUFFER_CLASS = 12; // 4 KiB
+    static const int MAX_BUFFER_CLASS = 22; // 4 MiB, holds MAX_PROTOCOL_MESSAGE_LENGTH
+
+private:
+    CCriticalSection cs;
+    std::vector<std::vector<CSerializeData> > vFreeBuffers;
+    size_t nMaxCachedBytes;
+    size_t nCachedBytes;
+
+public:
+    explicit CNetRecvBufferPool(size_t nMaxCachedBytesIn = MAX_RECV_BUFFER_POOL_SIZE);
+
+    /** Replace vchRet by an empty buffer with room for nSize bytes */
+    void Take(size_t nSize, CSerializeData& vchRet);
+    /** Keep the storage of vch for a later Take(), vch is left empty */
+    void Return(CSerializeData& vch);
+
+    size_t GetCachedBytes();
+};
+
+CNetRecvBufferPool& GetNetRecvBufferPool();
+
 class CNetMessage {
 private:
     mutable CHash256 hasher;
@@ -665,6 +758,8 @@ public:
         nTime = 0;
     }
 
+    ~CNetMessage();
+
     bool complete() const
     {
         if (!in_data)
@@ -682,6 +777,16 @@ public:
 
     int readHeader(const char *pch, unsigned int nBytes);
     int readData(const char *pch, unsigned int nBytes);
+
+    /**
+     * Room for up to nBytes of the message data that still has to arrive, so the socket can
+     * be read into it directly. Pass the same pointer to readData() to account the data.
+     */
+    char* GetDataBuffer(unsigned int& nBytes);
+
+private:
+    CNetMessage(const CNetMessage&);
+    void operator=(const CNetMessage&);
 };
 
 
@@ -700,6 +805,8 @@ public:
     std::deque<std::vector<unsigned char>> vSendMsg;
     CCriticalSection cs_vSend;
     CCriticalSection cs_hSocket;
+    // epoll instance hSocket is registered with, -1 if none (protected by cs_hSocket)
+    int nEpollFd;
     CCriticalSection cs_vRecv;
 
     CCriticalSection cs_vProcessMsg;
@@ -757,6 +864,8 @@ protected:
 
     mapMsgCmdSize mapSendBytesPerMsgCmd;
     mapMsgCmdSize mapRecvBytesPerMsgCmd;
+    mapMsgCmdTiming mapTimingPerMsgCmd;
+    CCriticalSection cs_mapTimingPerMsgCmd;
 
 public:
     uint256 hashContinue;
@@ -850,6 +959,11 @@ public:
     }
 
     bool ReceiveMsgBytes(const char *pch, unsigned int nBytes, bool& complete);
+    /** Buffer of the large message being received to recv() into directly, nullptr if none */
+    char* GetRecvDataBuffer(unsigned int& nBytes);
+
+    /** Account a processed message, to measure how fairly peers get scheduled */
+    void RecordMsgTiming(const std::string& strCommand, int64_t nWaitTime, int64_t nProcessTime);
 
     void SetRecvVersion(int nVersionIn)
     {
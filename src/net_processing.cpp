@@ -137,8 +137,141 @@ namespace {
     MapRelay mapRelay;
     /** Expiration-time ordered list of (expire time, relay map entry) pairs, protected by cs_main). */
     std::deque<std::pair<int64_t, MapRelay::iterator>> vRelayExpiration;
+
+    /**
+     * Peers are sharded across the message handler threads, but the core protocol
+     * handlers expect to run one at a time. Everything except the commands registered
+     * as concurrent with the message dispatcher is processed and sent under this lock.
+     */
+    CCriticalSection cs_serialMessages;
 } // anon namespace
 
+CNetMessageDispatcher::CNetMessageDispatcher()
+{
+    const std::vector<std::string>& vTypes = getAllNetMessageTypes();
+    vEntries.reserve(vTypes.size() + 1);
+    BOOST_FOREACH(const std::string& strCommand, vTypes) {
+        mapCommandIds.emplace(strCommand, vEntries.size());
+        vEntries.emplace_back(new CCommandEntry(strCommand));
+    }
+    vEntries.emplace_back(new CCommandEntry(NET_MESSAGE_COMMAND_OTHER));
+}
+
+void CNetMessageDispatcher::RegisterHandler(const std::string& strCommand, const Handler& handler, bool fConcurrent)
+{
+    int nCommandId = GetCommandId(strCommand);
+    assert(nCommandId != -1);
+    vEntries[nCommandId]->handler = handler;
+    vEntries[nCommandId]->fConcurrent = fConcurrent;
+}
+
+int CNetMessageDispatcher::GetCommandId(const std::string& strCommand) const
+{
+    auto it = mapCommandIds.find(strCommand);
+    return it == mapCommandIds.end() ? -1 : it->second;
+}
+
+bool CNetMessageDispatcher::IsConcurrent(int nCommandId) const
+{
+    return nCommandId != -1 && vEntries[nCommandId]->fConcurrent;
+}
+
+bool CNetMessageDispatcher::Dispatch(int nCommandId, CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) const
+{
+    if (nCommandId == -1)
+        return false;
+    // Known commands nobody handles are dropped silently
+    if (vEntries[nCommandId]->handler)
+        vEntries[nCommandId]->handler(pfrom, strCommand, vRecv, connman);
+    return true;
+}
+
+void CNetMessageDispatcher::RecordProcessed(int nCommandId, int64_t nTime)
+{
+    CCommandEntry& entry = *(nCommandId == -1 ? vEntries.back() : vEntries[nCommandId]);
+    entry.nCount++;
+    entry.nTime += nTime;
+}
+
+std::map<std::string, CNetMessageDispatcher::CCommandStats> CNetMessageDispatcher::GetStats() const
+{
+    std::map<std::string, CCommandStats> mapStats;
+    BOOST_FOREACH(const std::unique_ptr<CCommandEntry>& entry, vEntries) {
+        CCommandStats& stats = mapStats[entry->strCommand];
+        stats.nCount = entry->nCount;
+        stats.nTime = entry->nTime;
+    }
+    return mapStats;
+}
+
+CNetMessageDispatcher& GetNetMessageDispatcher()
+{
+    static CNetMessageDispatcher dispatcher;
+    return dispatcher;
+}
+
+static void RegisterMessageHandlers(CNetMessageDispatcher& dispatcher)
+{
+    // These managers lock their own state, so their messages may run alongside other peers' (see cs_serialMessages)
+    auto mnodemanHandler = [](CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) {
+        mnodeman.ProcessMessage(pfrom, strCommand, vRecv, connman);
+    };
+    for (const char* strCommand : {NetMsgType::MNANNOUNCE, NetMsgType::MNPING, NetMsgType::DSEG, NetMsgType::MNVERIFY})
+        dispatcher.RegisterHandler(strCommand, mnodemanHandler, true);
+
+    auto mnpaymentsHandler = [](CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) {
+        mnpayments.ProcessMessage(pfrom, strCommand, vRecv, connman);
+    };
+    for (const char* strCommand : {NetMsgType::MASTERNODEPAYMENTSYNC, NetMsgType::MASTERNODEPAYMENTVOTE})
+        dispatcher.RegisterHandler(strCommand, mnpaymentsHandler, true);
+
+    // TXLOCKREQUEST is a transaction and handled by ProcessMessage() itself
+    dispatcher.RegisterHandler(NetMsgType::TXLOCKVOTE, [](CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) {
+        instantsend.ProcessMessage(pfrom, strCommand, vRecv, connman);
+    }, true);
+
+    auto governanceHandler = [](CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) {
+        governance.ProcessMessage(pfrom, strCommand, vRecv, connman);
+    };
+    for (const char* strCommand : {NetMsgType::MNGOVERNANCESYNC, NetMsgType::MNGOVERNANCEOBJECT, NetMsgType::MNGOVERNANCEOBJECTVOTE})
+        dispatcher.RegisterHandler(strCommand, governanceHandler, true);
+
+    dispatcher.RegisterHandler(NetMsgType::SYNCSTATUSCOUNT, [](CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) {
+        masternodeSync.ProcessMessage(pfrom, strCommand, vRecv);
+    }, true);
+
+    // Sporks and PrivateSend keep state without locks of their own
+    auto sporkHandler = [](CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) {
+        sporkManager.ProcessSpork(pfrom, strCommand, vRecv, connman);
+    };
+    for (const char* strCommand : {NetMsgType::SPORK, NetMsgType::GETSPORKS, NetMsgType::CHECKPOINT, NetMsgType::BLACKLIST})
+        dispatcher.RegisterHandler(strCommand, sporkHandler, false);
+
+    auto privateSendServerHandler = [](CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) {
+        privateSendServer.ProcessMessage(pfrom, strCommand, vRecv, connman);
+    };
+    for (const char* strCommand : {NetMsgType::DSACCEPT, NetMsgType::DSVIN, NetMsgType::DSSIGNFINALTX})
+        dispatcher.RegisterHandler(strCommand, privateSendServerHandler, false);
+
+#ifdef ENABLE_WALLET
+    auto privateSendClientHandler = [](CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) {
+        privateSendClient.ProcessMessage(pfrom, strCommand, vRecv, connman);
+    };
+    for (const char* strCommand : {NetMsgType::DSSTATUSUPDATE, NetMsgType::DSFINALTX, NetMsgType::DSCOMPLETE})
+        dispatcher.RegisterHandler(strCommand, privateSendClientHandler, false);
+
+    // Masternodes serve queues, everybody else joins them
+    dispatcher.RegisterHandler(NetMsgType::DSQUEUE, [](CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) {
+        if (fMasternodeMode)
+            privateSendServer.ProcessMessage(pfrom, strCommand, vRecv, connman);
+        else
+            privateSendClient.ProcessMessage(pfrom, strCommand, vRecv, connman);
+    }, false);
+#else
+    dispatcher.RegisterHandler(NetMsgType::DSQUEUE, privateSendServerHandler, false);
+#endif // ENABLE_WALLET
+}
+
 //////////////////////////////////////////////////////////////////////////////
 //
 // Registration of network node signals.
@@ -637,6 +770,8 @@ bool GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats) {
 
 void RegisterNodeSignals(CNodeSignals& nodeSignals)
 {
+    RegisterMessageHandlers(GetNetMessageDispatcher());
+
     nodeSignals.ProcessMessages.connect(&ProcessMessages);
     nodeSignals.SendMessages.connect(&SendMessages);
     nodeSignals.InitializeNode.connect(&InitializeNode);
@@ -2565,11 +2700,16 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             Misbehaving(pfrom->GetId(), 20);
             return error("headers message size = %u", nCount);
         }
-        headers.resize(nCount);
+        std::vector<CBlockHeader> vHeaders(nCount);
         for (unsigned int n = 0; n < nCount; n++) {
-            vRecv >> headers[n];
+            vRecv >> vHeaders[n];
             ReadCompactSize(vRecv); // ignore tx count; assume it is 0.
         }
+
+        // Hash the whole message up front, the hash caches make the per-header checks below cheap.
+        std::vector<uint256> vHashes(nCount);
+        HashX11Batch(vHeaders.data(), vHeaders.size(), vHashes.data());
+        headers.assign(std::make_move_iterator(vHeaders.begin()), std::make_move_iterator(vHeaders.end()));
       }
 
         const CBlockIndex *pindexLast = NULL;
@@ -3011,30 +3151,9 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
     }
 
     else {
-        bool found = false;
-        const std::vector<std::string> &allMessages = getAllNetMessageTypes();
-        BOOST_FOREACH(const std::string msg, allMessages) {
-            if(msg == strCommand) {
-                found = true;
-                break;
-            }
-        }
-
-        if (found)
-        {
-            //probably one the extensions
-#ifdef ENABLE_WALLET
-            privateSendClient.ProcessMessage(pfrom, strCommand, vRecv, connman);
-#endif // ENABLE_WALLET
-            privateSendServer.ProcessMessage(pfrom, strCommand, vRecv, connman);
-            mnodeman.ProcessMessage(pfrom, strCommand, vRecv, connman);
-            mnpayments.ProcessMessage(pfrom, strCommand, vRecv, connman);
-            instantsend.ProcessMessage(pfrom, strCommand, vRecv, connman);
-            sporkManager.ProcessSpork(pfrom, strCommand, vRecv, connman);
-            masternodeSync.ProcessMessage(pfrom, strCommand, vRecv);
-            governance.ProcessMessage(pfrom, strCommand, vRecv, connman);
-        }
-        else
+        // One of the extensions, handed to the manager registered for it
+        const CNetMessageDispatcher& dispatcher = GetNetMessageDispatcher();
+        if (!dispatcher.Dispatch(dispatcher.GetCommandId(strCommand), pfrom, strCommand, vRecv, connman))
         {
             // Ignore unknown commands for extensibility
             LogPrint("net", "Unknown command \"%s\" from peer=%d\n", SanitizeString(strCommand), pfrom->id);
@@ -3087,13 +3206,17 @@ bool ProcessMessages(CNode* pfrom, CConnman& connman, const std::atomic<bool>& i
     //
     bool fMoreWork = false;
 
-    // Continue processing after burst limit got reached
-    if (TryPostponedHeaders(pfrom, GetAdjustedTime(), chainparams, connman, interruptMsgProc)) {
-        fMoreWork = true;
-    }
+    {
+        LOCK(cs_serialMessages);
 
-    if (!pfrom->vRecvGetData.empty())
-        ProcessGetData(pfrom, chainparams.GetConsensus(), connman, interruptMsgProc);
+        // Continue processing after burst limit got reached
+        if (TryPostponedHeaders(pfrom, GetAdjustedTime(), chainparams, connman, interruptMsgProc)) {
+            fMoreWork = true;
+        }
+
+        if (!pfrom->vRecvGetData.empty())
+            ProcessGetData(pfrom, chainparams.GetConsensus(), connman, interruptMsgProc);
+    }
 
     if (pfrom->fDisconnect)
         return false;
@@ -3153,10 +3276,20 @@ bool ProcessMessages(CNode* pfrom, CConnman& connman, const std::atomic<bool>& i
         }
 
         // Process message
+        CNetMessageDispatcher& dispatcher = GetNetMessageDispatcher();
+        int nCommandId = dispatcher.GetCommandId(strCommand);
         bool fRet = false;
+        int64_t nProcessStart = 0;
         try
         {
-            fRet = ProcessMessage(pfrom, strCommand, vRecv, msg.nTime, chainparams, connman, interruptMsgProc);
+            if (dispatcher.IsConcurrent(nCommandId)) {
+                nProcessStart = GetTimeMicros();
+                fRet = ProcessMessage(pfrom, strCommand, vRecv, msg.nTime, chainparams, connman, interruptMsgProc);
+            } else {
+                LOCK(cs_serialMessages);
+                nProcessStart = GetTimeMicros();
+                fRet = ProcessMessage(pfrom, strCommand, vRecv, msg.nTime, chainparams, connman, interruptMsgProc);
+            }
             if (interruptMsgProc)
                 return false;
             if (!pfrom->vRecvGetData.empty())
@@ -3195,6 +3328,12 @@ bool ProcessMessages(CNode* pfrom, CConnman& connman, const std::atomic<bool>& i
             LogPrintf("%s(%s, %u bytes) FAILED peer=%d\n", __func__, SanitizeString(strCommand), nMessageSize, pfrom->id);
         }
 
+        if (nProcessStart != 0) {
+            int64_t nProcessTime = GetTimeMicros() - nProcessStart;
+            pfrom->RecordMsgTiming(strCommand, nProcessStart - msg.nTime, nProcessTime);
+            dispatcher.RecordProcessed(nCommandId, nProcessTime);
+        }
+
         LOCK(cs_main);
         SendRejectsAndCheckIfBanned(pfrom, connman);
 
@@ -3226,6 +3365,8 @@ bool SendMessages(CNode* pto, CConnman& connman, const std::atomic<bool>& interr
         if (!pto->fSuccessfullyConnected || pto->fDisconnect)
             return true;
 
+        LOCK(cs_serialMessages);
+
         // If we get here, the outgoing message serialization version is set and can't change.
         const CNetMsgMaker msgMaker(pto->GetSendVersion());
 
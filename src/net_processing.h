@@ -10,6 +10,12 @@
 #include "net.h"
 #include "validationinterface.h"
 
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
 /** Default for -maxorphantx, maximum number of orphan transactions kept in memory */
 static const unsigned int DEFAULT_MAX_ORPHAN_TRANSACTIONS = 100;
 /** Expiration time for orphan transactions in seconds */
@@ -25,6 +31,56 @@ static constexpr int64_t HEADERS_DOWNLOAD_TIMEOUT_PER_HEADER = 1000; // 1ms/head
 /** Default number of orphan+recently-replaced txn to keep around for block reconstruction */
 static const unsigned int DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN = 100;
 
+/**
+ * Routes the commands the core protocol handler doesn't know about (masternode, governance,
+ * InstantSend, PrivateSend, spork and sync messages) to the one handler registered for each.
+ * Commands are interned to ids once, so dispatch and the per-command statistics are array lookups.
+ * Handlers are registered at startup, before the message handler threads run.
+ */
+class CNetMessageDispatcher
+{
+public:
+    typedef std::function<void(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman)> Handler;
+
+    struct CCommandStats
+    {
+        uint64_t nCount;
+        int64_t nTime; // total processing time in microseconds
+    };
+
+private:
+    struct CCommandEntry
+    {
+        std::string strCommand;
+        Handler handler;
+        bool fConcurrent;
+        std::atomic<uint64_t> nCount;
+        std::atomic<int64_t> nTime;
+
+        explicit CCommandEntry(const std::string& strCommandIn) : strCommand(strCommandIn), fConcurrent(false), nCount(0), nTime(0) {}
+    };
+
+    std::unordered_map<std::string, int> mapCommandIds;
+    /** One entry per protocol command, the last one collects unknown commands */
+    std::vector<std::unique_ptr<CCommandEntry>> vEntries;
+
+public:
+    CNetMessageDispatcher();
+
+    /** Route strCommand to handler. fConcurrent if the handler locks its own state and may run
+     *  while other peers' messages are being processed. */
+    void RegisterHandler(const std::string& strCommand, const Handler& handler, bool fConcurrent);
+    /** Interned id of a protocol command, -1 for unknown commands */
+    int GetCommandId(const std::string& strCommand) const;
+    bool IsConcurrent(int nCommandId) const;
+    /** Run the handler of nCommandId, if any. Returns false for unknown commands. */
+    bool Dispatch(int nCommandId, CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) const;
+    void RecordProcessed(int nCommandId, int64_t nTime);
+    std::map<std::string, CCommandStats> GetStats() const;
+};
+
+CNetMessageDispatcher& GetNetMessageDispatcher();
+
 /** Register with a network node to receive its signals */
 void RegisterNodeSignals(CNodeSignals& nodeSignals);
 /** Unregister a network node */
@@ -8,6 +8,7 @@
 #include <boost/assign/list_of.hpp>
 #include <boost/lexical_cast.hpp>
 
+#include "cachemap.h"
 #include "chainparams.h"
 #include "db.h"
 #include "pos_kernel.h"
@@ -16,6 +17,11 @@
 #include "timedata.h"
 #include "util.h"
 #include "consensus/validation.h"
+#include "crypto/common.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 using namespace std;
 
@@ -263,6 +269,54 @@ bool ComputeNextStakeModifier(const CBlockIndex* pindexPrev, uint64_t& nStakeMod
     return true;
 }
 
+static CCriticalSection cs_stakeModifierCache;
+static CacheMap<const CBlockIndex*, uint64_t> mapStakeModifierCache(MAX_STAKE_MODIFIER_CACHE_SIZE);
+static uint64_t nStakeModifierCacheHits = 0;
+static uint64_t nStakeModifierCacheMisses = 0;
+
+bool GetKernelStakeModifier(const CBlockIndex* pindexPrev, uint64_t& nStakeModifier)
+{
+    {
+        LOCK(cs_stakeModifierCache);
+        if (mapStakeModifierCache.Get(pindexPrev, nStakeModifier)) {
+            ++nStakeModifierCacheHits;
+            return true;
+        }
+        ++nStakeModifierCacheMisses;
+    }
+
+    // computed without the lock, concurrent misses for the same block produce the same value
+    if (!ComputeNextStakeModifier(pindexPrev, nStakeModifier)) {
+        return false;
+    }
+
+    LOCK(cs_stakeModifierCache);
+    mapStakeModifierCache.Insert(pindexPrev, nStakeModifier);
+    return true;
+}
+
+void InvalidateStakeModifierCache(const CBlockIndex* pindex)
+{
+    LOCK(cs_stakeModifierCache);
+    mapStakeModifierCache.Erase(pindex);
+}
+
+void ClearStakeModifierCache()
+{
+    LOCK(cs_stakeModifierCache);
+    mapStakeModifierCache.Clear();
+    nStakeModifierCacheHits = 0;
+    nStakeModifierCacheMisses = 0;
+}
+
+void GetStakeModifierCacheStats(size_t& nEntries, uint64_t& nHits, uint64_t& nMisses)
+{
+    LOCK(cs_stakeModifierCache);
+    nEntries = mapStakeModifierCache.GetSize();
+    nHits = nStakeModifierCacheHits;
+    nMisses = nStakeModifierCacheMisses;
+}
+
 uint256 stakeHash(unsigned int nTimeTx, CDataStream ss, unsigned int prevoutIndex, uint256 prevoutHash, unsigned int nTimeBlockFrom)
 {
     //Pivx will hash in the transaction hash and the index number in order to make sure each hash is unique
@@ -270,8 +324,46 @@ uint256 stakeHash(unsigned int nTimeTx, CDataStream ss, unsigned int prevoutInde
     return Hash(ss.begin(), ss.end());
 }
 
-//instead of looping outside and reinitializing variables many times, we will give a nTimeTx and also search interval so that we can do all the hashing here
-bool CheckStakeKernelHash(unsigned int nBits, const CBlockIndex &blockFrom, const CTransaction txPrev, const COutPoint prevout, unsigned int& nTimeTx, unsigned int nHashDrift, bool fCheck, uint256& hashProofOfStake, uint64_t &nStakeModifier, bool fPrintProofOfStake)
+CStakeKernel::CStakeKernel(uint64_t nStakeModifierIn, unsigned int nTimeBlockFrom, const COutPoint& prevout,
+                           const arith_uint256& bnTargetIn, unsigned int nMinTimeTxIn) :
+    bnTarget(bnTargetIn),
+    nStakeModifier(nStakeModifierIn),
+    nMinTimeTx(nMinTimeTxIn)
+{
+    // same layout as stakeHash(), less the transaction time
+    unsigned char prefix[8 + 4 + 4 + 32];
+    WriteLE64(prefix, nStakeModifier);
+    WriteLE32(prefix + 8, nTimeBlockFrom);
+    WriteLE32(prefix + 12, prevout.n);
+    memcpy(prefix + 16, prevout.hash.begin(), 32);
+    hasherPrefix.Write(prefix, sizeof(prefix));
+}
+
+uint256 CStakeKernel::GetHash(unsigned int nTimeTx) const
+{
+    unsigned char time[4];
+    WriteLE32(time, nTimeTx);
+    unsigned char buf[CSHA256::OUTPUT_SIZE];
+    CSHA256(hasherPrefix).Write(time, sizeof(time)).Finalize(buf);
+    uint256 result;
+    CSHA256().Write(buf, sizeof(buf)).Finalize(result.begin());
+    return result;
+}
+
+bool CStakeKernel::Search(unsigned int nTimeFrom, unsigned int nTimeTo, unsigned int& nTimeTxRet, uint256& hashProofOfStakeRet) const
+{
+    for (auto try_time = nTimeFrom; try_time < nTimeTo; ++try_time) {
+        uint256 hash = GetHash(try_time);
+        if (UintToArith256(hash) < bnTarget) {
+            nTimeTxRet = try_time;
+            hashProofOfStakeRet = hash;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PrepareStakeKernel(unsigned int nBits, const CBlockIndex &blockFrom, const CTransaction& txPrev, const COutPoint& prevout, unsigned int nTimeTx, bool fCheck, CStakeKernel& kernelRet)
 {
     //assign new variables to make it easier to read
     CAmount nValueIn = txPrev.vout[prevout.n].nValue;
@@ -313,30 +405,100 @@ bool CheckStakeKernelHash(unsigned int nBits, const CBlockIndex &blockFrom, cons
     uint64_t nRequiredStakeModifier = 0;
 
     // NOTE: this must be calculated based on previous-to-tip, but not previous-to-stake block!
-    if (!ComputeNextStakeModifier(&blockFrom, nRequiredStakeModifier)) {
+    if (!GetKernelStakeModifier(&blockFrom, nRequiredStakeModifier)) {
         LogPrintf("CheckStakeKernelHash(): failed to get kernel stake modifier \n");
         return false;
     }
-    
+
+    kernelRet = CStakeKernel(nRequiredStakeModifier, nTimeBlockFrom, prevout, bnTarget, nTimeBlockFrom + min_age);
+    return true;
+}
+
+bool FindStakeKernel(const std::vector<CStakeKernel>& vKernels, size_t nStart, unsigned int nTimeFrom, unsigned int nTimeTo,
+                     int nThreads, size_t& nIndexRet, unsigned int& nTimeTxRet, uint256& hashProofOfStakeRet)
+{
+    if (nStart >= vKernels.size() || nTimeFrom >= nTimeTo) {
+        return false;
+    }
+
+    // candidates are handed out in order, so every index below a found one is searched as well
+    static const size_t KERNEL_CHUNK_SIZE = 64;
+    size_t nCount = vKernels.size() - nStart;
+    nThreads = std::max(1, std::min<int>(nThreads, nCount / MIN_STAKE_KERNELS_PER_THREAD));
+
+    std::atomic<size_t> nNextChunk(nStart);
+    std::atomic<size_t> nFound(vKernels.size());
+    std::mutex mutexResult;
+
+    auto worker = [&]() {
+        for (;;) {
+            size_t nBegin = nNextChunk.fetch_add(KERNEL_CHUNK_SIZE);
+            if (nBegin >= nFound.load()) {
+                return;
+            }
+            size_t nEnd = std::min(nBegin + KERNEL_CHUNK_SIZE, vKernels.size());
+            for (size_t i = nBegin; i < nEnd && i < nFound.load(); ++i) {
+                const CStakeKernel& kernel = vKernels[i];
+                // the age only grows during the search, so the start time decides
+                if (nTimeFrom < kernel.GetMinTimeTx()) {
+                    continue;
+                }
+                unsigned int nTimeTx;
+                uint256 hashProofOfStake;
+                if (kernel.Search(nTimeFrom, nTimeTo, nTimeTx, hashProofOfStake)) {
+                    std::lock_guard<std::mutex> lock(mutexResult);
+                    if (i < nFound.load()) {
+                        nFound = i;
+                        nTimeTxRet = nTimeTx;
+                        hashProofOfStakeRet = hashProofOfStake;
+                    }
+                    return;
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < nThreads; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (nFound.load() == vKernels.size()) {
+        return false;
+    }
+    nIndexRet = nFound.load();
+    return true;
+}
+
+//instead of looping outside and reinitializing variables many times, we will give a nTimeTx and also search interval so that we can do all the hashing here
+bool CheckStakeKernelHash(unsigned int nBits, const CBlockIndex &blockFrom, const CTransaction& txPrev, const COutPoint& prevout, unsigned int& nTimeTx, unsigned int nHashDrift, bool fCheck, uint256& hashProofOfStake, uint64_t &nStakeModifier, bool fPrintProofOfStake)
+{
+    CStakeKernel kernel;
+    if (!PrepareStakeKernel(nBits, blockFrom, txPrev, prevout, nTimeTx, fCheck, kernel)) {
+        return false;
+    }
+
     if (fCheck) {
-        if (nStakeModifier != nRequiredStakeModifier) {
+        if (nStakeModifier != kernel.GetStakeModifier()) {
             return error(
                 "%s : nStakeModifier mismatch at %d %llx != %llx",
                 __func__, blockFrom.nHeight,
-                nStakeModifier, nRequiredStakeModifier );
+                nStakeModifier, kernel.GetStakeModifier() );
         }
     } else {
-        nStakeModifier = nRequiredStakeModifier;
+        nStakeModifier = kernel.GetStakeModifier();
     }
 
-    //create data stream once instead of repeating it in the loop
-    CDataStream ss(SER_GETHASH, 0);
-    ss << nStakeModifier;
+    unsigned int nTimeBlockFrom = blockFrom.GetBlockTime();
 
     // if wallet is simply checking to make sure a hash is valid
     //-------------------
     if (fCheck) {
-        uint256 requiredHashProofOfStake = stakeHash(nTimeTx, ss, prevout.n, prevout.hash, nTimeBlockFrom);
+        uint256 requiredHashProofOfStake = kernel.GetHash(nTimeTx);
         
         if (requiredHashProofOfStake != hashProofOfStake) {
             return error(
@@ -347,7 +509,7 @@ bool CheckStakeKernelHash(unsigned int nBits, const CBlockIndex &blockFrom, cons
                 requiredHashProofOfStake.ToString().c_str() );
         }
 
-        return UintToArith256(hashProofOfStake) < bnTarget;
+        return UintToArith256(hashProofOfStake) < kernel.GetTarget();
     }
 
     // search
@@ -359,35 +521,27 @@ bool CheckStakeKernelHash(unsigned int nBits, const CBlockIndex &blockFrom, cons
     LogPrint("stake", "%s: looking for solution in range %lld .. %lld (%lld) \n",
              __func__, min_time, max_time, (max_time - min_time));
 
-    for (auto try_time = min_time; try_time < max_time; ++try_time)
-    {
-        //hash this iteration
-        hashProofOfStake = stakeHash(try_time, ss, prevout.n, prevout.hash, nTimeBlockFrom);
-
-        // if stake hash does not meet the target then continue to next iteration
-        if (UintToArith256(hashProofOfStake) >= bnTarget) {
-            continue;
-        }
-
-        nTimeTx = try_time;
-
-        if (fDebug || fPrintProofOfStake) {
-            LogPrintf("CheckStakeKernelHash() : using modifier %llx at height=%d timestamp=%s for block from height=%d timestamp=%s\n",
-                nStakeModifier,
-                blockFrom.nHeight,
-                DateTimeStrFormat("%Y-%m-%d %H:%M:%S", blockFrom.nTime).c_str(),
-                blockFrom.nHeight,
-                DateTimeStrFormat("%Y-%m-%d %H:%M:%S", blockFrom.GetBlockTime()).c_str());
-            LogPrintf("CheckStakeKernelHash() : pass protocol=%s modifier=%s nTimeBlockFrom=%u prevoutHash=%s nTimeTxPrev=%u nPrevout=%u nTimeTx=%u hashProof=%s\n",
-                "0.3",
-                boost::lexical_cast<std::string>(nStakeModifier).c_str(),
-                nTimeBlockFrom, prevout.hash.ToString().c_str(), nTimeBlockFrom, prevout.n, try_time,
-                hashProofOfStake.ToString().c_str());
-        }
-        return true;
+    unsigned int try_time;
+    if (!kernel.Search(min_time, max_time, try_time, hashProofOfStake)) {
+        return false;
     }
 
-    return false;
+    nTimeTx = try_time;
+
+    if (fDebug || fPrintProofOfStake) {
+        LogPrintf("CheckStakeKernelHash() : using modifier %llx at height=%d timestamp=%s for block from height=%d timestamp=%s\n",
+            nStakeModifier,
+            blockFrom.nHeight,
+            DateTimeStrFormat("%Y-%m-%d %H:%M:%S", blockFrom.nTime).c_str(),
+            blockFrom.nHeight,
+            DateTimeStrFormat("%Y-%m-%d %H:%M:%S", blockFrom.GetBlockTime()).c_str());
+        LogPrintf("CheckStakeKernelHash() : pass protocol=%s modifier=%s nTimeBlockFrom=%u prevoutHash=%s nTimeTxPrev=%u nPrevout=%u nTimeTx=%u hashProof=%s\n",
+            "0.3",
+            boost::lexical_cast<std::string>(nStakeModifier).c_str(),
+            nTimeBlockFrom, prevout.hash.ToString().c_str(), nTimeBlockFrom, prevout.n, try_time,
+            hashProofOfStake.ToString().c_str());
+    }
+    return true;
 }
 
 // Check kernel hash target and coinstake signature
@@ -6,21 +6,75 @@
 #ifndef BITCOIN_KERNEL_H
 #define BITCOIN_KERNEL_H
 
+#include "arith_uint256.h"
+#include "crypto/sha256.h"
 #include "streams.h"
 #include "validation.h"
 
+#include <vector>
+
 
 static constexpr CAmount MIN_STAKE_AMOUNT = COIN;
 static constexpr int64_t MAX_POS_BLOCK_AHEAD_TIME = 180;
 static constexpr int64_t MAX_POS_BLOCK_AHEAD_SAFETY_MARGIN = 5;
 
+// Maximum number of blocks to remember the kernel stake modifier for
+static const size_t MAX_STAKE_MODIFIER_CACHE_SIZE = 20000;
+
 // Compute the hash modifier for proof-of-stake
 bool ComputeNextStakeModifier(const CBlockIndex* pindexPrev, uint64_t& nStakeModifier);
 
+// Memoized ComputeNextStakeModifier, shared by the kernel search and the stake checks.
+// The modifier depends only on the headers up to pindexPrev, so an entry stays valid as long as the index exists.
+bool GetKernelStakeModifier(const CBlockIndex* pindexPrev, uint64_t& nStakeModifier);
+// Forget the modifier of a block, e.g. when it is disconnected
+void InvalidateStakeModifierCache(const CBlockIndex* pindex);
+// Forget all modifiers, must be called before the block index is freed
+void ClearStakeModifierCache();
+void GetStakeModifierCacheStats(size_t& nEntries, uint64_t& nHits, uint64_t& nMisses);
+
+// Minimum number of stake candidates given to each kernel search thread
+static const size_t MIN_STAKE_KERNELS_PER_THREAD = 512;
+
+/**
+ * Kernel hash input of a staked output. Everything but the transaction time is fixed
+ * during a search, so it is written into the hasher once and only the time is hashed per try.
+ */
+class CStakeKernel
+{
+private:
+    CSHA256 hasherPrefix;
+    arith_uint256 bnTarget;
+    uint64_t nStakeModifier;
+    unsigned int nMinTimeTx;
+
+public:
+    CStakeKernel() : nStakeModifier(0), nMinTimeTx(0) {}
+    CStakeKernel(uint64_t nStakeModifierIn, unsigned int nTimeBlockFrom, const COutPoint& prevout,
+                 const arith_uint256& bnTargetIn, unsigned int nMinTimeTxIn);
+
+    uint64_t GetStakeModifier() const { return nStakeModifier; }
+    const arith_uint256& GetTarget() const { return bnTarget; }
+    // Earliest transaction time meeting the stake age requirement
+    unsigned int GetMinTimeTx() const { return nMinTimeTx; }
+
+    uint256 GetHash(unsigned int nTimeTx) const;
+    // Find the first time in [nTimeFrom, nTimeTo) with a hash meeting the target
+    bool Search(unsigned int nTimeFrom, unsigned int nTimeTo, unsigned int& nTimeTxRet, uint256& hashProofOfStakeRet) const;
+};
+
+// Check the stake value and age at nTimeTx and prepare the kernel of the output
+bool PrepareStakeKernel(unsigned int nBits, const CBlockIndex &blockFrom, const CTransaction& txPrev, const COutPoint& prevout, unsigned int nTimeTx, bool fCheck, CStakeKernel& kernelRet);
+
+// Search the kernels from nStart on over the times [nTimeFrom, nTimeTo) using up to nThreads threads.
+// Returns the lowest kernel index with a solution, which is the one a sequential search would find.
+bool FindStakeKernel(const std::vector<CStakeKernel>& vKernels, size_t nStart, unsigned int nTimeFrom, unsigned int nTimeTo,
+                     int nThreads, size_t& nIndexRet, unsigned int& nTimeTxRet, uint256& hashProofOfStakeRet);
+
 // Check whether stake kernel meets hash target
 // Sets hashProofOfStake on success return
 uint256 stakeHash(unsigned int nTimeTx, CDataStream ss, unsigned int prevoutIndex, uint256 prevoutHash, unsigned int nTimeBlockFrom);
-bool CheckStakeKernelHash(unsigned int nBits, const CBlockIndex &blockFrom, const CTransaction txPrev, const COutPoint prevout, unsigned int& nTimeTx, unsigned int nHashDrift, bool fCheck, uint256& hashProofOfStake, uint64_t &nStakeModifier, bool fPrintProofOfStake = false);
+bool CheckStakeKernelHash(unsigned int nBits, const CBlockIndex &blockFrom, const CTransaction& txPrev, const COutPoint& prevout, unsigned int& nTimeTx, unsigned int nHashDrift, bool fCheck, uint256& hashProofOfStake, uint64_t &nStakeModifier, bool fPrintProofOfStake = false);
 
 // Check kernel hash target and coinstake signature
 // Sets hashProofOfStake on success return
@@ -12,24 +12,89 @@
 #include "tinyformat.h"
 #include "utilstrencodings.h"
 #include "crypto/common.h"
+#include "crypto/x11.h"
 #include "compat/endian.h"
 #include "keystore.h"
 #include "pos_kernel.h"
 #include "util.h"
 
 #include <algorithm>
+#include <map>
 
 
-uint256 CBlockHeader::GetPOWHash()
+CBlockHashCache::CBlockHashCache(const CBlockHashCache& other)
 {
-    if (IsProofOfStake()) {
-        return hashProofOfStake();
+    std::lock_guard<std::mutex> lock(other.cs);
+    vchHeader = other.vchHeader;
+    hash = other.hash;
+}
+
+CBlockHashCache::CBlockHashCache(CBlockHashCache&& other)
+{
+    std::lock_guard<std::mutex> lock(other.cs);
+    vchHeader = std::move(other.vchHeader);
+    hash = other.hash;
+}
+
+CBlockHashCache& CBlockHashCache::operator=(const CBlockHashCache& other)
+{
+    if (this == &other) {
+        return *this;
     }
-    //use X11
-    std::vector<unsigned char> vch(80);
-    CVectorWriter ss(SER_NETWORK, PROTOCOL_VERSION, vch, 0);
-    ss << *this;
-    return HashX11((const char *)vch.data(), (const char *)vch.data() + vch.size());
+
+    std::vector<unsigned char> vchHeaderOther;
+    uint256 hashOther;
+    {
+        std::lock_guard<std::mutex> lock(other.cs);
+        vchHeaderOther = other.vchHeader;
+        hashOther = other.hash;
+    }
+
+    std::lock_guard<std::mutex> lock(cs);
+    vchHeader.swap(vchHeaderOther);
+    hash = hashOther;
+    return *this;
+}
+
+bool CBlockHashCache::Get(const std::vector<unsigned char>& vchHeaderIn, uint256& hashOut) const
+{
+    std::lock_guard<std::mutex> lock(cs);
+    if (vchHeader.empty() || vchHeader != vchHeaderIn) {
+        return false;
+    }
+    hashOut = hash;
+    return true;
+}
+
+void CBlockHashCache::Set(std::vector<unsigned char>&& vchHeaderIn, const uint256& hashIn)
+{
+    std::lock_guard<std::mutex> lock(cs);
+    vchHeader = std::move(vchHeaderIn);
+    hash = hashIn;
+}
+
+static std::vector<unsigned char> SerializeHeader(const CBlockHeader& header, int nType)
+{
+    std::vector<unsigned char> vch;
+    vch.reserve(160);
+    CVectorWriter ss(nType, PROTOCOL_VERSION, vch, 0);
+    ss << header;
+    return vch;
+}
+
+uint256 CBlockHeader::GetX11Hash(int nType) const
+{
+    // serializing is cheap compared to the 11 rounds of X11, so it is used as the cache key
+    std::vector<unsigned char> vch = SerializeHeader(*this, nType);
+
+    uint256 hash;
+    if (hashCache.Get(vch, hash)) {
+        return hash;
+    }
+
+    hash = HashX11((const char *)vch.data(), (const char *)vch.data() + vch.size());
+    hashCache.Set(std::move(vch), hash);
+    return hash;
 }
 
 uint256 CBlockHeader::GetPOWHash() const
@@ -37,28 +102,50 @@ uint256 CBlockHeader::GetPOWHash() const
     if (IsProofOfStake()) {
         return hashProofOfStake();
     }
-    
-    std::vector<unsigned char> vch(80);
-    CVectorWriter ss(SER_NETWORK, PROTOCOL_VERSION, vch, 0);
-    ss << *this;
-    return HashX11((const char *)vch.data(), (const char *)vch.data() + vch.size());
+
+    //use X11
+    return GetX11Hash(SER_NETWORK);
 }
 
 uint256 CBlockHeader::GetHash() const
 {
-    if (IsProofOfStake()) {
-    // use Dash X11 
-    std::vector<unsigned char> vch(80);
-    CVectorWriter ss(SER_GETHASH, PROTOCOL_VERSION, vch, 0);
-    ss << *this;
-    return HashX11((const char *)vch.data(), (const char *)vch.data() + vch.size());
-    }
-
-    // use Dash X11 
-    std::vector<unsigned char> vch(80);
-    CVectorWriter ss(SER_NETWORK, PROTOCOL_VERSION, vch, 0);
-    ss << *this;
-    return HashX11((const char *)vch.data(), (const char *)vch.data() + vch.size());
+    // use Dash X11, the PoS block signature is not part of the hash
+    return GetX11Hash(IsProofOfStake() ? SER_GETHASH : SER_NETWORK);
+}
+
+void HashX11Batch(const CBlockHeader* headers, size_t n, uint256* out)
+{
+    // PoW and PoS headers serialize to different sizes, only equal sizes share a multi-lane pass
+    std::vector<std::vector<unsigned char>> vchHeaders(n);
+    std::map<size_t, std::vector<size_t>> mapPending;
+    for (size_t i = 0; i < n; i++) {
+        const CBlockHeader& header = headers[i];
+        vchHeaders[i] = SerializeHeader(header, header.IsProofOfStake() ? SER_GETHASH : SER_NETWORK);
+        if (!header.hashCache.Get(vchHeaders[i], out[i])) {
+            mapPending[vchHeaders[i].size()].push_back(i);
+        }
+    }
+
+    for (const auto& pending : mapPending) {
+        const std::vector<size_t>& vIndex = pending.second;
+        size_t pos = 0;
+        for (; pos + X11_LANES <= vIndex.size(); pos += X11_LANES) {
+            const unsigned char* in[X11_LANES];
+            unsigned char* hashes[X11_LANES];
+            for (size_t lane = 0; lane < X11_LANES; lane++) {
+                in[lane] = vchHeaders[vIndex[pos + lane]].data();
+                hashes[lane] = out[vIndex[pos + lane]].begin();
+            }
+            X11Hash4Way(in, pending.first, hashes);
+        }
+        for (; pos < vIndex.size(); pos++) {
+            const std::vector<unsigned char>& vch = vchHeaders[vIndex[pos]];
+            out[vIndex[pos]] = HashX11((const char *)vch.data(), (const char *)vch.data() + vch.size());
+        }
+        for (size_t i : vIndex) {
+            headers[i].hashCache.Set(std::move(vchHeaders[i]), out[i]);
+        }
+    }
 }
 
 std::string CBlock::ToString() const
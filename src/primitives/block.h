@@ -12,8 +12,33 @@
 #include "uint256.h"
 #include "pubkey.h"
 
+#include <mutex>
+
 class CKeyStore;
 
+/** Memory-only cache of the X11 hash of a block header.
+ *
+ * Header fields are public and get changed in place (e.g. by the miner nonce loop),
+ * so the hash is stored together with the serialized header it was computed from
+ * and only reused while the header still serializes to the same bytes.
+ */
+class CBlockHashCache
+{
+private:
+    mutable std::mutex cs;
+    std::vector<unsigned char> vchHeader;
+    uint256 hash;
+
+public:
+    CBlockHashCache() {}
+    CBlockHashCache(const CBlockHashCache& other);
+    CBlockHashCache(CBlockHashCache&& other);
+    CBlockHashCache& operator=(const CBlockHashCache& other);
+
+    bool Get(const std::vector<unsigned char>& vchHeaderIn, uint256& hashOut) const;
+    void Set(std::vector<unsigned char>&& vchHeaderIn, const uint256& hashIn);
+};
+
 /** Nodes collect new transactions into a block, hash them into a hash tree,
  * and scan through nonce values to make the block's hash satisfy proof-of-work
  * requirements.  When they solve the proof-of-work, they broadcast the block
@@ -45,6 +70,7 @@ public:
 
     // Memory-only
     mutable CPubKey posPubKey;
+    mutable CBlockHashCache hashCache;
 
     CBlockHeader()
     {
@@ -99,15 +125,13 @@ public:
         return (nBits == 0);
     }
 
-    /** GetPOWHash() returns the egihash used to satisfy the proof of work condition.
-    *       The first time this is computed, the hashMix is stored.
-    */
-    uint256 GetPOWHash();
-
-    /** GetPOWHash() returns the egihash used to satisfy the proof of work condition.
+    /** GetPOWHash() returns the hash used to satisfy the proof of work condition.
+    *       For PoW blocks this is the same X11 hash as GetHash() and shares its cache.
     */
     uint256 GetPOWHash() const;
 
+    /** GetHash() returns the X11 block hash, it is computed once per distinct header.
+    */
     uint256 GetHash() const;
 
     uint256 GetHashMix() const
@@ -149,8 +173,18 @@ public:
     COutPoint StakeInput() const {
         return COutPoint(posStakeHash, posStakeN);
     }
+
+private:
+    uint256 GetX11Hash(int nType) const;
 };
 
+/** Compute GetHash() of n headers, hashing headers of equal size X11_LANES at a time.
+ *
+ * Results are stored in out[0..n-1] and in the hash cache of each header, so later
+ * GetHash() / GetPOWHash() calls on the same headers are free.
+ */
+void HashX11Batch(const CBlockHeader* headers, size_t n, uint256* out);
+
 class CBlock : public CBlockHeader
 {
 public:
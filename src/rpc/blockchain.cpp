@@ -1693,22 +1693,22 @@ static const CRPCCommand commands[] =
 { //  category              name                      actor (function)         okSafe argNames
   //  --------------------- ------------------------  -----------------------  ------ ----------
     { "blockchain",         "getblockchaininfo",      &getblockchaininfo,      true,  {} },
-    { "blockchain",         "getbestblockhash",       &getbestblockhash,       true,  {} },
-    { "blockchain",         "getblockcount",          &getblockcount,          true,  {} },
-    { "blockchain",         "getblock",               &getblock,               true,  {"blockhash","verbose"} },
-    { "blockchain",         "getblockhashes",         &getblockhashes,         true,  {"high","low"} },
-    { "blockchain",         "getblockhash",           &getblockhash,           true,  {"height"} },
-    { "blockchain",         "getblockheader",         &getblockheader,         true,  {"blockhash","verbose"} },
+    { "blockchain",         "getbestblockhash",       &getbestblockhash,       true,  {}, true },
+    { "blockchain",         "getblockcount",          &getblockcount,          true,  {}, true },
+    { "blockchain",         "getblock",               &getblock,               true,  {"blockhash","verbose"}, true },
+    { "blockchain",         "getblockhashes",         &getblockhashes,         true,  {"high","low"}, true },
+    { "blockchain",         "getblockhash",           &getblockhash,           true,  {"height"}, true },
+    { "blockchain",         "getblockheader",         &getblockheader,         true,  {"blockhash","verbose"}, true },
     { "blockchain",         "getblockheadersize",      &getblockheadersize,    true,  {"blockhash"} },
-    { "blockchain",         "getblockheaders",        &getblockheaders,        true,  {"blockhash","count","verbose"} },
-    { "blockchain",         "getchaintips",           &getchaintips,           true,  {"count","branchlen"} },
-    { "blockchain",         "getdifficulty",          &getdifficulty,          true,  {} },
-    { "blockchain",         "getmempoolancestors",    &getmempoolancestors,    true,  {"txid","verbose"} },
-    { "blockchain",         "getmempooldescendants",  &getmempooldescendants,  true,  {"txid","verbose"} },
-    { "blockchain",         "getmempoolentry",        &getmempoolentry,        true,  {"txid"} },
+    { "blockchain",         "getblockheaders",        &getblockheaders,        true,  {"blockhash","count","verbose"}, true },
+    { "blockchain",         "getchaintips",           &getchaintips,           true,  {"count","branchlen"}, true },
+    { "blockchain",         "getdifficulty",          &getdifficulty,          true,  {}, true },
+    { "blockchain",         "getmempoolancestors",    &getmempoolancestors,    true,  {"txid","verbose"}, true },
+    { "blockchain",         "getmempooldescendants",  &getmempooldescendants,  true,  {"txid","verbose"}, true },
+    { "blockchain",         "getmempoolentry",        &getmempoolentry,        true,  {"txid"}, true },
     { "blockchain",         "getmempoolinfo",         &getmempoolinfo,         true,  {} },
-    { "blockchain",         "getrawmempool",          &getrawmempool,          true,  {"verbose"} },
-    { "blockchain",         "gettxout",               &gettxout,               true,  {"txid","n","include_mempool"} },
+    { "blockchain",         "getrawmempool",          &getrawmempool,          true,  {"verbose"}, true },
+    { "blockchain",         "gettxout",               &gettxout,               true,  {"txid","n","include_mempool"}, true },
     { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        true,  {} },
     { "blockchain",         "pruneblockchain",        &pruneblockchain,        true,  {"height"} },
     { "blockchain",         "verifychain",            &verifychain,            true,  {"checklevel","nblocks"} },
@@ -655,51 +655,48 @@ UniValue gobject(const JSONRPCRequest& request)
 
         // GET MATCHING GOVERNANCE OBJECTS
 
-        LOCK2(cs_main, governance.cs);
-
-        std::vector<const CGovernanceObject*> objs = governance.GetAllNewerThan(nStartTime);
+        // copied under governance.cs, the results are built without holding it
+        std::vector<governance_object_summary_t> vSummaries = governance.GetSummariesNewerThan(nStartTime);
         governance.UpdateLastDiffTime(GetTime());
 
         // CREATE RESULTS FOR USER
 
-        for (const auto& pGovObj : objs)
+        for (const auto& summary : vSummaries)
         {
-            if(strCachedSignal == "valid" && !pGovObj->IsSetCachedValid()) continue;
-            if(strCachedSignal == "funding" && !pGovObj->IsSetCachedFunding()) continue;
-            if(strCachedSignal == "delete" && !pGovObj->IsSetCachedDelete()) continue;
-            if(strCachedSignal == "endorsed" && !pGovObj->IsSetCachedEndorsed()) continue;
+            if(strCachedSignal == "valid" && !summary.fCachedValid) continue;
+            if(strCachedSignal == "funding" && !summary.fCachedFunding) continue;
+            if(strCachedSignal == "delete" && !summary.fCachedDelete) continue;
+            if(strCachedSignal == "endorsed" && !summary.fCachedEndorsed) continue;
 
-            if(strType == "proposals" && pGovObj->GetObjectType() != GOVERNANCE_OBJECT_PROPOSAL) continue;
-            if(strType == "triggers" && pGovObj->GetObjectType() != GOVERNANCE_OBJECT_TRIGGER) continue;
+            if(strType == "proposals" && summary.nObjectType != GOVERNANCE_OBJECT_PROPOSAL) continue;
+            if(strType == "triggers" && summary.nObjectType != GOVERNANCE_OBJECT_TRIGGER) continue;
 
             UniValue bObj(UniValue::VOBJ);
-            bObj.push_back(Pair("DataHex",  pGovObj->GetDataAsHexString()));
-            bObj.push_back(Pair("DataString",  pGovObj->GetDataAsPlainString()));
-            bObj.push_back(Pair("Hash",  pGovObj->GetHash().ToString()));
-            bObj.push_back(Pair("CollateralHash",  pGovObj->GetCollateralHash().ToString()));
-            bObj.push_back(Pair("ObjectType", pGovObj->GetObjectType()));
-            bObj.push_back(Pair("CreationTime", pGovObj->GetCreationTime()));
-            const COutPoint& masternodeOutpoint = pGovObj->GetMasternodeOutpoint();
-            if(masternodeOutpoint != COutPoint()) {
-                bObj.push_back(Pair("SigningMasternode", masternodeOutpoint.ToStringShort()));
+            bObj.push_back(Pair("DataHex",  summary.strDataHex));
+            bObj.push_back(Pair("DataString",  summary.strDataString));
+            bObj.push_back(Pair("Hash",  summary.nHash.ToString()));
+            bObj.push_back(Pair("CollateralHash",  summary.nCollateralHash.ToString()));
+            bObj.push_back(Pair("ObjectType", summary.nObjectType));
+            bObj.push_back(Pair("CreationTime", summary.nCreationTime));
+            if(summary.masternodeOutpoint != COutPoint()) {
+                bObj.push_back(Pair("SigningMasternode", summary.masternodeOutpoint.ToStringShort()));
             }
 
             // REPORT STATUS FOR FUNDING VOTES SPECIFICALLY
-            bObj.push_back(Pair("AbsoluteYesCount",  pGovObj->GetAbsoluteYesCount(VOTE_SIGNAL_FUNDING)));
-            bObj.push_back(Pair("YesCount",  pGovObj->GetYesCount(VOTE_SIGNAL_FUNDING)));
-            bObj.push_back(Pair("NoCount",  pGovObj->GetNoCount(VOTE_SIGNAL_FUNDING)));
-            bObj.push_back(Pair("AbstainCount",  pGovObj->GetAbstainCount(VOTE_SIGNAL_FUNDING)));
+            bObj.push_back(Pair("AbsoluteYesCount",  summary.nFundingYesCount - summary.nFundingNoCount));
+            bObj.push_back(Pair("YesCount",  summary.nFundingYesCount));
+            bObj.push_back(Pair("NoCount",  summary.nFundingNoCount));
+            bObj.push_back(Pair("AbstainCount",  summary.nFundingAbstainCount));
 
             // REPORT VALIDITY AND CACHING FLAGS FOR VARIOUS SETTINGS
-            std::string strError = "";
-            bObj.push_back(Pair("fBlockchainValidity",  pGovObj->IsValidLocally(strError, false)));
-            bObj.push_back(Pair("IsValidReason",  strError.c_str()));
-            bObj.push_back(Pair("fCachedValid",  pGovObj->IsSetCachedValid()));
-            bObj.push_back(Pair("fCachedFunding",  pGovObj->IsSetCachedFunding()));
-            bObj.push_back(Pair("fCachedDelete",  pGovObj->IsSetCachedDelete()));
-            bObj.push_back(Pair("fCachedEndorsed",  pGovObj->IsSetCachedEndorsed()));
-
-            objResult.push_back(Pair(pGovObj->GetHash().ToString(), bObj));
+            bObj.push_back(Pair("fBlockchainValidity",  summary.fLocalValidity));
+            bObj.push_back(Pair("IsValidReason",  summary.strLocalValidityError));
+            bObj.push_back(Pair("fCachedValid",  summary.fCachedValid));
+            bObj.push_back(Pair("fCachedFunding",  summary.fCachedFunding));
+            bObj.push_back(Pair("fCachedDelete",  summary.fCachedDelete));
+            bObj.push_back(Pair("fCachedEndorsed",  summary.fCachedEndorsed));
+
+            objResult.push_back(Pair(summary.nHash.ToString(), bObj));
         }
 
         return objResult;
@@ -795,11 +792,7 @@ UniValue gobject(const JSONRPCRequest& request)
 
         // FIND OBJECT USER IS LOOKING FOR
 
-        LOCK(governance.cs);
-
-        CGovernanceObject* pGovObj = governance.FindGovernanceObject(hash);
-
-        if(pGovObj == NULL) {
+        if(governance.FindGovernanceObject(hash) == NULL) {
             throw JSONRPCError(RPC_INVALID_PARAMETER, "Unknown governance-hash");
         }
 
@@ -838,11 +831,7 @@ UniValue gobject(const JSONRPCRequest& request)
 
         // FIND OBJECT USER IS LOOKING FOR
 
-        LOCK(governance.cs);
-
-        CGovernanceObject* pGovObj = governance.FindGovernanceObject(hash);
-
-        if(pGovObj == NULL) {
+        if(governance.FindGovernanceObject(hash) == NULL) {
             throw JSONRPCError(RPC_INVALID_PARAMETER, "Unknown governance-hash");
         }
 
@@ -211,6 +211,15 @@ UniValue masternode(const JSONRPCRequest& request)
             obj.push_back(Pair("enabled", enabled));
             obj.push_back(Pair("qualify", nCount));
 
+            int nCacheEntries;
+            uint64_t nCacheHits, nCacheMisses;
+            mnodeman.GetScoreCacheStats(nCacheEntries, nCacheHits, nCacheMisses);
+            UniValue objCache(UniValue::VOBJ);
+            objCache.push_back(Pair("entries", nCacheEntries));
+            objCache.push_back(Pair("hits", nCacheHits));
+            objCache.push_back(Pair("misses", nCacheMisses));
+            obj.push_back(Pair("score_cache", objCache));
+
             return obj;
         }
 
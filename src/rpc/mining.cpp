@@ -17,6 +17,7 @@
 #include "validation.h"
 #include "miner.h"
 #include "net.h"
+#include "pos_kernel.h"
 #include "pow.h"
 #include "rpc/server.h"
 #include "spork.h"
@@ -1032,6 +1033,14 @@ UniValue getstakingstatus(const JSONRPCRequest& request)
             "  \"enoughcoins\": true|false,        (boolean) if available coins are greater than reserve balance\n"
             "  \"mnsync\": true|false,             (boolean) if masternode data is synced\n"
             "  \"staking\": true|false,            (boolean) if the wallet is staking or not\n"
+            "  \"templatebuildtime\": n,           (numeric) milliseconds the last block template took to select transactions\n"
+            "  \"templatereuses\": n,              (numeric) templates reusing the previous transaction selection as is\n"
+            "  \"templateupdates\": n,             (numeric) templates adding new mempool transactions to the previous selection\n"
+            "  \"stakemodifiercache\": {            (object) kernel stake modifier cache\n"
+            "    \"entries\": n,                   (numeric) number of cached blocks\n"
+            "    \"hits\": n,                      (numeric) lookups answered from the cache\n"
+            "    \"misses\": n                     (numeric) lookups which computed the modifier\n"
+            "  }\n"
             "}\n"
 
             "\nExamples:\n" +
@@ -1054,6 +1063,18 @@ UniValue getstakingstatus(const JSONRPCRequest& request)
     }
     obj.push_back(Pair("mnsync", masternodeSync.IsSynced()));
     obj.push_back(Pair("staking", IsStakingActive()));
+    obj.push_back(Pair("templatebuildtime", nLastBlockTemplateTime * 0.001));
+    obj.push_back(Pair("templatereuses", (int64_t)nBlockTemplatesReused));
+    obj.push_back(Pair("templateupdates", (int64_t)nBlockTemplatesExtended));
+
+    size_t nEntries;
+    uint64_t nHits, nMisses;
+    GetStakeModifierCacheStats(nEntries, nHits, nMisses);
+    UniValue cacheObj(UniValue::VOBJ);
+    cacheObj.push_back(Pair("entries", (int64_t)nEntries));
+    cacheObj.push_back(Pair("hits", (int64_t)nHits));
+    cacheObj.push_back(Pair("misses", (int64_t)nMisses));
+    obj.push_back(Pair("stakemodifiercache", cacheObj));
 
     return obj;
 }
@@ -22,7 +22,9 @@
 #include "wallet/walletdb.h"
 #endif
 
+#include "instantx.h"
 #include "masternode-sync.h"
+#include "masternodeman.h"
 #include "spork.h"
 
 #include <stdint.h>
@@ -802,6 +804,75 @@ bool timestampSort(std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> a,
     return a.second.time < b.second.time;
 }
 
+/** Serialize the position after which the next page of an address index RPC continues. */
+template<typename Key>
+std::string getAddressContinuation(size_t nAddress, const Key& key)
+{
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << (uint32_t)nAddress << key;
+    return HexStr(ss.begin(), ss.end());
+}
+
+/**
+ * Read the optional "limit" and "continuation" fields of an address index RPC.
+ * Returns false if the caller did not ask for paging. Otherwise nAddressRet is the position in
+ * addresses to continue at and keyAfterRet, if fHaveKeyRet, the last index key returned before.
+ */
+template<typename Key>
+bool getAddressPagingFromParams(const UniValue& params, const std::vector<std::pair<uint160, int> > &addresses,
+                                size_t& nLimitRet, size_t& nAddressRet, Key& keyAfterRet, bool& fHaveKeyRet)
+{
+    nLimitRet = 0;
+    nAddressRet = 0;
+    fHaveKeyRet = false;
+
+    if (!params[0].isObject()) {
+        return false;
+    }
+
+    UniValue limitValue = find_value(params[0].get_obj(), "limit");
+    UniValue continuationValue = find_value(params[0].get_obj(), "continuation");
+
+    if (limitValue.isNull()) {
+        if (!continuationValue.isNull()) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Continuation requires a limit");
+        }
+        return false;
+    }
+
+    int nLimit = limitValue.get_int();
+    if (nLimit <= 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Limit is expected to be greater than zero");
+    }
+    nLimitRet = nLimit;
+
+    if (continuationValue.isNull()) {
+        return true;
+    }
+
+    std::string strContinuation = continuationValue.get_str();
+    if (!IsHex(strContinuation)) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid continuation");
+    }
+    std::vector<unsigned char> data(ParseHex(strContinuation));
+    CDataStream ss(data, SER_DISK, CLIENT_VERSION);
+    uint32_t nAddress;
+    try {
+        ss >> nAddress >> keyAfterRet;
+    } catch (const std::exception&) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid continuation");
+    }
+    // the token is only valid for the address list it was created for
+    if (!ss.empty() || nAddress >= addresses.size() ||
+        keyAfterRet.hashBytes != addresses[nAddress].first || (int)keyAfterRet.type != addresses[nAddress].second) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid continuation");
+    }
+    nAddressRet = nAddress;
+    fHaveKeyRet = true;
+
+    return true;
+}
+
 UniValue getaddressmempool(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 1)
@@ -879,6 +950,8 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
         throw std::runtime_error(
             "getaddressutxos\n"
             "\nReturns all unspent outputs for an address (requires addressindex to be enabled).\n"
+            "When a limit is given the outputs are returned in pages, per address and in index order\n"
+            "instead of by height.\n"
             "\nArguments:\n"
             "{\n"
             "  \"addresses\"\n"
@@ -886,6 +959,8 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
             "      \"address\"  (string) The base58check encoded address\n"
             "      ,...\n"
             "    ]\n"
+            "  \"limit\" (number, optional) Return at most this many entries and a continuation token\n"
+            "  \"continuation\" (string, optional) The continuation token of the previous page\n"
             "}\n"
             "\nResult:\n"
             "[\n"
@@ -898,8 +973,14 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
             "    \"height\"  (number) The block height\n"
             "  }\n"
             "]\n"
+            "\nResult (with limit):\n"
+            "{\n"
+            "  \"utxos\"  (array) The unspent outputs of this page as above\n"
+            "  \"continuation\"  (string) The token for the next page, only present if the page is full\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddressutxos", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
+            + HelpExampleCli("getaddressutxos", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"], \"limit\": 1000}'")
             + HelpExampleRpc("getaddressutxos", "{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}")
         );
 
@@ -909,15 +990,34 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    size_t nLimit, nAddress;
+    CAddressUnspentKey keyAfter;
+    bool fHaveKey;
+    bool fPaged = getAddressPagingFromParams(request.params, addresses, nLimit, nAddress, keyAfter, fHaveKey);
+
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspentOutputs;
+    std::string strContinuation;
 
-    for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (!GetAddressUnspent((*it).first, (*it).second, unspentOutputs)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+    if (fPaged) {
+        for (; nAddress < addresses.size(); nAddress++, fHaveKey = false) {
+            if (!GetAddressUnspent(addresses[nAddress].first, addresses[nAddress].second, unspentOutputs,
+                                   fHaveKey ? &keyAfter : NULL, nLimit - unspentOutputs.size())) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            }
+            if (unspentOutputs.size() == nLimit) {
+                strContinuation = getAddressContinuation(nAddress, unspentOutputs.back().first);
+                break;
+            }
+        }
+    } else {
+        for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
+            if (!GetAddressUnspent((*it).first, (*it).second, unspentOutputs)) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            }
         }
-    }
 
-    std::sort(unspentOutputs.begin(), unspentOutputs.end(), heightSort);
+        std::sort(unspentOutputs.begin(), unspentOutputs.end(), heightSort);
+    }
 
     UniValue result(UniValue::VARR);
 
@@ -937,6 +1037,15 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
         result.push_back(output);
     }
 
+    if (fPaged) {
+        UniValue page(UniValue::VOBJ);
+        page.push_back(Pair("utxos", result));
+        if (!strContinuation.empty()) {
+            page.push_back(Pair("continuation", strContinuation));
+        }
+        return page;
+    }
+
     return result;
 }
 
@@ -955,6 +1064,8 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
             "    ]\n"
             "  \"start\" (number) The start block height\n"
             "  \"end\" (number) The end block height\n"
+            "  \"limit\" (number, optional) Return at most this many entries and a continuation token\n"
+            "  \"continuation\" (string, optional) The continuation token of the previous page\n"
             "}\n"
             "\nResult:\n"
             "[\n"
@@ -967,8 +1078,14 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
             "    \"address\"  (string) The base58check encoded address\n"
             "  }\n"
             "]\n"
+            "\nResult (with limit):\n"
+            "{\n"
+            "  \"deltas\"  (array) The deltas of this page as above\n"
+            "  \"continuation\"  (string) The token for the next page, only present if the page is full\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddressdeltas", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
+            + HelpExampleCli("getaddressdeltas", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"], \"limit\": 1000}'")
             + HelpExampleRpc("getaddressdeltas", "{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}")
         );
 
@@ -993,16 +1110,35 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    size_t nLimit, nAddress;
+    CAddressIndexKey keyAfter;
+    bool fHaveKey;
+    bool fPaged = getAddressPagingFromParams(request.params, addresses, nLimit, nAddress, keyAfter, fHaveKey);
+
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    std::string strContinuation;
 
-    for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (start > 0 && end > 0) {
-            if (!GetAddressIndex((*it).first, (*it).second, addressIndex, start, end)) {
+    if (fPaged) {
+        for (; nAddress < addresses.size(); nAddress++, fHaveKey = false) {
+            if (!GetAddressIndex(addresses[nAddress].first, addresses[nAddress].second, addressIndex, start, end,
+                                 fHaveKey ? &keyAfter : NULL, nLimit - addressIndex.size())) {
                 throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
             }
-        } else {
-            if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            if (addressIndex.size() == nLimit) {
+                strContinuation = getAddressContinuation(nAddress, addressIndex.back().first);
+                break;
+            }
+        }
+    } else {
+        for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
+            if (start > 0 && end > 0) {
+                if (!GetAddressIndex((*it).first, (*it).second, addressIndex, start, end)) {
+                    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+                }
+            } else {
+                if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
+                    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+                }
             }
         }
     }
@@ -1025,6 +1161,15 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
         result.push_back(delta);
     }
 
+    if (fPaged) {
+        UniValue page(UniValue::VOBJ);
+        page.push_back(Pair("deltas", result));
+        if (!strContinuation.empty()) {
+            page.push_back(Pair("continuation", strContinuation));
+        }
+        return page;
+    }
+
     return result;
 }
 
@@ -1090,6 +1235,8 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
         throw std::runtime_error(
             "getaddresstxids\n"
             "\nReturns the txids for an address(es) (requires addressindex to be enabled).\n"
+            "When a limit is given the txids are returned in pages, by height per address, and a\n"
+            "transaction involving several of the addresses is listed once for each of them.\n"
             "\nArguments:\n"
             "{\n"
             "  \"addresses\"\n"
@@ -1099,14 +1246,22 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
             "    ]\n"
             "  \"start\" (number) The start block height\n"
             "  \"end\" (number) The end block height\n"
+            "  \"limit\" (number, optional) Return at most this many entries and a continuation token\n"
+            "  \"continuation\" (string, optional) The continuation token of the previous page\n"
             "}\n"
             "\nResult:\n"
             "[\n"
             "  \"transactionid\"  (string) The transaction id\n"
             "  ,...\n"
             "]\n"
+            "\nResult (with limit):\n"
+            "{\n"
+            "  \"txids\"  (array) The txids of this page as above\n"
+            "  \"continuation\"  (string) The token for the next page, only present if the page is full\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddresstxids", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
+            + HelpExampleCli("getaddresstxids", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"], \"limit\": 1000}'")
             + HelpExampleRpc("getaddresstxids", "{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}")
         );
 
@@ -1127,6 +1282,54 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
         }
     }
 
+    size_t nLimit, nAddress;
+    CAddressIndexKey keyAfter;
+    bool fHaveKey;
+    if (getAddressPagingFromParams(request.params, addresses, nLimit, nAddress, keyAfter, fHaveKey)) {
+        UniValue result(UniValue::VARR);
+        std::string strContinuation;
+        std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+
+        // read every address in chunks of at most nLimit entries, the entries of a transaction are adjacent
+        for (; nAddress < addresses.size() && strContinuation.empty(); nAddress++, fHaveKey = false) {
+            uint256 lastTxHash;
+            if (fHaveKey) {
+                // the previous page ended with this transaction
+                lastTxHash = keyAfter.txhash;
+            }
+            while (strContinuation.empty()) {
+                addressIndex.clear();
+                if (!GetAddressIndex(addresses[nAddress].first, addresses[nAddress].second, addressIndex, start, end,
+                                     fHaveKey ? &keyAfter : NULL, nLimit)) {
+                    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+                }
+                for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
+                    if (it->first.txhash == lastTxHash) {
+                        continue;
+                    }
+                    lastTxHash = it->first.txhash;
+                    result.push_back(lastTxHash.GetHex());
+                    if (result.size() == nLimit) {
+                        strContinuation = getAddressContinuation(nAddress, it->first);
+                        break;
+                    }
+                }
+                if (addressIndex.size() < nLimit) {
+                    break;
+                }
+                keyAfter = addressIndex.back().first;
+                fHaveKey = true;
+            }
+        }
+
+        UniValue page(UniValue::VOBJ);
+        page.push_back(Pair("txids", result));
+        if (!strContinuation.empty()) {
+            page.push_back(Pair("continuation", strContinuation));
+        }
+        return page;
+    }
+
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
 
     for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
@@ -1227,6 +1430,31 @@ static UniValue RPCLockedMemoryInfo()
     return obj;
 }
 
+static UniValue RPCMasternodeScoreCacheInfo()
+{
+    int nEntries;
+    uint64_t nHits, nMisses;
+    mnodeman.GetScoreCacheStats(nEntries, nHits, nMisses);
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("entries", nEntries));
+    obj.push_back(Pair("hits", nHits));
+    obj.push_back(Pair("misses", nMisses));
+    return obj;
+}
+
+static UniValue RPCInstantSendMemoryInfo()
+{
+    size_t nCandidates, nVotes, nOrphanVotes, nScheduled, nUsage;
+    instantsend.GetMemoryStats(nCandidates, nVotes, nOrphanVotes, nScheduled, nUsage);
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("candidates", (uint64_t)nCandidates));
+    obj.push_back(Pair("votes", (uint64_t)nVotes));
+    obj.push_back(Pair("orphan_votes", (uint64_t)nOrphanVotes));
+    obj.push_back(Pair("scheduled_expiries", (uint64_t)nScheduled));
+    obj.push_back(Pair("usage", (uint64_t)nUsage));
+    return obj;
+}
+
 UniValue getmemoryinfo(const JSONRPCRequest& request)
 {
     /* Please, avoid using the word "pool" here in the RPC interface or help,
@@ -1245,6 +1473,18 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
             "    \"locked\": xxxxxx,       (numeric) Amount of bytes that succeeded locking. If this number is smaller than total, locking pages failed at some point and key data could be swapped to disk.\n"
             "    \"chunks_used\": xxxxx,   (numeric) Number allocated chunks\n"
             "    \"chunks_free\": xxxxx,   (numeric) Number unused chunks\n"
+            "  },\n"
+            "  \"masternode_scores\": {    (json object) Information about the masternode score cache\n"
+            "    \"entries\": xxxxx,       (numeric) Number of block hashes with cached scores\n"
+            "    \"hits\": xxxxx,          (numeric) Number of lookups served from the cache\n"
+            "    \"misses\": xxxxx,        (numeric) Number of lookups which had to calculate the scores\n"
+            "  },\n"
+            "  \"instantsend\": {          (json object) Information about the InstantSend lock and vote store\n"
+            "    \"candidates\": xxxxx,    (numeric) Number of transaction lock candidates\n"
+            "    \"votes\": xxxxx,         (numeric) Number of lock votes\n"
+            "    \"orphan_votes\": xxxxx,  (numeric) Number of lock votes waiting for their lock request\n"
+            "    \"scheduled_expiries\": xxxxx, (numeric) Number of pending expiry checks\n"
+            "    \"usage\": xxxxx,         (numeric) Estimated memory usage in bytes\n"
             "  }\n"
             "}\n"
             "\nExamples:\n"
@@ -1253,6 +1493,8 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
         );
     UniValue obj(UniValue::VOBJ);
     obj.push_back(Pair("locked", RPCLockedMemoryInfo()));
+    obj.push_back(Pair("masternode_scores", RPCMasternodeScoreCacheInfo()));
+    obj.push_back(Pair("instantsend", RPCInstantSendMemoryInfo()));
     return obj;
 }
 
@@ -1301,14 +1543,14 @@ static const CRPCCommand commands[] =
     { "util",               "verifymessage",          &verifymessage,          true,  {"address","signature","message"} },
     { "util",               "signmessagewithprivkey", &signmessagewithprivkey, true,  {"privkey","message"} },
     { "util",               "genkeypair",             &genkeypair,             true,  {} },
-    { "blockchain",         "getspentinfo",           &getspentinfo,           false, {"json"} },
+    { "blockchain",         "getspentinfo",           &getspentinfo,           false, {"json"}, true },
 
     /* Address index */
-    { "addressindex",       "getaddressmempool",      &getaddressmempool,      true,  {"addresses"}  },
-    { "addressindex",       "getaddressutxos",        &getaddressutxos,        false, {"addresses"} },
-    { "addressindex",       "getaddressdeltas",       &getaddressdeltas,       false, {"addresses"} },
-    { "addressindex",       "getaddresstxids",        &getaddresstxids,        false, {"addresses"} },
-    { "addressindex",       "getaddressbalance",      &getaddressbalance,      false, {"addresses"} },
+    { "addressindex",       "getaddressmempool",      &getaddressmempool,      true,  {"addresses"}, true },
+    { "addressindex",       "getaddressutxos",        &getaddressutxos,        false, {"addresses"}, true },
+    { "addressindex",       "getaddressdeltas",       &getaddressdeltas,       false, {"addresses"}, true },
+    { "addressindex",       "getaddresstxids",        &getaddresstxids,        false, {"addresses"}, true },
+    { "addressindex",       "getaddressbalance",      &getaddressbalance,      false, {"addresses"}, true },
 
     /* QuantisNet features */
     { "quantisnet",             "mnsync",                 &mnsync,                 true,  {} },
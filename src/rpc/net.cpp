@@ -137,6 +137,15 @@ UniValue getpeerinfo(const JSONRPCRequest& request)
             "    \"bytesrecv_per_msg\": {\n"
             "       \"addr\": n,              (numeric) The total bytes received aggregated by message type\n"
             "       ...\n"
+            "    },\n"
+            "    \"timing_per_msg\": {\n"
+            "       \"addr\": {\n"
+            "          \"count\": n,          (numeric) The number of messages processed\n"
+            "          \"wait\": n,           (numeric) The total time in microseconds messages waited from receipt to processing\n"
+            "          \"maxwait\": n,        (numeric) The longest such wait in microseconds\n"
+            "          \"process\": n         (numeric) The total time in microseconds spent processing\n"
+            "       },\n"
+            "       ...\n"
             "    }\n"
             "  }\n"
             "  ,...\n"
@@ -210,6 +219,19 @@ UniValue getpeerinfo(const JSONRPCRequest& request)
         }
         obj.push_back(Pair("bytesrecv_per_msg", recvPerMsgCmd));
 
+        UniValue timingPerMsgCmd(UniValue::VOBJ);
+        BOOST_FOREACH(const mapMsgCmdTiming::value_type &i, stats.mapTimingPerMsgCmd) {
+            if (i.second.nCount > 0) {
+                UniValue timing(UniValue::VOBJ);
+                timing.push_back(Pair("count", i.second.nCount));
+                timing.push_back(Pair("wait", i.second.nWaitTime));
+                timing.push_back(Pair("maxwait", i.second.nMaxWaitTime));
+                timing.push_back(Pair("process", i.second.nProcessTime));
+                timingPerMsgCmd.push_back(Pair(i.first, timing));
+            }
+        }
+        obj.push_back(Pair("timing_per_msg", timingPerMsgCmd));
+
         ret.push_back(obj);
     }
 
@@ -397,6 +419,40 @@ UniValue getnettotals(const JSONRPCRequest& request)
     return obj;
 }
 
+UniValue getmessagestats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 0)
+        throw std::runtime_error(
+            "getmessagestats\n"
+            "\nReturns how many messages of each command were processed and how long that took, over all peers.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"command\": {        (object) Only commands received at least once\n"
+            "    \"count\": n,       (numeric) The number of messages processed\n"
+            "    \"time\": n,        (numeric) The total processing time in microseconds\n"
+            "    \"avgtime\": n      (numeric) The average processing time in microseconds\n"
+            "  },\n"
+            "  ...\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getmessagestats", "")
+            + HelpExampleRpc("getmessagestats", "")
+       );
+
+    UniValue obj(UniValue::VOBJ);
+    for (const auto& entry : GetNetMessageDispatcher().GetStats()) {
+        const CNetMessageDispatcher::CCommandStats& stats = entry.second;
+        if (stats.nCount == 0)
+            continue;
+        UniValue cmd(UniValue::VOBJ);
+        cmd.push_back(Pair("count", stats.nCount));
+        cmd.push_back(Pair("time", stats.nTime));
+        cmd.push_back(Pair("avgtime", stats.nTime / (int64_t)stats.nCount));
+        obj.push_back(Pair(entry.first, cmd));
+    }
+    return obj;
+}
+
 static UniValue GetNetworksInfo()
 {
     UniValue networks(UniValue::VARR);
@@ -640,6 +696,7 @@ static const CRPCCommand commands[] =
     { "network",            "disconnectnode",         &disconnectnode,         true,  {"address"} },
     { "network",            "getaddednodeinfo",       &getaddednodeinfo,       true,  {"node"} },
     { "network",            "getnettotals",           &getnettotals,           true,  {} },
+    { "network",            "getmessagestats",        &getmessagestats,        true,  {} },
     { "network",            "getnetworkinfo",         &getnetworkinfo,         true,  {} },
     { "network",            "setban",                 &setban,                 true,  {"subnet", "command", "bantime", "absolute"} },
     { "network",            "listbanned",             &listbanned,             true,  {} },
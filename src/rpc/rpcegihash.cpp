@@ -10,6 +10,12 @@
 
 using namespace egihash;
 
+static int GetCurrentEpoch()
+{
+    LOCK(cs_main);
+    return static_cast<int>(chainActive.Height() / constants::EPOCH_LENGTH);
+}
+
 UniValue getepoch(const JSONRPCRequest& request)
 {
     auto& params = request.params;
@@ -18,7 +24,7 @@ UniValue getepoch(const JSONRPCRequest& request)
         throw std::runtime_error("getepoch\n"
                                  "\nReturns current epoch number");
     }
-    return static_cast<int>(chainActive.Height() / constants::EPOCH_LENGTH);
+    return GetCurrentEpoch();
 }
 
 UniValue getseedhash(const JSONRPCRequest& request)
@@ -33,7 +39,7 @@ UniValue getseedhash(const JSONRPCRequest& request)
     }
     int epoch = 0;
     if (params[0].isNull()) {
-        epoch = static_cast<int>(chainActive.Height() / constants::EPOCH_LENGTH);
+        epoch = GetCurrentEpoch();
     } else {
         try {
             epoch = std::stoi(params[0].get_str());
@@ -56,7 +62,7 @@ UniValue getdagsize(const JSONRPCRequest& request)
     }
     int epoch = 0;
     if (params[0].isNull()) {
-        epoch = static_cast<int>(chainActive.Height() / constants::EPOCH_LENGTH);
+        epoch = GetCurrentEpoch();
     } else {
         try {
             epoch = std::stoi(params[0].get_str());
@@ -79,7 +85,7 @@ UniValue getdagcachesize(const JSONRPCRequest& request)
     }
     int epoch = 0;
     if (params[0].isNull()) {
-        epoch = static_cast<int>(chainActive.Height() / constants::EPOCH_LENGTH);
+        epoch = GetCurrentEpoch();
     } else {
         try {
             epoch = std::stoi(params[0].get_str());
@@ -103,7 +109,7 @@ UniValue getdag(const JSONRPCRequest& request)
     UniValue result(UniValue::VOBJ);
     int epoch = 0;
     if (params[0].isNull()) {
-        epoch = static_cast<int>(chainActive.Height() / constants::EPOCH_LENGTH);
+        epoch = GetCurrentEpoch();
     } else {
         try {
             epoch = std::stoi(params[0].get_str());
@@ -132,7 +138,7 @@ UniValue getcache(const JSONRPCRequest& request)
     UniValue result(UniValue::VOBJ);
     int epoch = 0;
     if (params[0].isNull()) {
-        epoch = static_cast<int>(chainActive.Height() / constants::EPOCH_LENGTH);
+        epoch = GetCurrentEpoch();
     } else {
         try {
             epoch = std::stoi(params[0].get_str());
@@ -151,17 +157,36 @@ UniValue getactivedag(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() > 1) {
         throw std::runtime_error("getactivedag\n"
-                                 "\nReturns a JSON list specifying loaded DAG");
+                                 "\nReturns a JSON list specifying loaded DAG and the state of the next epoch DAG prefetch");
     }
-    const auto& dag = ActiveDAG();
-    if (dag == nullptr) {
+    const auto dag = ActiveDAG();
+    CDAGManager::Status status = dagManager.GetStatus();
+    // the first DAG may still be on its way
+    if (dag == nullptr && status.state == CDAGManager::PREFETCH_IDLE) {
         throw std::runtime_error("there is no active dag");
     }
     using namespace egihash;
     UniValue result(UniValue::VOBJ);
-    result.push_back(Pair("epoch", dag->epoch()));
-    result.push_back(Pair("seedhash", cache_t::get_seedhash(dag->epoch() * constants::EPOCH_LENGTH).to_hex()));
-    result.push_back(Pair("size", static_cast<uint64_t>(dag->size())));
+    if (dag) {
+        result.push_back(Pair("epoch", dag->epoch()));
+        result.push_back(Pair("seedhash", cache_t::get_seedhash(dag->epoch() * constants::EPOCH_LENGTH).to_hex()));
+        result.push_back(Pair("size", static_cast<uint64_t>(dag->size())));
+    }
+
+    UniValue prefetch(UniValue::VOBJ);
+    prefetch.push_back(Pair("state", CDAGManager::StateToString(status.state)));
+    prefetch.push_back(Pair("distance", status.nDistance));
+    if (status.state != CDAGManager::PREFETCH_IDLE) {
+        prefetch.push_back(Pair("epoch", status.nEpoch));
+        prefetch.push_back(Pair("progress", static_cast<uint64_t>(status.nProgress)));
+        prefetch.push_back(Pair("progress_max", static_cast<uint64_t>(status.nProgressMax)));
+        prefetch.push_back(Pair("starttime", status.nStartTime));
+        prefetch.push_back(Pair("duration_ms", status.nDuration));
+    }
+    if (status.state == CDAGManager::PREFETCH_FAILED) {
+        prefetch.push_back(Pair("error", status.strError));
+    }
+    result.push_back(Pair("prefetch", prefetch));
     return result;
 }
 
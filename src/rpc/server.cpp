@@ -27,7 +27,10 @@
 #include <boost/thread.hpp>
 #include <boost/algorithm/string/case_conv.hpp> // for to_upper()
 
+#include <atomic>
+#include <condition_variable>
 #include <memory> // for unique_ptr
+#include <mutex>
 #include <unordered_map>
 
 static bool fRPCRunning = false;
@@ -416,13 +419,84 @@ static UniValue JSONRPCExecOne(const UniValue& req)
     return rpc_result;
 }
 
-std::string JSONRPCExecBatch(const UniValue& vReq)
+/** Entries of a batch, shared by the threads executing them */
+class JSONRPCBatch
 {
-    UniValue ret(UniValue::VARR);
-    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
-        ret.push_back(JSONRPCExecOne(vReq[reqIdx]));
+private:
+    const UniValue& vReq;
+    const size_t nSize;
+    std::atomic<size_t> nNext;
+    std::vector<UniValue> vReplies;
+    size_t nDone;
+    std::mutex mutex;
+    std::condition_variable cond;
 
-    return ret.write() + "\n";
+public:
+    JSONRPCBatch(const UniValue& vReqIn) : vReq(vReqIn), nSize(vReqIn.size()), nNext(0), vReplies(nSize), nDone(0) {}
+
+    /** Execute entries not taken by another thread yet, until there are none left */
+    void Run()
+    {
+        size_t nIdx;
+        // vReq may only be touched once an entry was taken, the batch may be over already
+        while ((nIdx = nNext++) < nSize) {
+            UniValue reply = JSONRPCExecOne(vReq[nIdx]);
+            std::lock_guard<std::mutex> lock(mutex);
+            vReplies[nIdx] = reply;
+            if (++nDone == nSize)
+                cond.notify_all();
+        }
+    }
+
+    /** Wait until all entries were executed, and return the replies in request order */
+    UniValue Wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [this] { return nDone == nSize; });
+        UniValue ret(UniValue::VARR);
+        for (const UniValue& reply : vReplies)
+            ret.push_back(reply);
+        return ret;
+    }
+};
+
+/** Whether the entries of a batch may be executed concurrently, and in any order */
+static bool IsParallelBatch(const UniValue& vReq)
+{
+    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++) {
+        if (!vReq[reqIdx].isObject())
+            continue;
+        const UniValue& method = find_value(vReq[reqIdx].get_obj(), "method");
+        if (!method.isStr())
+            continue;
+        const CRPCCommand* pcmd = tableRPC[method.get_str()];
+        // unknown commands only produce an error
+        if (pcmd && !pcmd->okParallel)
+            return false;
+    }
+    return true;
+}
+
+std::string JSONRPCExecBatch(const UniValue& vReq, const RPCBatchExecutor& executor, int nThreads)
+{
+    if (!executor || nThreads <= 1 || vReq.size() < 2 || !IsParallelBatch(vReq)) {
+        UniValue ret(UniValue::VARR);
+        for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
+            ret.push_back(JSONRPCExecOne(vReq[reqIdx]));
+
+        return ret.write() + "\n";
+    }
+
+    std::shared_ptr<JSONRPCBatch> batch = std::make_shared<JSONRPCBatch>(vReq);
+    int nHelpers = std::min((size_t)nThreads, vReq.size()) - 1;
+    for (int i = 0; i < nHelpers; i++) {
+        // helpers starting late find no entries left, the calling thread always finishes the batch
+        if (!executor([batch] { batch->Run(); }))
+            break;
+    }
+    batch->Run();
+
+    return batch->Wait().write() + "\n";
 }
 
 /**
@@ -11,6 +11,7 @@
 #include "rpc/protocol.h"
 #include "uint256.h"
 
+#include <functional>
 #include <list>
 #include <map>
 #include <stdint.h>
@@ -141,6 +142,13 @@ public:
     rpcfn_type actor;
     bool okSafeMode;
     std::vector<std::string> argNames;
+    /** Read-only, may run concurrently with the other entries of a batch */
+    bool okParallel;
+
+    CRPCCommand(const std::string& categoryIn, const std::string& nameIn, rpcfn_type actorIn, bool okSafeModeIn,
+                const std::vector<std::string>& argNamesIn, bool okParallelIn = false) :
+        category(categoryIn), name(nameIn), actor(actorIn), okSafeMode(okSafeModeIn),
+        argNames(argNamesIn), okParallel(okParallelIn) {}
 };
 
 /**
@@ -204,7 +212,19 @@ extern void EnsureWalletIsUnlocked();
 bool StartRPC();
 void InterruptRPC();
 void StopRPC();
-std::string JSONRPCExecBatch(const UniValue& vReq);
+/** Default for -rpcbatchthreads, the number of threads executing the entries of one batch.
+ *  One less than the default -rpcthreads, so a batch always leaves a worker for other requests. */
+static const int DEFAULT_RPC_BATCH_THREADS = 3;
+
+/** Runs a function on another thread, returns false if it can't take more work */
+typedef std::function<bool(const std::function<void()>&)> RPCBatchExecutor;
+
+/**
+ * Execute a batch of requests and return the replies in request order.
+ * Batches made of okParallel commands only are spread over up to nThreads threads:
+ * the calling one and nThreads - 1 helpers started through executor.
+ */
+std::string JSONRPCExecBatch(const UniValue& vReq, const RPCBatchExecutor& executor = RPCBatchExecutor(), int nThreads = 1);
 void RPCNotifyBlockChange(bool ibd, const CBlockIndex *);
 
 #endif // BITCOIN_RPCSERVER_H
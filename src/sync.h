@@ -15,6 +15,9 @@
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/recursive_mutex.hpp>
 
+#include <atomic>
+#include <stdint.h>
+
 
 /////////////////////////////////////////////////
 //                                             //
@@ -88,15 +91,31 @@ void static inline DeleteLock(void* cs) {}
 #define AssertLockHeld(cs) AssertLockHeldInternal(#cs, __FILE__, __LINE__, &cs)
 
 /**
- * Wrapped boost mutex: supports recursive locking, but no waiting
+ * Wrapped boost mutex: supports recursive locking, but no waiting.
+ * Counts how often a thread found it held by another one and had to wait.
  * TODO: We should move away from using the recursive lock by default.
  */
 class CCriticalSection : public AnnotatedMixin<boost::recursive_mutex>
 {
+private:
+    std::atomic<uint64_t> nContentions;
+
 public:
+    CCriticalSection() : nContentions(0) {}
+
     ~CCriticalSection() {
         DeleteLock((void*)this);
     }
+
+    void lock() EXCLUSIVE_LOCK_FUNCTION()
+    {
+        if (!try_lock()) {
+            ++nContentions;
+            AnnotatedMixin<boost::recursive_mutex>::lock();
+        }
+    }
+
+    uint64_t GetContentions() const { return nContentions; }
 };
 
 typedef CCriticalSection CDynamicCriticalSection;
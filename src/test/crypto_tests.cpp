@@ -4,12 +4,17 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "crypto/aes.h"
+#include "crypto/egihash.h"
 #include "crypto/ripemd160.h"
 #include "crypto/sha1.h"
 #include "crypto/sha256.h"
 #include "crypto/sha512.h"
 #include "crypto/hmac_sha256.h"
 #include "crypto/hmac_sha512.h"
+#include "crypto/x11.h"
+#include "hash.h"
+#include "primitives/block.h"
+#include "random.h"
 #include "utilstrencodings.h"
 #include "test/test_quantisnet.h"
 #include "test/test_random.h"
@@ -463,4 +468,89 @@ BOOST_AUTO_TEST_CASE(pbkdf2_hmac_sha512_test) {
     BOOST_CHECK(HexStr(k, k + 64) == "8c0511f4c6e597c6ac6315d8f0362e225f3c501495ba23b868c005174dc4ee71115b59f9e60cd9532fa33e0f75aefe30225c583a186cd82bd4daea9724a3d3b8");
 }
 
+static void TestX11Hash4Way()
+{
+    // lengths around the 128-byte blake block and its padding boundary
+    const size_t lens[] = {0, 1, 64, 80, 111, 112, 127, 128, 200, 240, 1000};
+    for (size_t len : lens) {
+        std::vector<unsigned char> in[X11_LANES];
+        unsigned char out[X11_LANES][32];
+        const unsigned char* pin[X11_LANES];
+        unsigned char* pout[X11_LANES];
+        for (size_t i = 0; i < X11_LANES; i++) {
+            in[i].resize(len);
+            for (size_t j = 0; j < len; j++) in[i][j] = insecure_rand();
+            pin[i] = in[i].data();
+            pout[i] = out[i];
+        }
+        X11Hash4Way(pin, len, pout);
+        for (size_t i = 0; i < X11_LANES; i++) {
+            uint256 hash = HashX11(in[i].begin(), in[i].end());
+            BOOST_CHECK(HexStr(out[i], out[i] + 32) == HexStr(hash.begin(), hash.end()));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(x11_4way)
+{
+    // the portable fallback first, then whatever the CPU supports
+    TestX11Hash4Way();
+    X11AutoDetect();
+    TestX11Hash4Way();
+
+    // 6 headers of one size and 3 of another, so both the 4-way and the single path run
+    std::vector<CBlockHeader> headers(9);
+    for (size_t i = 0; i < headers.size(); i++) {
+        headers[i].nVersion = 1;
+        headers[i].nTime = insecure_rand();
+        headers[i].nNonce = i;
+        if (i >= 6) {
+            headers[i].nVersion |= CBlockHeader::POS_BIT;
+            headers[i].posStakeHash = GetRandHash();
+            headers[i].posStakeN = i;
+        }
+    }
+    std::vector<uint256> hashes(headers.size());
+    HashX11Batch(headers.data(), headers.size(), hashes.data());
+    for (size_t i = 0; i < headers.size(); i++) {
+        CBlockHeader uncached(headers[i]);
+        uncached.hashCache = CBlockHashCache();
+        BOOST_CHECK(hashes[i] == uncached.GetHash());
+        BOOST_CHECK(hashes[i] == headers[i].GetHash());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(egihash_parallel_generation)
+{
+    // DAG items must not depend on the number of threads generating them, the
+    // range covers several work chunks and a partial one
+    egihash::cache_t cache(0);
+    uint32_t const nItems = 8 * egihash::constants::CALLBACK_FREQUENCY + 7;
+    std::vector<egihash::node> serial(nItems * egihash::data_view_t::row_words);
+    std::vector<egihash::node> parallel(serial.size());
+    egihash::dag_t::generate_items(cache, serial.data(), 0, nItems, 1);
+    egihash::dag_t::generate_items(cache, parallel.data(), 0, nItems, 4);
+    BOOST_CHECK(memcmp(serial.data(), parallel.data(), serial.size() * sizeof(egihash::node)) == 0);
+
+    // a range not starting at the first item
+    std::vector<egihash::node> offset((nItems - 100) * egihash::data_view_t::row_words);
+    egihash::dag_t::generate_items(cache, offset.data(), 100, nItems, 3);
+    BOOST_CHECK(memcmp(&serial[100 * egihash::data_view_t::row_words], offset.data(), offset.size() * sizeof(egihash::node)) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(egihash_hash_reference)
+{
+    // the allocation-free hashimoto kernel must match the reference implementation
+    egihash::cache_t cache(0);
+    egihash::h256_t header;
+    for (uint64_t nonce = 0; nonce < 8; nonce++) {
+        uint8_t input[sizeof(header.b) + sizeof(nonce)] = {0};
+        memcpy(&input[sizeof(header.b)], &nonce, sizeof(nonce));
+        egihash::result_t reference = egihash::light::hash_reference(cache, input, sizeof(input));
+        BOOST_CHECK(egihash::light::hash(cache, input, sizeof(input)) == reference);
+        BOOST_CHECK(egihash::light::hash(cache, header, nonce) == reference);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,58 @@
+// Copyright (c) 2017-2019 The QuantisNet Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "expirywheel.h"
+
+#include "test/test_quantisnet.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(expirywheel_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(expirywheel_test)
+{
+    CExpiryWheel<int> wheel(10);
+    std::vector<int> vKeys;
+
+    wheel.Schedule(1, 5);
+    wheel.Schedule(2, 9);
+    wheel.Schedule(3, 10);
+    wheel.Schedule(4, 25);
+    wheel.Schedule(1, 25);
+    BOOST_CHECK_EQUAL(wheel.GetSize(), 5U);
+    BOOST_CHECK(wheel.DynamicMemoryUsage() > 0);
+
+    // nothing is due before the end of its bucket
+    wheel.PopDue(4, vKeys);
+    BOOST_CHECK(vKeys.empty());
+    wheel.PopDue(8, vKeys);
+    BOOST_CHECK(vKeys.empty());
+
+    wheel.PopDue(9, vKeys);
+    BOOST_CHECK(vKeys == std::vector<int>({1, 2}));
+    BOOST_CHECK_EQUAL(wheel.GetSize(), 3U);
+
+    // several buckets at once, in order
+    vKeys.clear();
+    wheel.PopDue(100, vKeys);
+    BOOST_CHECK(vKeys == std::vector<int>({3, 4, 1}));
+    BOOST_CHECK_EQUAL(wheel.GetSize(), 0U);
+
+    // negative ticks round the same way
+    wheel.Schedule(5, -3);
+    vKeys.clear();
+    wheel.PopDue(-2, vKeys);
+    BOOST_CHECK(vKeys.empty());
+    wheel.PopDue(-1, vKeys);
+    BOOST_CHECK(vKeys == std::vector<int>({5}));
+
+    wheel.Schedule(6, 0);
+    wheel.Clear();
+    vKeys.clear();
+    wheel.PopDue(100, vKeys);
+    BOOST_CHECK(vKeys.empty());
+    BOOST_CHECK_EQUAL(wheel.GetSize(), 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
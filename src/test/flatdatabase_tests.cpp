@@ -0,0 +1,147 @@
+// Copyright (c) 2017-2019 The QuantisNet Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "flat-database.h"
+#include "random.h"
+
+#include "test/test_quantisnet.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(flatdatabase_tests, TestingSetup)
+
+struct CFlatDBTestObject
+{
+    std::vector<std::vector<unsigned char> > vItems;
+    int nCleaned;
+
+    CFlatDBTestObject() : nCleaned(0) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(vItems);
+    }
+
+    void Clear() { vItems.clear(); }
+    void CheckAndRemove() { nCleaned++; }
+    std::string ToString() const { return strprintf("Items: %d", vItems.size()); }
+};
+
+static std::vector<unsigned char> RandomItem(size_t nSize)
+{
+    std::vector<unsigned char> vch(nSize);
+    GetRandBytes(vch.data(), vch.size());
+    return vch;
+}
+
+BOOST_AUTO_TEST_CASE(flatdatabase_log)
+{
+    boost::filesystem::path path = GetDataDir() / "flatdbtest.log";
+    CFlatDB<CFlatDBTestObject> flatdb("flatdbtest.dat", "magicFlatDBTest");
+
+    CFlatDBTestObject obj;
+    for (int i = 0; i < 5000; i++) {
+        obj.vItems.push_back(RandomItem(100));
+    }
+
+    // missing file
+    CFlatDBTestObject objLoaded;
+    BOOST_CHECK(flatdb.Load(objLoaded));
+    BOOST_CHECK(objLoaded.vItems.empty());
+
+    BOOST_CHECK(flatdb.Dump(obj));
+    uint64_t nSize = boost::filesystem::file_size(path);
+    BOOST_CHECK(flatdb.Load(objLoaded));
+    BOOST_CHECK(objLoaded.vItems == obj.vItems);
+    BOOST_CHECK_EQUAL(objLoaded.nCleaned, 1);
+
+    // an unchanged object only appends a checkpoint
+    BOOST_CHECK(flatdb.Dump(obj));
+    BOOST_CHECK(boost::filesystem::file_size(path) < nSize + 1024);
+
+    // a small change in the middle only appends the chunks around it
+    nSize = boost::filesystem::file_size(path);
+    obj.vItems.insert(obj.vItems.begin() + 2500, RandomItem(10));
+    BOOST_CHECK(flatdb.Dump(obj));
+    BOOST_CHECK(boost::filesystem::file_size(path) < nSize + 2 * FLATDB_MAX_CHUNK_SIZE + 1024);
+    CFlatDBTestObject objLoaded2;
+    BOOST_CHECK(flatdb.Load(objLoaded2));
+    BOOST_CHECK(objLoaded2.vItems == obj.vItems);
+
+    // a torn record at the end is ignored and dropped by the next dump
+    nSize = boost::filesystem::file_size(path);
+    FILE* file = fopen(path.string().c_str(), "ab");
+    fwrite("\x01\x05\x00", 1, 3, file);
+    fclose(file);
+    CFlatDBTestObject objLoaded3;
+    BOOST_CHECK(flatdb.Load(objLoaded3));
+    BOOST_CHECK(objLoaded3.vItems == obj.vItems);
+    obj.vItems.pop_back();
+    BOOST_CHECK(flatdb.Dump(obj));
+    CFlatDBTestObject objLoaded4;
+    BOOST_CHECK(flatdb.Load(objLoaded4));
+    BOOST_CHECK(objLoaded4.vItems == obj.vItems);
+    BOOST_CHECK(!boost::filesystem::exists(GetDataDir() / "flatdbtest.dat"));
+
+    // a corrupted chunk is not used, the load falls back to the last checkpoint whose
+    // chunks are intact (the one before the item was removed) and the next dump writes it again
+    nSize = boost::filesystem::file_size(path);
+    file = fopen(path.string().c_str(), "r+b");
+    fseek(file, 100, SEEK_SET);
+    int ch = fgetc(file);
+    fseek(file, 100, SEEK_SET);
+    fputc(ch ^ 0xff, file);
+    fclose(file);
+    CFlatDBTestObject objLoaded5;
+    BOOST_CHECK(flatdb.Load(objLoaded5));
+    BOOST_CHECK_EQUAL(objLoaded5.vItems.size(), obj.vItems.size() + 1);
+    BOOST_CHECK(flatdb.Dump(obj));
+    BOOST_CHECK(boost::filesystem::file_size(path) > nSize + FLATDB_MIN_CHUNK_SIZE);
+    CFlatDBTestObject objLoaded6;
+    BOOST_CHECK(flatdb.Load(objLoaded6));
+    BOOST_CHECK(objLoaded6.vItems == obj.vItems);
+}
+
+BOOST_AUTO_TEST_CASE(flatdatabase_legacy)
+{
+    boost::filesystem::path path = GetDataDir() / "flatdbtest.dat";
+    boost::filesystem::remove(GetDataDir() / "flatdbtest.log");
+    CFlatDB<CFlatDBTestObject> flatdb("flatdbtest.dat", "magicFlatDBTest");
+
+    CFlatDBTestObject obj;
+    for (int i = 0; i < 100; i++) {
+        obj.vItems.push_back(RandomItem(100));
+    }
+
+    // file in the single image format of previous versions
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << std::string("magicFlatDBTest") << FLATDATA(Params().MessageStart()) << obj;
+    uint256 hash = Hash(ss.begin(), ss.end());
+    ss << hash;
+    FILE* file = fopen(path.string().c_str(), "wb");
+    fwrite(&ss[0], 1, ss.size(), file);
+    fclose(file);
+
+    CFlatDBTestObject objLoaded;
+    BOOST_CHECK(flatdb.Load(objLoaded));
+    BOOST_CHECK(objLoaded.vItems == obj.vItems);
+
+    // files of another type are refused
+    CFlatDB<CFlatDBTestObject> flatdbOther("flatdbtest.dat", "magicOtherTest");
+    CFlatDBTestObject objOther;
+    BOOST_CHECK(!flatdbOther.Load(objOther));
+    BOOST_CHECK(!flatdbOther.Dump(obj));
+
+    // converted to a log under its own name by the next dump, previous versions start over
+    BOOST_CHECK(flatdb.Dump(obj));
+    BOOST_CHECK(!boost::filesystem::exists(path));
+    BOOST_CHECK(boost::filesystem::exists(GetDataDir() / "flatdbtest.log"));
+    CFlatDBTestObject objLoaded2;
+    BOOST_CHECK(flatdb.Load(objLoaded2));
+    BOOST_CHECK(objLoaded2.vItems == obj.vItems);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,153 @@
+// Copyright (c) 2017-2019 The QuantisNet Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "indexwriter.h"
+#include "arith_uint256.h"
+#include "chainparams.h"
+#include "consensus/validation.h"
+#include "validation.h"
+
+#include "test/test_quantisnet.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(indexwriter_tests, TestingSetup)
+
+static CIndexUpdate ConnectUpdate(int nHeight, const uint160& addr)
+{
+    CIndexUpdate update;
+    update.hashBlock = ArithToUint256(arith_uint256(nHeight));
+    update.vAddressIndex.push_back(std::make_pair(CAddressIndexKey(1, addr, nHeight, 1, uint256S("aa"), 0, false), nHeight));
+    update.vSpentIndex.push_back(std::make_pair(CSpentIndexKey(uint256S("bb"), nHeight), CSpentIndexValue(uint256S("cc"), 0, nHeight, 5, 1, addr)));
+    return update;
+}
+
+BOOST_AUTO_TEST_CASE(indexwriter_order)
+{
+    uint160 addr;
+    addr.SetHex("1234");
+    std::vector<std::pair<CAddressIndexKey, CAmount> > vAddressIndex;
+    CSpentIndexValue value;
+    uint256 hashBest;
+
+    indexWriter.Start();
+    for (int nHeight = 1; nHeight <= 250; nHeight++)
+        BOOST_CHECK(indexWriter.Queue(ConnectUpdate(nHeight, addr)));
+
+    // disconnect the last block again, it must not come back
+    CIndexUpdate update;
+    update.hashBlock = ArithToUint256(arith_uint256(249));
+    update.vAddressIndexErase.push_back(CAddressIndexKey(1, addr, 250, 1, uint256S("aa"), 0, false));
+    update.vSpentIndex.push_back(std::make_pair(CSpentIndexKey(uint256S("bb"), 250), CSpentIndexValue()));
+    BOOST_CHECK(indexWriter.Queue(std::move(update)));
+
+    BOOST_CHECK(indexWriter.Flush());
+    BOOST_CHECK(pblocktree->ReadAddressIndex(addr, 1, vAddressIndex, 0, 0));
+    BOOST_CHECK_EQUAL(vAddressIndex.size(), 249U);
+    BOOST_CHECK(pblocktree->ReadIndexBestBlock(hashBest));
+    BOOST_CHECK(hashBest == ArithToUint256(arith_uint256(249)));
+    CSpentIndexKey key249(uint256S("bb"), 249);
+    CSpentIndexKey key250(uint256S("bb"), 250);
+    BOOST_CHECK(pblocktree->ReadSpentIndex(key249, value));
+    BOOST_CHECK(!pblocktree->ReadSpentIndex(key250, value));
+
+    // whatever is still queued gets written on stop
+    BOOST_CHECK(indexWriter.Queue(ConnectUpdate(250, addr)));
+    indexWriter.Stop();
+    BOOST_CHECK(pblocktree->ReadIndexBestBlock(hashBest));
+    BOOST_CHECK(hashBest == ArithToUint256(arith_uint256(250)));
+    BOOST_CHECK(pblocktree->ReadSpentIndex(key250, value));
+
+    // without the thread the caller writes on flush
+    BOOST_CHECK(indexWriter.Queue(ConnectUpdate(251, addr)));
+    BOOST_CHECK(indexWriter.Flush());
+    BOOST_CHECK(pblocktree->ReadIndexBestBlock(hashBest));
+    BOOST_CHECK(hashBest == ArithToUint256(arith_uint256(251)));
+}
+
+// The transactions in the address index of a pay-to-pubkey key, in index order
+static std::vector<uint256> GetIndexedTxes(const CKey& key)
+{
+    std::vector<std::pair<CAddressIndexKey, CAmount> > vAddressIndex;
+    BOOST_CHECK(pblocktree->ReadAddressIndex(key.GetPubKey().GetID(), 1, vAddressIndex));
+    std::vector<uint256> vTxes;
+    for (const auto& entry : vAddressIndex)
+        vTxes.push_back(entry.first.txhash);
+    return vTxes;
+}
+
+// The coinbase transactions of the active chain that are among vCoinbases, in chain order
+static std::vector<uint256> GetChainCoinbases(const std::vector<CTransaction>& vCoinbases)
+{
+    std::set<uint256> setCoinbases;
+    for (const CTransaction& tx : vCoinbases)
+        setCoinbases.insert(tx.GetHash());
+    std::vector<uint256> vTxes;
+    for (int nHeight = 1; nHeight <= chainActive.Height(); nHeight++) {
+        CBlock block;
+        BOOST_CHECK(ReadBlockFromDisk(block, chainActive[nHeight], Params().GetConsensus(), false));
+        if (setCoinbases.count(block.vtx[0]->GetHash()))
+            vTxes.push_back(block.vtx[0]->GetHash());
+    }
+    return vTxes;
+}
+
+BOOST_FIXTURE_TEST_CASE(catchupindexes, TestChain100Setup)
+{
+    const CChainParams& chainparams = Params();
+    LOCK(cs_main);
+    fAddressIndex = true;
+    uint256 hashBest;
+
+    // marker behind the chain, the missing blocks are redone
+    BOOST_CHECK(pblocktree->WriteIndexBestBlock(chainActive.Genesis()->GetBlockHash()));
+    BOOST_CHECK(CatchUpIndexes(chainparams));
+    BOOST_CHECK(GetIndexedTxes(coinbaseKey) == GetChainCoinbases(coinbaseTxns));
+    BOOST_CHECK_EQUAL(GetIndexedTxes(coinbaseKey).size(), coinbaseTxns.size());
+    BOOST_CHECK(pblocktree->ReadIndexBestBlock(hashBest));
+    BOOST_CHECK(hashBest == chainActive.Tip()->GetBlockHash());
+
+    // marker ahead of the chain, as after a crash before the chainstate flush
+    CBlockIndex* pindexTip = chainActive.Tip();
+    chainActive.SetTip(chainActive[98]);
+    BOOST_CHECK(CatchUpIndexes(chainparams));
+    BOOST_CHECK(GetIndexedTxes(coinbaseKey) == GetChainCoinbases(coinbaseTxns));
+    BOOST_CHECK_EQUAL(GetIndexedTxes(coinbaseKey).size(), 98U);
+    BOOST_CHECK(pblocktree->ReadIndexBestBlock(hashBest));
+    BOOST_CHECK(hashBest == chainActive[98]->GetBlockHash());
+    chainActive.SetTip(pindexTip);
+    BOOST_CHECK(CatchUpIndexes(chainparams));
+    BOOST_CHECK_EQUAL(GetIndexedTxes(coinbaseKey).size(), coinbaseTxns.size());
+
+    // marker on a stale branch, it is undone back to the fork and the chain redone
+    CBlockIndex* pindexFork = chainActive[98];
+    CValidationState state;
+    BOOST_CHECK(InvalidateBlock(state, chainparams, chainActive[99]));
+    CKey otherKey;
+    otherKey.MakeNewKey(true);
+    CScript scriptPubKey = CScript() << ToByteVector(otherKey.GetPubKey()) << OP_CHECKSIG;
+    std::vector<CMutableTransaction> noTxns;
+    for (int i = 0; i < 3; i++)
+        CreateAndProcessBlock(noTxns, scriptPubKey);
+    BOOST_CHECK(chainActive.Height() == 101 && chainActive[98] == pindexFork);
+    CBlockIndex* pindexStale = chainActive.Tip();
+    FlushStateToDisk();
+    BOOST_CHECK_EQUAL(GetIndexedTxes(otherKey).size(), 3U);
+    BOOST_CHECK_EQUAL(GetIndexedTxes(coinbaseKey).size(), 98U);
+    BOOST_CHECK(pblocktree->ReadIndexBestBlock(hashBest));
+    BOOST_CHECK(hashBest == pindexStale->GetBlockHash());
+
+    chainActive.SetTip(pindexTip);
+    BOOST_CHECK(CatchUpIndexes(chainparams));
+    BOOST_CHECK(GetIndexedTxes(otherKey).empty());
+    BOOST_CHECK(GetIndexedTxes(coinbaseKey) == GetChainCoinbases(coinbaseTxns));
+    BOOST_CHECK_EQUAL(GetIndexedTxes(coinbaseKey).size(), coinbaseTxns.size());
+    BOOST_CHECK(pblocktree->ReadIndexBestBlock(hashBest));
+    BOOST_CHECK(hashBest == pindexTip->GetBlockHash());
+
+    chainActive.SetTip(pindexStale);
+    fAddressIndex = false;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -10,6 +10,7 @@
 #include "serialize.h"
 #include "streams.h"
 #include "net.h"
+#include "net_processing.h"
 #include "netbase.h"
 #include "chainparams.h"
 
@@ -173,4 +174,97 @@ BOOST_AUTO_TEST_CASE(cnode_simple_test)
     BOOST_CHECK(pnode2->fFeeler == false);
 }
 
+BOOST_AUTO_TEST_CASE(netmessage_dispatch)
+{
+    CNetMessageDispatcher dispatcher;
+    CConnman connman(0x1337, 0x1337);
+    CDataStream vRecv(SER_NETWORK, PROTOCOL_VERSION);
+
+    std::vector<std::string> vDispatched;
+    dispatcher.RegisterHandler(NetMsgType::MNPING, [&vDispatched](CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) {
+        vDispatched.push_back(strCommand);
+    }, true);
+    dispatcher.RegisterHandler(NetMsgType::SPORK, [&vDispatched](CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman) {
+        vDispatched.push_back("spork handler");
+    }, false);
+
+    int nPingId = dispatcher.GetCommandId(NetMsgType::MNPING);
+    int nSporkId = dispatcher.GetCommandId(NetMsgType::SPORK);
+    int nDsegId = dispatcher.GetCommandId(NetMsgType::DSEG);
+    BOOST_CHECK(nPingId != -1 && nSporkId != -1 && nDsegId != -1);
+    BOOST_CHECK(nPingId != nSporkId);
+    BOOST_CHECK_EQUAL(dispatcher.GetCommandId("nosuchcmd"), -1);
+
+    BOOST_CHECK(dispatcher.IsConcurrent(nPingId));
+    BOOST_CHECK(!dispatcher.IsConcurrent(nSporkId));
+    BOOST_CHECK(!dispatcher.IsConcurrent(-1));
+
+    // Every command reaches exactly its own handler, known commands without one are dropped
+    BOOST_CHECK(dispatcher.Dispatch(nSporkId, nullptr, NetMsgType::SPORK, vRecv, connman));
+    BOOST_CHECK(dispatcher.Dispatch(nPingId, nullptr, NetMsgType::MNPING, vRecv, connman));
+    BOOST_CHECK(dispatcher.Dispatch(nDsegId, nullptr, NetMsgType::DSEG, vRecv, connman));
+    BOOST_CHECK(!dispatcher.Dispatch(-1, nullptr, "nosuchcmd", vRecv, connman));
+    BOOST_CHECK(vDispatched == std::vector<std::string>({"spork handler", NetMsgType::MNPING}));
+
+    dispatcher.RecordProcessed(nPingId, 10);
+    dispatcher.RecordProcessed(nPingId, 5);
+    dispatcher.RecordProcessed(-1, 7);
+    std::map<std::string, CNetMessageDispatcher::CCommandStats> mapStats = dispatcher.GetStats();
+    BOOST_CHECK_EQUAL(mapStats[NetMsgType::MNPING].nCount, 2U);
+    BOOST_CHECK_EQUAL(mapStats[NetMsgType::MNPING].nTime, 15);
+    BOOST_CHECK_EQUAL(mapStats[NET_MESSAGE_COMMAND_OTHER].nCount, 1U);
+    BOOST_CHECK_EQUAL(mapStats[NetMsgType::SPORK].nCount, 0U);
+}
+
+BOOST_AUTO_TEST_CASE(netmessage_recv_buffer)
+{
+    CNetRecvBufferPool pool(1 << 20);
+    CSerializeData vch;
+    pool.Take(5000, vch);
+    BOOST_CHECK(vch.empty());
+    BOOST_CHECK(vch.capacity() >= 8192);
+    const char* pchStorage = vch.data();
+    size_t nCapacity = vch.capacity();
+    vch.resize(5000);
+    pool.Return(vch);
+    BOOST_CHECK(vch.empty());
+    BOOST_CHECK_EQUAL(pool.GetCachedBytes(), nCapacity);
+
+    // The buffer is reused for the next message of its size class only
+    pool.Take(100, vch);
+    BOOST_CHECK(vch.capacity() >= 4096 && vch.data() != pchStorage);
+    pool.Take(8000, vch);
+    BOOST_CHECK(vch.data() == pchStorage);
+    BOOST_CHECK_EQUAL(pool.GetCachedBytes(), 0U);
+
+    // Small messages don't reserve a pooled buffer
+    CNetMessage msgSmall(Params().MessageStart(), SER_NETWORK, PROTOCOL_VERSION);
+    CDataStream ssSmall(SER_NETWORK, PROTOCOL_VERSION);
+    ssSmall << CMessageHeader(Params().MessageStart(), NetMsgType::PING, 8);
+    BOOST_CHECK_EQUAL(msgSmall.readHeader(&ssSmall[0], CMessageHeader::HEADER_SIZE), (int)CMessageHeader::HEADER_SIZE);
+    CSerializeData vchSmall;
+    msgSmall.vRecv.swap(vchSmall);
+    BOOST_CHECK(vchSmall.capacity() < 4096);
+
+    // Data received in place is not copied again, but still hashed
+    CDataStream ssWire(SER_NETWORK, PROTOCOL_VERSION);
+    ssWire << CMessageHeader(Params().MessageStart(), NetMsgType::BLOCK, 100000);
+    ssWire.resize(ssWire.size() + 100000, 0x42);
+    CNetMessage msg(Params().MessageStart(), SER_NETWORK, PROTOCOL_VERSION);
+    BOOST_CHECK_EQUAL(msg.readHeader(&ssWire[0], CMessageHeader::HEADER_SIZE), (int)CMessageHeader::HEADER_SIZE);
+    BOOST_CHECK(msg.vRecv.empty());
+    unsigned int nPos = CMessageHeader::HEADER_SIZE;
+    while (!msg.complete()) {
+        unsigned int nBytes = 30000;
+        char* pch = msg.GetDataBuffer(nBytes);
+        BOOST_CHECK_EQUAL(nBytes, std::min(30000U, 100000 - msg.nDataPos));
+        memcpy(pch, &ssWire[nPos], nBytes);
+        BOOST_CHECK_EQUAL(msg.readData(pch, nBytes), (int)nBytes);
+        nPos += nBytes;
+    }
+    BOOST_CHECK(msg.vRecv.size() == 100000);
+    BOOST_CHECK(std::equal(msg.vRecv.begin(), msg.vRecv.end(), ssWire.begin() + CMessageHeader::HEADER_SIZE));
+    BOOST_CHECK(msg.GetMessageHash() == Hash(msg.vRecv.begin(), msg.vRecv.end()));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
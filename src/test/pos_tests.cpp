@@ -608,4 +608,182 @@ BOOST_AUTO_TEST_CASE(PoS_abandon_stake) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(PoS_stake_index) {
+    UpdateMockTime();
+
+    std::vector<COutput> vCoins;
+    pwalletMain->AvailableCoins(vCoins);
+    std::set<COutPoint> available;
+    for (auto& c : vCoins) {
+        available.emplace(c.tx->GetHash(), c.i);
+    }
+
+    // The indexed selection only returns available outputs, in order of amount
+    CWallet::StakeCandidates candidates;
+    BOOST_CHECK(pwalletMain->SelectStakeCoins(candidates, MAX_MONEY));
+    BOOST_CHECK(pwalletMain->MintableCoins());
+    for (auto& c : candidates) {
+        BOOST_CHECK(available.count(COutPoint(std::get<1>(c)->GetHash(), std::get<2>(c))));
+    }
+
+    CWallet::StakeCandidates small;
+    pwalletMain->SelectStakeCoins(small, std::get<0>(*candidates.begin()));
+    BOOST_CHECK(!small.empty());
+    for (auto& c : small) {
+        BOOST_CHECK(std::get<0>(c) <= std::get<0>(*candidates.begin()));
+    }
+
+    // Locked outputs are skipped
+    for (auto& c : candidates) {
+        pwalletMain->LockCoin(COutPoint(std::get<1>(c)->GetHash(), std::get<2>(c)));
+    }
+    CWallet::StakeCandidates locked;
+    BOOST_CHECK(!pwalletMain->SelectStakeCoins(locked, MAX_MONEY));
+    BOOST_CHECK(!pwalletMain->MintableCoins());
+    pwalletMain->UnlockAllCoins();
+
+    // The output spent by a new stake leaves the index
+    auto blk = CreateAndProcessBlock(CMutableTransactionList(), CScript());
+    BOOST_CHECK(blk.IsProofOfStake());
+    CWallet::StakeCandidates after;
+    BOOST_CHECK(pwalletMain->SelectStakeCoins(after, MAX_MONEY));
+    for (auto& c : after) {
+        BOOST_CHECK(!pwalletMain->IsSpent(std::get<1>(c)->GetHash(), std::get<2>(c)));
+        BOOST_CHECK(COutPoint(std::get<1>(c)->GetHash(), std::get<2>(c)) != blk.Stake()->vin[0].prevout);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(PoS_template_reuse) {
+    UpdateMockTime();
+
+    BlockAssembler assembler(Params());
+    auto reused = nBlockTemplatesReused;
+    auto extended = nBlockTemplatesExtended;
+    TestMemPoolEntryHelper entry;
+
+    CMutableTransaction tx1;
+    tx1.vin.emplace_back(COutPoint(uint256S("01"), 0));
+    tx1.vout.emplace_back(COIN, CScript() << OP_TRUE);
+    BOOST_CHECK(mempool.addUnchecked(tx1.GetHash(), entry.Fee(10000).FromTx(tx1)));
+
+    auto pblk = assembler.CreateNewBlock(CScript(), pwalletMain)->block;
+    BOOST_CHECK(pblk->vtx.back()->GetHash() == tx1.GetHash());
+    BOOST_CHECK_EQUAL(nBlockTemplatesReused, reused);
+    BOOST_CHECK_EQUAL(nBlockTemplatesExtended, extended);
+
+    // Same tip and mempool: the selection is reused
+    pblk = assembler.CreateNewBlock(CScript(), pwalletMain)->block;
+    BOOST_CHECK(pblk->vtx.back()->GetHash() == tx1.GetHash());
+    BOOST_CHECK_EQUAL(nBlockTemplatesReused, reused + 1);
+
+    // A new transaction is appended to the previous selection
+    CMutableTransaction tx2;
+    tx2.vin.emplace_back(COutPoint(uint256S("02"), 0));
+    tx2.vout.emplace_back(COIN, CScript() << OP_TRUE);
+    BOOST_CHECK(mempool.addUnchecked(tx2.GetHash(), entry.Fee(10000).FromTx(tx2)));
+
+    pblk = assembler.CreateNewBlock(CScript(), pwalletMain)->block;
+    BOOST_CHECK(pblk->vtx[pblk->vtx.size() - 2]->GetHash() == tx1.GetHash());
+    BOOST_CHECK(pblk->vtx.back()->GetHash() == tx2.GetHash());
+    BOOST_CHECK_EQUAL(nBlockTemplatesExtended, extended + 1);
+
+    // A selected transaction left the mempool: the selection is rebuilt
+    mempool.removeRecursive(tx1);
+    pblk = assembler.CreateNewBlock(CScript(), pwalletMain)->block;
+    BOOST_CHECK(pblk->vtx.back()->GetHash() == tx2.GetHash());
+    BOOST_CHECK_EQUAL(nBlockTemplatesReused, reused + 1);
+    BOOST_CHECK_EQUAL(nBlockTemplatesExtended, extended + 1);
+
+    mempool.clear();
+}
+
+BOOST_AUTO_TEST_CASE(PoS_stake_modifier_cache) {
+    ClearStakeModifierCache();
+
+    for (auto pindex = chainActive.Tip(); pindex; pindex = pindex->pprev) {
+        uint64_t expected, cached;
+        BOOST_CHECK(ComputeNextStakeModifier(pindex, expected));
+        BOOST_CHECK(GetKernelStakeModifier(pindex, cached));
+        BOOST_CHECK_EQUAL(cached, expected);
+        BOOST_CHECK(GetKernelStakeModifier(pindex, cached));
+        BOOST_CHECK_EQUAL(cached, expected);
+    }
+
+    size_t entries;
+    uint64_t hits, misses;
+    GetStakeModifierCacheStats(entries, hits, misses);
+    BOOST_CHECK_EQUAL(entries, size_t(chainActive.Height() + 1));
+    BOOST_CHECK_EQUAL(hits, uint64_t(chainActive.Height() + 1));
+    BOOST_CHECK_EQUAL(misses, uint64_t(chainActive.Height() + 1));
+
+    // Staking on the cached modifiers still produces valid blocks
+    auto tip = chainActive.Tip();
+    auto blk = CreateAndProcessBlock(CMutableTransactionList(), CScript());
+    BOOST_CHECK(blk.IsProofOfStake());
+    BOOST_CHECK(chainActive.Tip()->pprev == tip);
+    UpdateMockTime();
+
+    {
+        CValidationState state;
+        InvalidateBlock(state, Params(), chainActive.Tip());
+        BOOST_CHECK(state.IsValid());
+        ActivateBestChain(state, Params());
+        BOOST_CHECK(state.IsValid());
+    }
+    BOOST_CHECK(chainActive.Tip() == tip);
+    GetStakeModifierCacheStats(entries, hits, misses);
+    BOOST_CHECK(entries <= size_t(chainActive.Height() + 1));
+}
+
+BOOST_AUTO_TEST_CASE(PoS_kernel_search) {
+    const unsigned int nTimeBlockFrom = 1550000000;
+    const unsigned int nTimeTx = nTimeBlockFrom + 3600;
+    const arith_uint256 bnTarget = ~arith_uint256(0) >> 8;
+
+    std::vector<CStakeKernel> vKernels;
+    for (uint32_t i = 0; i < 4 * MIN_STAKE_KERNELS_PER_THREAD; ++i) {
+        uint64_t nStakeModifier = 0x1234567887654321 + i;
+        COutPoint prevout(ArithToUint256(arith_uint256(i * 7919)), i % 3);
+        // a few candidates are too young at nTimeTx
+        CStakeKernel kernel(nStakeModifier, nTimeBlockFrom, prevout, bnTarget, (i % 5) ? nTimeBlockFrom : nTimeTx + 1);
+
+        CDataStream ss(SER_GETHASH, 0);
+        ss << nStakeModifier;
+        BOOST_CHECK(kernel.GetHash(nTimeTx) == stakeHash(nTimeTx, ss, prevout.n, prevout.hash, nTimeBlockFrom));
+        vKernels.push_back(kernel);
+    }
+
+    // Every thread count must find the same kernels as a sequential scan
+    size_t nStart = 0;
+    for (;;) {
+        size_t nExpected = vKernels.size();
+        unsigned int nExpectedTime = 0;
+        uint256 hashExpected;
+        for (size_t i = nStart; i < vKernels.size(); ++i) {
+            if (nTimeTx >= vKernels[i].GetMinTimeTx() && vKernels[i].Search(nTimeTx, nTimeTx + 4, nExpectedTime, hashExpected)) {
+                nExpected = i;
+                break;
+            }
+        }
+
+        for (int nThreads = 1; nThreads <= 4; ++nThreads) {
+            size_t nIndex = 0;
+            unsigned int nTimeFound = 0;
+            uint256 hashFound;
+            bool fFound = FindStakeKernel(vKernels, nStart, nTimeTx, nTimeTx + 4, nThreads, nIndex, nTimeFound, hashFound);
+            BOOST_CHECK_EQUAL(fFound, nExpected != vKernels.size());
+            if (fFound) {
+                BOOST_CHECK_EQUAL(nIndex, nExpected);
+                BOOST_CHECK_EQUAL(nTimeFound, nExpectedTime);
+                BOOST_CHECK(hashFound == hashExpected);
+            }
+        }
+
+        if (nExpected == vKernels.size()) {
+            break;
+        }
+        nStart = nExpected + 1;
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
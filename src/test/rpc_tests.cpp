@@ -17,6 +17,8 @@
 
 #include <univalue.h>
 
+#include <thread>
+
 UniValue CallRPC(std::string args)
 {
     std::vector<std::string> vArgs;
@@ -354,4 +356,61 @@ BOOST_AUTO_TEST_CASE(rpc_sentinel_ping)
     BOOST_CHECK_THROW(CallRPC("sentinelping 2"), std::bad_cast);
 }
 
+
+// Run a batch, with helpers started on their own threads, and return its replies
+static UniValue ExecBatch(const std::string& strBatch, int nThreads, int& nHelpersRet)
+{
+    UniValue vReq;
+    BOOST_CHECK(vReq.read(strBatch));
+    std::vector<std::thread> vThreads;
+    nHelpersRet = 0;
+    RPCBatchExecutor executor = [&vThreads, &nHelpersRet](const std::function<void()>& func) {
+        nHelpersRet++;
+        vThreads.emplace_back(func);
+        return true;
+    };
+    std::string strReply = JSONRPCExecBatch(vReq, executor, nThreads);
+    for (std::thread& thread : vThreads)
+        thread.join();
+    UniValue vReply;
+    BOOST_CHECK(vReply.read(strReply));
+    return vReply;
+}
+
+BOOST_AUTO_TEST_CASE(rpc_batch)
+{
+    if (RPCIsInWarmup(NULL))
+        SetRPCWarmupFinished();
+
+    const std::string strParallel =
+        "[{\"method\":\"getblockhash\",\"params\":[0],\"id\":1},"
+        "{\"method\":\"getblockcount\",\"params\":[],\"id\":2},"
+        "{\"method\":\"getbestblockhash\",\"params\":[],\"id\":3},"
+        "{\"method\":\"nosuchmethod\",\"params\":[],\"id\":4}";
+    int nHelpers;
+
+    // read-only commands are spread over the threads, replies keep the request order
+    UniValue vReply = ExecBatch(strParallel + "]", 3, nHelpers);
+    BOOST_CHECK_EQUAL(nHelpers, 2);
+    BOOST_CHECK_EQUAL(vReply.size(), 4U);
+    for (size_t i = 0; i < vReply.size(); i++)
+        BOOST_CHECK_EQUAL(find_value(vReply[i], "id").get_int(), (int)i + 1);
+    BOOST_CHECK_EQUAL(find_value(vReply[0], "result").get_str(), find_value(vReply[2], "result").get_str());
+    BOOST_CHECK_EQUAL(find_value(vReply[1], "result").get_int(), 0);
+    BOOST_CHECK_EQUAL(find_value(find_value(vReply[3], "error"), "code").get_int(), (int)RPC_METHOD_NOT_FOUND);
+
+    // a single command without okParallel makes the whole batch sequential
+    vReply = ExecBatch(strParallel + ",{\"method\":\"getmempoolinfo\",\"params\":[],\"id\":5}]", 3, nHelpers);
+    BOOST_CHECK_EQUAL(nHelpers, 0);
+    BOOST_CHECK_EQUAL(vReply.size(), 5U);
+    for (size_t i = 0; i < vReply.size(); i++)
+        BOOST_CHECK_EQUAL(find_value(vReply[i], "id").get_int(), (int)i + 1);
+    BOOST_CHECK(find_value(vReply[4], "error").isNull());
+
+    // so does a single thread
+    vReply = ExecBatch(strParallel + "]", 1, nHelpers);
+    BOOST_CHECK_EQUAL(nHelpers, 0);
+    BOOST_CHECK_EQUAL(vReply.size(), 4U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
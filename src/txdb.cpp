@@ -33,6 +33,7 @@ static const char DB_BEST_BLOCK = 'B';
 static const char DB_FLAG = 'F';
 static const char DB_REINDEX_FLAG = 'R';
 static const char DB_LAST_BLOCK = 'l';
+static const char DB_INDEX_BEST_BLOCK = 'I';
 
 namespace {
 
@@ -236,19 +237,31 @@ bool CBlockTreeDB::UpdateAddressUnspentIndex(const std::vector<std::pair<CAddres
 }
 
 bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type,
-                                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs) {
+                                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs,
+                                           const CAddressUnspentKey* pkeyAfter, size_t nLimit) {
 
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
 
-    pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
+    if (pkeyAfter) {
+        pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, *pkeyAfter));
+    } else {
+        pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
+    }
 
-    while (pcursor->Valid()) {
+    size_t nCount = 0;
+    while (pcursor->Valid() && (nLimit == 0 || nCount < nLimit)) {
         boost::this_thread::interruption_point();
         std::pair<char,CAddressUnspentKey> key;
         if (pcursor->GetKey(key) && key.first == DB_ADDRESSUNSPENTINDEX && key.second.hashBytes == addressHash) {
+            // the seek lands on the cursor key itself when it still exists, it was returned by the previous page
+            if (pkeyAfter && key.second.txhash == pkeyAfter->txhash && key.second.index == pkeyAfter->index) {
+                pcursor->Next();
+                continue;
+            }
             CAddressUnspentValue nValue;
             if (pcursor->GetValue(nValue)) {
                 unspentOutputs.push_back(std::make_pair(key.second, nValue));
+                nCount++;
                 pcursor->Next();
             } else {
                 return error("failed to get address unspent value");
@@ -277,26 +290,38 @@ bool CBlockTreeDB::EraseAddressIndex(const std::vector<std::pair<CAddressIndexKe
 
 bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type,
                                     std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
-                                    int start, int end) {
+                                    int start, int end,
+                                    const CAddressIndexKey* pkeyAfter, size_t nLimit) {
 
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
 
-    if (start > 0 && end > 0) {
+    if (pkeyAfter) {
+        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, *pkeyAfter));
+    } else if (start > 0 && end > 0) {
         pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, addressHash, start)));
     } else {
         pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorKey(type, addressHash)));
     }
 
-    while (pcursor->Valid()) {
+    size_t nCount = 0;
+    while (pcursor->Valid() && (nLimit == 0 || nCount < nLimit)) {
         boost::this_thread::interruption_point();
         std::pair<char,CAddressIndexKey> key;
         if (pcursor->GetKey(key) && key.first == DB_ADDRESSINDEX && key.second.hashBytes == addressHash) {
             if (end > 0 && key.second.blockHeight > end) {
                 break;
             }
+            // the seek lands on the cursor key itself when it still exists, it was returned by the previous page
+            if (pkeyAfter && key.second.blockHeight == pkeyAfter->blockHeight && key.second.txindex == pkeyAfter->txindex &&
+                key.second.txhash == pkeyAfter->txhash && key.second.index == pkeyAfter->index &&
+                key.second.spending == pkeyAfter->spending) {
+                pcursor->Next();
+                continue;
+            }
             CAmount nValue;
             if (pcursor->GetValue(nValue)) {
                 addressIndex.push_back(std::make_pair(key.second, nValue));
+                nCount++;
                 pcursor->Next();
             } else {
                 return error("failed to get address index value");
@@ -335,6 +360,49 @@ bool CBlockTreeDB::ReadTimestampIndex(const unsigned int &high, const unsigned i
     return true;
 }
 
+bool CBlockTreeDB::WriteIndexUpdates(const std::vector<CIndexUpdate>& vUpdates) {
+    if (vUpdates.empty())
+        return true;
+    // One batch in the original order, so the best block marker always matches the index contents
+    CDBBatch batch(*this);
+    for (const CIndexUpdate& update : vUpdates) {
+        for (const auto& entry : update.vAddressIndex)
+            batch.Write(std::make_pair(DB_ADDRESSINDEX, entry.first), entry.second);
+        for (const CAddressIndexKey& key : update.vAddressIndexErase)
+            batch.Erase(std::make_pair(DB_ADDRESSINDEX, key));
+        for (const auto& entry : update.vAddressUnspentIndex) {
+            if (entry.second.IsNull()) {
+                batch.Erase(std::make_pair(DB_ADDRESSUNSPENTINDEX, entry.first));
+            } else {
+                batch.Write(std::make_pair(DB_ADDRESSUNSPENTINDEX, entry.first), entry.second);
+            }
+        }
+        for (const auto& entry : update.vSpentIndex) {
+            if (entry.second.IsNull()) {
+                batch.Erase(std::make_pair(DB_SPENTINDEX, entry.first));
+            } else {
+                batch.Write(std::make_pair(DB_SPENTINDEX, entry.first), entry.second);
+            }
+        }
+        for (const CTimestampIndexKey& key : update.vTimestampIndex)
+            batch.Write(std::make_pair(DB_TIMESTAMPINDEX, key), 0);
+        for (const auto& entry : update.vBlockFileInfo)
+            batch.Write(std::make_pair(DB_BLOCK_FILES, entry.first), entry.second);
+        for (const CDiskBlockIndex& diskindex : update.vBlockIndex)
+            batch.Write(std::make_pair(DB_BLOCK_INDEX, diskindex.GetBlockHash()), diskindex);
+    }
+    batch.Write(DB_INDEX_BEST_BLOCK, vUpdates.back().hashBlock);
+    return WriteBatch(batch);
+}
+
+bool CBlockTreeDB::ReadIndexBestBlock(uint256& hashBlock) {
+    return Read(DB_INDEX_BEST_BLOCK, hashBlock);
+}
+
+bool CBlockTreeDB::WriteIndexBestBlock(const uint256& hashBlock) {
+    return Write(DB_INDEX_BEST_BLOCK, hashBlock);
+}
+
 bool CBlockTreeDB::WriteFlag(const std::string &name, bool fValue) {
     return Write(std::make_pair(DB_FLAG, name), fValue ? '1' : '0');
 }
@@ -110,6 +110,24 @@ private:
     friend class CCoinsViewDB;
 };
 
+/** Address, spent and timestamp index changes of connecting or disconnecting one block */
+struct CIndexUpdate
+{
+    //! Best block of the indexes once this update is applied
+    uint256 hashBlock;
+    std::vector<std::pair<CAddressIndexKey, CAmount> > vAddressIndex;
+    std::vector<CAddressIndexKey> vAddressIndexErase;
+    //! Null values are erased
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > vAddressUnspentIndex;
+    //! Null values are erased
+    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > vSpentIndex;
+    std::vector<CTimestampIndexKey> vTimestampIndex;
+    //! Block index entries and block file information written in the same batch, so the
+    //! marker never names a block whose data or undo position is not on disk yet
+    std::vector<CDiskBlockIndex> vBlockIndex;
+    std::vector<std::pair<int, CBlockFileInfo> > vBlockFileInfo;
+};
+
 /** Access to the block database (blocks/index/) */
 class CBlockTreeDB : public CDBWrapper
 {
@@ -129,15 +147,24 @@ public:
     bool ReadSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value);
     bool UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >&vect);
     bool UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue > >&vect);
+    /** Read the unspent outputs of an address in key order, starting after pkeyAfter if set and
+     *  stopping after nLimit entries if non-zero. */
     bool ReadAddressUnspentIndex(uint160 addressHash, int type,
-                                 std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vect);
+                                 std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vect,
+                                 const CAddressUnspentKey* pkeyAfter = NULL, size_t nLimit = 0);
     bool WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect);
     bool EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect);
+    /** Read the address index entries of an address in key order (by height), optionally limited to
+     *  the heights start..end, starting after pkeyAfter if set and stopping after nLimit entries if non-zero. */
     bool ReadAddressIndex(uint160 addressHash, int type,
                           std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
-                          int start = 0, int end = 0);
+                          int start = 0, int end = 0,
+                          const CAddressIndexKey* pkeyAfter = NULL, size_t nLimit = 0);
     bool WriteTimestampIndex(const CTimestampIndexKey &timestampIndex);
     bool ReadTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &vect);
+    bool WriteIndexUpdates(const std::vector<CIndexUpdate>& vUpdates);
+    bool ReadIndexBestBlock(uint256& hashBlock);
+    bool WriteIndexBestBlock(const uint256& hashBlock);
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
     bool LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex,
@@ -17,6 +17,7 @@
 #include "consensus/merkle.h"
 #include "consensus/validation.h"
 #include "hash.h"
+#include "indexwriter.h"
 #include "init.h"
 #include "policy/policy.h"
 #include "pos_kernel.h"
@@ -1125,6 +1126,9 @@ bool GetTimestampIndex(const unsigned int &high, const unsigned int &low, std::v
     if (!fTimestampIndex)
         return error("Timestamp index not enabled");
 
+    if (!indexWriter.Flush())
+        return error("Unable to write pending timestamp index updates");
+
     if (!pblocktree->ReadTimestampIndex(high, low, hashes))
         return error("Unable to get hashes for timestamps");
 
@@ -1139,6 +1143,9 @@ bool GetSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value)
     if (mempool.getSpentIndex(key, value))
         return true;
 
+    if (!indexWriter.Flush())
+        return false;
+
     if (!pblocktree->ReadSpentIndex(key, value))
         return false;
 
@@ -1146,24 +1153,32 @@ bool GetSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value)
 }
 
 bool GetAddressIndex(uint160 addressHash, int type,
-                     std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex, int start, int end)
+                     std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex, int start, int end,
+                     const CAddressIndexKey* pkeyAfter, size_t nLimit)
 {
     if (!fAddressIndex)
         return error("address index not enabled");
 
-    if (!pblocktree->ReadAddressIndex(addressHash, type, addressIndex, start, end))
+    if (!indexWriter.Flush())
+        return error("unable to write pending address index updates");
+
+    if (!pblocktree->ReadAddressIndex(addressHash, type, addressIndex, start, end, pkeyAfter, nLimit))
         return error("unable to get txids for address");
 
     return true;
 }
 
 bool GetAddressUnspent(uint160 addressHash, int type,
-                       std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs)
+                       std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs,
+                       const CAddressUnspentKey* pkeyAfter, size_t nLimit)
 {
     if (!fAddressIndex)
         return error("address index not enabled");
 
-    if (!pblocktree->ReadAddressUnspentIndex(addressHash, type, unspentOutputs))
+    if (!indexWriter.Flush())
+        return error("unable to write pending address index updates");
+
+    if (!pblocktree->ReadAddressUnspentIndex(addressHash, type, unspentOutputs, pkeyAfter, nLimit))
         return error("unable to get txids for address");
 
     return true;
@@ -1822,9 +1837,108 @@ int ApplyTxInUndo(Coin&& undo, CCoinsViewCache& view, const COutPoint& out)
     return fClean ? DISCONNECT_OK : DISCONNECT_UNCLEAN;
 }
 
+/** Address index type (1 for P2PKH and P2PK, 2 for P2SH) and hash of a script, 0 if not indexed */
+static int GetAddressIndexType(const CScript& script, uint160& hashBytes)
+{
+    if (script.IsPayToScriptHash()) {
+        hashBytes = uint160(std::vector<unsigned char>(script.begin()+2, script.begin()+22));
+        return 2;
+    } else if (script.IsPayToPublicKeyHash()) {
+        hashBytes = uint160(std::vector<unsigned char>(script.begin()+3, script.begin()+23));
+        return 1;
+    } else if (script.IsPayToPublicKey()) {
+        hashBytes = Hash160(script.begin()+1, script.end()-1);
+        return 1;
+    }
+    hashBytes.SetNull();
+    return 0;
+}
+
+/**
+ * Address, spent and timestamp index changes of connecting a block, or with fDisconnect of
+ * undoing it again. The spent outputs are taken from the block's undo data.
+ */
+static bool GetIndexUpdate(const CBlock& block, const CBlockIndex* pindex, const CBlockUndo& blockundo, bool fDisconnect, CIndexUpdate& update)
+{
+    if (blockundo.vtxundo.size() + 1 != block.vtx.size())
+        return false;
+    for (size_t i = 1; i < block.vtx.size(); i++) {
+        if (blockundo.vtxundo[i-1].vprevout.size() != block.vtx[i]->vin.size())
+            return false;
+    }
+
+    update.hashBlock = fDisconnect ? pindex->pprev->GetBlockHash() : pindex->GetBlockHash();
+
+    // disconnecting walks the block backwards, so outputs spent within the block come back last
+    for (size_t n = 0; n < block.vtx.size(); n++) {
+        const size_t i = fDisconnect ? block.vtx.size() - 1 - n : n;
+        const CTransaction& tx = *block.vtx[i];
+        const uint256 txhash = tx.GetHash();
+        uint160 hashBytes;
+
+        if (fDisconnect && fAddressIndex) {
+            for (size_t k = tx.vout.size(); k-- > 0;) {
+                int addressType = GetAddressIndexType(tx.vout[k].scriptPubKey, hashBytes);
+                if (addressType == 0)
+                    continue;
+                // undo receiving activity and unspent output
+                update.vAddressIndexErase.push_back(CAddressIndexKey(addressType, hashBytes, pindex->nHeight, i, txhash, k, false));
+                update.vAddressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(addressType, hashBytes, txhash, k), CAddressUnspentValue()));
+            }
+        }
+
+        // inputs (there are none for the coinbase)
+        for (size_t m = 0; i > 0 && m < tx.vin.size(); m++) {
+            const size_t j = fDisconnect ? tx.vin.size() - 1 - m : m;
+            const COutPoint& prevout = tx.vin[j].prevout;
+            const Coin& coin = blockundo.vtxundo[i-1].vprevout[j];
+            int addressType = GetAddressIndexType(coin.out.scriptPubKey, hashBytes);
+
+            if (fSpentIndex) {
+                // the txid and input that spent an output, and the amount and address of an input
+                update.vSpentIndex.push_back(std::make_pair(CSpentIndexKey(prevout.hash, prevout.n),
+                    fDisconnect ? CSpentIndexValue() : CSpentIndexValue(txhash, j, pindex->nHeight, coin.out.nValue, addressType, hashBytes)));
+            }
+
+            if (fAddressIndex && addressType > 0) {
+                CAddressIndexKey key(addressType, hashBytes, pindex->nHeight, i, txhash, j, true);
+                CAddressUnspentKey unspentKey(addressType, hashBytes, prevout.hash, prevout.n);
+                if (fDisconnect) {
+                    // undo spending activity and restore the unspent output
+                    update.vAddressIndexErase.push_back(key);
+                    update.vAddressUnspentIndex.push_back(std::make_pair(unspentKey, CAddressUnspentValue(coin.out.nValue, coin.out.scriptPubKey, coin.nHeight)));
+                } else {
+                    // record spending activity and remove the unspent output
+                    update.vAddressIndex.push_back(std::make_pair(key, coin.out.nValue * -1));
+                    update.vAddressUnspentIndex.push_back(std::make_pair(unspentKey, CAddressUnspentValue()));
+                }
+            }
+        }
+
+        if (!fDisconnect && fAddressIndex) {
+            for (size_t k = 0; k < tx.vout.size(); k++) {
+                const CTxOut& out = tx.vout[k];
+                int addressType = GetAddressIndexType(out.scriptPubKey, hashBytes);
+                if (addressType == 0)
+                    continue;
+                // record receiving activity and unspent output
+                update.vAddressIndex.push_back(std::make_pair(CAddressIndexKey(addressType, hashBytes, pindex->nHeight, i, txhash, k, false), out.nValue));
+                update.vAddressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(addressType, hashBytes, txhash, k), CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight)));
+            }
+        }
+    }
+
+    if (!fDisconnect && fTimestampIndex)
+        update.vTimestampIndex.push_back(CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash()));
+
+    return true;
+}
+
 /** Undo the effects of this block (with given index) on the UTXO set represented by coins.
+ *  The matching index changes are returned in pindexUpdate, if given.
  *  When UNCLEAN or FAILED is returned, view is left in an indeterminate state. */
-static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& state, const CBlockIndex* pindex, CCoinsViewCache& view)
+static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& state, const CBlockIndex* pindex, CCoinsViewCache& view,
+                                        CIndexUpdate* pindexUpdate = nullptr)
 {
     assert(pindex->GetBlockHash() == view.GetBestBlock());
 
@@ -1846,9 +1960,11 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
         return DISCONNECT_FAILED;
     }
 
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
-    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
+    // before the undo data is moved into the view
+    if (pindexUpdate && !GetIndexUpdate(block, pindex, blockUndo, true, *pindexUpdate)) {
+        error("DisconnectBlock(): block and undo data inconsistent");
+        return DISCONNECT_FAILED;
+    }
 
     // undo transactions in reverse order
     for (int i = block.vtx.size() - 1; i >= 0; i--) {
@@ -1856,41 +1972,6 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
         uint256 hash = tx.GetHash();
         bool is_coinbase = tx.IsCoinBase();
 
-        if (fAddressIndex) {
-
-            for (unsigned int k = tx.vout.size(); k-- > 0;) {
-                const CTxOut &out = tx.vout[k];
-
-                if (out.scriptPubKey.IsPayToScriptHash()) {
-                    std::vector<unsigned char> hashBytes(out.scriptPubKey.begin()+2, out.scriptPubKey.begin()+22);
-
-                    // undo receiving activity
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(2, uint160(hashBytes), pindex->nHeight, i, hash, k, false), out.nValue));
-
-                    // undo unspent index
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(2, uint160(hashBytes), hash, k), CAddressUnspentValue()));
-
-                } else if (out.scriptPubKey.IsPayToPublicKeyHash()) {
-                    std::vector<unsigned char> hashBytes(out.scriptPubKey.begin()+3, out.scriptPubKey.begin()+23);
-
-                    // undo receiving activity
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(1, uint160(hashBytes), pindex->nHeight, i, hash, k, false), out.nValue));
-
-                    // undo unspent index
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, uint160(hashBytes), hash, k), CAddressUnspentValue()));
-
-                } else if (out.scriptPubKey.IsPayToPublicKey()) {
-                    uint160 hashBytes(Hash160(out.scriptPubKey.begin()+1, out.scriptPubKey.end()-1));
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(1, hashBytes, pindex->nHeight, i, hash, k, false), out.nValue));
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, hashBytes, hash, k), CAddressUnspentValue()));
-                } else {
-                    continue;
-                }
-
-            }
-
-        }
-
         // Check that all outputs are available and match the outputs in the block itself
         // exactly.
         for (size_t o = 0; o < tx.vout.size(); o++) {
@@ -1913,49 +1994,9 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
             }
             for (unsigned int j = tx.vin.size(); j-- > 0;) {
                 const COutPoint &out = tx.vin[j].prevout;
-                int undoHeight = txundo.vprevout[j].nHeight;
                 int res = ApplyTxInUndo(std::move(txundo.vprevout[j]), view, out);
                 if (res == DISCONNECT_FAILED) return DISCONNECT_FAILED;
                 fClean = fClean && res != DISCONNECT_UNCLEAN;
-
-                const CTxIn input = tx.vin[j];
-
-                if (fSpentIndex) {
-                    // undo and delete the spent index
-                    spentIndex.push_back(std::make_pair(CSpentIndexKey(input.prevout.hash, input.prevout.n), CSpentIndexValue()));
-                }
-
-                if (fAddressIndex) {
-                    const Coin &coin = view.AccessCoin(tx.vin[j].prevout);
-                    const CTxOut &prevout = coin.out;
-                    if (prevout.scriptPubKey.IsPayToScriptHash()) {
-                        std::vector<unsigned char> hashBytes(prevout.scriptPubKey.begin()+2, prevout.scriptPubKey.begin()+22);
-
-                        // undo spending activity
-                        addressIndex.push_back(std::make_pair(CAddressIndexKey(2, uint160(hashBytes), pindex->nHeight, i, hash, j, true), prevout.nValue * -1));
-
-                        // restore unspent index
-                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(2, uint160(hashBytes), input.prevout.hash, input.prevout.n), CAddressUnspentValue(prevout.nValue, prevout.scriptPubKey, undoHeight)));
-
-
-                    } else if (prevout.scriptPubKey.IsPayToPublicKeyHash()) {
-                        std::vector<unsigned char> hashBytes(prevout.scriptPubKey.begin()+3, prevout.scriptPubKey.begin()+23);
-
-                        // undo spending activity
-                        addressIndex.push_back(std::make_pair(CAddressIndexKey(1, uint160(hashBytes), pindex->nHeight, i, hash, j, true), prevout.nValue * -1));
-
-                        // restore unspent index
-                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, uint160(hashBytes), input.prevout.hash, input.prevout.n), CAddressUnspentValue(prevout.nValue, prevout.scriptPubKey, undoHeight)));
-
-                    } else if (prevout.scriptPubKey.IsPayToPublicKey()) {
-                        uint160 hashBytes(Hash160(prevout.scriptPubKey.begin()+1, prevout.scriptPubKey.end()-1));
-                        addressIndex.push_back(std::make_pair(CAddressIndexKey(1, hashBytes, pindex->nHeight, i, hash, j, false), prevout.nValue));
-                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, hashBytes, hash, j), CAddressUnspentValue()));
-                    } else {
-                        continue;
-                    }
-                }
-
             }
             // At this point, all of txundo.vprevout should have been moved out.
         }
@@ -1965,17 +2006,6 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
     // move best block pointer to prevout block
     view.SetBestBlock(pindex->pprev->GetBlockHash());
 
-    if (fAddressIndex) {
-        if (!pblocktree->EraseAddressIndex(addressIndex)) {
-            AbortNode(state, "Failed to delete address index");
-            return DISCONNECT_FAILED;
-        }
-        if (!pblocktree->UpdateAddressUnspentIndex(addressUnspentIndex)) {
-            AbortNode(state, "Failed to write address unspent index");
-            return DISCONNECT_FAILED;
-        }
-    }
-
     return fClean ? DISCONNECT_OK : DISCONNECT_UNCLEAN;
 }
 
@@ -2225,16 +2255,12 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
     std::vector<std::pair<uint256, CDiskTxPos> > vPos;
     vPos.reserve(block.vtx.size());
     blockundo.vtxundo.reserve(block.vtx.size() - 1);
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
-    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
 
     bool fDIP0001Active_context = pindex->nHeight >= Params().GetConsensus().DIP0001Height;
 
     for (unsigned int i = 0; i < block.vtx.size(); i++)
     {
         const CTransaction &tx = *(block.vtx[i]);
-        const uint256 txhash = tx.GetHash();
 
         nInputs += tx.vin.size();
         nSigOps += GetLegacySigOpCount(tx);
@@ -2261,46 +2287,6 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
                                  REJECT_INVALID, "bad-txns-nonfinal");
             }
 
-            if (fAddressIndex || fSpentIndex)
-            {
-                for (size_t j = 0; j < tx.vin.size(); j++) {
-                    const CTxIn input = tx.vin[j];
-                    const Coin& coin = view.AccessCoin(tx.vin[j].prevout);
-                    const CTxOut &prevout = coin.out;
-                    uint160 hashBytes;
-                    int addressType;
-
-                    if (prevout.scriptPubKey.IsPayToScriptHash()) {
-                        hashBytes = uint160(std::vector<unsigned char>(prevout.scriptPubKey.begin()+2, prevout.scriptPubKey.begin()+22));
-                        addressType = 2;
-                    } else if (prevout.scriptPubKey.IsPayToPublicKeyHash()) {
-                        hashBytes = uint160(std::vector<unsigned char>(prevout.scriptPubKey.begin()+3, prevout.scriptPubKey.begin()+23));
-                        addressType = 1;
-                    } else if (prevout.scriptPubKey.IsPayToPublicKey()) {
-                        hashBytes = Hash160(prevout.scriptPubKey.begin()+1, prevout.scriptPubKey.end()-1);
-                        addressType = 1;
-                    } else {
-                        hashBytes.SetNull();
-                        addressType = 0;
-                    }
-
-                    if (fAddressIndex && addressType > 0) {
-                        // record spending activity
-                        addressIndex.push_back(std::make_pair(CAddressIndexKey(addressType, hashBytes, pindex->nHeight, i, txhash, j, true), prevout.nValue * -1));
-
-                        // remove address from unspent index
-                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(addressType, hashBytes, input.prevout.hash, input.prevout.n), CAddressUnspentValue()));
-                    }
-
-                    if (fSpentIndex) {
-                        // add the spent index to determine the txid and input that spent an output
-                        // and to find the amount and address from an input
-                        spentIndex.push_back(std::make_pair(CSpentIndexKey(input.prevout.hash, input.prevout.n), CSpentIndexValue(txhash, j, pindex->nHeight, prevout.nValue, addressType, hashBytes)));
-                    }
-                }
-
-            }
-
             if (fStrictPayToScriptHash)
             {
                 // Add in sigops done by pay-to-script-hash inputs;
@@ -2322,39 +2308,6 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
             control.Add(vChecks);
         }
 
-        if (fAddressIndex) {
-            for (unsigned int k = 0; k < tx.vout.size(); k++) {
-                const CTxOut &out = tx.vout[k];
-
-                if (out.scriptPubKey.IsPayToScriptHash()) {
-                    std::vector<unsigned char> hashBytes(out.scriptPubKey.begin()+2, out.scriptPubKey.begin()+22);
-
-                    // record receiving activity
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(2, uint160(hashBytes), pindex->nHeight, i, txhash, k, false), out.nValue));
-
-                    // record unspent output
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(2, uint160(hashBytes), txhash, k), CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight)));
-
-                } else if (out.scriptPubKey.IsPayToPublicKeyHash()) {
-                    std::vector<unsigned char> hashBytes(out.scriptPubKey.begin()+3, out.scriptPubKey.begin()+23);
-
-                    // record receiving activity
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(1, uint160(hashBytes), pindex->nHeight, i, txhash, k, false), out.nValue));
-
-                    // record unspent output
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, uint160(hashBytes), txhash, k), CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight)));
-
-                } else if (out.scriptPubKey.IsPayToPublicKey()) {
-                    uint160 hashBytes(Hash160(out.scriptPubKey.begin()+1, out.scriptPubKey.end()-1));
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(1, hashBytes, pindex->nHeight, i, txhash, k, false), out.nValue));
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, hashBytes, txhash, k), CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight)));
-                } else {
-                    continue;
-                }
-
-            }
-        }
-
         CTxUndo undoDummy;
         if (i > 0) {
             blockundo.vtxundo.push_back(CTxUndo());
@@ -2419,24 +2372,17 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
         if (!pblocktree->WriteTxIndex(vPos))
             return AbortNode(state, "Failed to write transaction index");
 
-    if (fAddressIndex) {
-        if (!pblocktree->WriteAddressIndex(addressIndex)) {
-            return AbortNode(state, "Failed to write address index");
-        }
-
-        if (!pblocktree->UpdateAddressUnspentIndex(addressUnspentIndex)) {
-            return AbortNode(state, "Failed to write address unspent index");
-        }
+    if (fAddressIndex || fSpentIndex || fTimestampIndex) {
+        CIndexUpdate update;
+        if (!GetIndexUpdate(block, pindex, blockundo, false, update))
+            return error("ConnectBlock(): block and undo data inconsistent");
+        // the index best block marker may get to disk before the next block index flush
+        update.vBlockIndex.push_back(CDiskBlockIndex(pindex));
+        update.vBlockFileInfo.push_back(std::make_pair(pindex->nFile, vinfoBlockFile[pindex->nFile]));
+        if (!indexWriter.Queue(std::move(update)))
+            return AbortNode(state, "Failed to write address, spent or timestamp index");
     }
 
-    if (fSpentIndex)
-        if (!pblocktree->UpdateSpentIndex(spentIndex))
-            return AbortNode(state, "Failed to write transaction index");
-
-    if (fTimestampIndex)
-        if (!pblocktree->WriteTimestampIndex(CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash())))
-            return AbortNode(state, "Failed to write timestamp index");
-
     // add this block to the view's block chain
     view.SetBestBlock(pindex->GetBlockHash());
 
@@ -2517,6 +2463,10 @@ bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode, int n
             return state.Error("out of disk space");
         // First make sure all block and undo data is flushed to disk.
         FlushBlockFile();
+        // Queued index updates carry older copies of the block index and block file information,
+        // and the indexes must never fall behind the chainstate.
+        if (!indexWriter.Flush())
+            return AbortNode(state, "Failed to write address, spent or timestamp index");
         // Then update all block file information (which may refer to block and undo files).
         {
             std::vector<std::pair<int, const CBlockFileInfo*> > vFiles;
@@ -2651,8 +2601,11 @@ bool static DisconnectTip(CValidationState& state, const CChainParams& chainpara
     int64_t nStart = GetTimeMicros();
     {
         CCoinsViewCache view(pcoinsTip);
-        if (DisconnectBlock(block, state, pindexDelete, view) != DISCONNECT_OK)
+        CIndexUpdate update;
+        if (DisconnectBlock(block, state, pindexDelete, view, &update) != DISCONNECT_OK)
             return error("DisconnectTip(): DisconnectBlock %s failed", pindexDelete->GetBlockHash().ToString());
+        if ((fAddressIndex || fSpentIndex || fTimestampIndex) && !indexWriter.Queue(std::move(update)))
+            return AbortNode(state, "Failed to write address, spent or timestamp index");
         bool flushed = view.Flush();
         assert(flushed);
     }
@@ -2685,6 +2638,7 @@ bool static DisconnectTip(CValidationState& state, const CChainParams& chainpara
     // UpdateTransactionsFromBlock finds descendants of any transactions in this
     // block that were added back and cleans up the mempool state.
     mempool.UpdateTransactionsFromBlock(vHashUpdate);
+    InvalidateStakeModifierCache(pindexDelete);
     // Update chainActive and related variables.
     UpdateTip(pindexDelete->pprev, chainparams);
     // Let wallets know transactions went from 1-confirmed to
@@ -4236,7 +4190,7 @@ bool CVerifyDB::VerifyDB(const CChainParams& chainparams, CCoinsView *coinsview,
         }
         CBlock block;
         // check level 0: read from disk
-        if (!ReadBlockFromDisk(block, pindex, chainparams.GetConsensus()))
+        if (!ReadBlockFromDisk(block, pindex, chainparams.GetConsensus(), false))
             return error("VerifyDB(): *** ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
         // check level 1: verify block validity
         if (nCheckLevel >= 1 && !CheckBlock(block, state, chainparams.GetConsensus()))
@@ -4279,7 +4233,7 @@ bool CVerifyDB::VerifyDB(const CChainParams& chainparams, CCoinsView *coinsview,
             uiInterface.ShowProgress(_("Verifying blocks..."), std::max(1, std::min(99, 100 - (int)(((double)(chainActive.Height() - pindex->nHeight)) / (double)nCheckDepth * 50))));
             pindex = chainActive.Next(pindex);
             CBlock block;
-            if (!ReadBlockFromDisk(block, pindex, chainparams.GetConsensus()))
+            if (!ReadBlockFromDisk(block, pindex, chainparams.GetConsensus(), false))
                 return error("VerifyDB(): *** ReadBlockFromDisk failed at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
             if (!ConnectBlock(block, state, pindex, coins, chainparams))
                 return error("VerifyDB(): *** found unconnectable block at %d, hash=%s", pindex->nHeight, pindex->GetBlockHash().ToString());
@@ -4313,6 +4267,7 @@ void UnloadBlockIndex()
     for (int b = 0; b < VERSIONBITS_NUM_BITS; b++) {
         warningcache[b].clear();
     }
+    ClearStakeModifierCache();
 
     BOOST_FOREACH(BlockMap::value_type& entry, mapBlockIndex) {
         delete entry.second;
@@ -4329,6 +4284,64 @@ bool LoadBlockIndex(const CChainParams& chainparams)
     return true;
 }
 
+bool CatchUpIndexes(const CChainParams& chainparams)
+{
+    LOCK(cs_main);
+    if (!fAddressIndex && !fSpentIndex && !fTimestampIndex)
+        return true;
+
+    uint256 hashIndexBest;
+    if (!pblocktree->ReadIndexBestBlock(hashIndexBest)) {
+        // Databases without the marker were written together with the chain
+        if (chainActive.Tip() && !pblocktree->WriteIndexBestBlock(chainActive.Tip()->GetBlockHash()))
+            return error("%s: failed to write the index best block", __func__);
+        return true;
+    }
+    BlockMap::iterator mi = mapBlockIndex.find(hashIndexBest);
+    if (mi == mapBlockIndex.end())
+        return error("%s: index best block %s not found", __func__, hashIndexBest.ToString());
+    CBlockIndex* pindex = mi->second;
+
+    // Undo the blocks the indexes got ahead of the chain with, in a crash or on a stale branch
+    int nUndone = 0;
+    while (pindex && pindex->pprev && !chainActive.Contains(pindex)) {
+        CBlock block;
+        CBlockUndo blockundo;
+        CIndexUpdate update;
+        if (!ReadBlockFromDisk(block, pindex, chainparams.GetConsensus(), false))
+            return error("%s: failed to read block %s", __func__, pindex->GetBlockHash().ToString());
+        if (!UndoReadFromDisk(blockundo, pindex->GetUndoPos(), pindex->pprev->GetBlockHash()) ||
+            !GetIndexUpdate(block, pindex, blockundo, true, update))
+            return error("%s: no valid undo data for block %s", __func__, pindex->GetBlockHash().ToString());
+        if (!indexWriter.Queue(std::move(update)))
+            return error("%s: failed to write index updates", __func__);
+        pindex = pindex->pprev;
+        nUndone++;
+    }
+
+    // Redo the blocks the chain got ahead with, their updates were still queued in a crash
+    int nRedone = 0;
+    for (pindex = chainActive.Contains(pindex) ? chainActive.Next(pindex) : NULL; pindex; pindex = chainActive.Next(pindex)) {
+        CBlock block;
+        CBlockUndo blockundo;
+        CIndexUpdate update;
+        if (!ReadBlockFromDisk(block, pindex, chainparams.GetConsensus(), false))
+            return error("%s: failed to read block %s", __func__, pindex->GetBlockHash().ToString());
+        if (!UndoReadFromDisk(blockundo, pindex->GetUndoPos(), pindex->pprev->GetBlockHash()) ||
+            !GetIndexUpdate(block, pindex, blockundo, false, update))
+            return error("%s: no valid undo data for block %s", __func__, pindex->GetBlockHash().ToString());
+        if (!indexWriter.Queue(std::move(update)))
+            return error("%s: failed to write index updates", __func__);
+        nRedone++;
+    }
+
+    if (!indexWriter.Flush())
+        return error("%s: failed to write index updates", __func__);
+    if (nUndone || nRedone)
+        LogPrintf("%s: undid %d and redid %d blocks of the address, spent and timestamp indexes\n", __func__, nUndone, nRedone);
+    return true;
+}
+
 static bool AddGenesisBlock(const CChainParams& chainparams, const CBlock& block, CValidationState& state)
 {
     // Start new block file
@@ -733,6 +733,10 @@ void CWallet::AddToSpends(const COutPoint& outpoint, const uint256& wtxid)
     mapTxSpends.insert(std::make_pair(outpoint, wtxid));
     setWalletUTXO.erase(outpoint);
 
+    std::map<uint256, CWalletTx>::const_iterator it = mapWallet.find(outpoint.hash);
+    if (it != mapWallet.end() && outpoint.n < it->second.tx->vout.size())
+        setStakeUTXO.erase(std::make_pair(it->second.tx->vout[outpoint.n].nValue, outpoint));
+
     std::pair<TxSpends::iterator, TxSpends::iterator> range;
     range = mapTxSpends.equal_range(outpoint);
     SyncMetaData(range);
@@ -750,6 +754,22 @@ void CWallet::AddToSpends(const uint256& wtxid)
         AddToSpends(txin.prevout, wtxid);
 }
 
+void CWallet::AddToStakeUTXO(const uint256& hash)
+{
+    std::map<uint256, CWalletTx>::const_iterator it = mapWallet.find(hash);
+    if (it == mapWallet.end())
+        return;
+
+    const CWalletTx& wtx = it->second;
+    for (unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
+        CAmount nValue = wtx.tx->vout[i].nValue;
+        if (nValue < MIN_STAKE_AMOUNT || nValue == MASTERNODE_COLLATERAL_AMOUNT)
+            continue;
+        if (IsMine(wtx.tx->vout[i]) != ISMINE_NO && !IsSpent(hash, i))
+            setStakeUTXO.insert(std::make_pair(nValue, COutPoint(hash, i)));
+    }
+}
+
 bool CWallet::EncryptWallet(const SecureString& strWalletPassphrase)
 {
     if (IsCrypted())
@@ -1123,6 +1143,8 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
             }
         }
     }
+    // a rescan or an abandoned spend can make outputs of a known transaction stakeable again
+    AddToStakeUTXO(hash);
 
     bool fUpdated = false;
     if (!fInsertedNew)
@@ -1296,8 +1318,10 @@ bool CWallet::AbandonTransaction(const uint256& hashTx)
             // available of the outputs it spends. So force those to be recomputed
             BOOST_FOREACH(const CTxIn& txin, wtx.tx->vin)
             {
-                if (mapWallet.count(txin.prevout.hash))
+                if (mapWallet.count(txin.prevout.hash)) {
                     mapWallet[txin.prevout.hash].MarkDirty();
+                    AddToStakeUTXO(txin.prevout.hash);
+                }
             }
         }
     }
@@ -1360,8 +1384,10 @@ void CWallet::MarkConflicted(const uint256& hashBlock, const uint256& hashTx)
             // available of the outputs it spends. So force those to be recomputed
             BOOST_FOREACH(const CTxIn& txin, wtx.tx->vin)
             {
-                if (mapWallet.count(txin.prevout.hash))
+                if (mapWallet.count(txin.prevout.hash)) {
                     mapWallet[txin.prevout.hash].MarkDirty();
+                    AddToStakeUTXO(txin.prevout.hash);
+                }
             }
         }
     }
@@ -3152,46 +3178,39 @@ bool CWallet::SelectCoinsGrouppedByAddresses(std::vector<CompactTallyItem>& vecT
 
 bool CWallet::SelectStakeCoins(StakeCandidates& setCoins, CAmount nTargetAmount) const
 {
-    std::vector<COutput> vCoins;
-    AvailableCoins(vCoins, true);
+    LOCK2(cs_main, cs_wallet);
     auto curr_time = GetTime() + nStakeSetUpdateTime;
     auto min_age =  curr_time >= sporkManager.GetSporkValue(SPORK_20_STAKEMINAGEV2) ? Params().MinStakeAgeNew() : Params().MinStakeAgeOld();
 
-    for (const COutput& out : vCoins) {
-        CAmount out_value = out.tx->tx->vout[out.i].nValue;
-
+    // setStakeUTXO only holds our outputs of stakeable value, other than collaterals, sorted by amount
+    for (const auto& item : setStakeUTXO) {
         //make sure not to outrun target amount
-        if (out_value > nTargetAmount) {
-            continue;
-        }
-
-        if (out_value < MIN_STAKE_AMOUNT) {
-            continue;
+        if (item.first > nTargetAmount) {
+            break;
         }
 
-        // Do not touch collaterals
-        if (out_value == MASTERNODE_COLLATERAL_AMOUNT) {
+        const COutPoint& outpoint = item.second;
+        std::map<uint256, CWalletTx>::const_iterator it = mapWallet.find(outpoint.hash);
+        if (it == mapWallet.end()) {
             continue;
         }
+        const CWalletTx* pcoin = &it->second;
 
         //check for min age
-        if (curr_time - out.tx->GetTxTime() < min_age) {
+        if (curr_time - pcoin->GetTxTime() < min_age) {
             continue;
         }
 
-        //check that it is matured
-        if (out.nDepth < (out.tx->IsCoinBase() ? COINBASE_MATURITY : 10)) {
+        //check that it is matured, which also makes it final and trusted
+        if (pcoin->GetDepthInMainChain(false) < (pcoin->IsCoinBase() ? COINBASE_MATURITY : 10)) {
             continue;
         }
 
         // Ignore already staked, locked or spent
-        auto tx_hash = out.tx->tx->GetHash();
-        if (IsSpent(tx_hash, out.i) || IsLockedCoin(tx_hash, out.i)) {
+        if (IsSpent(outpoint.hash, outpoint.n) || IsLockedCoin(outpoint.hash, outpoint.n)) {
             continue;
         }
 
-        auto outpoint = COutPoint(tx_hash, out.i);
-
         // Check another way if spent
         if (!pcoinsTip->HaveCoin(outpoint)) {
             continue;
@@ -3203,7 +3222,7 @@ bool CWallet::SelectStakeCoins(StakeCandidates& setCoins, CAmount nTargetAmount)
         }
 
         //add to our stake set
-        setCoins.emplace(out.tx->tx->vout[out.i].nValue, out.tx, out.i);
+        setCoins.emplace(item.first, pcoin, outpoint.n);
     }
 
     return !setCoins.empty();
@@ -3216,25 +3235,25 @@ bool CWallet::MintableCoins()
     if (nBalance <= nReserveBalance)
         return false;
 
-    std::vector<COutput> vCoins;
-    AvailableCoins(vCoins, true);
+    LOCK2(cs_main, cs_wallet);
     auto min_age = GetAdjustedTime() >= sporkManager.GetSporkValue(SPORK_20_STAKEMINAGEV2) ? Params().MinStakeAgeNew() : Params().MinStakeAgeOld();
 
-
-    BOOST_FOREACH (const COutput& out, vCoins) {
-        if (out.nDepth < (out.tx->IsCoinBase() ? COINBASE_MATURITY : 10))
+    for (const auto& item : setStakeUTXO) {
+        const COutPoint& outpoint = item.second;
+        std::map<uint256, CWalletTx>::const_iterator it = mapWallet.find(outpoint.hash);
+        if (it == mapWallet.end())
             continue;
+        const CWalletTx& wtx = it->second;
 
-        CAmount out_value = out.tx->tx->vout[out.i].nValue;
+        if (wtx.GetDepthInMainChain(false) < (wtx.IsCoinBase() ? COINBASE_MATURITY : 10))
+            continue;
 
-        if (out_value == MASTERNODE_COLLATERAL_AMOUNT) continue;
-        
-        if (out_value < MIN_STAKE_AMOUNT)
+        if (IsSpent(outpoint.hash, outpoint.n) || IsLockedCoin(outpoint.hash, outpoint.n))
             continue;
 
         // Some more filters are possible, but excessive
 
-        if (GetTime() - out.tx->GetTxTime() >= min_age)
+        if (GetTime() - wtx.GetTxTime() >= min_age)
             return true;
     }
 
@@ -3945,118 +3964,136 @@ bool CWallet::CreateCoinStake(const CKeyStore& keystore, CBlock &curr_block, CMu
 
     LogPrint("stake", "%s : found %u possible stake inputs\n", __func__, setStakeCoins.size());
 
+    // Prepare the kernel of every candidate once, then search them all for the hash drift window.
     // NOTE: go from smaller amounts to bigger to increase chance, unlike it was before
-    for (auto iter = setStakeCoins.begin(); iter != setStakeCoins.end(); ++iter) {
-        if (ShutdownRequested()) {
-            break;
-        }
+    std::vector<CStakeKernel> vKernels;
+    std::vector<std::pair<const CWalletTx*, unsigned int> > vKernelInputs;
+    vKernels.reserve(setStakeCoins.size());
+    vKernelInputs.reserve(setStakeCoins.size());
 
-        CBlockIndex* pcoin_index = NULL;
+    for (auto iter = setStakeCoins.begin(); iter != setStakeCoins.end(); ++iter) {
         auto pWalletTxIn = std::get<1>(*iter);
-
         COutPoint prevoutStake = COutPoint(pWalletTxIn->GetHash(), std::get<2>(*iter));
-        LogPrint("stake", "%s : trying tx=%s n=%u\n", __func__,
-                 prevoutStake.hash.ToString().c_str(), prevoutStake.n);
 
         // Read block header
         BlockMap::iterator it = mapBlockIndex.find(pWalletTxIn->hashBlock);
-        if (it != mapBlockIndex.end())
-            pcoin_index = it->second;
-        else {
+        if (it == mapBlockIndex.end()) {
             LogPrintf("%s : failed to find block index for %s \n",
                       __func__, pWalletTxIn->hashBlock.ToString().c_str());
             continue;
         }
 
-        //iterates each utxo inside of CheckStakeKernelHash()
-        bool fKernelFound = CheckStakeKernelHash(
-                curr_block.nBits, *pcoin_index, *pWalletTxIn,
-                prevoutStake,
-                curr_block.nTime,
-                nHashDrift,
-                false,
-                curr_block.hashProofOfStake(),
-                curr_block.nStakeModifier(),
-                true);
-
-        if (fKernelFound) {
-            //Double check that this will pass time requirements
-            if (curr_block.nTime <= chainActive.Tip()->GetMedianTimePast()) {
-                LogPrint("stake", "%s kernel found, but it is too far in the past \n", __func__);
-                continue;
-            }
+        CStakeKernel kernel;
+        if (!PrepareStakeKernel(curr_block.nBits, *it->second, *pWalletTxIn, prevoutStake, curr_block.nTime, false, kernel)) {
+            continue;
+        }
+        vKernels.push_back(kernel);
+        vKernelInputs.push_back(std::make_pair(pWalletTxIn, prevoutStake.n));
+    }
 
-            // Found a kernel
-            LogPrint("stake", "%s  : kernel found\n", __func__ );
+    LogPrint("stake", "%s : searching %u kernels\n", __func__, vKernels.size());
 
-            std::vector<std::vector<unsigned char>> vSolutions;
-            txnouttype whichType;
-            CScript scriptPubKeyOut;
-            const auto &tx_in = pWalletTxIn->tx->vout[prevoutStake.n];
-            const auto &scriptPubKeyKernel = tx_in.scriptPubKey;
+    size_t nKernelStart = 0;
+    size_t nKernel;
+    unsigned int nTimeTx;
+    uint256 hashProofOfStake;
 
-            if (!Solver(scriptPubKeyKernel, whichType, vSolutions)) {
-                LogPrint("stake", "%s : failed to parse kernel\n", __func__);
-                continue;
-            }
+    while (!ShutdownRequested()) {
+        unsigned int nTimeFrom = curr_block.nTime;
+        unsigned int nTimeTo = std::min<int64_t>(
+                nTimeFrom + nHashDrift,
+                GetAdjustedTime() + MAX_POS_BLOCK_AHEAD_TIME - MAX_POS_BLOCK_AHEAD_SAFETY_MARGIN);
 
-            LogPrint("stake", "%s  : parsed kernel type=%d\n", __func__, whichType);
+        if (!FindStakeKernel(vKernels, nKernelStart, nTimeFrom, nTimeTo, GetNumCores(), nKernel, nTimeTx, hashProofOfStake)) {
+            break;
+        }
+        nKernelStart = nKernel + 1;
 
-            if (whichType == TX_PUBKEYHASH) // pay to address type
-            {
-                // convert to pay to address type
-                if (!keystore.GetPubKey(CKeyID(uint160(vSolutions[0])), curr_block.posPubKey)) {
-                    LogPrint("stake", "%s : failed to get key for kernel type=%d\n", __func__, whichType);
-                    continue;
-                }
-            }
-            else if (whichType == TX_PUBKEY) // pay to public key
-            {
-                curr_block.posPubKey = CPubKey(vSolutions[0]);
-            }
-            else
-            {
-                LogPrint("stake", "%s : no support for kernel type=%d\n", __func__, whichType);
-                continue;
-            }
+        auto pWalletTxIn = vKernelInputs[nKernel].first;
+        COutPoint prevoutStake = COutPoint(pWalletTxIn->GetHash(), vKernelInputs[nKernel].second);
+        LogPrint("stake", "%s : kernel tx=%s n=%u\n", __func__,
+                 prevoutStake.hash.ToString().c_str(), prevoutStake.n);
+
+        curr_block.nTime = nTimeTx;
+        curr_block.hashProofOfStake() = hashProofOfStake;
+        curr_block.nStakeModifier() = vKernels[nKernel].GetStakeModifier();
 
-            assert(curr_block.posPubKey.IsValid());
-            scriptPubKeyOut = GetScriptForDestination(curr_block.posPubKey.GetID());
+        //Double check that this will pass time requirements
+        if (curr_block.nTime <= chainActive.Tip()->GetMedianTimePast()) {
+            LogPrint("stake", "%s kernel found, but it is too far in the past \n", __func__);
+            continue;
+        }
 
-            // Require the same miner's output in CoinBase
-            coinbaseTx.vout[0].scriptPubKey = scriptPubKeyOut;
-            
-            CMutableTransaction stakeTx;
-            stakeTx.vin.emplace_back(prevoutStake);
-            stakeTx.vout.emplace_back(tx_in.nValue, scriptPubKeyOut);
+        // Found a kernel
+        LogPrint("stake", "%s  : kernel found\n", __func__ );
 
-            // TODO: potentially support multi-input stake where extra inputs
-            //       combine Dust.
+        std::vector<std::vector<unsigned char>> vSolutions;
+        txnouttype whichType;
+        CScript scriptPubKeyOut;
+        const auto &tx_in = pWalletTxIn->tx->vout[prevoutStake.n];
+        const auto &scriptPubKeyKernel = tx_in.scriptPubKey;
 
-            CAmount reward = stakeTx.vout[0].nValue;
-            CAmount split_threshold = nStakeSplitThreshold * COIN;
-            CAmount half_reward = (reward / 2);
+        if (!Solver(scriptPubKeyKernel, whichType, vSolutions)) {
+            LogPrint("stake", "%s : failed to parse kernel\n", __func__);
+            continue;
+        }
 
-            if (half_reward > split_threshold) {
-                stakeTx.vout[0].nValue = half_reward;
-                stakeTx.vout.emplace_back((reward - half_reward), scriptPubKeyOut);
-            }
-            
-            if (!SignSignature(*this, scriptPubKeyKernel, stakeTx, 0)) {
-                return error("CreateCoinStake : failed to sign coinstake");
+        LogPrint("stake", "%s  : parsed kernel type=%d\n", __func__, whichType);
+
+        if (whichType == TX_PUBKEYHASH) // pay to address type
+        {
+            // convert to pay to address type
+            if (!keystore.GetPubKey(CKeyID(uint160(vSolutions[0])), curr_block.posPubKey)) {
+                LogPrint("stake", "%s : failed to get key for kernel type=%d\n", __func__, whichType);
+                continue;
             }
+        }
+        else if (whichType == TX_PUBKEY) // pay to public key
+        {
+            curr_block.posPubKey = CPubKey(vSolutions[0]);
+        }
+        else
+        {
+            LogPrint("stake", "%s : no support for kernel type=%d\n", __func__, whichType);
+            continue;
+        }
 
-            curr_block.posStakeHash = prevoutStake.hash;
-            curr_block.posStakeN = prevoutStake.n;
-            curr_block.Stake() = MakeTransactionRef(std::move(stakeTx));
+        assert(curr_block.posPubKey.IsValid());
+        scriptPubKeyOut = GetScriptForDestination(curr_block.posPubKey.GetID());
 
-            LogPrint("stake", "%s : added kernel type=%d stakemod=%llx\n", 
-                     __func__, whichType, curr_block.nStakeModifier());
+        // Require the same miner's output in CoinBase
+        coinbaseTx.vout[0].scriptPubKey = scriptPubKeyOut;
+        
+        CMutableTransaction stakeTx;
+        stakeTx.vin.emplace_back(prevoutStake);
+        stakeTx.vout.emplace_back(tx_in.nValue, scriptPubKeyOut);
 
-            // Force update
-            nLastStakeSetUpdate = 0;
-            return true;
+        // TODO: potentially support multi-input stake where extra inputs
+        //       combine Dust.
+
+        CAmount reward = stakeTx.vout[0].nValue;
+        CAmount split_threshold = nStakeSplitThreshold * COIN;
+        CAmount half_reward = (reward / 2);
+
+        if (half_reward > split_threshold) {
+            stakeTx.vout[0].nValue = half_reward;
+            stakeTx.vout.emplace_back((reward - half_reward), scriptPubKeyOut);
+        }
+        
+        if (!SignSignature(*this, scriptPubKeyKernel, stakeTx, 0)) {
+            return error("CreateCoinStake : failed to sign coinstake");
         }
+
+        curr_block.posStakeHash = prevoutStake.hash;
+        curr_block.posStakeN = prevoutStake.n;
+        curr_block.Stake() = MakeTransactionRef(std::move(stakeTx));
+
+        LogPrint("stake", "%s : added kernel type=%d stakemod=%llx\n", 
+                 __func__, whichType, curr_block.nStakeModifier());
+
+        // Force update
+        nLastStakeSetUpdate = 0;
+        return true;
     }
 
     LogPrint("stake", "%s : no stakes found\n", __func__);
@@ -4198,6 +4235,7 @@ DBErrors CWallet::LoadWallet(bool& fFirstRunRet)
                     setWalletUTXO.insert(COutPoint(pair.first, i));
                 }
             }
+            AddToStakeUTXO(pair.first);
         }
     }
 
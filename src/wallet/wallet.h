@@ -672,6 +672,11 @@ private:
 
     std::set<COutPoint> setWalletUTXO;
 
+    /** Unspent outputs of stakeable value sorted by amount, so staking does not have to scan mapWallet */
+    typedef std::set<std::pair<CAmount, COutPoint> > StakeUTXOs;
+    StakeUTXOs setStakeUTXO;
+    void AddToStakeUTXO(const uint256& hash);
+
     /* Mark a transaction (and its in-wallet descendants) as conflicting with a particular block. */
     void MarkConflicted(const uint256& hashBlock, const uint256& hashTx);
 